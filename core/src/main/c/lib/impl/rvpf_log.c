@@ -15,19 +15,47 @@
 #include "rvpf_version.h"
 
 #include "rvpf_log.h"
+#include "rvpf_ring.h"
 
 #include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 // Private macro definitions.
 
+#define _ASYNC_IDLE_NANOS 1000000
+#define _ASYNC_MESSAGE_SIZE 512
 #define _DEFAULT_LOG_LEVEL RVPF_LOG_LEVEL_WARN
 #define _RVPF_LOG_LEVEL "RVPF_LOG_LEVEL"
 
+#if defined(__GNUC__) && !defined(_WIN32)
+#define _ASYNC_SUPPORTED 1
+#define _THREAD_LOCAL __thread
+#else
+#define _THREAD_LOCAL
+#endif
+
+// Private structure definitions.
+
+struct _asyncCell {
+    size_t length;
+    char text[_ASYNC_MESSAGE_SIZE];
+};
+
 // Private forward declarations.
 
+#ifdef _ASYNC_SUPPORTED
+static void _logAsync(
+    RVPF_LOG_Level level,
+    const char *file,
+    int line,
+    const char *format,
+    va_list ap);
+#endif
+
 static void _log(
     RVPF_LOG_Level level,
     const char *file,
@@ -35,9 +63,28 @@ static void _log(
     const char *format,
     va_list ap);
 
+static size_t _prefix(
+    char *text,
+    size_t size,
+    RVPF_LOG_Level level,
+    const char *file,
+    int line);
+
+#ifdef _ASYNC_SUPPORTED
+static void *_writer(void *argument);
+#endif
+
 // Private storage.
 
-static RVPF_LOG_Level _level = _DEFAULT_LOG_LEVEL;
+static struct {
+    RVPF_RING_Context ring;
+    unsigned long dropped;
+    int users;
+    bool running;
+    bool stopping;
+    pthread_t writer;
+} _async;
+
 static bool _levelSet = false;
 static const char *_levels[] = {
 	"NONE",
@@ -51,12 +98,18 @@ static const char *_levels[] = {
 };
 static FILE *_logFile = NULL;
 static int _logged = 0;
+static _THREAD_LOCAL time_t _stampTime;
+static _THREAD_LOCAL char _stampText[21];
+
+// Public variable definitions.
+
+RVPF_LOG_Level rvpf_log_activeLevel = _DEFAULT_LOG_LEVEL;
 
 // Public function definitions.
 
 extern void rvpf_log(RVPF_LOG_Level level, const char *format, va_list ap)
 {
-    if (_level >= level) {
+    if (rvpf_log_activeLevel >= level) {
         _log(level, NULL, 0, format, ap);
     }
 }
@@ -68,13 +121,15 @@ extern void rvpf_log_s(
     const char *format,
     va_list ap)
 {
-    if (_level >= level) {
+    if (rvpf_log_activeLevel >= level) {
         _log(level, file, line, format, ap);
     }
 }
 
 extern void rvpf_log_close(void)
 {
+    rvpf_log_stopAsync();
+
     if (_logFile != NULL && _logFile != stderr) {
         FILE *logFile = _logFile;
 
@@ -89,7 +144,7 @@ extern void rvpf_log_close(void)
 
 extern void rvpf_log_debug(const char *format, ...)
 {
-    if (_level >= RVPF_LOG_LEVEL_DEBUG) {
+    if (rvpf_log_activeLevel >= RVPF_LOG_LEVEL_DEBUG) {
         va_list ap;
 
         va_start(ap, format);
@@ -103,7 +158,7 @@ extern void rvpf_log_debug_s(
     int line,
     const char *format, ...)
 {
-    if (_level >= RVPF_LOG_LEVEL_DEBUG) {
+    if (rvpf_log_activeLevel >= RVPF_LOG_LEVEL_DEBUG) {
         va_list ap;
 
         va_start(ap, format);
@@ -114,7 +169,7 @@ extern void rvpf_log_debug_s(
 
 extern void rvpf_log_error(const char *format, ...)
 {
-    if (_level >= RVPF_LOG_LEVEL_ERROR) {
+    if (rvpf_log_activeLevel >= RVPF_LOG_LEVEL_ERROR) {
         va_list ap;
 
         va_start(ap, format);
@@ -128,7 +183,7 @@ extern void rvpf_log_error_s(
     int line,
     const char *format, ...)
 {
-    if (_level >= RVPF_LOG_LEVEL_ERROR) {
+    if (rvpf_log_activeLevel >= RVPF_LOG_LEVEL_ERROR) {
         va_list ap;
 
         va_start(ap, format);
@@ -139,7 +194,7 @@ extern void rvpf_log_error_s(
 
 extern void rvpf_log_fatal(const char *format, ...)
 {
-    if (_level >= RVPF_LOG_LEVEL_FATAL) {
+    if (rvpf_log_activeLevel >= RVPF_LOG_LEVEL_FATAL) {
         va_list ap;
 
         va_start(ap, format);
@@ -153,7 +208,7 @@ extern void rvpf_log_fatal_s(
     int line,
     const char *format, ...)
 {
-    if (_level >= RVPF_LOG_LEVEL_FATAL) {
+    if (rvpf_log_activeLevel >= RVPF_LOG_LEVEL_FATAL) {
         va_list ap;
 
         va_start(ap, format);
@@ -162,19 +217,32 @@ extern void rvpf_log_fatal_s(
     }
 }
 
+extern unsigned long rvpf_log_getDropped(void)
+{
+#ifdef _ASYNC_SUPPORTED
+    return __atomic_load_n(&_async.dropped, __ATOMIC_RELAXED);
+#else
+    return 0;
+#endif
+}
+
 extern RVPF_LOG_Level rvpf_log_getLevel(void)
 {
-	return _level;
+	return rvpf_log_activeLevel;
 }
 
 extern int rvpf_log_getLogged(void)
 {
+#ifdef _ASYNC_SUPPORTED
+    return __atomic_load_n(&_logged, __ATOMIC_RELAXED);
+#else
     return _logged;
+#endif
 }
 
 extern void rvpf_log_info(const char *format, ...)
 {
-    if (_level >= RVPF_LOG_LEVEL_INFO) {
+    if (rvpf_log_activeLevel >= RVPF_LOG_LEVEL_INFO) {
         va_list ap;
 
         va_start(ap, format);
@@ -188,7 +256,7 @@ extern void rvpf_log_info_s(
     int line,
     const char *format, ...)
 {
-    if (_level >= RVPF_LOG_LEVEL_INFO) {
+    if (rvpf_log_activeLevel >= RVPF_LOG_LEVEL_INFO) {
         va_list ap;
 
         va_start(ap, format);
@@ -199,22 +267,22 @@ extern void rvpf_log_info_s(
 
 extern bool rvpf_log_isDebugEnabled(void)
 {
-    return _level >= RVPF_LOG_LEVEL_DEBUG;
+    return rvpf_log_activeLevel >= RVPF_LOG_LEVEL_DEBUG;
 }
 
 extern bool rvpf_log_isEnabledFor(RVPF_LOG_Level level)
 {
-    return _level >= level;
+    return rvpf_log_activeLevel >= level;
 }
 
 extern bool rvpf_log_isInfoEnabled(void)
 {
-    return _level >= RVPF_LOG_LEVEL_INFO;
+    return rvpf_log_activeLevel >= RVPF_LOG_LEVEL_INFO;
 }
 
 extern bool rvpf_log_isTraceEnabled(void)
 {
-    return _level >= RVPF_LOG_LEVEL_TRACE;
+    return rvpf_log_activeLevel >= RVPF_LOG_LEVEL_TRACE;
 }
 
 extern bool rvpf_log_open(const char *filePath)
@@ -245,14 +313,60 @@ extern void rvpf_log_setLevel(int level)
             if (level >= (int) RVPF_LOG_LEVEL_NONE) rvpf_log_setLevel(level);
         }
     } else if (level <= RVPF_LOG_LEVEL_ALL) {
-        _level = level;
+        rvpf_log_activeLevel = level;
         _levelSet = true;
     }
 }
 
+extern bool rvpf_log_startAsync(size_t capacity)
+{
+#ifdef _ASYNC_SUPPORTED
+    if (_async.running) {
+        return true;
+    }
+
+    _async.ring = rvpf_ring_create(capacity, sizeof(struct _asyncCell));
+    if (_async.ring == NULL) {
+        return false;
+    }
+    _async.stopping = false;
+
+    if (!_logFile) _logFile = stderr;
+
+    if (pthread_create(&_async.writer, NULL, _writer, NULL)) {
+        rvpf_ring_dispose(_async.ring);
+        _async.ring = NULL;
+        return false;
+    }
+    __atomic_store_n(&_async.running, true, __ATOMIC_RELEASE);
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+extern void rvpf_log_stopAsync(void)
+{
+#ifdef _ASYNC_SUPPORTED
+    if (_async.running) {
+        struct timespec idle = {0, _ASYNC_IDLE_NANOS};
+
+        __atomic_store_n(&_async.running, false, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&_async.users, __ATOMIC_SEQ_CST)) {
+            nanosleep(&idle, NULL);
+        }
+        __atomic_store_n(&_async.stopping, true, __ATOMIC_RELEASE);
+        pthread_join(_async.writer, NULL);
+        rvpf_ring_dispose(_async.ring);
+        _async.ring = NULL;
+    }
+#endif
+}
+
 extern void rvpf_log_trace(const char *format, ...)
 {
-    if (_level >= RVPF_LOG_LEVEL_TRACE) {
+    if (rvpf_log_activeLevel >= RVPF_LOG_LEVEL_TRACE) {
         va_list ap;
 
         va_start(ap, format);
@@ -266,7 +380,7 @@ extern void rvpf_log_trace_s(
     int line,
     const char *format, ...)
 {
-    if (_level >= RVPF_LOG_LEVEL_TRACE) {
+    if (rvpf_log_activeLevel >= RVPF_LOG_LEVEL_TRACE) {
         va_list ap;
 
         va_start(ap, format);
@@ -282,7 +396,7 @@ extern char *rvpf_log_version(void)
 
 extern void rvpf_log_warn(const char *format, ...)
 {
-    if (_level >= RVPF_LOG_LEVEL_WARN) {
+    if (rvpf_log_activeLevel >= RVPF_LOG_LEVEL_WARN) {
         va_list ap;
 
         va_start(ap, format);
@@ -296,7 +410,7 @@ extern void rvpf_log_warn_s(
     int line,
     const char *format, ...)
 {
-    if (_level >= RVPF_LOG_LEVEL_WARN) {
+    if (rvpf_log_activeLevel >= RVPF_LOG_LEVEL_WARN) {
         va_list ap;
 
         va_start(ap, format);
@@ -314,14 +428,109 @@ static void _log(
     const char *format,
     va_list ap)
 {
+#ifdef _ASYNC_SUPPORTED
+    if (__atomic_load_n(&_async.running, __ATOMIC_ACQUIRE)) {
+        bool logged = false;
+
+        // The users count keeps the ring alive while it is used.
+
+        __atomic_add_fetch(&_async.users, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&_async.running, __ATOMIC_SEQ_CST)) {
+            _logAsync(level, file, line, format, ap);
+            logged = true;
+        }
+        __atomic_sub_fetch(&_async.users, 1, __ATOMIC_SEQ_CST);
+        if (logged) return;
+    }
+#endif
+
+    char prefix[_ASYNC_MESSAGE_SIZE];
+
     if (!_logFile) _logFile = stderr;
 
+    _prefix(prefix, sizeof prefix, level, file, line);
+
+#ifndef _WIN32
+    flockfile(_logFile);
+#endif
+
+    fputs(prefix, _logFile);
+
+    if (format) {
+        fputs(" ", _logFile);
+        vfprintf(_logFile, format, ap);
+    }
+
+    fputs("\n", _logFile);
+    fflush(_logFile);
+
+#ifdef _ASYNC_SUPPORTED
+    __atomic_add_fetch(&_logged, 1, __ATOMIC_RELAXED);
+#else
+    ++_logged;
+#endif
+
+#ifndef _WIN32
+    funlockfile(_logFile);
+#endif
+}
+
+#ifdef _ASYNC_SUPPORTED
+static void _logAsync(
+    RVPF_LOG_Level level,
+    const char *file,
+    int line,
+    const char *format,
+    va_list ap)
+{
+    // A full ring drops the message.
+
+    size_t position;
+    struct _asyncCell *cell = rvpf_ring_claim(_async.ring, &position);
+
+    if (cell == NULL) {
+        __atomic_add_fetch(&_async.dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    size_t size = sizeof cell->text - 1;
+    size_t length = _prefix(cell->text, size, level, file, line);
+
+    if (format && length + 1 < size) {
+        int count;
+
+        cell->text[length++] = ' ';
+        count = vsnprintf(cell->text + length, size - length, format, ap);
+        if (count > 0) {
+            length += (size_t) count < size - length?
+                (size_t) count: size - length - 1;
+        }
+    }
+    cell->text[length++] = '\n';
+    cell->length = length;
+
+    __atomic_add_fetch(&_logged, 1, __ATOMIC_RELAXED);
+    rvpf_ring_publish(_async.ring, position);
+}
+#endif
+
+static size_t _prefix(
+    char *text,
+    size_t size,
+    RVPF_LOG_Level level,
+    const char *file,
+    int line)
+{
+    size_t length = 0;
+    int count;
+
     if (_logFile != stderr) {
         time_t now = time(NULL);
 
-        if (now > 0) {
+        // The stamp text is kept for the current second.
+
+        if (now > 0 && now != _stampTime) {
             struct tm *now_tm_ptr;
-            char now_string[20];
 
 #if defined(__MINGW32__)
             now_tm_ptr = localtime(&now);
@@ -332,30 +541,65 @@ static void _log(
             localtime_r(&now, now_tm_ptr);
 #endif
             if (strftime(
-                    now_string,
-                    sizeof now_string,
-                    "%Y-%m-%d %H:%M:%S",
+                    _stampText,
+                    sizeof _stampText,
+                    "%Y-%m-%d %H:%M:%S ",
                     now_tm_ptr)) {
-                fputs(now_string, _logFile);
-                fputs(" ", _logFile);
-            }
+                _stampTime = now;
+            } else _stampText[0] = '\0';
+        }
+        if (now > 0) {
+            length = strlen(_stampText);
+            memcpy(text, _stampText, length);
         }
     }
 
-    fputs(_levels[level], _logFile);
+    if (file) {
+        count = snprintf(text + length, size - length,
+            "%s (FILE '%s', LINE %d)", _levels[level], file, line);
+    } else {
+        count = snprintf(text + length, size - length, "%s", _levels[level]);
+    }
+    if (count > 0) {
+        length += (size_t) count < size - length?
+            (size_t) count: size - length - 1;
+    }
 
-    if (file) fprintf(_logFile, " (FILE '%s', LINE %d)", file, line);
+    return length;
+}
 
-    if (format) {
-        fputs(" ", _logFile);
-        vfprintf(_logFile, format, ap);
-    }
+#ifdef _ASYNC_SUPPORTED
+static void *_writer(void *argument)
+{
+    struct timespec idle = {0, _ASYNC_IDLE_NANOS};
 
-    fputs("\n", _logFile);
-    fflush(_logFile);
+    while (true) {
+        size_t written = 0;
 
-    ++_logged;
+        while (true) {
+            struct _asyncCell *cell = rvpf_ring_peek(_async.ring);
+
+            if (cell == NULL) break;
+
+            fwrite(cell->text, 1, cell->length, _logFile);
+            rvpf_ring_release(_async.ring);
+            ++written;
+        }
+
+        if (written) {
+            fflush(_logFile);
+        } else if (__atomic_load_n(&_async.stopping, __ATOMIC_ACQUIRE)) {
+            // Waits for the messages claimed before the stop.
+
+            if (rvpf_ring_isEmpty(_async.ring)) break;
+        } else {
+            nanosleep(&idle, NULL);
+        }
+    }
+
+    return NULL;
 }
+#endif
 
 /* This is free software; you can redistribute it and/or modify
  * it under the terms of the GNU Lesser General Public License
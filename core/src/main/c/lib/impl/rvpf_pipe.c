@@ -20,18 +20,51 @@
 #include "rvpf_pipe.h"
 
 #include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
+#ifdef _WIN32
+#include <io.h>
+#define read _read
+#else
+#include <poll.h>
+#include <unistd.h>
+#endif
+
 // Private macro definitions.
 
+#define ARENA_ALIGNMENT 16
+#define ARENA_BLOCK_SIZE 4096
+#define ARENA_HEADER_SIZE \
+    ((sizeof(struct rvpf_pipe_arenaBlock) + ARENA_ALIGNMENT - 1) \
+        & ~(size_t) (ARENA_ALIGNMENT - 1))
+#define CACHED_DOUBLE 0x01
+#define CACHED_DOUBLE_VALID 0x02
+#define CACHED_LONG 0x04
+#define CACHED_LONG_VALID 0x08
+#define CACHED_STAMP 0x10
+#define CACHED_STAMP_VALID 0x20
+#define CACHED_TYPED_DOUBLE 0x40
+#define CACHED_TYPED_LONG 0x80
+#define CACHED_TYPED_STAMP 0x100
+#define CACHED_TYPED_VALUE (CACHED_TYPED_DOUBLE | CACHED_TYPED_LONG)
+#define DOUBLE_FIXED_DECIMALS 9
+#define DOUBLE_FIXED_UNITS_LIMIT 9007199254740992.0
 #define ENGINE_REQUEST_FORMAT_VERSION 1
 #define INITIAL_CONTROL_BUFFER_CAPACITY 128
+#define INITIAL_INPUT_BUFFER_CAPACITY 65536
+#define INITIAL_NAMES_CAPACITY 256
+#define POOL_SLOTS_PER_WORKER 4
+#define RAW_PER_SECOND 10000000LL
 #define SINK_DELETE_REQUEST_TYPE "-"
 #define SINK_REQUEST_FORMAT_VERSION 1
 #define SINK_UPDATE_REQUEST_TYPE "+"
+#define UNIX_EPOCH_RAW 0x007C95674BEB4000LL
 
 // Private structure definitions.
 
@@ -43,9 +76,32 @@ typedef struct rvpf_pipe_buffer {
     size_t capacity;
 } *RVPF_PIPE_Buffer;
 
+typedef struct rvpf_pipe_arena {
+    struct rvpf_pipe_arenaBlock {
+        struct rvpf_pipe_arenaBlock *next;
+        size_t capacity;
+        size_t used;
+    } *blocks;
+} *RVPF_PIPE_Arena;
+
+typedef struct rvpf_pipe_names {
+    pthread_mutex_t mutex;
+    struct rvpf_pipe_arena arena;
+    struct rvpf_pipe_name {
+        char *name;
+        size_t hash;
+    } *at;
+    int count;
+    int capacity;
+    int *slots;
+    size_t mask;
+} *RVPF_PIPE_Names;
+
 typedef struct rvpf_pipe_request {
+    struct rvpf_pipe_arena arena;
     char *requestID;
     int version;
+    struct rvpf_pipe_buffer line;
     struct rvpf_pipe_buffer buffer;
 } *RVPF_PIPE_Request;
 
@@ -77,50 +133,102 @@ struct rvpf_pipe_sinkRequest {
     struct rvpf_pipe_request control;
     enum rvpf_pipe_sinkRequestType requestType;
     struct rvpf_pipe_pointValue pointValue;
+    int sequence; /* Position in its batch. */
+    struct rvpf_pipe_sinkRequest *superseded; /* Coalesced into this one. */
 };
 
+typedef struct rvpf_pipe_pool {
+    pthread_mutex_t mutex;
+    pthread_cond_t space;
+    pthread_cond_t work;
+    pthread_cond_t done;
+    struct rvpf_pipe_poolSlot {
+        RVPF_PIPE_EngineRequest request;
+        int status;
+        bool done;
+    } *slots;
+    size_t capacity;
+    size_t queued;
+    size_t taken;
+    size_t written;
+    bool ended;
+    bool aborted;
+    int status;
+    RVPF_PIPE_EngineCallback callback;
+    void *data;
+} *RVPF_PIPE_Pool;
+
 // Public variable definitions.
 
-jmp_buf rvpf_pipe_jmp_buf;
+RVPF_PIPE_THREAD_LOCAL jmp_buf rvpf_pipe_jmp_buf;
 
 char *rvpf_pipe_sink_request_types[] = {
     "Update", "Delete"
 };
 
-int rvpf_pipe_status = RVPF_PIPE_STATUS_OK;
+RVPF_PIPE_THREAD_LOCAL int rvpf_pipe_status = RVPF_PIPE_STATUS_OK;
 
 // Private variable definitions.
 
 static const char _deletedState[] = "DELETED";
+static struct rvpf_pipe_buffer _input;
 static const char _nullRequestMessage[] = "Null request!";
+static struct rvpf_pipe_names _names = {PTHREAD_MUTEX_INITIALIZER};
+static const char _nullPointValueMessage[] = "Null point value!";
+static struct rvpf_pipe_buffer _output;
+static const double _powersOf10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static pthread_mutex_t _outputMutex = PTHREAD_MUTEX_INITIALIZER;
+static bool _stopping;
 
 // Private forward declarations.
 
 static void *_alloc(size_t size);
+static void _awaitInput(void);
+static void *_arenaAlloc(RVPF_PIPE_Arena arena, size_t size);
+static char *_arenaString(RVPF_PIPE_Arena arena, const char *string);
+static void _bufferToOutput(RVPF_PIPE_Buffer buffer);
 static void _charToBuffer(char c, RVPF_PIPE_Buffer buffer);
-static void _clearControl(RVPF_PIPE_Request control);
-static void _clearPointValue(RVPF_PIPE_PointValue);
-static char *_cloneString(const char *string);
+static void _doubleToBuffer(double value, RVPF_PIPE_Buffer buffer);
+static void _engineResponseToOutput(RVPF_PIPE_EngineRequest request);
 static void _expandBuffer(RVPF_PIPE_Buffer buffer, size_t size);
 static void _fillPointValue(
     RVPF_PIPE_PointValue pointValue,
     RVPF_PIPE_Buffer buffer,
-    bool stampRequired);
+    bool stampRequired,
+    RVPF_PIPE_Arena arena);
 static char *_firstLine(RVPF_PIPE_Buffer buffer);
 static void _flushBuffer(RVPF_PIPE_Buffer buffer);
-static void _freeEngineRequest(RVPF_PIPE_EngineRequest request);
-static void _freeSinkRequest(RVPF_PIPE_SinkRequest request);
+static void _flushOutput(void);
+static void _freeRequest(RVPF_PIPE_Request control);
+static bool _inputAvailable(void);
+static int _intern(const char *name, char **interned);
 static void _intToBuffer(int value, RVPF_PIPE_Buffer buffer);
+static void _longToBuffer(long long value, RVPF_PIPE_Buffer buffer);
+static void *_newRequest(size_t size);
 static char *_nextField(RVPF_PIPE_Buffer buffer, bool required, bool last);
 static char *_nextLine(RVPF_PIPE_Buffer buffer, bool required);
+static bool _parseDouble(const char *text, double *value);
+static bool _parseLong(const char *text, long long *value);
+static bool _parseStamp(const char *stamp, long long *ticks);
 static void _pointValueToBuffer(
     RVPF_PIPE_PointValue pointValue,
     RVPF_PIPE_Buffer buffer);
-static char *_requestID(RVPF_PIPE_Buffer buffer);
+static int _poolCall(RVPF_PIPE_Pool pool, RVPF_PIPE_EngineRequest request);
+static void *_poolReader(void *argument);
+static void *_poolWorker(void *argument);
+static RVPF_PIPE_EngineRequest _readEngineRequest(void);
+static bool _readInput(void);
+static RVPF_PIPE_SinkRequest _readSinkRequest(void);
+static char *_requestID(RVPF_PIPE_Buffer buffer, RVPF_PIPE_Arena arena);
 static void _resetBuffer(RVPF_PIPE_Buffer buffer);
+static void _sinkResponseToOutput(RVPF_PIPE_SinkRequest request, int summary);
 static void _stop(void);
 static void _stringToBuffer(const char *text, RVPF_PIPE_Buffer buffer);
 static int _stringToInt(const char *string);
+static void _ticksToBuffer(long long ticks, RVPF_PIPE_Buffer buffer);
 
 // Public function definitions.
 
@@ -141,17 +249,19 @@ extern void rvpf_pipe_addEngineResult(
         rvpf_pipe_error("Missing time stamp");
     }
 
+    RVPF_PIPE_Arena arena = &request->control.arena;
     struct rvpf_pipe_pointValues *pointValues =
-        _alloc(sizeof(struct rvpf_pipe_pointValues));
+        _arenaAlloc(arena, sizeof(struct rvpf_pipe_pointValues));
     char *space;
 
-    pointValues->result.pointName = _cloneString(pointName);
-    pointValues->result.stamp = _cloneString(stamp);
+    pointValues->result.pointID =
+        _intern(pointName, &pointValues->result.pointName);
+    pointValues->result.stamp = _arenaString(arena, stamp);
     while ((space = strchr(pointValues->result.stamp, ' '))) {
         *space = 'T';
     }
-    pointValues->result.state = _cloneString(state);
-    pointValues->result.value = _cloneString(value);
+    pointValues->result.state = _arenaString(arena, state);
+    pointValues->result.value = _arenaString(arena, value);
 
     if (request->results.first) {
         request->results.last->next = pointValues;
@@ -162,27 +272,53 @@ extern void rvpf_pipe_addEngineResult(
     ++request->results.count;
 }
 
-extern void rvpf_pipe_clearEngineResults(RVPF_PIPE_EngineRequest request)
+extern void rvpf_pipe_addEngineResultDouble(
+    RVPF_PIPE_EngineRequest request,
+    const char *pointName,
+    long long stampTicks,
+    const char *state,
+    double value)
 {
     if (!request) {
         rvpf_pipe_fatal(_nullRequestMessage);
     }
-
-    if (request->result) {
-        _clearPointValue(request->result);
-        free(request->result);
-        request->result = NULL;
+    if (!pointName || !*pointName) {
+        rvpf_pipe_error("Missing point name");
     }
 
-    request->results.last = NULL;
-    while (request->results.first) {
-        struct rvpf_pipe_pointValues *results = request->results.first;
+    RVPF_PIPE_Arena arena = &request->control.arena;
+    struct rvpf_pipe_pointValues *pointValues =
+        _arenaAlloc(arena, sizeof(struct rvpf_pipe_pointValues));
+
+    pointValues->result.pointID =
+        _intern(pointName, &pointValues->result.pointName);
+    pointValues->result.state = _arenaString(arena, state);
+    pointValues->result.stampTicks = stampTicks;
+    pointValues->result.doubleValue = value;
+    pointValues->result.cached = CACHED_TYPED_STAMP | CACHED_STAMP
+        | CACHED_STAMP_VALID | CACHED_TYPED_DOUBLE | CACHED_DOUBLE
+        | CACHED_DOUBLE_VALID;
 
-        request->results.first = results->next;
-        results->next = NULL;
-        _clearPointValue(&results->result);
-        free(results);
+    if (request->results.first) {
+        request->results.last->next = pointValues;
+        request->results.last = pointValues;
+    } else {
+        request->results.last = request->results.first = pointValues;
+    }
+    ++request->results.count;
+}
+
+extern void rvpf_pipe_clearEngineResults(RVPF_PIPE_EngineRequest request)
+{
+    if (!request) {
+        rvpf_pipe_fatal(_nullRequestMessage);
     }
+
+    // The space stays in the request arena until the request ends.
+
+    request->result = NULL;
+    request->results.first = request->results.last = NULL;
+    request->results.count = 0;
 }
 
 extern void rvpf_pipe_debug(const char *format, ...)
@@ -200,40 +336,35 @@ extern void rvpf_pipe_endEngineRequest(RVPF_PIPE_EngineRequest request)
         rvpf_pipe_fatal(_nullRequestMessage);
     }
 
-    int summary;
+    pthread_mutex_lock(&_outputMutex);
+    _engineResponseToOutput(request);
+    _flushOutput();
+    pthread_mutex_unlock(&_outputMutex);
 
-    if (request->result) {
-        if (request->result->value || request->results.count) {
-            summary = 1 + request->results.count;
-        } else {
-            summary = 0;
+    _freeRequest(&request->control);
+}
+
+extern void rvpf_pipe_endEngineRequests(
+    RVPF_PIPE_EngineRequest *requests,
+    int count)
+{
+    for (int i = 0; i < count; ++i) {
+        if (!requests[i]) {
+            rvpf_pipe_fatal(_nullRequestMessage);
         }
-    } else if (request->results.count) {
-        summary = request->results.count;
-    } else {
-        summary = -1;
     }
 
-    _resetBuffer(&request->control.buffer);
-
-    _stringToBuffer(request->control.requestID, &request->control.buffer);
-    _stringToBuffer(" ", &request->control.buffer);
-    _intToBuffer(summary, &request->control.buffer);
-    _flushBuffer(&request->control.buffer);
-
-    if (summary > 0) {
-        for (struct rvpf_pipe_pointValues *next = request->results.first;
-                next; next = next->next) {
-            _pointValueToBuffer(&next->result, &request->control.buffer);
-            _flushBuffer(&request->control.buffer);
-        }
-        if (request->result) {
-            _pointValueToBuffer(request->result, &request->control.buffer);
-            _flushBuffer(&request->control.buffer);
-        }
+    pthread_mutex_lock(&_outputMutex);
+    for (int i = 0; i < count; ++i) {
+        _engineResponseToOutput(requests[i]);
     }
+    _flushOutput();
+    pthread_mutex_unlock(&_outputMutex);
 
-    _freeEngineRequest(request);
+    for (int i = 0; i < count; ++i) {
+        _freeRequest(&requests[i]->control);
+        requests[i] = NULL;
+    }
 }
 
 extern void rvpf_pipe_endSinkRequest(RVPF_PIPE_SinkRequest request, int summary)
@@ -242,14 +373,74 @@ extern void rvpf_pipe_endSinkRequest(RVPF_PIPE_SinkRequest request, int summary)
         rvpf_pipe_fatal(_nullRequestMessage);
     }
 
-    _resetBuffer(&request->control.buffer);
+    pthread_mutex_lock(&_outputMutex);
+    _sinkResponseToOutput(request, summary);
+    _flushOutput();
+    pthread_mutex_unlock(&_outputMutex);
 
-    _stringToBuffer(request->control.requestID, &request->control.buffer);
-    _stringToBuffer(" ", &request->control.buffer);
-    _intToBuffer(summary, &request->control.buffer);
-    _flushBuffer(&request->control.buffer);
+    _freeRequest(&request->control);
+}
+
+extern void rvpf_pipe_endSinkRequests(
+    RVPF_PIPE_SinkRequest *requests,
+    const int *summaries,
+    int count)
+{
+    RVPF_PIPE_SinkRequest *ordered;
+    int *orderedSummaries;
+    int total = 0;
+
+    for (int i = 0; i < count; ++i) {
+        if (!requests[i]) {
+            rvpf_pipe_fatal(_nullRequestMessage);
+        }
+        for (RVPF_PIPE_SinkRequest request = requests[i];
+                request; request = request->superseded) {
+            if (request->sequence >= total) {
+                total = request->sequence + 1;
+            }
+        }
+    }
+
+    // Puts back the coalesced requests in their place.
+
+    ordered = _alloc(sizeof(RVPF_PIPE_SinkRequest) * total);
+    orderedSummaries = _alloc(sizeof(int) * total);
+    for (int i = 0; i < count; ++i) {
+        RVPF_PIPE_SinkRequest request = requests[i];
+
+        int summary = summaries[i];
+
+        // The coalesced requests share the outcome of their replacement.
+
+        ordered[request->sequence] = request;
+        orderedSummaries[request->sequence] = summary;
+        for (request = request->superseded;
+                request; request = request->superseded) {
+            ordered[request->sequence] = request;
+            orderedSummaries[request->sequence] = summary;
+        }
+    }
+
+    pthread_mutex_lock(&_outputMutex);
+    for (int i = 0; i < total; ++i) {
+        if (!ordered[i]) {
+            rvpf_pipe_fatal("Incomplete sink requests batch");
+        }
+        _sinkResponseToOutput(ordered[i], orderedSummaries[i]);
+    }
+    _flushOutput();
+    pthread_mutex_unlock(&_outputMutex);
 
-    _freeSinkRequest(request);
+    for (int i = 0; i < total; ++i) {
+        _freeRequest(&ordered[i]->control);
+    }
+    for (int i = 0; i < count; ++i) {
+        requests[i] = NULL;
+    }
+
+    free(orderedSummaries);
+    free(ordered);
 }
 
 extern void rvpf_pipe_error(const char *format, ...)
@@ -274,6 +465,30 @@ extern void rvpf_pipe_fatal(const char *format, ...)
     longjmp(rvpf_pipe_jmp_buf, 1);
 }
 
+extern bool rvpf_pipe_getDoubleValue(
+    const RVPF_PIPE_PointValue pointValue,
+    double *value)
+{
+    if (!pointValue) {
+        rvpf_pipe_fatal(_nullPointValueMessage);
+    }
+
+    if (!(pointValue->cached & CACHED_DOUBLE)) {
+        if (pointValue->value
+                && _parseDouble(pointValue->value, &pointValue->doubleValue)) {
+            pointValue->cached |= CACHED_DOUBLE_VALID;
+        }
+        pointValue->cached |= CACHED_DOUBLE;
+    }
+
+    if (!(pointValue->cached & CACHED_DOUBLE_VALID)) {
+        return false;
+    }
+    *value = pointValue->doubleValue;
+
+    return true;
+}
+
 extern RVPF_PIPE_PointValue rvpf_pipe_getEngineInput(
     RVPF_PIPE_EngineRequest request,
     int position)
@@ -374,6 +589,54 @@ extern RVPF_PIPE_SinkRequestType rvpf_pipe_getSinkRequestType(
     return request->requestType;
 }
 
+extern bool rvpf_pipe_getLongValue(
+    const RVPF_PIPE_PointValue pointValue,
+    long long *value)
+{
+    if (!pointValue) {
+        rvpf_pipe_fatal(_nullPointValueMessage);
+    }
+
+    if (!(pointValue->cached & CACHED_LONG)) {
+        if (pointValue->value
+                && _parseLong(pointValue->value, &pointValue->longValue)) {
+            pointValue->cached |= CACHED_LONG_VALID;
+        }
+        pointValue->cached |= CACHED_LONG;
+    }
+
+    if (!(pointValue->cached & CACHED_LONG_VALID)) {
+        return false;
+    }
+    *value = pointValue->longValue;
+
+    return true;
+}
+
+extern const char *rvpf_pipe_getPointName(int pointID)
+{
+    const char *name = NULL;
+
+    pthread_mutex_lock(&_names.mutex);
+    if (pointID > 0 && pointID <= _names.count) {
+        name = _names.at[pointID - 1].name;
+    }
+    pthread_mutex_unlock(&_names.mutex);
+
+    return name;
+}
+
+extern int rvpf_pipe_getPointNamesCount(void)
+{
+    int count;
+
+    pthread_mutex_lock(&_names.mutex);
+    count = _names.count;
+    pthread_mutex_unlock(&_names.mutex);
+
+    return count;
+}
+
 extern void rvpf_pipe_info(const char *format, ...)
 {
     va_list ap;
@@ -383,115 +646,138 @@ extern void rvpf_pipe_info(const char *format, ...)
     va_end(ap);
 }
 
+extern int rvpf_pipe_internPointName(const char *pointName)
+{
+    char *interned;
+
+    if (!pointName || !*pointName) {
+        rvpf_pipe_error("Missing point name");
+    }
+
+    return _intern(pointName, &interned);
+}
+
 extern bool rvpf_pipe_isValueDeleted(const RVPF_PIPE_PointValue pointValue)
 {
     return pointValue && pointValue->state == _deletedState;
 }
 
-extern RVPF_PIPE_EngineRequest rvpf_pipe_nextEngineRequest(void)
+extern bool rvpf_pipe_getStampTicks(
+    const RVPF_PIPE_PointValue pointValue,
+    long long *stampTicks)
 {
-    RVPF_PIPE_EngineRequest request =
-        _alloc(sizeof(struct rvpf_pipe_engineRequest));
+    if (!pointValue) {
+        rvpf_pipe_fatal(_nullPointValueMessage);
+    }
 
-    request->control.buffer.capacity = INITIAL_CONTROL_BUFFER_CAPACITY;
-    request->control.buffer.at = _alloc(request->control.buffer.capacity);
+    if (!(pointValue->cached & CACHED_STAMP)) {
+        if (pointValue->stamp
+                && _parseStamp(pointValue->stamp, &pointValue->stampTicks)) {
+            pointValue->cached |= CACHED_STAMP_VALID;
+        }
+        pointValue->cached |= CACHED_STAMP;
+    }
 
-    if (!_firstLine(&request->control.buffer)) {
-        _freeEngineRequest(request);
-        _stop();
+    if (!(pointValue->cached & CACHED_STAMP_VALID)) {
+        return false;
     }
+    *stampTicks = pointValue->stampTicks;
 
-    request->control.requestID = _requestID(&request->control.buffer);
+    return true;
+}
 
-    request->control.version =
-        _stringToInt(_nextField(&request->control.buffer, true, false));
-    if (request->control.version > ENGINE_REQUEST_FORMAT_VERSION) {
-        rvpf_pipe_error(
-            "Unsupported request format version: %s",
-            request->control.version);
+extern RVPF_PIPE_EngineRequest rvpf_pipe_nextEngineRequest(void)
+{
+    RVPF_PIPE_EngineRequest request = _stopping? NULL: _readEngineRequest();
+
+    if (!request) {
+        _stop();
     }
-    request->transformParams.count =
-        _stringToInt(_nextField(&request->control.buffer, true, false));
-    request->pointParams.count =
-        _stringToInt(_nextField(&request->control.buffer, true, false));
-    request->inputs.count =
-        _stringToInt(_nextField(&request->control.buffer, true, false));
 
-    _nextLine(&request->control.buffer, true);
-    request->result = _alloc(sizeof(struct rvpf_pipe_pointValue));
-    _fillPointValue(request->result, &request->control.buffer, true);
+    return request;
+}
+
+extern int rvpf_pipe_nextEngineRequests(
+    RVPF_PIPE_EngineRequest *requests,
+    int limit)
+{
+    int count = 0;
 
-    if (request->transformParams.count) {
-        request->transformParams.at =
-            _alloc(sizeof(char *) * request->transformParams.count);
-        for (int i = 0; i < request->transformParams.count; ++i) {
-            request->transformParams.at[i] =
-                _cloneString(_nextLine(&request->control.buffer, true));
-        }
+    if (limit < 1) {
+        rvpf_pipe_fatal("Bad requests limit: %i", limit);
     }
 
-    if (request->pointParams.count) {
-        request->pointParams.at =
-            _alloc(sizeof(char *) * request->pointParams.count);
-        for (int i = 0; i < request->pointParams.count; ++i) {
-            request->pointParams.at[i] =
-                _cloneString(_nextLine(&request->control.buffer, true));
-        }
-    }
+    requests[count++] = rvpf_pipe_nextEngineRequest();
 
-    if (request->inputs.count) {
-        request->inputs.at =
-            _alloc(sizeof(struct rvpf_pipe_pointValue) * request->inputs.count);
-        for (int i = 0; i < request->inputs.count; ++i) {
-            _nextLine(&request->control.buffer, true);
-            _fillPointValue(
-                request->inputs.at + i,
-                &request->control.buffer,
-                false);
+    while (count < limit && _inputAvailable()) {
+        RVPF_PIPE_EngineRequest request = _readEngineRequest();
+
+        if (!request) {
+            _stopping = true; // Stops on the next call.
+            break;
         }
+        requests[count++] = request;
     }
 
-    return request;
+    return count;
 }
 
 extern RVPF_PIPE_SinkRequest rvpf_pipe_nextSinkRequest(void)
 {
-    RVPF_PIPE_SinkRequest request =
-        _alloc(sizeof(struct rvpf_pipe_sinkRequest));
-    char *field;
-
-    request->control.buffer.capacity = INITIAL_CONTROL_BUFFER_CAPACITY;
-    request->control.buffer.at = _alloc(request->control.buffer.capacity);
+    RVPF_PIPE_SinkRequest request = _stopping? NULL: _readSinkRequest();
 
-    if (!_firstLine(&request->control.buffer)) {
-        _freeSinkRequest(request);
+    if (!request) {
         _stop();
     }
 
-    request->control.requestID = _requestID(&request->control.buffer);
+    return request;
+}
 
-    request->control.version =
-        _stringToInt(_nextField(&request->control.buffer, true, false));
-    if (request->control.version > SINK_REQUEST_FORMAT_VERSION) {
-        rvpf_pipe_error(
-            "Unsupported request format version: %s",
-            request->control.version);
-    }
-    field = _nextField(&request->control.buffer, true, false);
-    if (!strcmp(field, SINK_UPDATE_REQUEST_TYPE)) {
-        request->requestType = RVPF_PIPE_SINK_UPDATE;
-    } else if (!strcmp(field, SINK_DELETE_REQUEST_TYPE)) {
-        request->requestType = RVPF_PIPE_SINK_DELETE;
-    } else {
-        rvpf_pipe_error("Unsupported request type '%s'", field);
+extern int rvpf_pipe_nextSinkRequests(
+    RVPF_PIPE_SinkRequest *requests,
+    int limit,
+    bool coalesce)
+{
+    int count = 0;
+    int sequence = 0;
+
+    if (limit < 1) {
+        rvpf_pipe_fatal("Bad requests limit: %i", limit);
     }
 
-    _nextLine(&request->control.buffer, true);
-    _fillPointValue(
-        &request->pointValue, &request->control.buffer,
-        request->requestType == RVPF_PIPE_SINK_UPDATE);
+    requests[count++] = rvpf_pipe_nextSinkRequest();
+    ++sequence;
 
-    return request;
+    while (sequence < limit && _inputAvailable()) {
+        RVPF_PIPE_SinkRequest request = _readSinkRequest();
+        int i;
+
+        if (!request) {
+            _stopping = true; // Stops on the next call.
+            break;
+        }
+        request->sequence = sequence++;
+
+        // A repeated point and stamp supersedes the previous request.
+
+        for (i = 0; coalesce && i < count; ++i) {
+            RVPF_PIPE_PointValue previous = &requests[i]->pointValue;
+
+            if (previous->pointID == request->pointValue.pointID
+                    && previous->stamp && request->pointValue.stamp
+                    && !strcmp(previous->stamp, request->pointValue.stamp)) {
+                break;
+            }
+        }
+        if (coalesce && i < count) {
+            request->superseded = requests[i];
+            requests[i] = request;
+        } else {
+            requests[count++] = request;
+        }
+    }
+
+    return count;
 }
 
 extern RVPF_PIPE_PointValue rvpf_pipe_getSinkPointValue(
@@ -504,31 +790,137 @@ extern RVPF_PIPE_PointValue rvpf_pipe_getSinkPointValue(
     return &request->pointValue;
 }
 
+extern void rvpf_pipe_runEngineWorkers(
+    int workers,
+    RVPF_PIPE_EngineCallback callback,
+    void *data)
+{
+    if (workers < 1) {
+        rvpf_pipe_fatal("Bad workers count: %i", workers);
+    }
+    if (!callback) {
+        rvpf_pipe_fatal("Missing engine callback!");
+    }
+
+    RVPF_PIPE_Pool pool = _alloc(sizeof(struct rvpf_pipe_pool));
+    pthread_t *threads = _alloc(sizeof(pthread_t) * workers);
+    pthread_t reader;
+    struct rvpf_pipe_poolSlot *slot;
+    bool ended;
+    int status;
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->space, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->capacity = (size_t) workers * POOL_SLOTS_PER_WORKER;
+    pool->slots = _alloc(sizeof(struct rvpf_pipe_poolSlot) * pool->capacity);
+    pool->callback = callback;
+    pool->data = data;
+
+    for (int i = 0; i < workers; ++i) {
+        if (pthread_create(threads + i, NULL, _poolWorker, pool)) {
+            rvpf_pipe_fatal("Failed to start a worker thread!");
+        }
+    }
+    if (pthread_create(&reader, NULL, _poolReader, pool)) {
+        rvpf_pipe_fatal("Failed to start the reader thread!");
+    }
+
+    // Writes the responses in the requests order.
+
+    pthread_mutex_lock(&pool->mutex);
+    while (true) {
+        if (pool->written == pool->queued) {
+            if (pool->ended) {
+                status = pool->status;
+                break;
+            }
+            pthread_cond_wait(&pool->done, &pool->mutex);
+            continue;
+        }
+
+        slot = pool->slots + pool->written % pool->capacity;
+        if (!slot->done) {
+            pthread_cond_wait(&pool->done, &pool->mutex);
+            continue;
+        }
+        if (slot->status != RVPF_PIPE_STATUS_OK) {
+            status = slot->status;
+            pool->aborted = true;
+            pthread_cond_broadcast(&pool->work);
+            pthread_cond_signal(&pool->space);
+            break;
+        }
+        pthread_mutex_unlock(&pool->mutex);
+
+        rvpf_pipe_endEngineRequest(slot->request);
+
+        pthread_mutex_lock(&pool->mutex);
+        slot->request = NULL;
+        ++pool->written;
+        pthread_cond_signal(&pool->space);
+    }
+    ended = pool->ended;
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < workers; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+
+    // On abort, the reader may be waiting for input.
+
+    if (!ended) {
+        pthread_cancel(reader);
+    }
+    pthread_join(reader, NULL);
+
+    for (size_t i = 0; i < pool->capacity; ++i) {
+        if (pool->slots[i].request) {
+            _freeRequest(&pool->slots[i].request->control);
+        }
+    }
+    free(pool->slots);
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->space);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool);
+
+    if (status == RVPF_PIPE_STATUS_OK) {
+        _stop();
+    }
+    rvpf_pipe_status = status;
+    longjmp(rvpf_pipe_jmp_buf, 1);
+}
+
 extern void rvpf_pipe_setLogLevel(int level)
 {
 	rvpf_log_setLevel(level);
 }
 
-extern void rvpf_pipe_setEngineResultState(
+extern void rvpf_pipe_setEngineResultDouble(
     RVPF_PIPE_EngineRequest request,
-    const char *state)
+    double value)
 {
     if (!request) {
         rvpf_pipe_fatal(_nullRequestMessage);
     }
     if (!request->result) {
-        rvpf_pipe_error("Can't set the state of a cleared result!");
+        rvpf_pipe_error("Can't set the value of a cleared result!");
     }
 
-    if (request->result->state) {
-        free(request->result->state);
-    }
-    request->result->state = _cloneString(state);
+    request->result->value = NULL;
+    request->result->doubleValue = value;
+    request->result->cached &= CACHED_STAMP | CACHED_STAMP_VALID;
+    request->result->cached |=
+        CACHED_TYPED_DOUBLE | CACHED_DOUBLE | CACHED_DOUBLE_VALID;
 }
 
-extern void rvpf_pipe_setEngineResultValue(
+extern void rvpf_pipe_setEngineResultLong(
     RVPF_PIPE_EngineRequest request,
-    const char *value)
+    long long value)
 {
     if (!request) {
         rvpf_pipe_fatal(_nullRequestMessage);
@@ -537,22 +929,55 @@ extern void rvpf_pipe_setEngineResultValue(
         rvpf_pipe_error("Can't set the value of a cleared result!");
     }
 
-    if (request->result->value) {
-        free(request->result->value);
-    }
-    request->result->value = _cloneString(value);
+    request->result->value = NULL;
+    request->result->longValue = value;
+    request->result->doubleValue = (double) value;
+    request->result->cached &= CACHED_STAMP | CACHED_STAMP_VALID;
+    request->result->cached |= CACHED_TYPED_LONG | CACHED_LONG
+        | CACHED_LONG_VALID | CACHED_DOUBLE | CACHED_DOUBLE_VALID;
 }
 
-extern void rvpf_pipe_trace(const char *format, ...)
+extern void rvpf_pipe_setEngineResultState(
+    RVPF_PIPE_EngineRequest request,
+    const char *state)
 {
-    va_list ap;
+    if (!request) {
+        rvpf_pipe_fatal(_nullRequestMessage);
+    }
+    if (!request->result) {
+        rvpf_pipe_error("Can't set the state of a cleared result!");
+    }
 
-    va_start(ap, format);
-    rvpf_log(RVPF_LOG_LEVEL_TRACE, format, ap);
-    va_end(ap);
+    request->result->state = _arenaString(&request->control.arena, state);
 }
 
-extern char *rvpf_pipe_version(void)
+extern void rvpf_pipe_setEngineResultValue(
+    RVPF_PIPE_EngineRequest request,
+    const char *value)
+{
+    if (!request) {
+        rvpf_pipe_fatal(_nullRequestMessage);
+    }
+    if (!request->result) {
+        rvpf_pipe_error("Can't set the value of a cleared result!");
+    }
+
+    request->result->value = _arenaString(&request->control.arena, value);
+    request->result->cached &= CACHED_STAMP | CACHED_STAMP_VALID;
+}
+
+extern void rvpf_pipe_trace(const char *format, ...)
+{
+    if (RVPF_LOG_TRACE_ENABLED()) {
+        va_list ap;
+
+        va_start(ap, format);
+        rvpf_log(RVPF_LOG_LEVEL_TRACE, format, ap);
+        va_end(ap);
+    }
+}
+
+extern char *rvpf_pipe_version(void)
 {
 	rvpf_log_setLevel(-RVPF_LOG_LEVEL_TRACE);
 
@@ -581,54 +1006,182 @@ static void *_alloc(size_t size)
     return memory;
 }
 
-static void _charToBuffer(char c, RVPF_PIPE_Buffer buffer)
+static void _awaitInput(void)
 {
-    _expandBuffer(buffer, 2);
-    buffer->at[buffer->limit++] = c;
-    buffer->at[buffer->limit] = '\0';
+    // A cancellation point for the pool reader.
+
+#ifndef _WIN32
+    if (_input.position < _input.limit) {
+        return;
+    }
+
+    struct pollfd pollfd = {0, POLLIN, 0};
+    int cancelState;
+
+    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &cancelState);
+    while (poll(&pollfd, 1, -1) < 0 && errno == EINTR) {
+        pthread_testcancel();
+    }
+    pthread_setcancelstate(cancelState, NULL);
+#endif
 }
 
-static void _clearControl(RVPF_PIPE_Request control)
+static void *_arenaAlloc(RVPF_PIPE_Arena arena, size_t size)
 {
-    if (control->requestID) {
-        free(control->requestID);
-        control->requestID = NULL;
-    }
+    struct rvpf_pipe_arenaBlock *block = arena->blocks;
+    void *memory;
+
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t) (ARENA_ALIGNMENT - 1);
 
-    if (control->buffer.at) {
-        free(control->buffer.at);
-        control->buffer.at = NULL;
+    if (!block || size > block->capacity - block->used) {
+        size_t capacity = size > ARENA_BLOCK_SIZE - ARENA_HEADER_SIZE?
+            size: ARENA_BLOCK_SIZE - ARENA_HEADER_SIZE;
+
+        block = _alloc(ARENA_HEADER_SIZE + capacity);
+        block->capacity = capacity;
+        block->next = arena->blocks;
+        arena->blocks = block;
     }
+
+    memory = (char *) block + ARENA_HEADER_SIZE + block->used;
+    block->used += size;
+
+    return memory;
 }
 
-static void _clearPointValue(RVPF_PIPE_PointValue pointValue)
+static char *_arenaString(RVPF_PIPE_Arena arena, const char *string)
 {
-    if (pointValue->pointName) {
-        free(pointValue->pointName);
-        pointValue->pointName = NULL;
+    if (string == NULL) {
+        return NULL;
     }
 
-    if (pointValue->stamp) {
-        free(pointValue->stamp);
-        pointValue->stamp = NULL;
+    size_t size = strlen(string) + 1;
+
+    return memcpy(_arenaAlloc(arena, size), string, size);
+}
+
+static void _bufferToOutput(RVPF_PIPE_Buffer buffer)
+{
+    if (RVPF_LOG_TRACE_ENABLED()) {
+        rvpf_log_trace("Sent: {%s}", buffer->at);
     }
 
-    if (pointValue->state) {
-        if (pointValue->state != _deletedState) {
-            free(pointValue->state);
+    _expandBuffer(&_output, buffer->limit + 2);
+    memcpy(_output.at + _output.limit, buffer->at, buffer->limit);
+    _output.limit += buffer->limit;
+    _output.at[_output.limit++] = '\n';
+    _output.at[_output.limit] = '\0';
+
+    _resetBuffer(buffer);
+}
+
+static void _charToBuffer(char c, RVPF_PIPE_Buffer buffer)
+{
+    _expandBuffer(buffer, 2);
+    buffer->at[buffer->limit++] = c;
+    buffer->at[buffer->limit] = '\0';
+}
+
+static void _doubleToBuffer(double value, RVPF_PIPE_Buffer buffer)
+{
+    char digits[32];
+
+    // Fast path: a fixed point text which converts back exactly.
+
+    if (isfinite(value)) {
+        double scale = 1.0;
+
+        for (int decimals = 0; decimals <= DOUBLE_FIXED_DECIMALS; ++decimals) {
+            double scaled = value * scale;
+
+            if (fabs(scaled) >= DOUBLE_FIXED_UNITS_LIMIT) break;
+
+            long long units = llrint(scaled);
+
+            if ((double) units / scale == value) {
+                unsigned long long magnitude =
+                    units < 0? -(unsigned long long) units: units;
+                char *next = digits + sizeof(digits);
+                int position = 0;
+
+                *--next = '\0';
+                if (!decimals) {
+                    *--next = '0';
+                    *--next = '.';
+                }
+                do {
+                    *--next = '0' + magnitude % 10;
+                    magnitude /= 10;
+                    if (++position == decimals) {
+                        *--next = '.';
+                        if (!magnitude) *--next = '0';
+                    }
+                } while (magnitude || position < decimals);
+                if (signbit(value)) *--next = '-';
+
+                _stringToBuffer(next, buffer);
+                return;
+            }
+            scale *= 10.0;
         }
-        pointValue->state = NULL;
     }
 
-    if (pointValue->value) {
-        free(pointValue->value);
-        pointValue->value = NULL;
+    // Java spells the special values.
+
+    if (isnan(value)) {
+        _stringToBuffer("NaN", buffer);
+        return;
+    }
+    if (isinf(value)) {
+        _stringToBuffer(value < 0? "-Infinity": "Infinity", buffer);
+        return;
     }
+
+    // Otherwise, the shortest of the usual precisions which round trips.
+
+    snprintf(digits, sizeof(digits), "%.15g", value);
+    if (strtod(digits, NULL) != value) {
+        snprintf(digits, sizeof(digits), "%.17g", value);
+    }
+    _stringToBuffer(digits, buffer);
 }
 
-static char *_cloneString(const char *string)
+static void _engineResponseToOutput(RVPF_PIPE_EngineRequest request)
 {
-    return string != NULL? strcpy(_alloc(strlen(string) + 1), string): NULL;
+    int summary;
+
+    if (request->result) {
+        if (request->result->value
+                || (request->result->cached & CACHED_TYPED_VALUE)
+                || request->results.count) {
+            summary = 1 + request->results.count;
+        } else {
+            summary = 0;
+        }
+    } else if (request->results.count) {
+        summary = request->results.count;
+    } else {
+        summary = -1;
+    }
+
+    _resetBuffer(&request->control.buffer);
+
+    _stringToBuffer(request->control.requestID, &request->control.buffer);
+    _stringToBuffer(" ", &request->control.buffer);
+    _intToBuffer(summary, &request->control.buffer);
+    _bufferToOutput(&request->control.buffer);
+
+    if (summary > 0) {
+        for (struct rvpf_pipe_pointValues *next = request->results.first;
+                next; next = next->next) {
+            _pointValueToBuffer(&next->result, &request->control.buffer);
+            _bufferToOutput(&request->control.buffer);
+        }
+        if (request->result) {
+            _pointValueToBuffer(request->result, &request->control.buffer);
+            _bufferToOutput(&request->control.buffer);
+        }
+    }
 }
 
 static void _expandBuffer(RVPF_PIPE_Buffer buffer, size_t size)
@@ -647,15 +1200,17 @@ static void _expandBuffer(RVPF_PIPE_Buffer buffer, size_t size)
 static void _fillPointValue(
     RVPF_PIPE_PointValue pointValue,
     RVPF_PIPE_Buffer buffer,
-    bool stampRequired)
+    bool stampRequired,
+    RVPF_PIPE_Arena arena)
 {
     char *field;
 
-    pointValue->pointName = _cloneString(_nextField(buffer, true, false));
+    pointValue->pointID =
+        _intern(_nextField(buffer, true, false), &pointValue->pointName);
 
     field = _nextField(buffer, stampRequired, false);
     if (field) {
-        pointValue->stamp = _cloneString(field);
+        pointValue->stamp = _arenaString(arena, field);
         field = _nextField(buffer, false, true);
     }
 
@@ -702,7 +1257,7 @@ static void _fillPointValue(
 
             ++next;
         }
-        pointValue->state = _cloneString(start);
+        pointValue->state = _arenaString(arena, start);
         field = next;
     }
 
@@ -739,11 +1294,8 @@ static void _fillPointValue(
 
                 ++next;
             }
-            pointValue->value = _cloneString(start);
+            pointValue->value = _arenaString(arena, start);
         } else if (*field == '-') {
-            if (pointValue->state) {
-                free(pointValue->state);
-            }
             pointValue->state = (char *) _deletedState;
         }
     }
@@ -769,56 +1321,128 @@ static char *_firstLine(RVPF_PIPE_Buffer buffer)
 
 static void _flushBuffer(RVPF_PIPE_Buffer buffer)
 {
-    fputs(buffer->at, stdout);
-    fputs("\n", stdout);
-    fflush(stdout);
-
-    rvpf_log_trace("Sent: {%s}", buffer->at);
-    _resetBuffer(buffer);
+    pthread_mutex_lock(&_outputMutex);
+    _bufferToOutput(buffer);
+    _flushOutput();
+    pthread_mutex_unlock(&_outputMutex);
 }
 
-static void _freeEngineRequest(RVPF_PIPE_EngineRequest request)
+static void _flushOutput(void)
 {
-    if (request->transformParams.at) {
-        for (int i = 0; i < request->transformParams.count; ++i) {
-            free(request->transformParams.at[i]);
-            request->transformParams.at[i] = NULL;
-        }
-        free(request->transformParams.at);
-        request->transformParams.at = NULL;
+    if (_output.limit) {
+        fwrite(_output.at, 1, _output.limit, stdout);
+        fflush(stdout);
+        _resetBuffer(&_output);
     }
+}
 
-    if (request->pointParams.at) {
-        for (int i = 0; i < request->pointParams.count; ++i) {
-            free(request->pointParams.at[i]);
-            request->pointParams.at[i] = NULL;
-        }
-        free(request->pointParams.at);
-        request->pointParams.at = NULL;
+static void _freeRequest(RVPF_PIPE_Request control)
+{
+    struct rvpf_pipe_arenaBlock *block = control->arena.blocks;
+
+    free(control->buffer.at);
+
+    // The control itself lives in the last block.
+
+    while (block) {
+        struct rvpf_pipe_arenaBlock *next = block->next;
+
+        free(block);
+        block = next;
     }
+}
 
-    if (request->inputs.at) {
-        for (int i = 0; i < request->inputs.count; ++i) {
-            _clearPointValue(request->inputs.at + i);
-        }
-        free(request->inputs.at);
-        request->inputs.at = NULL;
+static bool _inputAvailable(void)
+{
+    if (_input.position < _input.limit) {
+        return true;
     }
 
-    rvpf_pipe_clearEngineResults(request);
+#ifdef _WIN32
+    return false;
+#else
+    struct pollfd pollfd = {0, POLLIN, 0};
+    int ready;
 
-    _clearControl(&request->control);
+    do {
+        ready = poll(&pollfd, 1, 0);
+    } while (ready < 0 && errno == EINTR);
 
-    free(request);
+    return ready > 0;
+#endif
 }
 
-static void _freeSinkRequest(RVPF_PIPE_SinkRequest request)
+static int _intern(const char *name, char **interned)
 {
-    _clearPointValue(&request->pointValue);
+    // The names table lives as long as the process.
+
+    size_t length = strlen(name);
+    size_t hash = 2166136261u;
+    size_t slot;
+    int id;
+
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash ^ (unsigned char) name[i]) * 16777619u;
+    }
+
+    pthread_mutex_lock(&_names.mutex);
+
+    if (_names.slots) {
+        for (slot = hash & _names.mask; (id = _names.slots[slot]); ) {
+            struct rvpf_pipe_name *entry = _names.at + id - 1;
+
+            if (entry->hash == hash && !strcmp(entry->name, name)) {
+                *interned = entry->name;
+                pthread_mutex_unlock(&_names.mutex);
+                return id;
+            }
+            slot = (slot + 1) & _names.mask;
+        }
+    }
+
+    if (_names.count == _names.capacity) {
+        int capacity = _names.capacity?
+            _names.capacity * 2: INITIAL_NAMES_CAPACITY;
+        struct rvpf_pipe_name *at =
+            realloc(_names.at, sizeof(struct rvpf_pipe_name) * capacity);
+        int *slots = calloc(capacity * 2, sizeof(int));
+
+        if (at == NULL || slots == NULL) {
+            pthread_mutex_unlock(&_names.mutex);
+            rvpf_pipe_fatal("Failed to grow the names table!");
+        }
+
+        // Keeps the slots at most half full.
+
+        free(_names.slots);
+        _names.at = at;
+        _names.capacity = capacity;
+        _names.slots = slots;
+        _names.mask = capacity * 2 - 1;
+        for (int i = 0; i < _names.count; ++i) {
+            slot = _names.at[i].hash & _names.mask;
+            while (_names.slots[slot]) {
+                slot = (slot + 1) & _names.mask;
+            }
+            _names.slots[slot] = i + 1;
+        }
+        for (slot = hash & _names.mask; _names.slots[slot]; ) {
+            slot = (slot + 1) & _names.mask;
+        }
+    }
 
-    _clearControl(&request->control);
+    struct rvpf_pipe_name *entry = _names.at + _names.count;
 
-    free(request);
+    entry->name = memcpy(
+        _arenaAlloc(&_names.arena, length + 1), name, length + 1);
+    entry->hash = hash;
+    id = ++_names.count;
+    _names.slots[slot] = id;
+    *interned = entry->name;
+
+    pthread_mutex_unlock(&_names.mutex);
+
+    return id;
 }
 
 static void _intToBuffer(int value, RVPF_PIPE_Buffer buffer)
@@ -830,6 +1454,25 @@ static void _intToBuffer(int value, RVPF_PIPE_Buffer buffer)
     _stringToBuffer(digits, buffer);
 }
 
+static void _longToBuffer(long long value, RVPF_PIPE_Buffer buffer)
+{
+    char digits[24];
+
+    snprintf(digits, sizeof(digits), "%lli", value);
+
+    _stringToBuffer(digits, buffer);
+}
+
+static void *_newRequest(size_t size)
+{
+    struct rvpf_pipe_arena arena = {NULL};
+    RVPF_PIPE_Request control = _arenaAlloc(&arena, size);
+
+    control->arena = arena;
+
+    return control;
+}
+
 static char *_nextField(RVPF_PIPE_Buffer buffer, bool required, bool last)
 {
     if (buffer->position >= buffer->limit) {
@@ -852,7 +1495,7 @@ static char *_nextField(RVPF_PIPE_Buffer buffer, bool required, bool last)
             buffer->at[buffer->position] = '\0';
         }
     }
-    if (rvpf_log_getLevel() >= RVPF_LOG_LEVEL_ALL) {
+    if (RVPF_LOG_UNLIKELY(RVPF_LOG_ENABLED(RVPF_LOG_LEVEL_ALL))) {
         rvpf_log_trace("Field: {%s}", buffer->at + buffer->mark);
     }
 
@@ -861,43 +1504,231 @@ static char *_nextField(RVPF_PIPE_Buffer buffer, bool required, bool last)
 
 static char *_nextLine(RVPF_PIPE_Buffer buffer, bool required)
 {
+    // The line is a view into the input buffer, valid until the next call.
+
     _resetBuffer(buffer);
+    buffer->at = NULL;
 
     while (true) {
-        int next = fgetc(stdin);
+        char *start = _input.at + _input.position;
+        char *end = _input.position < _input.limit?
+            memchr(start, '\n', _input.limit - _input.position): NULL;
+
+        if (!end) {
+            if (_readInput()) {
+                continue;
+            }
 
-        if (next == EOF) {
-            if (buffer->limit) {
-                rvpf_pipe_warn("Lost characters at end of input");
-                buffer->limit = 0;
+            while (_input.position < _input.limit) {
+                if (!isspace((unsigned char) _input.at[_input.position++])) {
+                    rvpf_pipe_warn("Lost characters at end of input");
+                    break;
+                }
             }
+            _input.position = _input.limit;
             if (required) {
                 rvpf_pipe_error("Unexpected end of input");
             }
             return NULL;
         }
 
-        if (next == '\n') {
-            while (buffer->limit && isspace((unsigned char) buffer->at[buffer->limit - 1])) {
-                --buffer->limit; // Drops trailing spaces.
+        _input.position = end + 1 - _input.at;
+
+        if (memchr(start, '\r', end - start)) {
+            char *next = start;
+            char *stop = start;
+
+            while (next != end) {
+                if (*next != '\r') {
+                    *stop++ = *next;
+                }
+                ++next;
             }
-            if (buffer->limit) {
+            end = stop;
+        }
+        while (start != end && isspace((unsigned char) *start)) {
+            ++start; // Drops leading spaces.
+        }
+        while (end != start && isspace((unsigned char) end[-1])) {
+            --end; // Drops trailing spaces.
+        }
+        if (start != end) {
+            *end = '\0';
+            buffer->at = start;
+            buffer->limit = end - start;
+            break;
+        }
+    }
+    if (RVPF_LOG_TRACE_ENABLED()) {
+        rvpf_log_trace("Received: {%s}", buffer->at);
+    }
+
+    return buffer->at;
+}
+
+static bool _parseDouble(const char *text, double *value)
+{
+    // Fast path: a plain decimal text with an exact mantissa.
+
+    const char *next = text;
+    unsigned long long mantissa = 0;
+    int decimals = 0;
+    bool negative = false;
+    bool digits = false;
+    bool exact = true;
+
+    if (*next == '-' || *next == '+') {
+        negative = *next++ == '-';
+    }
+    for (bool point = false; ; ++next) {
+        if (isdigit((unsigned char) *next)) {
+            if (mantissa >= 100000000000000ULL) {
+                exact = false;
                 break;
             }
-            continue;
+            mantissa = mantissa * 10 + (*next - '0');
+            if (point) ++decimals;
+            digits = true;
+        } else if (*next == '.' && !point) {
+            point = true;
+        } else break;
+    }
+    if (exact && digits && !*next
+            && decimals < sizeof(_powersOf10) / sizeof(_powersOf10[0])) {
+        double result = (double) mantissa / _powersOf10[decimals];
+
+        *value = negative? -result: result;
+        return true;
+    }
+
+    char *end;
+
+    *value = strtod(text, &end);
+    if (end == text) {
+        return false;
+    }
+    while (isspace((unsigned char) *end)) {
+        ++end;
+    }
+
+    return !*end;
+}
+
+static bool _parseLong(const char *text, long long *value)
+{
+    const char *next = text;
+    unsigned long long magnitude = 0;
+    bool negative = false;
+
+    while (isspace((unsigned char) *next)) {
+        ++next;
+    }
+    if (*next == '-' || *next == '+') {
+        negative = *next++ == '-';
+    }
+    if (!isdigit((unsigned char) *next)) {
+        return false;
+    }
+    while (isdigit((unsigned char) *next)) {
+        unsigned digit = *next++ - '0';
+
+        if (magnitude > (9223372036854775808ULL - digit) / 10) {
+            return false;
         }
+        magnitude = magnitude * 10 + digit;
+    }
+    while (isspace((unsigned char) *next)) {
+        ++next;
+    }
+    if (*next || (!negative && magnitude > 9223372036854775807ULL)) {
+        return false;
+    }
+
+    *value = negative? (long long) -magnitude: (long long) magnitude;
 
-        if (next != '\r') {
-            if (buffer->limit || !isspace(next)) {
-                _expandBuffer(buffer, 2); // Includes the final nul.
-                buffer->at[buffer->limit++] = next;
+    return true;
+}
+
+static bool _parseStamp(const char *stamp, long long *ticks)
+{
+    // Accepts stamps like "2019-01-01T04:00:00.0000000-05:00"; the stamps
+    // without a time zone are left to the engine.
+
+    int year, month, day, hour, minute;
+    int second = 0;
+    int offset = 0;
+    long long fraction = 0;
+    long long days;
+    long long scale = RAW_PER_SECOND / 10;
+    int count = 0;
+    const char *next;
+
+    if (sscanf(stamp, "%5d-%2d-%2d%*1[T ]%2d:%2d%n",
+            &year, &month, &day, &hour, &minute, &count) < 5 || !count) {
+        return false;
+    }
+    next = stamp + count;
+    if (*next == ':') {
+        if (!isdigit((unsigned char) next[1])
+                || !isdigit((unsigned char) next[2])) {
+            return false;
+        }
+        second = (next[1] - '0') * 10 + next[2] - '0';
+        next += 3;
+        if (*next == '.' || *next == ',') {
+            ++next;
+            while (isdigit((unsigned char) *next)) {
+                fraction += (*next - '0') * scale;
+                scale /= 10;
+                ++next;
             }
         }
     }
-    buffer->at[buffer->limit] = '\0';
-    rvpf_log_trace("Received: {%s}", buffer->at);
+    if (*next == 'Z' || *next == 'z') {
+        ++next;
+    } else if (*next == '+' || *next == '-') {
+        int sign = *next++ == '-'? -1: 1;
+        int hours, minutes = 0;
+
+        if (!isdigit((unsigned char) next[0])
+                || !isdigit((unsigned char) next[1])) {
+            return false;
+        }
+        hours = (next[0] - '0') * 10 + next[1] - '0';
+        next += 2;
+        if (*next == ':') ++next;
+        if (isdigit((unsigned char) next[0])
+                && isdigit((unsigned char) next[1])) {
+            minutes = (next[0] - '0') * 10 + next[1] - '0';
+            next += 2;
+        }
+        offset = sign * (hours * 60 + minutes);
+    } else {
+        return false;
+    }
+    if (*next || month < 1 || month > 12 || day < 1 || day > 31
+            || hour > 23 || minute > 59 || second > 59) {
+        return false;
+    }
 
-    return buffer->at;
+    // Days since the Unix epoch in the proleptic Gregorian calendar.
+
+    if (month <= 2) --year;
+    {
+        long long era = (year >= 0? year: year - 399) / 400;
+        long long yearOfEra = year - era * 400;
+        long long dayOfYear =
+            (153 * (month > 2? month - 3: month + 9) + 2) / 5 + day - 1;
+        long long dayOfEra =
+            yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+        days = era * 146097 + dayOfEra - 719468;
+    }
+
+    *ticks = ((days * 24 + hour) * 60 + minute - offset) * 60 + second;
+    *ticks = *ticks * RAW_PER_SECOND + fraction + UNIX_EPOCH_RAW;
+
+    return true;
 }
 
 static void _pointValueToBuffer(
@@ -906,7 +1737,11 @@ static void _pointValueToBuffer(
 {
     _stringToBuffer(pointValue->pointName, buffer);
     _charToBuffer(' ', buffer);
-    _stringToBuffer(pointValue->stamp, buffer);
+    if (pointValue->cached & CACHED_TYPED_STAMP) {
+        _ticksToBuffer(pointValue->stampTicks, buffer);
+    } else {
+        _stringToBuffer(pointValue->stamp, buffer);
+    }
 
     if (pointValue->state) {
         size_t length = strlen(pointValue->state);
@@ -933,14 +1768,254 @@ static void _pointValueToBuffer(
             _charToBuffer(c, buffer);
         }
         _charToBuffer('"', buffer);
+    } else if (pointValue->cached & CACHED_TYPED_VALUE) {
+        _stringToBuffer(" \"", buffer);
+        if (pointValue->cached & CACHED_TYPED_LONG) {
+            _longToBuffer(pointValue->longValue, buffer);
+        } else {
+            _doubleToBuffer(pointValue->doubleValue, buffer);
+        }
+        _charToBuffer('"', buffer);
+    }
+}
+
+static RVPF_PIPE_EngineRequest _readEngineRequest(void)
+{
+    RVPF_PIPE_EngineRequest request =
+        _newRequest(sizeof(struct rvpf_pipe_engineRequest));
+    RVPF_PIPE_Arena arena = &request->control.arena;
+
+    request->control.buffer.capacity = INITIAL_CONTROL_BUFFER_CAPACITY;
+    request->control.buffer.at = _alloc(request->control.buffer.capacity);
+
+    if (!_firstLine(&request->control.line)) {
+        _freeRequest(&request->control);
+        return NULL;
+    }
+
+    request->control.requestID = _requestID(&request->control.line, arena);
+
+    request->control.version =
+        _stringToInt(_nextField(&request->control.line, true, false));
+    if (request->control.version > ENGINE_REQUEST_FORMAT_VERSION) {
+        rvpf_pipe_error(
+            "Unsupported request format version: %i",
+            request->control.version);
+    }
+    request->transformParams.count =
+        _stringToInt(_nextField(&request->control.line, true, false));
+    request->pointParams.count =
+        _stringToInt(_nextField(&request->control.line, true, false));
+    request->inputs.count =
+        _stringToInt(_nextField(&request->control.line, true, false));
+
+    _nextLine(&request->control.line, true);
+    request->result = _arenaAlloc(arena, sizeof(struct rvpf_pipe_pointValue));
+    _fillPointValue(request->result, &request->control.line, true, arena);
+
+    if (request->transformParams.count) {
+        request->transformParams.at =
+            _arenaAlloc(arena, sizeof(char *) * request->transformParams.count);
+        for (int i = 0; i < request->transformParams.count; ++i) {
+            request->transformParams.at[i] = _arenaString(
+                arena, _nextLine(&request->control.line, true));
+        }
+    }
+
+    if (request->pointParams.count) {
+        request->pointParams.at =
+            _arenaAlloc(arena, sizeof(char *) * request->pointParams.count);
+        for (int i = 0; i < request->pointParams.count; ++i) {
+            request->pointParams.at[i] = _arenaString(
+                arena, _nextLine(&request->control.line, true));
+        }
+    }
+
+    if (request->inputs.count) {
+        request->inputs.at = _arenaAlloc(
+            arena, sizeof(struct rvpf_pipe_pointValue) * request->inputs.count);
+        for (int i = 0; i < request->inputs.count; ++i) {
+            _nextLine(&request->control.line, true);
+            _fillPointValue(
+                request->inputs.at + i,
+                &request->control.line,
+                false,
+                arena);
+        }
+    }
+
+    return request;
+}
+
+static int _poolCall(RVPF_PIPE_Pool pool, RVPF_PIPE_EngineRequest request)
+{
+    if (setjmp(rvpf_pipe_jmp_buf)) {
+        return rvpf_pipe_status;
+    }
+
+    pool->callback(request, pool->data);
+
+    return RVPF_PIPE_STATUS_OK;
+}
+
+static void *_poolReader(void *argument)
+{
+    RVPF_PIPE_Pool pool = argument;
+    RVPF_PIPE_EngineRequest request;
+
+    // Only cancelled between requests, while awaiting input.
+
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+
+    if (setjmp(rvpf_pipe_jmp_buf)) {
+        pthread_mutex_lock(&pool->mutex);
+        pool->status = rvpf_pipe_status;
+        pool->ended = true;
+        pthread_cond_broadcast(&pool->work);
+        pthread_cond_signal(&pool->done);
+        pthread_mutex_unlock(&pool->mutex);
+
+        return NULL;
+    }
+
+    while (true) {
+        _awaitInput();
+        request = rvpf_pipe_nextEngineRequest();
+
+        pthread_mutex_lock(&pool->mutex);
+        while (pool->queued - pool->written >= pool->capacity
+                && !pool->aborted) {
+            pthread_cond_wait(&pool->space, &pool->mutex);
+        }
+        if (pool->aborted) {
+            pthread_mutex_unlock(&pool->mutex);
+            _freeRequest(&request->control);
+            break;
+        }
+
+        struct rvpf_pipe_poolSlot *slot =
+            pool->slots + pool->queued % pool->capacity;
+
+        slot->request = request;
+        slot->done = false;
+        ++pool->queued;
+        pthread_cond_signal(&pool->work);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    return NULL;
+}
+
+static void *_poolWorker(void *argument)
+{
+    RVPF_PIPE_Pool pool = argument;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (true) {
+        if (pool->aborted) break;
+        if (pool->taken == pool->queued) {
+            if (pool->ended) break;
+            pthread_cond_wait(&pool->work, &pool->mutex);
+            continue;
+        }
+
+        struct rvpf_pipe_poolSlot *slot =
+            pool->slots + pool->taken++ % pool->capacity;
+
+        pthread_mutex_unlock(&pool->mutex);
+
+        int status = _poolCall(pool, slot->request);
+
+        pthread_mutex_lock(&pool->mutex);
+        slot->status = status;
+        slot->done = true;
+        pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+static bool _readInput(void)
+{
+    ssize_t count;
+
+    if (_input.position) {
+        _input.limit -= _input.position;
+        memmove(_input.at, _input.at + _input.position, _input.limit);
+        _input.position = 0;
+    }
+
+    if (_input.limit == _input.capacity) {
+        size_t capacity = _input.capacity?
+            _input.capacity * 2: INITIAL_INPUT_BUFFER_CAPACITY;
+        char *at = realloc(_input.at, capacity);
+
+        if (at == NULL) {
+            rvpf_pipe_fatal("Failed to allocate %s bytes!", capacity);
+        }
+        _input.at = at;
+        _input.capacity = capacity;
+    }
+
+    do {
+        count = read(0, _input.at + _input.limit, _input.capacity - _input.limit);
+    } while (count < 0 && errno == EINTR);
+
+    if (count <= 0) {
+        return false;
+    }
+    _input.limit += count;
+
+    return true;
+}
+
+static RVPF_PIPE_SinkRequest _readSinkRequest(void)
+{
+    RVPF_PIPE_SinkRequest request =
+        _newRequest(sizeof(struct rvpf_pipe_sinkRequest));
+    RVPF_PIPE_Arena arena = &request->control.arena;
+    char *field;
+
+    request->control.buffer.capacity = INITIAL_CONTROL_BUFFER_CAPACITY;
+    request->control.buffer.at = _alloc(request->control.buffer.capacity);
+
+    if (!_firstLine(&request->control.line)) {
+        _freeRequest(&request->control);
+        return NULL;
+    }
+
+    request->control.requestID = _requestID(&request->control.line, arena);
+
+    request->control.version =
+        _stringToInt(_nextField(&request->control.line, true, false));
+    if (request->control.version > SINK_REQUEST_FORMAT_VERSION) {
+        rvpf_pipe_error(
+            "Unsupported request format version: %i",
+            request->control.version);
+    }
+    field = _nextField(&request->control.line, true, false);
+    if (!strcmp(field, SINK_UPDATE_REQUEST_TYPE)) {
+        request->requestType = RVPF_PIPE_SINK_UPDATE;
+    } else if (!strcmp(field, SINK_DELETE_REQUEST_TYPE)) {
+        request->requestType = RVPF_PIPE_SINK_DELETE;
+    } else {
+        rvpf_pipe_error("Unsupported request type '%s'", field);
     }
+
+    _nextLine(&request->control.line, true);
+    _fillPointValue(
+        &request->pointValue, &request->control.line,
+        request->requestType == RVPF_PIPE_SINK_UPDATE, arena);
+
+    return request;
 }
 
-static char *_requestID(RVPF_PIPE_Buffer buffer)
+static char *_requestID(RVPF_PIPE_Buffer buffer, RVPF_PIPE_Arena arena)
 {
     char *requestID = _nextField(buffer, true, false);
 
-    return _cloneString(requestID);
+    return _arenaString(arena, requestID);
 }
 
 static void _resetBuffer(RVPF_PIPE_Buffer buffer)
@@ -948,12 +2023,63 @@ static void _resetBuffer(RVPF_PIPE_Buffer buffer)
     buffer->limit = buffer->position = buffer->mark = 0;
 }
 
+static void _sinkResponseToOutput(RVPF_PIPE_SinkRequest request, int summary)
+{
+    _resetBuffer(&request->control.buffer);
+
+    _stringToBuffer(request->control.requestID, &request->control.buffer);
+    _stringToBuffer(" ", &request->control.buffer);
+    _intToBuffer(summary, &request->control.buffer);
+    _bufferToOutput(&request->control.buffer);
+}
+
 static void _stop(void)
 {
     rvpf_pipe_status = RVPF_PIPE_STATUS_OK;
     longjmp(rvpf_pipe_jmp_buf, 1);
 }
 
+static void _ticksToBuffer(long long ticks, RVPF_PIPE_Buffer buffer)
+{
+    long long unixTicks = ticks - UNIX_EPOCH_RAW;
+    long long seconds = unixTicks / RAW_PER_SECOND;
+    long long fraction = unixTicks % RAW_PER_SECOND;
+    long long days, era, dayOfEra, yearOfEra, dayOfYear, monthIndex;
+    int secondOfDay;
+    char text[48];
+
+    if (fraction < 0) {
+        fraction += RAW_PER_SECOND;
+        --seconds;
+    }
+    days = seconds / 86400;
+    secondOfDay = seconds % 86400;
+    if (secondOfDay < 0) {
+        secondOfDay += 86400;
+        --days;
+    }
+
+    // Civil date from the days since the Unix epoch.
+
+    days += 719468;
+    era = (days >= 0? days: days - 146096) / 146097;
+    dayOfEra = days - era * 146097;
+    yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524
+        - dayOfEra / 146096) / 365;
+    dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    monthIndex = (5 * dayOfYear + 2) / 153;
+
+    int day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    int month = monthIndex < 10? monthIndex + 3: monthIndex - 9;
+    long long year = yearOfEra + era * 400 + (month <= 2);
+
+    snprintf(text, sizeof(text), "%04lli-%02i-%02iT%02i:%02i:%02i.%07lliZ",
+        year, month, day, secondOfDay / 3600, secondOfDay / 60 % 60,
+        secondOfDay % 60, fraction);
+
+    _stringToBuffer(text, buffer);
+}
+
 static void _stringToBuffer(const char *text, RVPF_PIPE_Buffer buffer)
 {
     size_t length = strlen(text);
@@ -0,0 +1,190 @@
+/** Related Values Processing Framework.
+ *
+ * Copyright (C) 2003-2019 Serge Brisson.
+ *
+ * This software is distributable under the LGPL license.
+ * See details at the bottom of this file.
+ *
+ * $Id$
+ */
+
+/** RVPF ring API implementation.
+ *
+ * See header file (.h) for API description.
+ */
+#include "rvpf_ring.h"
+
+#include <stdlib.h>
+
+#ifdef __GNUC__
+
+// Private structure definitions.
+
+union _cellHeader {
+    size_t sequence;
+    long double alignment;
+    void *pointer;
+};
+
+// Context definition.
+
+struct rvpf_ring_context
+{
+    char *cells;
+    size_t stride;
+    size_t mask;
+    size_t enqueue;
+    size_t dequeue;
+};
+
+// Private forward declarations.
+
+static union _cellHeader *_cell(
+    struct rvpf_ring_context *context,
+    size_t position);
+
+// Public function definitions.
+
+extern void *rvpf_ring_claim(
+    struct rvpf_ring_context *context,
+    size_t *position)
+{
+    // Each cell sequence tells its state: equal to the position when free,
+    // one more when published.
+
+    size_t claimed = __atomic_load_n(&context->enqueue, __ATOMIC_RELAXED);
+    union _cellHeader *cell;
+
+    while (true) {
+        cell = _cell(context, claimed);
+
+        size_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        long difference = (long) (sequence - claimed);
+
+        if (difference == 0) {
+            if (__atomic_compare_exchange_n(
+                    &context->enqueue, &claimed, claimed + 1, true,
+                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (difference < 0) {
+            return NULL;
+        } else {
+            claimed = __atomic_load_n(&context->enqueue, __ATOMIC_RELAXED);
+        }
+    }
+
+    *position = claimed;
+
+    return cell + 1;
+}
+
+extern struct rvpf_ring_context *rvpf_ring_create(
+    size_t capacity,
+    size_t cellSize)
+{
+    struct rvpf_ring_context *context = calloc(1, sizeof *context);
+    size_t size = 2;
+
+    if (context == NULL) {
+        return NULL;
+    }
+
+    while (size < capacity) {
+        size <<= 1;
+    }
+    context->stride = sizeof(union _cellHeader)
+        * (1 + (cellSize + sizeof(union _cellHeader) - 1)
+            / sizeof(union _cellHeader));
+    context->cells = calloc(size, context->stride);
+    if (context->cells == NULL) {
+        free(context);
+        return NULL;
+    }
+    context->mask = size - 1;
+    for (size_t i = 0; i < size; ++i) {
+        _cell(context, i)->sequence = i;
+    }
+
+    return context;
+}
+
+extern void rvpf_ring_dispose(struct rvpf_ring_context *context)
+{
+    if (context) {
+        free(context->cells);
+        free(context);
+    }
+}
+
+extern size_t rvpf_ring_getDequeued(struct rvpf_ring_context *context)
+{
+    return __atomic_load_n(&context->dequeue, __ATOMIC_ACQUIRE);
+}
+
+extern size_t rvpf_ring_getEnqueued(struct rvpf_ring_context *context)
+{
+    return __atomic_load_n(&context->enqueue, __ATOMIC_ACQUIRE);
+}
+
+extern bool rvpf_ring_isEmpty(struct rvpf_ring_context *context)
+{
+    return rvpf_ring_getEnqueued(context) == rvpf_ring_getDequeued(context);
+}
+
+extern void *rvpf_ring_peek(struct rvpf_ring_context *context)
+{
+    size_t dequeue = context->dequeue;
+    union _cellHeader *cell = _cell(context, dequeue);
+
+    if (__atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) != dequeue + 1) {
+        return NULL;
+    }
+
+    return cell + 1;
+}
+
+extern void rvpf_ring_publish(
+    struct rvpf_ring_context *context,
+    size_t position)
+{
+    __atomic_store_n(
+        &_cell(context, position)->sequence, position + 1, __ATOMIC_RELEASE);
+}
+
+extern void rvpf_ring_release(struct rvpf_ring_context *context)
+{
+    size_t dequeue = context->dequeue;
+
+    __atomic_store_n(
+        &_cell(context, dequeue)->sequence,
+        dequeue + context->mask + 1,
+        __ATOMIC_RELEASE);
+    __atomic_store_n(&context->dequeue, dequeue + 1, __ATOMIC_RELEASE);
+}
+
+// Private function definitions.
+
+static union _cellHeader *_cell(
+    struct rvpf_ring_context *context,
+    size_t position)
+{
+    return (union _cellHeader *)
+        (context->cells + (position & context->mask) * context->stride);
+}
+
+#endif
+
+/* This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
@@ -11,6 +11,21 @@
 /** RVPF SSL support API.
  *
  * See header file (.h) for API description.
+ *
+ * The SSL_CTX is shared by the contexts having the same trust and
+ * certificate configuration; it lives until the process ends. It keeps
+ * the last TLS session received from each server address, so that the
+ * next connection to that address may resume it with an abbreviated
+ * handshake. A session file extends this across processes.
+ *
+ * When not blocking, a send or receive which would block returns 0 and
+ * notes the readiness it awaits; a secure connection retries the same
+ * send, which is why the SSL_CTX accepts a moving write buffer. A gathering
+ * send copies small buffers into one TLS record, since OpenSSL has no
+ * equivalent of writev.
+ *
+ * The SSL_CTX reads ahead, so that a record and those following it are
+ * received together, instead of a header then a body for each record.
  */
 #include "rvpf_version.h"
 
@@ -23,6 +38,7 @@
 #include "rvpf_mem.h"
 
 #include <assert.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -31,47 +47,98 @@
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 #include <openssl/bio.h>
+#include <openssl/pem.h>
+#include <pthread.h>
 #else
-#include <errno.h>
-#ifdef _WIN32
-#include <winsock2.h>
-#else
+#ifndef _WIN32
 #include <sys/types.h>
 #include <sys/socket.h>
-#include <unistd.h>
 #include <netinet/in.h>
 #include <netdb.h>
 #endif
 #endif
 
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#ifdef SSL_ENABLED
+#define GATHER_SIZE SSL3_RT_MAX_PLAIN_LENGTH
+#else
+#define GATHER_COUNT 16
+#endif
+
 // Context definition.
 
+#ifdef SSL_ENABLED
+struct rvpf_ssl_session
+{
+    struct rvpf_ssl_session *next;
+    char *host;
+    int port;
+    SSL_SESSION *session;
+};
+
+struct rvpf_ssl_shared
+{
+    struct rvpf_ssl_shared *next;
+    char *trustFile;
+    char *trustDirectory;
+    char *certificateFile;
+    SSL_CTX *ctx;
+    struct rvpf_ssl_session *sessions;
+};
+#endif
+
 struct rvpf_ssl_context
 {
     char *host;
     int port;
 #ifdef SSL_ENABLED
     BIO *bio;
-    SSL_CTX *ctx;
+    bool secure;
+    struct rvpf_ssl_shared *shared;
     SSL *ssl;
+    bool resumed;
     char *trustFile;
     char *trustDirectory;
     char *certificateFile;
+    char *sessionFile;
 #else
     int socket;
 #endif
+    bool nonBlocking;
+    bool wouldBlock;
+    bool wantsWrite;
     int status;
     char *errorMessage;
 };
 
 // Private forward declarations.
 
+static void _applyBlocking(RVPF_SSL_Context context);
 static void _initCTX(RVPF_SSL_Context context);
+#ifdef SSL_ENABLED
+static int _newSession(SSL *ssl, SSL_SESSION *session);
+static void _readSession(RVPF_SSL_Context context);
+#endif
+static bool _retry(RVPF_SSL_Context context, ssize_t count, bool writing);
 static void _saveString(
     char *source,
     size_t length,
     char **destination,
     RVPF_SSL_Context context);
+#ifdef SSL_ENABLED
+static bool _sameString(const char *left, const char *right);
+static struct rvpf_ssl_session *_session(RVPF_SSL_Context context);
+static struct rvpf_ssl_shared *_shared(RVPF_SSL_Context context);
+static void _writeSession(RVPF_SSL_Context context, SSL_SESSION *session);
+#endif
 
 // Private storage.
 
@@ -94,8 +161,49 @@ static char *_messages[] =
     "unknown error"
 };
 
+#ifdef SSL_ENABLED
+static struct rvpf_ssl_shared *_sharedList = NULL;
+
+static pthread_mutex_t _sharedMutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 // Public function definitions.
 
+extern bool rvpf_ssl_await(RVPF_SSL_Context context, int timeout)
+{
+    assert(context);
+
+    if (rvpf_ssl_failed(context)) {
+        return false;
+    }
+    if (!rvpf_ssl_isOpen(context)) {
+        context->status = RVPF_SSL_ILLEGAL_STATE;
+        return false;
+    }
+    if (!context->wantsWrite && rvpf_ssl_pending(context) > 0) {
+        return true;
+    }
+
+    struct pollfd poller = {0};
+    int ready;
+
+    poller.fd = rvpf_ssl_socket(context);
+    poller.events = context->wantsWrite? POLLOUT: POLLIN;
+#ifdef _WIN32
+    ready = WSAPoll(&poller, 1, timeout);
+#else
+    ready = poll(&poller, 1, timeout);
+    if (ready < 0 && errno == EINTR) {
+        return false;
+    }
+#endif
+    if (ready < 0) {
+        context->status = RVPF_SSL_ASK_ERR;
+    }
+
+    return ready > 0;
+}
+
 extern void rvpf_ssl_clearError(RVPF_SSL_Context context)
 {
     assert(context);
@@ -169,11 +277,10 @@ extern void rvpf_ssl_dispose(RVPF_SSL_Context context)
         rvpf_ssl_close(context);
 
 #ifdef SSL_ENABLED
-        if (context->ctx != NULL) {
-            SSL_CTX_free(context->ctx);
-            context->ctx = NULL;
-        }
+        context->shared = NULL; // Kept for the other contexts.
         ERR_free_strings();
+        RVPF_MEM_FREE(context->sessionFile);
+        context->sessionFile = NULL;
         RVPF_MEM_FREE(context->certificateFile);
         context->certificateFile = NULL;
         RVPF_MEM_FREE(context->trustDirectory);
@@ -275,6 +382,17 @@ extern bool rvpf_ssl_isOpen(RVPF_SSL_Context context)
 #endif
 }
 
+extern bool rvpf_ssl_isResumed(RVPF_SSL_Context context)
+{
+    assert(context);
+
+#ifdef SSL_ENABLED
+    return context->resumed;
+#else
+    return false;
+#endif
+}
+
 extern int rvpf_ssl_open(RVPF_SSL_Context context, char *address)
 {
     assert(context);
@@ -317,11 +435,11 @@ extern int rvpf_ssl_open(RVPF_SSL_Context context, char *address)
     }
 
 #ifdef SSL_ENABLED
-    bool secure = context->ctx != NULL;
+    bool secure = context->secure;
     bool verified =
         context->trustFile || context->trustDirectory;
-    bool certified = context->certificateFile;
 
+    context->resumed = false;
     context->bio = BIO_new(BIO_s_connect());
     if (!context->bio) {
         context->status = RVPF_SSL_ASK_ERR;
@@ -334,40 +452,21 @@ extern int rvpf_ssl_open(RVPF_SSL_Context context, char *address)
         }
     }
 
-    if (verified && rvpf_ssl_succeeded(context)) {
-        if (!SSL_CTX_load_verify_locations(context->ctx,
-                context->trustFile, context->trustDirectory)) {
-            context->status = RVPF_SSL_ASK_ERR;
-        }
-    }
-    if (certified && rvpf_ssl_succeeded(context)) {
-        if (!SSL_CTX_use_certificate_chain_file(context->ctx,
-                context->certificateFile)) {
-            context->status = RVPF_SSL_ASK_ERR;
-        }
-    }
-    if (certified && rvpf_ssl_succeeded(context)) {
-        if (!SSL_CTX_use_PrivateKey_file(context->ctx,
-                context->certificateFile, SSL_FILETYPE_PEM)) {
-            context->status = RVPF_SSL_ASK_ERR;
-        }
-    }
     if (secure && rvpf_ssl_succeeded(context)) {
-        if (verified) {
-            SSL_CTX_set_verify(context->ctx, SSL_VERIFY_PEER, NULL);
-        }
-        if (!SSL_CTX_set_cipher_list(context->ctx,
-                "ALL:!ADH:!LOW:!EXP:!MD5:@STRENGTH")) {
+        context->shared = _shared(context);
+        if (!context->shared) {
             context->status = RVPF_SSL_ASK_ERR;
         }
     }
 
     if (secure && rvpf_ssl_succeeded(context)) {
-        context->ssl = SSL_new(context->ctx);
+        context->ssl = SSL_new(context->shared->ctx);
         if (!context->ssl) {
             context->status = RVPF_SSL_ASK_ERR;
         } else {
+            SSL_set_app_data(context->ssl, context);
             SSL_set_bio(context->ssl, context->bio, context->bio);
+            _readSession(context);
         }
     }
     if (secure && rvpf_ssl_succeeded(context)) {
@@ -383,6 +482,9 @@ extern int rvpf_ssl_open(RVPF_SSL_Context context, char *address)
             }
         }
     }
+    if (secure && rvpf_ssl_succeeded(context)) {
+        context->resumed = SSL_session_reused(context->ssl);
+    }
 #else
 #ifdef _WIN32
     WSADATA wsaData;
@@ -418,6 +520,11 @@ extern int rvpf_ssl_open(RVPF_SSL_Context context, char *address)
     }
 #endif
 
+    context->wouldBlock = false;
+    if (context->nonBlocking && rvpf_ssl_succeeded(context)) {
+        _applyBlocking(context);
+    }
+
     if (rvpf_ssl_failed(context)) {
         rvpf_ssl_close(context);
     }
@@ -425,6 +532,31 @@ extern int rvpf_ssl_open(RVPF_SSL_Context context, char *address)
     return context->status;
 }
 
+extern int rvpf_ssl_pending(RVPF_SSL_Context context)
+{
+    assert(context);
+
+#ifdef SSL_ENABLED
+    if (!context->ssl) {
+        return 0;
+    }
+
+    int pending = SSL_pending(context->ssl);
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    // Bytes read ahead are not decrypted yet; after a receive which would
+    // block, they are only part of a record.
+    if (!pending && !context->wouldBlock && SSL_has_pending(context->ssl)) {
+        pending = 1;
+    }
+#endif
+
+    return pending;
+#else
+    return 0;
+#endif
+}
+
 extern bool rvpf_ssl_printError(RVPF_SSL_Context context, char *prefix)
 {
     char *message = rvpf_ssl_errorMessage(context);
@@ -453,6 +585,7 @@ extern int rvpf_ssl_receive(RVPF_SSL_Context context, char *buffer, size_t size)
 
     ssize_t count;
 
+    context->wouldBlock = false;
 #ifdef SSL_ENABLED
     if (context->ssl) {
         count = SSL_read(context->ssl, buffer, size);
@@ -463,7 +596,9 @@ extern int rvpf_ssl_receive(RVPF_SSL_Context context, char *buffer, size_t size)
     count = recv(context->socket, buffer, size, 0);
 #endif
 
-    if (count < 0) {
+    if (_retry(context, count, false)) {
+        count = 0;
+    } else if (count < 0) {
         context->status = count == -1
             ? RVPF_SSL_ASK_ERR
             : RVPF_SSL_INTERNAL_ERROR;
@@ -486,6 +621,7 @@ extern int rvpf_ssl_send(RVPF_SSL_Context context, char *buffer, size_t size)
 
     ssize_t count;
 
+    context->wouldBlock = false;
 #ifdef SSL_ENABLED
     if (context->ssl) {
         count = SSL_write(context->ssl, buffer, size);
@@ -496,7 +632,9 @@ extern int rvpf_ssl_send(RVPF_SSL_Context context, char *buffer, size_t size)
     count = send(context->socket, buffer, size, 0);
 #endif
 
-    if (count <= 0) {
+    if (_retry(context, count, true)) {
+        count = 0;
+    } else if (count <= 0) {
         context->status = count == -1
             ? RVPF_SSL_ASK_ERR
             : RVPF_SSL_INTERNAL_ERROR;
@@ -505,6 +643,102 @@ extern int rvpf_ssl_send(RVPF_SSL_Context context, char *buffer, size_t size)
     return count;
 }
 
+extern int rvpf_ssl_sendBuffers(
+        RVPF_SSL_Context context,
+        RVPF_SSL_Buffer *buffers,
+        int count)
+{
+    if (rvpf_ssl_failed(context)) {
+        return 0;
+    }
+
+    size_t total = 0;
+    int i;
+
+    for (i = 0; buffers && i < count; ++i) {
+        total += buffers[i].size;
+    }
+    if (total < 1) {
+        context->status = RVPF_SSL_ILLEGAL_ARG;
+        return 0;
+    }
+
+    for (i = 0; !buffers[i].size; ++i) {}
+
+#ifdef SSL_ENABLED
+    char gathered[GATHER_SIZE];
+    size_t length = 0;
+
+    if (buffers[i].size >= sizeof(gathered)) {
+        return rvpf_ssl_send(context, buffers[i].buffer, buffers[i].size);
+    }
+
+    for (; i < count && length < sizeof(gathered); ++i) {
+        size_t size = buffers[i].size;
+
+        if (size > sizeof(gathered) - length) {
+            size = sizeof(gathered) - length;
+        }
+        if (size > 0) {
+            memcpy(gathered + length, buffers[i].buffer, size);
+            length += size;
+        }
+    }
+
+    return rvpf_ssl_send(context, gathered, length);
+#else
+    ssize_t sent;
+    int vectorsCount = 0;
+
+    context->wouldBlock = false;
+#ifdef _WIN32
+    WSABUF vectors[GATHER_COUNT];
+    DWORD bytes;
+
+    for (; i < count && vectorsCount < GATHER_COUNT; ++i) {
+        if (buffers[i].size > 0) {
+            vectors[vectorsCount].buf = buffers[i].buffer;
+            vectors[vectorsCount++].len = (ULONG) buffers[i].size;
+        }
+    }
+    sent = WSASend(context->socket, vectors, vectorsCount, &bytes, 0, NULL, NULL)
+        ? -1: (ssize_t) bytes;
+#else
+    struct iovec vectors[GATHER_COUNT];
+
+    for (; i < count && vectorsCount < GATHER_COUNT; ++i) {
+        if (buffers[i].size > 0) {
+            vectors[vectorsCount].iov_base = buffers[i].buffer;
+            vectors[vectorsCount++].iov_len = buffers[i].size;
+        }
+    }
+    sent = writev(context->socket, vectors, vectorsCount);
+#endif
+
+    if (_retry(context, sent, true)) {
+        sent = 0;
+    } else if (sent <= 0) {
+        context->status = sent == -1
+            ? RVPF_SSL_ASK_ERR
+            : RVPF_SSL_INTERNAL_ERROR;
+    }
+
+    return sent;
+#endif
+}
+
+extern int rvpf_ssl_setBlocking(RVPF_SSL_Context context, bool blocking)
+{
+    assert(context);
+
+    context->nonBlocking = !blocking;
+    if (rvpf_ssl_isOpen(context)) {
+        _applyBlocking(context);
+    }
+
+    return context->status;
+}
+
 extern void rvpf_ssl_setCertificate(RVPF_SSL_Context context, char *filePath)
 {
     if (rvpf_ssl_succeeded(context)) {
@@ -516,6 +750,16 @@ extern void rvpf_ssl_setCertificate(RVPF_SSL_Context context, char *filePath)
     }
 }
 
+extern void rvpf_ssl_setSessionFile(RVPF_SSL_Context context, char *filePath)
+{
+    if (rvpf_ssl_succeeded(context)) {
+#ifdef SSL_ENABLED
+        _saveString(filePath, filePath != NULL? strlen(filePath): 0,
+            &context->sessionFile, context);
+#endif
+    }
+}
+
 extern void rvpf_ssl_setTrust(
         RVPF_SSL_Context context,
         char *filePath,
@@ -534,6 +778,17 @@ extern void rvpf_ssl_setTrust(
     }
 }
 
+extern int rvpf_ssl_socket(RVPF_SSL_Context context)
+{
+    assert(context);
+
+#ifdef SSL_ENABLED
+    return context->bio? BIO_get_fd(context->bio, NULL): -1;
+#else
+    return context->socket;
+#endif
+}
+
 extern int rvpf_ssl_status(RVPF_SSL_Context context)
 {
     assert(context);
@@ -570,20 +825,154 @@ extern char *rvpf_ssl_version(void)
     return version;
 }
 
+extern bool rvpf_ssl_wantsWrite(RVPF_SSL_Context context)
+{
+    assert(context);
+
+    return context->wantsWrite;
+}
+
+extern bool rvpf_ssl_wouldBlock(RVPF_SSL_Context context)
+{
+    assert(context);
+
+    return context->wouldBlock;
+}
+
 // Private function definitions.
 
+static void _applyBlocking(RVPF_SSL_Context context)
+{
+    int descriptor = rvpf_ssl_socket(context);
+
+#ifdef SSL_ENABLED
+    if (!BIO_socket_nbio(descriptor, context->nonBlocking)) {
+        context->status = RVPF_SSL_ASK_ERR;
+    }
+#else
+#ifdef _WIN32
+    u_long mode = context->nonBlocking;
+
+    if (ioctlsocket(descriptor, FIONBIO, &mode)) {
+        context->status = RVPF_SSL_ASK_ERR;
+    }
+#else
+    int flags = fcntl(descriptor, F_GETFL);
+
+    if (flags != -1) {
+        flags = context->nonBlocking? flags | O_NONBLOCK: flags & ~O_NONBLOCK;
+        flags = fcntl(descriptor, F_SETFL, flags);
+    }
+    if (flags == -1) {
+        context->status = RVPF_SSL_ASK_ERR;
+    }
+#endif
+#endif
+}
+
 static void _initCTX(RVPF_SSL_Context context)
 {
 #ifdef SSL_ENABLED
-    if (!context->ctx) {
-        context->ctx = SSL_CTX_new(SSLv23_method());
-        if (context->ctx != NULL) {
-            SSL_CTX_set_options(context->ctx, SSL_OP_ALL|SSL_OP_NO_SSLv2);
-        } else {
-            context->status = RVPF_SSL_ASK_ERR;
+    context->secure = true; // The SSL_CTX is set up on open.
+#endif
+}
+
+#ifdef SSL_ENABLED
+static int _newSession(SSL *ssl, SSL_SESSION *session)
+{
+    // Keeps the reference to the session when returning 1.
+
+    RVPF_SSL_Context context = SSL_get_app_data(ssl);
+
+    if (!context) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&_sharedMutex);
+
+    struct rvpf_ssl_session *entry = _session(context);
+
+    if (entry->session) {
+        SSL_SESSION_free(entry->session);
+    }
+    entry->session = session;
+    _writeSession(context, session);
+
+    pthread_mutex_unlock(&_sharedMutex);
+
+    return 1;
+}
+
+static void _readSession(RVPF_SSL_Context context)
+{
+    // Offers the last session from the server address, if any.
+
+    pthread_mutex_lock(&_sharedMutex);
+
+    struct rvpf_ssl_session *entry = _session(context);
+
+    if (!entry->session && context->sessionFile) {
+        FILE *file = fopen(context->sessionFile, "r");
+
+        if (file) {
+            char line[256];
+            char address[256];
+
+            snprintf(address, sizeof(address),
+                "%s:%i\n", context->host, context->port);
+            if (fgets(line, sizeof(line), file) && !strcmp(line, address)) {
+                entry->session = PEM_read_SSL_SESSION(file, NULL, NULL, NULL);
+            }
+            fclose(file);
+            ERR_clear_error();
+        }
+    }
+
+    if (entry->session) {
+        SSL_set_session(context->ssl, entry->session);
+    }
+
+    pthread_mutex_unlock(&_sharedMutex);
+}
+#endif
+
+static bool _retry(RVPF_SSL_Context context, ssize_t count, bool writing)
+{
+    // Notes, when not blocking, a send or receive which would block.
+
+    if (!context->nonBlocking || count > 0) {
+        return false;
+    }
+
+#ifdef SSL_ENABLED
+    if (context->ssl) {
+        int error = SSL_get_error(context->ssl, count);
+
+        if (error != SSL_ERROR_WANT_READ && error != SSL_ERROR_WANT_WRITE) {
+            return false;
+        }
+        context->wantsWrite = error == SSL_ERROR_WANT_WRITE;
+    } else {
+        if (!BIO_should_retry(context->bio)) {
+            return false;
         }
+        context->wantsWrite = BIO_should_write(context->bio);
+    }
+#else
+#ifdef _WIN32
+    if (count != -1 || WSAGetLastError() != WSAEWOULDBLOCK) {
+        return false;
+    }
+#else
+    if (count != -1 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+        return false;
     }
 #endif
+    context->wantsWrite = writing;
+#endif
+    context->wouldBlock = true;
+
+    return true;
 }
 
 static void _saveString(
@@ -602,6 +991,142 @@ static void _saveString(
     }
 }
 
+#ifdef SSL_ENABLED
+static bool _sameString(const char *left, const char *right)
+{
+    return left? right && !strcmp(left, right): !right;
+}
+
+static struct rvpf_ssl_session *_session(RVPF_SSL_Context context)
+{
+    // Called with the shared mutex locked.
+
+    struct rvpf_ssl_session *entry = context->shared->sessions;
+
+    while (entry) {
+        if (entry->port == context->port
+                && !strcmp(entry->host, context->host)) {
+            return entry;
+        }
+        entry = entry->next;
+    }
+
+    entry = RVPF_MEM_ALLOCATE(sizeof(struct rvpf_ssl_session));
+    _saveString(context->host, strlen(context->host), &entry->host, context);
+    entry->port = context->port;
+    entry->next = context->shared->sessions;
+    context->shared->sessions = entry;
+
+    return entry;
+}
+
+static struct rvpf_ssl_shared *_shared(RVPF_SSL_Context context)
+{
+    // Returns the SSL_CTX entry for the configuration of the context.
+
+    pthread_mutex_lock(&_sharedMutex);
+
+    struct rvpf_ssl_shared *shared = _sharedList;
+
+    while (shared) {
+        if (_sameString(shared->trustFile, context->trustFile)
+                && _sameString(shared->trustDirectory, context->trustDirectory)
+                && _sameString(shared->certificateFile,
+                    context->certificateFile)) {
+            pthread_mutex_unlock(&_sharedMutex);
+            return shared;
+        }
+        shared = shared->next;
+    }
+
+    bool verified = context->trustFile || context->trustDirectory;
+    bool certified = context->certificateFile;
+    SSL_CTX *ctx = SSL_CTX_new(SSLv23_method());
+    bool succeeded = ctx != NULL;
+
+    if (succeeded) {
+        SSL_CTX_set_options(ctx, SSL_OP_ALL|SSL_OP_NO_SSLv2);
+        SSL_CTX_set_mode(ctx, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+        SSL_CTX_set_read_ahead(ctx, 1);
+        SSL_CTX_set_session_cache_mode(ctx,
+            SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(ctx, _newSession);
+    }
+    if (verified && succeeded) {
+        succeeded = SSL_CTX_load_verify_locations(ctx,
+            context->trustFile, context->trustDirectory);
+    }
+    if (certified && succeeded) {
+        succeeded = SSL_CTX_use_certificate_chain_file(ctx,
+            context->certificateFile);
+    }
+    if (certified && succeeded) {
+        succeeded = SSL_CTX_use_PrivateKey_file(ctx,
+            context->certificateFile, SSL_FILETYPE_PEM);
+    }
+    if (succeeded) {
+        if (verified) {
+            SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, NULL);
+        }
+        succeeded = SSL_CTX_set_cipher_list(ctx,
+            "ALL:!ADH:!LOW:!EXP:!MD5:@STRENGTH");
+    }
+
+    if (succeeded) {
+        shared = RVPF_MEM_ALLOCATE(sizeof(struct rvpf_ssl_shared));
+        shared->ctx = ctx;
+        if (context->trustFile) {
+            _saveString(context->trustFile, strlen(context->trustFile),
+                &shared->trustFile, context);
+        }
+        if (context->trustDirectory) {
+            _saveString(context->trustDirectory,
+                strlen(context->trustDirectory),
+                &shared->trustDirectory, context);
+        }
+        if (context->certificateFile) {
+            _saveString(context->certificateFile,
+                strlen(context->certificateFile),
+                &shared->certificateFile, context);
+        }
+        shared->next = _sharedList;
+        _sharedList = shared;
+    } else if (ctx) {
+        SSL_CTX_free(ctx);
+    }
+
+    pthread_mutex_unlock(&_sharedMutex);
+
+    return shared;
+}
+
+static void _writeSession(RVPF_SSL_Context context, SSL_SESSION *session)
+{
+    // Called with the shared mutex locked. The file holds secrets.
+
+    if (!context->sessionFile) {
+        return;
+    }
+
+#ifdef _WIN32
+    FILE *file = fopen(context->sessionFile, "w");
+#else
+    int fd = open(context->sessionFile, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    FILE *file = fd >= 0? fdopen(fd, "w"): NULL;
+
+    if (fd >= 0 && !file) {
+        close(fd);
+    }
+#endif
+
+    if (file) {
+        fprintf(file, "%s:%i\n", context->host, context->port);
+        PEM_write_SSL_SESSION(file, session);
+        fclose(file);
+    }
+}
+#endif
+
 /* This is free software; you can redistribute it and/or modify
  * it under the terms of the GNU Lesser General Public License
  * version 2.1 as published by the Free Software Foundation.
@@ -58,8 +58,10 @@ extern void rvpf_tree_clear(struct rvpf_tree_context *context)
     context->size = 0;
 #else
     while (context->root) {
-        _clearNode(context->root);
-        tdelete(context->root, (void **) &context->root, _nodeComparator);
+        struct rvpf_tree_node *node = *(struct rvpf_tree_node **) context->root;
+
+        tdelete(node, (void **) &context->root, _nodeComparator);
+        _clearNode(node);
         --context->size;
     }
     assert(context->size == 0);
@@ -85,10 +87,10 @@ extern void rvpf_tree_dispose(struct rvpf_tree_context *context)
 extern const void *rvpf_tree_get(struct rvpf_tree_context *context, const void *key)
 {
     struct rvpf_tree_node keyNode = {context, key};
-    struct rvpf_tree_node *foundNode =
+    struct rvpf_tree_node **foundNode =
         tfind(&keyNode, (void **) &context->root, _nodeComparator);
 
-    return foundNode? foundNode->value: NULL;
+    return foundNode? (*foundNode)->value: NULL;
 }
 
 extern const void *rvpf_tree_put(struct rvpf_tree_context *context, const void *key, const void *value)
@@ -101,16 +103,19 @@ extern const void *rvpf_tree_put(struct rvpf_tree_context *context, const void *
     newNode->value = value;
     ++context->size;
 
-    struct rvpf_tree_node *foundNode =
-        tsearch(&newNode, (void **) &context->root, _nodeComparator);
+    struct rvpf_tree_node **foundNode =
+        tsearch(newNode, (void **) &context->root, _nodeComparator);
     const void *oldValue;
 
-    if (foundNode == newNode) oldValue = NULL;
+    if (*foundNode == newNode) oldValue = NULL;
     else {
+        // Keeps the original key.
+
         --context->size;
+        RVPF_MEM_FREE((void *) newNode->key);
         RVPF_MEM_FREE(newNode);
-        oldValue = foundNode->value;
-        foundNode->value = value;
+        oldValue = (*foundNode)->value;
+        (*foundNode)->value = value;
     }
 
     return oldValue;
@@ -119,15 +124,18 @@ extern const void *rvpf_tree_put(struct rvpf_tree_context *context, const void *
 extern const void *rvpf_tree_remove(struct rvpf_tree_context *context, const void *key)
 {
     struct rvpf_tree_node keyNode = {context, key};
-    struct rvpf_tree_node *foundNode =
+    struct rvpf_tree_node **foundNode =
         tfind(&keyNode, (void **) &context->root, _nodeComparator);
     const void *deletedValue;
 
     if (foundNode) {
-        deletedValue = foundNode->value;
+        struct rvpf_tree_node *node = *foundNode;
+
+        deletedValue = node->value;
         tdelete(&keyNode, (void **) &context->root, _nodeComparator);
         --context->size;
-        RVPF_MEM_FREE(foundNode);
+        RVPF_MEM_FREE((void *) node->key);
+        RVPF_MEM_FREE(node);
     } else deletedValue = NULL;
 
     return deletedValue;
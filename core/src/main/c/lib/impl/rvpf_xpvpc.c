@@ -20,21 +20,27 @@
 
 #include "rvpf_xpvpc.h"
 #include "rvpf_mem.h"
+#include "rvpf_tree.h"
 
 #include <assert.h>
 #include <ctype.h>
 #include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 // Private macro definitions.
 
+#define INPUT_BUFFER_SIZE 4096
 #define MIN_BUFFER_SIZE 256
 
 #define CLIENT_ATTRIBUTE "client"
 #define DATA_ELEMENT "data"
 #define DELETED_VALUE_ELEMENT "deleted-value"
 #define FLUSH_ATTRIBUTE "flush"
+#define FRAMING_ATTRIBUTE "framing"
 #define ID_ATTRIBUTE "id"
 #define LOGIN_ELEMENT "login"
 #define MESSAGES_ELEMENT "messages"
@@ -46,8 +52,23 @@
 #define USER_ATTRIBUTE "user"
 #define VALUE_ELEMENT "value"
 
+#define ESCAPE_MAX_LENGTH 6
+
+#define BINARY_FRAMING "binary"
+#define BINARY_MESSAGES_FRAME 'M'
+#define BINARY_FLUSH_FLAG 0x01
+#define BINARY_DELETED_FLAG 0x01
+#define BINARY_NEW_POINT_FLAG 0x02
+#define BINARY_RAW_STAMP_FLAG 0x04
+#define BINARY_STATE_FLAG 0x08
+#define BINARY_VALUE_FLAG 0x10
+
+#define UNIX_EPOCH_RAW 0x007C95674BEB4000LL
+#define RAW_PER_SECOND 10000000LL
+
 #define RESPONSE_START "<done ref='"
 #define RESPONSE_END "'/>"
+#define RESPONSE_FRAMING_END "' " FRAMING_ATTRIBUTE "='" BINARY_FRAMING "'/>"
 
 // Context definition.
 
@@ -56,37 +77,140 @@ struct rvpf_xpvpc_context
     char *client;
     long long id;
     int pending;
+    struct timespec pendingSince;
+    int autoFlush;
+    size_t autoFlushBytes;
+    int autoFlushMillis;
+    int window;
+    int outstanding;
+    bool binary; // Offered on login.
+    bool framed; // Accepted by the server.
+    bool negotiating;
+    RVPF_TREE_Context points;
+    size_t frameStart;
     RVPF_SSL_Context ssl;
     char *buffer;
     size_t size;
-    size_t limit;
     size_t position;
+    char *spare;
+    size_t spareSize;
+    char input[INPUT_BUFFER_SIZE];
+    size_t inputLimit;
+    size_t inputPosition;
+    char line[MIN_BUFFER_SIZE];
+    size_t lineLimit;
+    size_t linePosition;
+    bool linePartial;
+    bool polled;
+    char *output; // Queued while polled.
+    size_t outputSize;
+    size_t outputPosition;
+    size_t outputLimit;
+    bool writeWantsRead;
+    bool readBlocked;
+    bool readWantsWrite;
+    pthread_mutex_t mutex;
+    pthread_cond_t ready;
+    pthread_cond_t done;
+    pthread_t sender;
+    bool senderRunning;
+    bool senderStopping;
+    bool flushRequested;
+    bool syncRequested;
     int status;
 };
 
+// Pool definition.
+
+struct rvpf_xpvpc_pool
+{
+    char *address;
+    char *user;
+    char *password;
+    RVPF_XPVPC_Configure configure;
+    void *data;
+    RVPF_XPVPC_Context *idle;
+    int idleCount;
+    int capacity;
+    pthread_mutex_t mutex;
+};
+
 // Private forward declarations.
 
+static void _addBinaryValue(
+    RVPF_XPVPC_Context context,
+    char *point,
+    char *stamp,
+    char *state,
+    char *value);
+
+static void _addBytes(RVPF_XPVPC_Context context, char *bytes, size_t length);
+
 static void _addChar(RVPF_XPVPC_Context context, char c);
 
+static void _addElement(RVPF_XPVPC_Context context, char *name, char *text);
+
 static void _addEncoded(RVPF_XPVPC_Context context, char *text, char quote);
 
 static void _addLong(RVPF_XPVPC_Context context, long long n);
 
+static void _addString(RVPF_XPVPC_Context context, char *text);
+
 static void _addText(RVPF_XPVPC_Context context, char *text);
 
-static void _match(RVPF_XPVPC_Context context, char *text);
+static void _addUnsigned(RVPF_XPVPC_Context context, unsigned long long n);
+
+static void _addXMLValue(
+    RVPF_XPVPC_Context context,
+    char *point,
+    char *stamp,
+    char *state,
+    char *value);
 
-static void _receiveLine(RVPF_XPVPC_Context context);
+static void _awaitSender(RVPF_XPVPC_Context context, bool sync);
 
-static void _resetText(RVPF_XPVPC_Context context);
+static void _beginFrame(RVPF_XPVPC_Context context, char type);
 
-static void _sendText(RVPF_XPVPC_Context context);
+static size_t _cleanLength(char *text, size_t length, char quote);
 
-static void _verifyResponse(RVPF_XPVPC_Context context, long long expectedId);
+static void _closeFrame(RVPF_XPVPC_Context context);
 
-// Private storage.
+static void _closeMessages(RVPF_XPVPC_Context context);
+
+static bool _flushDue(RVPF_XPVPC_Context context);
+
+static void _flushPending(RVPF_XPVPC_Context context);
+
+static int _match(RVPF_XPVPC_Context context, char *text);
+
+static bool _parseStamp(char *stamp, long long *raw);
+
+static int _receiveLine(RVPF_XPVPC_Context context);
+
+static void _queueOutput(
+        RVPF_XPVPC_Context context,
+        RVPF_SSL_Buffer *buffers,
+        int count);
+
+static bool _reserve(RVPF_XPVPC_Context context, size_t length);
+
+static void _sendBuffer(RVPF_XPVPC_Context context, char *buffer, size_t length);
+
+static void _sendOutput(RVPF_XPVPC_Context context);
+
+static void *_sender(void *argument);
 
-static int _autoFlush = 0;
+static void _settleRequests(RVPF_XPVPC_Context context);
+
+static void _syncAwaiting(RVPF_XPVPC_Context context);
+
+static char *_trim(char *text, size_t *length);
+
+static void _verifyOutstanding(RVPF_XPVPC_Context context, int window);
+
+static int _verifyResponse(RVPF_XPVPC_Context context, long long expectedId);
+
+// Private storage.
 
 static char *_deletedState = "DELETED";
 
@@ -104,28 +228,80 @@ static char *_messages[] =
 
 // Public function definitions.
 
+extern RVPF_XPVPC_Context rvpf_xpvpc_acquire(RVPF_XPVPC_Pool pool)
+{
+    assert(pool);
+
+    RVPF_XPVPC_Context context = NULL;
+
+    pthread_mutex_lock(&pool->mutex);
+    if (pool->idleCount > 0) {
+        context = pool->idle[--pool->idleCount];
+        pool->idle[pool->idleCount] = NULL;
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (context) {
+        return context;
+    }
+
+    context = rvpf_xpvpc_create();
+    if (pool->configure) {
+        pool->configure(context, pool->data);
+    }
+    if (rvpf_xpvpc_succeeded(context)) {
+        rvpf_xpvpc_open(context, pool->address);
+    }
+    if (rvpf_xpvpc_succeeded(context) && pool->user) {
+        rvpf_xpvpc_login(context, pool->user, pool->password);
+    }
+
+    return context;
+}
+
 extern void rvpf_xpvpc_clearError(RVPF_XPVPC_Context context)
 {
     assert(context);
 
-    _resetText(context);
+    pthread_mutex_lock(&context->mutex);
+
+    context->position = 0;
     context->pending = 0;
+    context->outstanding = 0;
+    context->inputLimit = 0;
+    context->inputPosition = 0;
+    context->lineLimit = 0;
+    context->linePartial = false;
+    context->outputPosition = 0;
+    context->outputLimit = 0;
+    context->readBlocked = false;
+    context->negotiating = false;
+    context->flushRequested = false;
+    context->syncRequested = false;
     context->status = RVPF_XPVPC_OK;
     rvpf_ssl_clearError(context->ssl);
+
+    pthread_mutex_unlock(&context->mutex);
 }
 
 extern int rvpf_xpvpc_close(RVPF_XPVPC_Context context)
 {
     assert(context);
 
+    if (context->senderRunning) rvpf_xpvpc_stopSender(context);
+
     if (!rvpf_ssl_isOpen(context->ssl)) {
         rvpf_xpvpc_clearError(context);
         return context->status;
     }
 
-    if (rvpf_xpvpc_succeeded(context)) rvpf_xpvpc_flush(context);
+    if (rvpf_xpvpc_succeeded(context)) _syncAwaiting(context);
     else context->status = RVPF_XPVPC_OK;
 
+    context->outputPosition = 0;
+    context->outputLimit = 0;
+    context->readBlocked = false;
+
     return rvpf_ssl_close(context->ssl);
 }
 
@@ -135,15 +311,46 @@ extern RVPF_XPVPC_Context rvpf_xpvpc_create(void)
         RVPF_MEM_ALLOCATE(sizeof(struct rvpf_xpvpc_context));
 
     context->ssl = rvpf_ssl_create();
+    context->points = rvpf_tree_create();
 
     context->size = MIN_BUFFER_SIZE;
     context->buffer = RVPF_MEM_ALLOCATE(context->size);
+    context->spareSize = MIN_BUFFER_SIZE;
+    context->spare = RVPF_MEM_ALLOCATE(context->spareSize);
+
+    pthread_mutex_init(&context->mutex, NULL);
+    pthread_cond_init(&context->ready, NULL);
+    pthread_cond_init(&context->done, NULL);
 
     context->status = RVPF_XPVPC_OK;
 
     return context;
 }
 
+extern RVPF_XPVPC_Pool rvpf_xpvpc_createPool(
+    char *address,
+    char *user,
+    char *password,
+    int capacity,
+    RVPF_XPVPC_Configure configure,
+    void *data)
+{
+    RVPF_XPVPC_Pool pool = RVPF_MEM_ALLOCATE(sizeof(struct rvpf_xpvpc_pool));
+
+    pool->address = RVPF_MEM_STRING(address);
+    pool->user = RVPF_MEM_STRING(user);
+    pool->password = RVPF_MEM_STRING(password);
+    pool->configure = configure;
+    pool->data = data;
+    pool->capacity = capacity > 0? capacity: 1;
+    pool->idle = RVPF_MEM_ALLOCATE(
+        sizeof(RVPF_XPVPC_Context) * pool->capacity);
+
+    pthread_mutex_init(&pool->mutex, NULL);
+
+    return pool;
+}
+
 extern char *rvpf_xpvpc_deletedState(void)
 {
     return _deletedState;
@@ -155,14 +362,47 @@ extern void rvpf_xpvpc_dispose(RVPF_XPVPC_Context context)
         rvpf_xpvpc_close(context);
         rvpf_xpvpc_setClient(context, NULL);
 
+        pthread_cond_destroy(&context->done);
+        pthread_cond_destroy(&context->ready);
+        pthread_mutex_destroy(&context->mutex);
+
+        RVPF_MEM_FREE(context->output);
+        context->output = NULL;
+        RVPF_MEM_FREE(context->spare);
+        context->spare = NULL;
         RVPF_MEM_FREE(context->buffer);
         context->buffer = NULL;
+        rvpf_tree_dispose(context->points);
+        context->points = NULL;
         rvpf_ssl_dispose(context->ssl);
         context->ssl = NULL;
         RVPF_MEM_FREE(context);
     }
 }
 
+extern void rvpf_xpvpc_disposePool(RVPF_XPVPC_Pool pool)
+{
+    if (pool) {
+        for (int i = 0; i < pool->idleCount; ++i) {
+            rvpf_xpvpc_dispose(pool->idle[i]);
+            pool->idle[i] = NULL;
+        }
+        pool->idleCount = 0;
+
+        pthread_mutex_destroy(&pool->mutex);
+
+        RVPF_MEM_FREE(pool->idle);
+        pool->idle = NULL;
+        RVPF_MEM_FREE(pool->password);
+        pool->password = NULL;
+        RVPF_MEM_FREE(pool->user);
+        pool->user = NULL;
+        RVPF_MEM_FREE(pool->address);
+        pool->address = NULL;
+        RVPF_MEM_FREE(pool);
+    }
+}
+
 extern char *rvpf_xpvpc_errorMessage(RVPF_XPVPC_Context context)
 {
     assert(context);
@@ -203,17 +443,17 @@ extern int rvpf_xpvpc_flush(RVPF_XPVPC_Context context)
         return context->status;
     }
 
-    if (context->pending) {
-        _addText(context, "</");
-        _addText(context, MESSAGES_ELEMENT);
-        _addText(context, ">\n");
-
-        _sendText(context);
-        _verifyResponse(context, context->id);
+    pthread_mutex_lock(&context->mutex);
 
-        context->pending = 0;
+    if (context->senderRunning) _awaitSender(context, false);
+    else {
+        if (context->polled) context->flushRequested = true;
+        _flushPending(context);
+        if (context->polled) _settleRequests(context);
     }
 
+    pthread_mutex_unlock(&context->mutex);
+
     return context->status;
 }
 
@@ -236,7 +476,16 @@ extern int rvpf_xpvpc_login(
         return context->status;
     }
 
-    rvpf_xpvpc_flush(context);
+    rvpf_xpvpc_sync(context);
+    if (rvpf_xpvpc_wouldBlock(context)) {
+        context->status = RVPF_XPVPC_ILLEGAL_STATE; // Values are in flight.
+        return context->status;
+    }
+
+    pthread_mutex_lock(&context->mutex);
+
+    // The binary framing is only offered: a server without it ignores the
+    // attribute and the connection stays on XML.
 
     _addChar(context, '<');
     _addText(context, LOGIN_ELEMENT);
@@ -258,10 +507,22 @@ extern int rvpf_xpvpc_login(
     _addText(context, PASSWORD_ATTRIBUTE);
     _addText(context, "='");
     _addEncoded(context, password, '\'');
+    if (context->binary && !context->framed) {
+        _addText(context, "' ");
+        _addText(context, FRAMING_ATTRIBUTE);
+        _addText(context, "='" BINARY_FRAMING);
+        context->negotiating = true;
+    }
     _addText(context, "'/>\n");
 
-    _sendText(context);
-    _verifyResponse(context, context->id);
+    _sendBuffer(context, context->buffer, context->position);
+    context->position = 0;
+    ++context->outstanding;
+    if (context->polled) context->syncRequested = true;
+    _verifyOutstanding(context, 0);
+    if (context->polled) _settleRequests(context);
+
+    pthread_mutex_unlock(&context->mutex);
 
     return context->status;
 }
@@ -276,8 +537,16 @@ extern int rvpf_xpvpc_open(RVPF_XPVPC_Context context, char *address)
     }
 
     context->status = RVPF_XPVPC_OK;
+    context->framed = false;
+    context->negotiating = false;
+
+    if (rvpf_ssl_open(context->ssl, address) == RVPF_SSL_OK && context->binary) {
+        // Point names are interned per connection.
+
+        rvpf_tree_clear(context->points);
+    }
 
-    return rvpf_ssl_open(context->ssl, address);
+    return rvpf_xpvpc_status(context);
 }
 
 extern bool rvpf_xpvpc_printError(RVPF_XPVPC_Context context, char *prefix)
@@ -296,6 +565,69 @@ extern bool rvpf_xpvpc_printError(RVPF_XPVPC_Context context, char *prefix)
     return true;
 }
 
+extern void rvpf_xpvpc_release(
+    RVPF_XPVPC_Pool pool,
+    RVPF_XPVPC_Context context)
+{
+    assert(pool);
+
+    if (!context) {
+        return;
+    }
+
+    if (context->senderRunning) {
+        rvpf_xpvpc_stopSender(context);
+    }
+    if (rvpf_xpvpc_succeeded(context) && rvpf_xpvpc_isOpen(context)) {
+        _syncAwaiting(context);
+    }
+
+    bool kept = false;
+
+    if (rvpf_xpvpc_succeeded(context) && rvpf_xpvpc_isOpen(context)) {
+        pthread_mutex_lock(&pool->mutex);
+        if (pool->idleCount < pool->capacity) {
+            pool->idle[pool->idleCount++] = context;
+            kept = true;
+        }
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    if (!kept) {
+        rvpf_xpvpc_dispose(context);
+    }
+}
+
+extern int rvpf_xpvpc_resume(RVPF_XPVPC_Context context)
+{
+    if (rvpf_xpvpc_failed(context)) {
+        return rvpf_xpvpc_status(context);
+    }
+    if (!context->polled || !rvpf_xpvpc_isOpen(context)) {
+        context->status = RVPF_XPVPC_ILLEGAL_STATE;
+        return context->status;
+    }
+
+    pthread_mutex_lock(&context->mutex);
+
+    context->readBlocked = false;
+    _sendOutput(context);
+    if (context->pending && (context->flushRequested
+            || context->syncRequested || _flushDue(context))) {
+        _flushPending(context);
+    } else {
+        _verifyOutstanding(
+            context,
+            context->window > 1? context->window - 1: 0);
+    }
+    if (context->syncRequested) _verifyOutstanding(context, 0);
+    _settleRequests(context);
+
+    pthread_mutex_unlock(&context->mutex);
+
+    return rvpf_xpvpc_status(context);
+}
+
 extern int rvpf_xpvpc_sendValue(
     RVPF_XPVPC_Context context,
     char *point,
@@ -314,87 +646,82 @@ extern int rvpf_xpvpc_sendValue(
         context->status = RVPF_XPVPC_ILLEGAL_ARG;
         return context->status;
     }
-
-    if (!context->pending) {
-        _addChar(context, '<');
-        _addText(context, MESSAGES_ELEMENT);
-        _addChar(context, ' ');
-
-        _addText(context, ID_ATTRIBUTE);
-        _addText(context, "='");
-        _addLong(context, ++context->id);
-        _addText(context, "' ");
-
-        _addText(context, FLUSH_ATTRIBUTE);
-        _addText(context, "='yes'>\n");
+    if (context->negotiating) {
+        context->status = RVPF_XPVPC_ILLEGAL_STATE; // The login is in flight.
+        return context->status;
     }
 
-    _addText(context, " <");
-    _addText(context,
-        state == _deletedState?
-            DELETED_VALUE_ELEMENT: POINT_VALUE_ELEMENT);
-    _addText(context, ">\n");
-
-    _addText(context, "  <");
-    _addText(context, POINT_ELEMENT);
-    _addChar(context, '>');
-    _addEncoded(context, point, '\0');
-    _addText(context, "</");
-    _addText(context, POINT_ELEMENT);
-    _addText(context, ">\n");
-
-    _addText(context, "  <");
-    _addText(context, STAMP_ELEMENT);
-    _addChar(context, '>');
-    _addEncoded(context, stamp, '\0');
-    _addText(context, "</");
-    _addText(context, STAMP_ELEMENT);
-    _addText(context, ">\n");
+    pthread_mutex_lock(&context->mutex);
 
-    if (state != _deletedState) {
-        if (state) {
-            _addText(context, "  <");
-            _addText(context, STATE_ELEMENT);
-            _addChar(context, '>');
-            _addEncoded(context, state, '\0');
-            _addText(context, "</");
-            _addText(context, STATE_ELEMENT);
-            _addText(context, ">\n");
-        }
-
-        if (value) {
-            while (isspace((unsigned char) *value)) {
-                ++value;
-            }
-            _addText(context, "  <");
-            _addText(context, VALUE_ELEMENT);
-            _addChar(context, '>');
-            _addEncoded(context, value, '\0');
-            _addText(context, "</");
-            _addText(context, VALUE_ELEMENT);
-            _addText(context, ">\n");
+    if (!context->pending) {
+        clock_gettime(CLOCK_REALTIME, &context->pendingSince);
+
+        if (context->framed) {
+            _beginFrame(context, BINARY_MESSAGES_FRAME);
+            _addUnsigned(context, ++context->id);
+            _addChar(context, BINARY_FLUSH_FLAG);
+        } else {
+            _addText(context, "<" MESSAGES_ELEMENT " " ID_ATTRIBUTE "='");
+            _addLong(context, ++context->id);
+            _addText(context, "' " FLUSH_ATTRIBUTE "='yes'>\n");
         }
     }
 
-    _addText(context, " </");
-    _addText(context,
-        state == _deletedState?
-            DELETED_VALUE_ELEMENT: POINT_VALUE_ELEMENT);
-    _addText(context, ">\n");
+    if (context->framed) {
+        _addBinaryValue(context, point, stamp, state, value);
+    } else {
+        _addXMLValue(context, point, stamp, state, value);
+    }
 
     ++context->pending;
-    if (_autoFlush > 0 && context->pending >= _autoFlush) {
-        rvpf_xpvpc_flush(context);
-    }
+    if (context->senderRunning) {
+        if ((context->pending == 1 && context->autoFlushMillis > 0)
+                || _flushDue(context)) {
+            pthread_cond_signal(&context->ready);
+        }
+    } else if (_flushDue(context)) _flushPending(context);
+
+    pthread_mutex_unlock(&context->mutex);
 
     return context->status;
 }
 
+
 extern void rvpf_xpvpc_setAutoFlush(RVPF_XPVPC_Context context, int autoFlush)
 {
     if (rvpf_xpvpc_isOpen(context)) rvpf_xpvpc_flush(context);
 
-    _autoFlush = autoFlush;
+    context->autoFlush = autoFlush;
+}
+
+extern void rvpf_xpvpc_setAutoFlushBytes(
+    RVPF_XPVPC_Context context,
+    size_t autoFlushBytes)
+{
+    if (rvpf_xpvpc_isOpen(context)) rvpf_xpvpc_flush(context);
+
+    context->autoFlushBytes = autoFlushBytes;
+}
+
+extern void rvpf_xpvpc_setAutoFlushMillis(
+    RVPF_XPVPC_Context context,
+    int autoFlushMillis)
+{
+    if (rvpf_xpvpc_isOpen(context)) rvpf_xpvpc_flush(context);
+
+    pthread_mutex_lock(&context->mutex);
+
+    context->autoFlushMillis = autoFlushMillis;
+    pthread_cond_signal(&context->ready);
+
+    pthread_mutex_unlock(&context->mutex);
+}
+
+extern void rvpf_xpvpc_setBinary(RVPF_XPVPC_Context context, bool binary)
+{
+    assert(context);
+
+    context->binary = binary;
 }
 
 extern void rvpf_xpvpc_setClient(RVPF_XPVPC_Context context, char *client)
@@ -412,279 +739,1024 @@ extern void rvpf_xpvpc_setClient(RVPF_XPVPC_Context context, char *client)
     }
 }
 
-extern RVPF_SSL_Context rvpf_xpvpc_ssl(RVPF_XPVPC_Context context)
+extern void rvpf_xpvpc_setPolled(RVPF_XPVPC_Context context, bool polled)
 {
     assert(context);
 
-    return context->ssl;
+    if (context->senderRunning) {
+        context->status = RVPF_XPVPC_ILLEGAL_STATE;
+        return;
+    }
+
+    if (!polled && rvpf_xpvpc_isOpen(context)) _syncAwaiting(context);
+
+    context->polled = polled;
+    rvpf_ssl_setBlocking(context->ssl, !polled);
 }
 
-extern int rvpf_xpvpc_status(RVPF_XPVPC_Context context)
+extern void rvpf_xpvpc_setWindow(RVPF_XPVPC_Context context, int window)
 {
-    assert(context);
+    if (rvpf_xpvpc_isOpen(context)) _syncAwaiting(context);
 
-    return context->status != RVPF_XPVPC_OK? context->status:
-            rvpf_ssl_status(context->ssl);
+    context->window = window;
 }
 
-extern bool rvpf_xpvpc_succeeded(RVPF_XPVPC_Context context)
+extern int rvpf_xpvpc_socket(RVPF_XPVPC_Context context)
 {
     assert(context);
 
-    return context->status == RVPF_XPVPC_OK
-        && rvpf_ssl_succeeded(context->ssl);
+    return rvpf_ssl_socket(context->ssl);
 }
 
-extern char *rvpf_xpvpc_version(void)
+extern RVPF_SSL_Context rvpf_xpvpc_ssl(RVPF_XPVPC_Context context)
 {
-    return "RVPF_XPVPC " RVPF_VERSION_REVISION;
-}
+    assert(context);
 
-// Private function definitions.
+    return context->ssl;
+}
 
-static void _addChar(RVPF_XPVPC_Context context, char c)
+extern int rvpf_xpvpc_startSender(RVPF_XPVPC_Context context)
 {
-    if (context->status != RVPF_XPVPC_OK) {
-        return;
+    assert(context);
+
+    if (context->senderRunning || context->polled) {
+        context->status = RVPF_XPVPC_ILLEGAL_STATE;
+        return context->status;
     }
 
-    if (context->position >= context->size - 1) {
-        size_t size = context->size * 2;
-        char *buffer = RVPF_MEM_REALLOCATE(context->buffer, size);
+    pthread_mutex_lock(&context->mutex);
 
-        memset(buffer + size, '\0', size);
-        context->buffer = buffer;
-        context->size = size;
-    }
+    context->senderStopping = false;
+    if (pthread_create(&context->sender, NULL, _sender, context)) {
+        context->status = RVPF_XPVPC_INTERNAL_ERROR;
+    } else context->senderRunning = true;
 
-    context->buffer[context->position++] = c;
-    context->buffer[context->position] = '\0';
+    pthread_mutex_unlock(&context->mutex);
+
+    return context->status;
 }
 
-static void _addEncoded(RVPF_XPVPC_Context context, char *text, char quote)
+extern int rvpf_xpvpc_status(RVPF_XPVPC_Context context)
 {
-    char *start;
-    char *end;
+    assert(context);
 
-    if (context->status != RVPF_XPVPC_OK) {
-        return;
-    }
+    return context->status != RVPF_XPVPC_OK? context->status:
+            rvpf_ssl_status(context->ssl);
+}
 
-    if (!text) {
-        return;
+extern int rvpf_xpvpc_stopSender(RVPF_XPVPC_Context context)
+{
+    assert(context);
+
+    if (!context->senderRunning) {
+        context->status = RVPF_XPVPC_ILLEGAL_STATE;
+        return context->status;
     }
 
-    // Trims.
+    pthread_mutex_lock(&context->mutex);
 
-    while (isspace((unsigned char) *text)) {
-        ++text;
-    }
-    start = text;
+    context->senderStopping = true;
+    pthread_cond_signal(&context->ready);
 
-    while (*text) {
-        ++text;
+    pthread_mutex_unlock(&context->mutex);
+
+    pthread_join(context->sender, NULL);
+    context->senderRunning = false;
+    context->senderStopping = false;
+
+    return rvpf_xpvpc_status(context);
+}
+
+extern bool rvpf_xpvpc_succeeded(RVPF_XPVPC_Context context)
+{
+    assert(context);
+
+    return context->status == RVPF_XPVPC_OK
+        && rvpf_ssl_succeeded(context->ssl);
+}
+
+extern int rvpf_xpvpc_sync(RVPF_XPVPC_Context context)
+{
+    if (rvpf_xpvpc_failed(context)) {
+        return rvpf_xpvpc_status(context);
+    }
+    if (!rvpf_xpvpc_isOpen(context)) {
+        context->status = RVPF_XPVPC_ILLEGAL_STATE;
+        return context->status;
     }
 
-    while (text != start) {
-        if (!isspace((unsigned char) text[-1])) {
-            break;
+    pthread_mutex_lock(&context->mutex);
+
+    if (context->senderRunning) _awaitSender(context, true);
+    else {
+        if (context->polled) {
+            context->flushRequested = true;
+            context->syncRequested = true;
         }
-        --text;
+        _flushPending(context);
+        _verifyOutstanding(context, 0);
+        if (context->polled) _settleRequests(context);
     }
-    end = text;
 
-    // Encodes.
+    pthread_mutex_unlock(&context->mutex);
 
-    text = start;
-    while (text != end) {
-        char next = *text++;
+    return rvpf_xpvpc_status(context);
+}
 
-        switch (next) {
-        case '<':
-            _addText(context, "&lt;");
-            break;
-        case '>':
-            _addText(context, "&gt;");
-            break;
-        case '&':
-            _addText(context, "&amp;");
-            break;
-        case '"':
-            if (quote == next) {
-                _addText(context, "&quot;");
-            } else {
-                _addChar(context, next);
-            }
+extern char *rvpf_xpvpc_version(void)
+{
+    return "RVPF_XPVPC " RVPF_VERSION_REVISION;
+}
+
+extern bool rvpf_xpvpc_wantsRead(RVPF_XPVPC_Context context)
+{
+    assert(context);
+
+    return (context->readBlocked && !context->readWantsWrite)
+        || (context->outputPosition < context->outputLimit
+            && context->writeWantsRead);
+}
+
+extern bool rvpf_xpvpc_wantsWrite(RVPF_XPVPC_Context context)
+{
+    assert(context);
+
+    return (context->readBlocked && context->readWantsWrite)
+        || (context->outputPosition < context->outputLimit
+            && !context->writeWantsRead);
+}
+
+extern bool rvpf_xpvpc_wouldBlock(RVPF_XPVPC_Context context)
+{
+    assert(context);
+
+    return context->readBlocked
+        || context->outputPosition < context->outputLimit;
+}
+
+// Private function definitions.
+
+static void _addBinaryValue(
+    RVPF_XPVPC_Context context,
+    char *point,
+    char *stamp,
+    char *state,
+    char *value)
+{
+    bool deleted = state == _deletedState;
+    const long *index = rvpf_tree_get(context->points, point);
+    long long raw;
+    char flags = 0;
+
+    if (deleted) flags |= BINARY_DELETED_FLAG;
+    if (!index) {
+        long *newIndex = RVPF_MEM_ALLOCATE(sizeof(long));
+
+        *newIndex = rvpf_tree_size(context->points);
+        rvpf_tree_put(context->points, RVPF_MEM_STRING(point), newIndex);
+        index = newIndex;
+        flags |= BINARY_NEW_POINT_FLAG;
+    }
+    if (_parseStamp(stamp, &raw)) flags |= BINARY_RAW_STAMP_FLAG;
+    if (!deleted && state) flags |= BINARY_STATE_FLAG;
+    if (!deleted && value) flags |= BINARY_VALUE_FLAG;
+
+    _addChar(context, flags);
+    _addUnsigned(context, *index);
+    if (flags & BINARY_NEW_POINT_FLAG) _addString(context, point);
+    if (flags & BINARY_RAW_STAMP_FLAG) {
+        char bytes[8];
+        int i;
+
+        for (i = 0; i < 8; ++i) {
+            bytes[i] = (char) ((unsigned long long) raw >> (8 * i));
+        }
+        _addBytes(context, bytes, sizeof(bytes));
+    } else _addString(context, stamp);
+    if (flags & BINARY_STATE_FLAG) _addString(context, state);
+    if (flags & BINARY_VALUE_FLAG) _addString(context, value);
+}
+
+static void _addBytes(RVPF_XPVPC_Context context, char *bytes, size_t length)
+{
+    if (!_reserve(context, length)) {
+        return;
+    }
+
+    memcpy(context->buffer + context->position, bytes, length);
+    context->position += length;
+    context->buffer[context->position] = '\0';
+}
+
+static void _addChar(RVPF_XPVPC_Context context, char c)
+{
+    if (!_reserve(context, 1)) {
+        return;
+    }
+
+    context->buffer[context->position++] = c;
+    context->buffer[context->position] = '\0';
+}
+
+static void _addElement(RVPF_XPVPC_Context context, char *name, char *text)
+{
+    size_t nameLength = strlen(name);
+
+    // Reserves for the tags and the worst case encoding of the text.
+
+    if (!_reserve(
+            context,
+            2 * nameLength + 8 + ESCAPE_MAX_LENGTH * strlen(text))) {
+        return;
+    }
+
+    _addBytes(context, "  <", 3);
+    _addBytes(context, name, nameLength);
+    _addChar(context, '>');
+    _addEncoded(context, text, '\0');
+    _addBytes(context, "</", 2);
+    _addBytes(context, name, nameLength);
+    _addBytes(context, ">\n", 2);
+}
+
+static void _addEncoded(RVPF_XPVPC_Context context, char *text, char quote)
+{
+    char *start;
+    char *end;
+    char *buffer;
+    size_t length;
+    size_t position;
+
+    if (!text) {
+        return;
+    }
+
+    start = _trim(text, &length);
+    end = start + length;
+
+    if (!_reserve(context, ESCAPE_MAX_LENGTH * (end - start))) {
+        return;
+    }
+
+    // Encodes: copies the clean runs as a whole, then escapes the next byte.
+
+    buffer = context->buffer;
+    position = context->position;
+    text = start;
+    while (text != end) {
+        unsigned char next;
+
+        length = _cleanLength(text, end - text, quote);
+        memcpy(buffer + position, text, length);
+        position += length;
+        text += length;
+        if (text == end) {
+            break;
+        }
+
+        next = (unsigned char) *text++;
+        switch (next) {
+        case '<':
+            memcpy(buffer + position, "&lt;", 4);
+            position += 4;
+            break;
+        case '>':
+            memcpy(buffer + position, "&gt;", 4);
+            position += 4;
+            break;
+        case '&':
+            memcpy(buffer + position, "&amp;", 5);
+            position += 5;
+            break;
+        case '"':
+            memcpy(buffer + position, "&quot;", 6);
+            position += 6;
             break;
         case '\'':
-            if (quote == next) {
-                _addText(context, "&apos;");
-            } else {
-                _addChar(context, next);
-            }
+            memcpy(buffer + position, "&apos;", 6);
+            position += 6;
             break;
         case '\t':
         case '\n':
         case '\r':
-            _addChar(context, next);
+            buffer[position++] = next;
             break;
         default:
-            if (next < ' ') {
-                _addText(context, "&#");
-                _addLong(context, next);
-                _addChar(context, ';');
-            } else {
-                _addChar(context, next);
-            }
+            buffer[position++] = '&';
+            buffer[position++] = '#';
+            if (next >= 10) buffer[position++] = next / 10 + '0';
+            buffer[position++] = next % 10 + '0';
+            buffer[position++] = ';';
             break;
         }
     }
+
+    context->position = position;
+    buffer[position] = '\0';
 }
 
 static void _addLong(RVPF_XPVPC_Context context, long long n)
 {
     char buffer[20];
-    size_t position = 0;
-
-    if (context->status != RVPF_XPVPC_OK) {
-        return;
-    }
+    size_t position = sizeof(buffer);
 
     do {
-        if (position >= sizeof(buffer)) {
+        if (position == 0) {
             context->status = RVPF_XPVPC_INTERNAL_ERROR;
             return;
         }
-        buffer[position++] = n % 10 + '0';
+        buffer[--position] = n % 10 + '0';
     } while ((n /= 10) > 0);
 
-    do {
-        _addChar(context, buffer[--position]);
-    } while (position > 0);
+    _addBytes(context, buffer + position, sizeof(buffer) - position);
+}
+
+static void _addString(RVPF_XPVPC_Context context, char *text)
+{
+    size_t length;
+
+    text = _trim(text, &length);
+    _addUnsigned(context, length);
+    _addBytes(context, text, length);
 }
 
 static void _addText(RVPF_XPVPC_Context context, char *text)
 {
+    _addBytes(context, text, strlen(text));
+}
+
+static void _addUnsigned(RVPF_XPVPC_Context context, unsigned long long n)
+{
+    char buffer[10];
+    size_t position = 0;
+
+    // Seven bits at a time, low order first, high bit set on all but the last.
+
+    while (n >= 0x80) {
+        buffer[position++] = (char) ((n & 0x7F) | 0x80);
+        n >>= 7;
+    }
+    buffer[position++] = (char) n;
+
+    _addBytes(context, buffer, position);
+}
+
+static void _addXMLValue(
+    RVPF_XPVPC_Context context,
+    char *point,
+    char *stamp,
+    char *state,
+    char *value)
+{
+    char *element;
+
+    element = state == _deletedState?
+        DELETED_VALUE_ELEMENT: POINT_VALUE_ELEMENT;
+
+    _addText(context, " <");
+    _addText(context, element);
+    _addText(context, ">\n");
+
+    _addElement(context, POINT_ELEMENT, point);
+    _addElement(context, STAMP_ELEMENT, stamp);
+    if (state != _deletedState) {
+        if (state) _addElement(context, STATE_ELEMENT, state);
+        if (value) _addElement(context, VALUE_ELEMENT, value);
+    }
+
+    _addText(context, " </");
+    _addText(context, element);
+    _addText(context, ">\n");
+}
+
+static void _awaitSender(RVPF_XPVPC_Context context, bool sync)
+{
+    // Called with the mutex locked.
+
+    context->flushRequested = true;
+    if (sync) context->syncRequested = true;
+    pthread_cond_signal(&context->ready);
+
+    while ((context->flushRequested || context->syncRequested)
+            && rvpf_xpvpc_succeeded(context)) {
+        pthread_cond_wait(&context->done, &context->mutex);
+    }
+}
+
+static void _beginFrame(RVPF_XPVPC_Context context, char type)
+{
+    // The frame length is patched in when the frame is closed.
+
+    _addChar(context, type);
+    context->frameStart = context->position;
+    _addBytes(context, "\0\0\0\0", 4);
+}
+
+static size_t _cleanLength(char *text, size_t length, char quote)
+{
+    // Scans a word at a time for the bytes needing an escape: controls
+    // (below a space), '<', '>', '&' and the quote when there is one.
+
+    static const uint64_t ones = 0x0101010101010101ULL;
+    static const uint64_t highs = 0x8080808080808080ULL;
+    size_t position = 0;
+
+#define HAS_ZERO(word) (((word) - ones) & ~(word) & highs)
+
+    while (length - position >= sizeof(uint64_t)) {
+        uint64_t word;
+        uint64_t found;
+
+        memcpy(&word, text + position, sizeof(word));
+        found = ((word - ones * ' ') & ~word & highs)
+            | HAS_ZERO(word ^ (ones * '<'))
+            | HAS_ZERO(word ^ (ones * '>'))
+            | HAS_ZERO(word ^ (ones * '&'));
+        if (quote) found |= HAS_ZERO(word ^ (ones * (unsigned char) quote));
+        if (found) {
+            break;
+        }
+        position += sizeof(word);
+    }
+
+#undef HAS_ZERO
+
+    while (position < length) {
+        unsigned char next = (unsigned char) text[position];
+
+        if (next < ' ' || next == '<' || next == '>' || next == '&'
+                || (quote && next == (unsigned char) quote)) {
+            break;
+        }
+        ++position;
+    }
+
+    return position;
+}
+
+static void _closeFrame(RVPF_XPVPC_Context context)
+{
+    size_t length = context->position - context->frameStart - 4;
+    unsigned char *bytes;
+    int i;
+
     if (context->status != RVPF_XPVPC_OK) {
         return;
     }
 
-    while (*text) {
-        _addChar(context, *text++);
+    bytes = (unsigned char *) context->buffer + context->frameStart;
+    for (i = 0; i < 4; ++i) {
+        bytes[i] = (unsigned char) (length >> (8 * i));
+    }
+}
+
+static void _closeMessages(RVPF_XPVPC_Context context)
+{
+    if (context->framed) _closeFrame(context);
+    else {
+        _addText(context, "</");
+        _addText(context, MESSAGES_ELEMENT);
+        _addText(context, ">\n");
+    }
+}
+
+static bool _flushDue(RVPF_XPVPC_Context context)
+{
+    if (!context->pending) {
+        return false;
+    }
+
+    if (context->autoFlush > 0 && context->pending >= context->autoFlush) {
+        return true;
+    }
+
+    if (context->autoFlushBytes > 0
+            && context->position >= context->autoFlushBytes) {
+        return true;
+    }
+
+    if (context->autoFlushMillis > 0) {
+        struct timespec now;
+
+        clock_gettime(CLOCK_REALTIME, &now);
+
+        long long elapsed =
+            (now.tv_sec - context->pendingSince.tv_sec) * 1000LL
+            + (now.tv_nsec - context->pendingSince.tv_nsec) / 1000000;
+
+        if (elapsed >= context->autoFlushMillis) {
+            return true;
+        }
     }
+
+    return false;
 }
 
-static void _match(RVPF_XPVPC_Context context, char *text)
+static void _flushPending(RVPF_XPVPC_Context context)
+{
+    // Called, without a sender, with the mutex locked. When polled, the
+    // pending values wait for room in the window.
+
+    int window = context->window > 1? context->window - 1: 0;
+
+    if (context->polled && context->outstanding > window) {
+        _verifyOutstanding(context, window);
+        if (context->outstanding > window) {
+            return;
+        }
+    }
+
+    if (context->pending) {
+        _closeMessages(context);
+
+        _sendBuffer(context, context->buffer, context->position);
+        context->position = 0;
+        ++context->outstanding;
+
+        context->pending = 0;
+    }
+
+    _verifyOutstanding(context, window);
+}
+
+static int _match(RVPF_XPVPC_Context context, char *text)
 {
     while (*text) {
-        if (context->position >= context->limit
-                || context->buffer[context->position] != *text) {
-            context->status = RVPF_XPVPC_UNEXPECTED_RESPONSE;
-            break;
+        if (context->linePosition >= context->lineLimit
+                || context->line[context->linePosition] != *text) {
+            return RVPF_XPVPC_UNEXPECTED_RESPONSE;
         }
         ++text;
-        ++context->position;
+        ++context->linePosition;
     }
+
+    return RVPF_XPVPC_OK;
 }
 
-static void _receiveLine(RVPF_XPVPC_Context context)
+static bool _parseStamp(char *stamp, long long *raw)
+{
+    // Only accepts UTC stamps like "2006-01-01T04:00:00.0000000Z"; others
+    // are sent as text for the server to interpret.
+
+    int year, month, day, hour, minute;
+    int second = 0;
+    long long fraction = 0;
+    long long days;
+    int scale = 1000000;
+    int count = 0;
+    char *next;
+
+    while (isspace((unsigned char) *stamp)) {
+        ++stamp;
+    }
+
+    if (sscanf(stamp, "%4d-%2d-%2d%*1[T ]%2d:%2d%n",
+            &year, &month, &day, &hour, &minute, &count) < 5 || !count) {
+        return false;
+    }
+    next = stamp + count;
+    if (*next == ':') {
+        if (!isdigit((unsigned char) next[1])
+                || !isdigit((unsigned char) next[2])) {
+            return false;
+        }
+        second = (next[1] - '0') * 10 + next[2] - '0';
+        next += 3;
+        if (*next == '.') {
+            ++next;
+            while (isdigit((unsigned char) *next)) {
+                if (scale > 0) {
+                    fraction += (*next - '0') * scale;
+                    scale /= 10;
+                }
+                ++next;
+            }
+        }
+    }
+    if (*next++ != 'Z') {
+        return false;
+    }
+    while (isspace((unsigned char) *next)) {
+        ++next;
+    }
+    if (*next || month < 1 || month > 12 || day < 1 || day > 31
+            || hour > 23 || minute > 59 || second > 59) {
+        return false;
+    }
+
+    // Days since the Unix epoch in the proleptic Gregorian calendar.
+
+    if (month <= 2) --year;
+    {
+        long long era = (year >= 0? year: year - 399) / 400;
+        long long yearOfEra = year - era * 400;
+        long long dayOfYear =
+            (153 * (month > 2? month - 3: month + 9) + 2) / 5 + day - 1;
+        long long dayOfEra =
+            yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+        days = era * 146097 + dayOfEra - 719468;
+    }
+
+    *raw = ((days * 24 + hour) * 60 + minute) * 60 + second;
+    *raw = *raw * RAW_PER_SECOND + fraction + UNIX_EPOCH_RAW;
+
+    return true;
+}
+
+static int _receiveLine(RVPF_XPVPC_Context context)
+{
+    // When polled, a line interrupted by the connection is resumed.
+
+    if (!context->linePartial) {
+        context->lineLimit = 0;
+    }
+    context->linePartial = false;
+    context->linePosition = 0;
+    for (;;) {
+        if (context->inputPosition < context->inputLimit) {
+            char *start = context->input + context->inputPosition;
+            size_t available = context->inputLimit - context->inputPosition;
+            char *end = memchr(start, '\n', available);
+            size_t length = end? (size_t) (end - start): available;
+
+            if (context->lineLimit + length >= sizeof(context->line)) {
+                return RVPF_XPVPC_UNEXPECTED_RESPONSE;
+            }
+            memcpy(context->line + context->lineLimit, start, length);
+            context->lineLimit += length;
+            context->inputPosition += end? length + 1: length;
+
+            if (end) {
+                context->line[context->lineLimit] = '\0';
+                return RVPF_XPVPC_OK;
+            }
+        }
+
+        // Keeps what follows the line for the next responses.
+
+        int count = rvpf_ssl_receive(
+            context->ssl,
+            context->input,
+            sizeof(context->input));
+
+        if (rvpf_ssl_failed(context->ssl)) {
+            return RVPF_XPVPC_OK;
+        }
+        if (rvpf_ssl_wouldBlock(context->ssl)) {
+            if (context->polled) {
+                context->readBlocked = true;
+                context->readWantsWrite = rvpf_ssl_wantsWrite(context->ssl);
+                context->linePartial = true;
+                return RVPF_XPVPC_OK;
+            }
+            rvpf_ssl_await(context->ssl, -1);
+            continue;
+        }
+
+        context->inputLimit = count;
+        context->inputPosition = 0;
+    }
+}
+
+static void _queueOutput(
+        RVPF_XPVPC_Context context,
+        RVPF_SSL_Buffer *buffers,
+        int count)
+{
+    size_t length = context->outputLimit - context->outputPosition;
+    size_t size = length;
+
+    for (int i = 0; i < count; ++i) {
+        size += buffers[i].size;
+    }
+
+    if (context->outputPosition > 0) {
+        memmove(context->output,
+            context->output + context->outputPosition, length);
+        context->outputPosition = 0;
+        context->outputLimit = length;
+    }
+    if (size > context->outputSize) {
+        size_t outputSize = context->outputSize? context->outputSize:
+            MIN_BUFFER_SIZE;
+
+        while (outputSize < size) {
+            outputSize *= 2;
+        }
+        context->output = RVPF_MEM_REALLOCATE(context->output, outputSize);
+        context->outputSize = outputSize;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        memcpy(context->output + context->outputLimit,
+            buffers[i].buffer, buffers[i].size);
+        context->outputLimit += buffers[i].size;
+    }
+}
+
+static bool _reserve(RVPF_XPVPC_Context context, size_t length)
 {
     if (context->status != RVPF_XPVPC_OK) {
+        return false;
+    }
+
+    // Keeps room for a terminating null.
+
+    if (context->position + length >= context->size) {
+        size_t size = context->size;
+        char *buffer;
+
+        while (context->position + length >= size) {
+            size *= 2;
+        }
+        buffer = RVPF_MEM_REALLOCATE(context->buffer, size);
+        memset(buffer + context->size, '\0', size - context->size);
+        context->buffer = buffer;
+        context->size = size;
+    }
+
+    return true;
+}
+
+static void _sendBuffer(RVPF_XPVPC_Context context, char *buffer, size_t length)
+{
+    RVPF_SSL_Buffer buffers[1];
+    int first = 0;
+    int count = 0;
+
+    if (rvpf_xpvpc_failed(context)) {
         return;
     }
 
-    context->limit = 0;
-    context->position = 0;
-    while (context->limit < context->size - 1) {
-        int count = rvpf_ssl_receive(
+    if (length > 0) {
+        buffers[count].buffer = buffer;
+        buffers[count++].size = length;
+    }
+
+    if (context->outputPosition < context->outputLimit) {
+        // Keeps the order behind the output already queued.
+
+        _queueOutput(context, buffers, count);
+        _sendOutput(context);
+        return;
+    }
+
+    while (first < count) {
+        int sent = rvpf_ssl_sendBuffers(
             context->ssl,
-            context->buffer + context->limit,
-            context->size - 1 - context->limit);
+            buffers + first,
+            count - first);
 
         if (rvpf_ssl_failed(context->ssl)) {
-            return;
+            break;
         }
+        if (rvpf_ssl_wouldBlock(context->ssl)) {
+            if (context->polled) {
+                // A secure connection resumes with the same bytes.
 
-        if (context->limit + count >= context->size - 1) {
-            context->status = RVPF_XPVPC_INTERNAL_ERROR;
-            return;
+                context->writeWantsRead = !rvpf_ssl_wantsWrite(context->ssl);
+                _queueOutput(context, buffers + first, count - first);
+                break;
+            }
+            rvpf_ssl_await(context->ssl, -1);
+            continue;
         }
-        context->buffer[context->limit + count] = '\0';
 
-        do {
-            if (context->buffer[context->limit] == '\n') {
-                context->buffer[context->limit] = '\0';
+        // Skips what has been sent, including empty buffers.
+
+        size_t position = sent;
+
+        while (first < count && position >= buffers[first].size) {
+            position -= buffers[first++].size;
+        }
+        if (first < count) {
+            buffers[first].buffer += position;
+            buffers[first].size -= position;
+        }
+    }
+}
+
+static void _sendOutput(RVPF_XPVPC_Context context)
+{
+    while (context->outputPosition < context->outputLimit) {
+        int sent = rvpf_ssl_send(
+            context->ssl,
+            context->output + context->outputPosition,
+            context->outputLimit - context->outputPosition);
+
+        if (rvpf_ssl_failed(context->ssl)) {
+            return;
+        }
+        if (rvpf_ssl_wouldBlock(context->ssl)) {
+            if (context->polled) {
+                context->writeWantsRead = !rvpf_ssl_wantsWrite(context->ssl);
                 return;
             }
-            ++context->limit;
-        } while (--count > 0);
+            rvpf_ssl_await(context->ssl, -1);
+            continue;
+        }
+
+        context->outputPosition += sent;
     }
 
-    if (context->limit >= context->size) {
-        context->status = RVPF_XPVPC_UNEXPECTED_RESPONSE;
+    context->outputPosition = 0;
+    context->outputLimit = 0;
+}
+
+static void *_sender(void *argument)
+{
+    RVPF_XPVPC_Context context = argument;
+
+    pthread_mutex_lock(&context->mutex);
+
+    for (;;) {
+        bool failed = !rvpf_xpvpc_succeeded(context);
+        bool draining = context->senderStopping || context->syncRequested;
+
+        if (!failed && context->pending && (draining
+                || context->flushRequested || _flushDue(context))) {
+            char *buffer = context->buffer;
+            size_t size = context->size;
+            size_t length;
+
+            _closeMessages(context);
+            length = context->position;
+
+            context->buffer = context->spare;
+            context->size = context->spareSize;
+            context->position = 0;
+            context->spare = buffer;
+            context->spareSize = size;
+            context->pending = 0;
+            ++context->outstanding;
+
+            pthread_mutex_unlock(&context->mutex);
+            _sendBuffer(context, buffer, length);
+            pthread_mutex_lock(&context->mutex);
+            continue;
+        }
+
+        int window = draining? 0: context->window > 1? context->window - 1: 0;
+
+        if (!failed && context->outstanding > window) {
+            // A batch started since does not have its acknowledgement due.
+            long long expectedId = context->id - context->outstanding + 1
+                - (context->pending? 1: 0);
+
+            pthread_mutex_unlock(&context->mutex);
+
+            int status = _verifyResponse(context, expectedId);
+
+            pthread_mutex_lock(&context->mutex);
+            if (status != RVPF_XPVPC_OK) context->status = status;
+            else --context->outstanding;
+            continue;
+        }
+
+        if (failed || !context->pending) {
+            context->flushRequested = false;
+            if (failed || !context->outstanding) context->syncRequested = false;
+            pthread_cond_broadcast(&context->done);
+        }
+
+        if (context->senderStopping
+                && (failed || (!context->pending && !context->outstanding))) {
+            break;
+        }
+
+        if (context->pending && context->autoFlushMillis > 0) {
+            struct timespec deadline = context->pendingSince;
+
+            deadline.tv_sec += context->autoFlushMillis / 1000;
+            deadline.tv_nsec += (context->autoFlushMillis % 1000) * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                ++deadline.tv_sec;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&context->ready, &context->mutex, &deadline);
+        } else pthread_cond_wait(&context->ready, &context->mutex);
     }
+
+    pthread_mutex_unlock(&context->mutex);
+
+    return NULL;
 }
 
-static void _resetText(RVPF_XPVPC_Context context)
+static void _settleRequests(RVPF_XPVPC_Context context)
 {
-    context->limit = context->position;
-    context->position = 0;
+    // Called, when polled, with the mutex locked.
+
+    if (!context->pending
+            && context->outputPosition == context->outputLimit) {
+        context->flushRequested = false;
+    }
+    if (!context->flushRequested && !context->outstanding) {
+        context->syncRequested = false;
+    }
 }
 
-static void _sendText(RVPF_XPVPC_Context context)
+static void _syncAwaiting(RVPF_XPVPC_Context context)
 {
-    if (rvpf_xpvpc_failed(context)) {
+    // Completes, awaiting the connection, what a polled context has left.
+
+    if (!context->polled) {
+        rvpf_xpvpc_sync(context);
         return;
     }
 
-    _resetText(context);
+    context->polled = false;
+    context->readBlocked = false;
+    rvpf_xpvpc_sync(context);
+    context->flushRequested = false;
+    context->syncRequested = false;
+    context->polled = true;
+}
 
-    while (context->position < context->limit) {
-        int count = rvpf_ssl_send(
-            context->ssl,
-            context->buffer + context->position,
-            context->limit - context->position);
+static char *_trim(char *text, size_t *length)
+{
+    char *end;
 
-        if (rvpf_ssl_failed(context->ssl)) {
+    while (isspace((unsigned char) *text)) {
+        ++text;
+    }
+    end = text + strlen(text);
+
+    while (end != text) {
+        if (!isspace((unsigned char) end[-1])) {
             break;
         }
+        --end;
+    }
+
+    *length = end - text;
+
+    return text;
+}
 
-        context->position += count;
+static void _verifyOutstanding(RVPF_XPVPC_Context context, int window)
+{
+    // When polled, a batch started since does not have its acknowledgement
+    // due.
+
+    while (context->outstanding > window && rvpf_xpvpc_succeeded(context)
+            && !context->readBlocked) {
+        long long expectedId = context->id - context->outstanding + 1
+            - (context->pending? 1: 0);
+        int status = _verifyResponse(context, expectedId);
+
+        if (context->readBlocked) {
+            break;
+        }
+        context->status = status;
+        --context->outstanding;
     }
 }
 
-static void _verifyResponse(RVPF_XPVPC_Context context, long long expectedId)
+static int _verifyResponse(RVPF_XPVPC_Context context, long long expectedId)
 {
     long long receivedId = 0;
+    int status = _receiveLine(context);
 
-    _receiveLine(context);
-    if (context->status != RVPF_XPVPC_OK) {
-        return;
+    if (status != RVPF_XPVPC_OK || rvpf_ssl_failed(context->ssl)
+            || context->readBlocked) {
+        return status;
     }
 
-    _match(context, RESPONSE_START);
-    if (context->status != RVPF_XPVPC_OK) {
-        return;
+    status = _match(context, RESPONSE_START);
+    if (status != RVPF_XPVPC_OK) {
+        return status;
     }
 
-    while (context->position < context->limit) {
-        if (!isdigit((unsigned char) context->buffer[context->position])) {
+    while (context->linePosition < context->lineLimit) {
+        if (!isdigit((unsigned char) context->line[context->linePosition])) {
             break;
         }
         receivedId *= 10;
-        receivedId += context->buffer[context->position++] - '0';
+        receivedId += context->line[context->linePosition++] - '0';
     }
 
-    _match(context, RESPONSE_END);
-    if (context->status != RVPF_XPVPC_OK) {
-        return;
+    if (context->negotiating) {
+        // Only the login response may accept the binary framing.
+
+        size_t linePosition = context->linePosition;
+
+        context->negotiating = false;
+        context->framed = _match(context, RESPONSE_FRAMING_END)
+            == RVPF_XPVPC_OK;
+        if (context->framed) {
+            return receivedId != expectedId
+                ? RVPF_XPVPC_MISMATCHED_ID: RVPF_XPVPC_OK;
+        }
+        context->linePosition = linePosition;
     }
 
-    if (receivedId != expectedId) {
-        context->status = RVPF_XPVPC_MISMATCHED_ID;
+    status = _match(context, RESPONSE_END);
+    if (status != RVPF_XPVPC_OK) {
+        return status;
     }
 
-    _resetText(context);
+    return receivedId != expectedId? RVPF_XPVPC_MISMATCHED_ID: RVPF_XPVPC_OK;
 }
 
 /* This is free software; you can redistribute it and/or modify
@@ -15,18 +15,45 @@
 
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define RVPF_LOG(level, ...) rvpf_log_s(level, __FILE__, __LINE__, __VA_ARGS__)
-#define RVPF_LOG_DEBUG(...) rvpf_log_debug_s(__FILE__, __LINE__, __VA_ARGS__)
-#define RVPF_LOG_ERROR(...) rvpf_log_error_s(__FILE__, __LINE__, __VA_ARGS__)
-#define RVPF_LOG_FATAL(...) rvpf_log_fatal_s(__FILE__, __LINE__, __VA_ARGS__)
-#define RVPF_LOG_INFO(...) rvpf_log_info_s(__FILE__, __LINE__, __VA_ARGS__)
-#define RVPF_LOG_TRACE(...) rvpf_log_trace_s(__FILE__, __LINE__, __VA_ARGS__)
-#define RVPF_LOG_WARN(...) rvpf_log_warn_s(__FILE__, __LINE__, __VA_ARGS__)
+/* Messages above this level are removed at compile time (see Makefile). */
+#ifndef RVPF_LOG_MIN_LEVEL
+#define RVPF_LOG_MIN_LEVEL RVPF_LOG_LEVEL_ALL
+#endif
+
+#ifdef __GNUC__
+#define RVPF_LOG_UNLIKELY(e) __builtin_expect(!!(e), 0)
+#else
+#define RVPF_LOG_UNLIKELY(e) (e)
+#endif
+
+/* The level checks are inline: arguments are not evaluated when disabled. */
+#define RVPF_LOG_ENABLED(level) \
+    ((level) <= RVPF_LOG_MIN_LEVEL && rvpf_log_activeLevel >= (level))
+#define RVPF_LOG_DEBUG_ENABLED() \
+    RVPF_LOG_UNLIKELY(RVPF_LOG_ENABLED(RVPF_LOG_LEVEL_DEBUG))
+#define RVPF_LOG_TRACE_ENABLED() \
+    RVPF_LOG_UNLIKELY(RVPF_LOG_ENABLED(RVPF_LOG_LEVEL_TRACE))
+
+#define RVPF_LOG(level, ...) (RVPF_LOG_ENABLED(level)? \
+    rvpf_log_s(level, __FILE__, __LINE__, __VA_ARGS__): (void) 0)
+#define RVPF_LOG_DEBUG(...) (RVPF_LOG_DEBUG_ENABLED()? \
+    rvpf_log_debug_s(__FILE__, __LINE__, __VA_ARGS__): (void) 0)
+#define RVPF_LOG_ERROR(...) (RVPF_LOG_ENABLED(RVPF_LOG_LEVEL_ERROR)? \
+    rvpf_log_error_s(__FILE__, __LINE__, __VA_ARGS__): (void) 0)
+#define RVPF_LOG_FATAL(...) (RVPF_LOG_ENABLED(RVPF_LOG_LEVEL_FATAL)? \
+    rvpf_log_fatal_s(__FILE__, __LINE__, __VA_ARGS__): (void) 0)
+#define RVPF_LOG_INFO(...) (RVPF_LOG_ENABLED(RVPF_LOG_LEVEL_INFO)? \
+    rvpf_log_info_s(__FILE__, __LINE__, __VA_ARGS__): (void) 0)
+#define RVPF_LOG_TRACE(...) (RVPF_LOG_TRACE_ENABLED()? \
+    rvpf_log_trace_s(__FILE__, __LINE__, __VA_ARGS__): (void) 0)
+#define RVPF_LOG_WARN(...) (RVPF_LOG_ENABLED(RVPF_LOG_LEVEL_WARN)? \
+    rvpf_log_warn_s(__FILE__, __LINE__, __VA_ARGS__): (void) 0)
 
 /** Log levels. */
 typedef enum rvpf_log_level {
@@ -40,6 +67,12 @@ typedef enum rvpf_log_level {
     RVPF_LOG_LEVEL_ALL
 } RVPF_LOG_Level;
 
+/** Current log level.
+ *
+ * <p>Read by the level check macros; use rvpf_log_setLevel to change it.</p>
+ */
+extern RVPF_LOG_Level rvpf_log_activeLevel;
+
 /** Logs a message at the specified level.
  *
  * @param level The log level.
@@ -118,6 +151,12 @@ extern void rvpf_log_fatal_s(
     int line,
     const char *format, ...);
 
+/** Gets the number of messages dropped by the asynchronous mode.
+ *
+ * @return The number of dropped messages.
+ */
+extern unsigned long rvpf_log_getDropped(void);
+
 /** Gets the log level.
  *
  * @return The current log level.
@@ -187,6 +226,26 @@ extern bool rvpf_log_open(const char *filePath);
  */
 extern void rvpf_log_setLevel(int level);
 
+/** Starts the asynchronous mode.
+ *
+ * <p>The messages are then formatted into a ring buffer without locking and
+ * written by a background thread, which flushes once per batch. When the
+ * ring is full, a message is dropped and counted instead of waiting. A
+ * message is truncated to 510 characters.</p>
+ *
+ * @param capacity The ring capacity in messages (rounded up to a power
+ *                 of 2).
+ *
+ * @return False if not supported or failed.
+ */
+extern bool rvpf_log_startAsync(size_t capacity);
+
+/** Stops the asynchronous mode after writing the pending messages.
+ *
+ * <p>Also done by 'close'.</p>
+ */
+extern void rvpf_log_stopAsync(void);
+
 /** Logs a message at the TRACE level.
  *
  * @param format The message text format.
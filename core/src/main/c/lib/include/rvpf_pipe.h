@@ -33,6 +33,18 @@ extern "C" {
 #define RVPF_PIPE_STATUS_ERROR 1
 #define RVPF_PIPE_STATUS_FATAL 2
 
+#if defined(_MSC_VER)
+#define RVPF_PIPE_THREAD_LOCAL __declspec(thread)
+#elif defined(__vms)
+#define RVPF_PIPE_THREAD_LOCAL
+#else
+#define RVPF_PIPE_THREAD_LOCAL __thread
+#endif
+
+/* Skips the arguments evaluation when the TRACE level is not enabled. */
+#define RVPF_PIPE_TRACE(...) \
+    (RVPF_LOG_TRACE_ENABLED()? rvpf_pipe_trace(__VA_ARGS__): (void) 0)
+
 typedef enum rvpf_pipe_sinkRequestType {
     RVPF_PIPE_SINK_UPDATE,
     RVPF_PIPE_SINK_DELETE
@@ -42,11 +54,26 @@ typedef struct rvpf_pipe_engineRequest *RVPF_PIPE_EngineRequest;
 
 typedef struct rvpf_pipe_sinkRequest *RVPF_PIPE_SinkRequest;
 
+typedef void (*RVPF_PIPE_EngineCallback)(
+    RVPF_PIPE_EngineRequest request,
+    void *data);
+
+/** A point value.
+ *
+ * <p>The point name is interned: it is shared by all the point values for
+ * the same point and must not be modified. The point ID identifies it for
+ * the life of the process.</p>
+ */
 typedef struct rvpf_pipe_pointValue {
     char *pointName;
     char *stamp;
     char *state;
     char *value;
+    int pointID;
+    unsigned cached; /* Private: conversions flags. */
+    double doubleValue; /* Private: cached or typed value. */
+    long long longValue; /* Private: cached or typed value. */
+    long long stampTicks; /* Private: cached or typed stamp. */
 } *RVPF_PIPE_PointValue;
 
 
@@ -57,16 +84,18 @@ typedef struct rvpf_pipe_pointValue {
  *          return rvpf_pipe_status; // Value returned by main.
  *      }
  * </code>
+ *
+ * <p>Each thread has its own 'rvpf_pipe_jmp_buf' and 'rvpf_pipe_status'.</p>
  */
 
 /** This MUST be set by 'setjmp'! */
-jmp_buf rvpf_pipe_jmp_buf; /* Omitted storage class (tentative definition). */
+extern RVPF_PIPE_THREAD_LOCAL jmp_buf rvpf_pipe_jmp_buf;
 
 /** Sink request type names. */
 extern char *rvpf_pipe_sink_request_types[];
 
 /** This must be returned by 'main'. */
-extern int rvpf_pipe_status;
+extern RVPF_PIPE_THREAD_LOCAL int rvpf_pipe_status;
 
 /** Adds an engine result.
  *
@@ -82,6 +111,23 @@ extern void rvpf_pipe_addEngineResult(
     const char *state,
     const char *value);
 
+/** Adds an engine result with a typed stamp and value.
+ *
+ * <p>The stamp and value are formatted when the response is written.</p>
+ *
+ * @param request The engine request.
+ * @param pointName The point name.
+ * @param stampTicks The stamp in 100 nanoseconds ticks of the RVPF epoch.
+ * @param state The state (may be NULL).
+ * @param value The value.
+ */
+extern void rvpf_pipe_addEngineResultDouble(
+    RVPF_PIPE_EngineRequest request,
+    const char *pointName,
+    long long stampTicks,
+    const char *state,
+    double value);
+
 /** Clear the engine results.
  *
  * @param request The engine request.
@@ -95,12 +141,28 @@ extern void rvpf_pipe_clearEngineResults(RVPF_PIPE_EngineRequest request);
 extern void rvpf_pipe_debug(const char *format, ...);
 
 /** Ends an engine request.
+ *
+ * <p>Releases the request with all the strings it holds.</p>
  *
  * @param request The engine request.
  */
 extern void rvpf_pipe_endEngineRequest(RVPF_PIPE_EngineRequest request);
 
+/** Ends a batch of engine requests.
+ *
+ * <p>The responses are written in the requests order with a single flush,
+ * then the requests are released and their slots cleared.</p>
+ *
+ * @param requests The engine requests.
+ * @param count The number of requests.
+ */
+extern void rvpf_pipe_endEngineRequests(
+    RVPF_PIPE_EngineRequest *requests,
+    int count);
+
 /** Ends a sink request.
+ *
+ * <p>Releases the request with all the strings it holds.</p>
  *
  * @param request The sink request.
  * @param summary The response summary.
@@ -109,6 +171,23 @@ extern void rvpf_pipe_endSinkRequest(
     RVPF_PIPE_SinkRequest request,
     int summary);
 
+/** Ends a batch of sink requests.
+ *
+ * <p>Must receive the whole batch returned by 'nextSinkRequests'. The
+ * responses are written in the order the requests were received with a
+ * single flush, the coalesced requests getting the summary of the request
+ * that superseded them, then the requests are released and their slots
+ * cleared.</p>
+ *
+ * @param requests The sink requests.
+ * @param summaries The response summaries (one per request).
+ * @param count The number of requests.
+ */
+extern void rvpf_pipe_endSinkRequests(
+    RVPF_PIPE_SinkRequest *requests,
+    const int *summaries,
+    int count);
+
 /** Logs a message at the ERROR level.
  *
  * @param format The message text format.
@@ -121,6 +200,19 @@ extern void rvpf_pipe_error(const char *format, ...);
  */
 extern void rvpf_pipe_fatal(const char *format, ...);
 
+/** Gets the value of a point value as a double.
+ *
+ * <p>The conversion is done on the first call and cached.</p>
+ *
+ * @param pointValue The point value.
+ * @param value Receives the value.
+ *
+ * @return False if the value is missing or not a number.
+ */
+extern bool rvpf_pipe_getDoubleValue(
+    const RVPF_PIPE_PointValue pointValue,
+    double *value);
+
 /** Gets an engine input.
  *
  * @param request The engine request.
@@ -197,12 +289,52 @@ extern char *rvpf_pipe_getEngineTransformParam(
 extern int rvpf_pipe_getEngineTransformParamsCount(
     RVPF_PIPE_EngineRequest request);
 
+/** Gets the value of a point value as a long integer.
+ *
+ * <p>The conversion is done on the first call and cached.</p>
+ *
+ * @param pointValue The point value.
+ * @param value Receives the value.
+ *
+ * @return False if the value is missing or not an integer.
+ */
+extern bool rvpf_pipe_getLongValue(
+    const RVPF_PIPE_PointValue pointValue,
+    long long *value);
+
+/** Gets an interned point name.
+ *
+ * @param pointID The point ID (1 up).
+ *
+ * @return The point name (NULL if unknown).
+ */
+extern const char *rvpf_pipe_getPointName(int pointID);
+
+/** Gets the number of interned point names.
+ *
+ * <p>The point IDs go from 1 to this number.</p>
+ *
+ * @return The number of interned point names.
+ */
+extern int rvpf_pipe_getPointNamesCount(void);
+
 /** Logs a message at the INFO level.
  *
  * @param format The message text format.
  */
 extern void rvpf_pipe_info(const char *format, ...);
 
+/** Interns a point name.
+ *
+ * <p>Allows an engine to know the ID of a point before receiving any value
+ * for it.</p>
+ *
+ * @param pointName The point name.
+ *
+ * @return The point ID (1 up).
+ */
+extern int rvpf_pipe_internPointName(const char *pointName);
+
 /** Asks if a point value is deleted.
  *
  * @param pointValue The point value.
@@ -237,18 +369,115 @@ extern char *rvpf_pipe_getSinkRequestID(RVPF_PIPE_SinkRequest request);
 extern RVPF_PIPE_SinkRequestType rvpf_pipe_getSinkRequestType(
     RVPF_PIPE_SinkRequest request);
 
+/** Gets the stamp of a point value as ticks.
+ *
+ * <p>The conversion is done on the first call and cached. Only the stamps
+ * with a time zone ('Z' or an offset) are converted.</p>
+ *
+ * @param pointValue The point value.
+ * @param stampTicks Receives the stamp in 100 nanoseconds ticks of the RVPF
+ *                   epoch.
+ *
+ * @return False if the stamp is missing or not convertible.
+ */
+extern bool rvpf_pipe_getStampTicks(
+    const RVPF_PIPE_PointValue pointValue,
+    long long *stampTicks);
+
 /** Returns the next engine request.
  *
  * @return The next engine request.
  */
 extern RVPF_PIPE_EngineRequest rvpf_pipe_nextEngineRequest(void);
 
+/** Gets a batch of engine requests.
+ *
+ * <p>Waits for the first request, then takes the requests already available
+ * on the pipe, up to the limit. A stop request seen after the first request
+ * takes effect on the next call.</p>
+ *
+ * @param requests An array receiving the engine requests.
+ * @param limit The size of the array.
+ *
+ * @return The number of engine requests (at least 1).
+ */
+extern int rvpf_pipe_nextEngineRequests(
+    RVPF_PIPE_EngineRequest *requests,
+    int limit);
+
 /** Returns the next sink request.
  *
  * @return The next sink request.
  */
 extern RVPF_PIPE_SinkRequest rvpf_pipe_nextSinkRequest(void);
 
+/** Gets a batch of sink requests.
+ *
+ * <p>Waits for the first request, then takes the requests already available
+ * on the pipe, up to the limit. A stop request seen after the first request
+ * takes effect on the next call.</p>
+ *
+ * <p>When coalescing, a request for the same point and stamp as a previous
+ * request of the batch takes its place in the array: the previous request
+ * is then answered by 'endSinkRequests' without being seen by the sink.</p>
+ *
+ * @param requests An array receiving the sink requests.
+ * @param limit The size of the array (maximum requests received).
+ * @param coalesce True to coalesce the requests for the same point value.
+ *
+ * @return The number of sink requests (at least 1).
+ */
+extern int rvpf_pipe_nextSinkRequests(
+    RVPF_PIPE_SinkRequest *requests,
+    int limit,
+    bool coalesce);
+
+/** Processes the engine requests on a pool of worker threads.
+ *
+ * <p>A reader thread gets the requests, the workers call the callback on
+ * each of them and the calling thread writes the responses in the requests
+ * order. The callback must not call 'endEngineRequest'. Like
+ * 'nextEngineRequest', this returns only thru 'rvpf_pipe_jmp_buf': on a
+ * stop request, or on an error in the reader or in a callback, once the
+ * responses to the preceding requests have been written.</p>
+ *
+ * @param workers The number of worker threads.
+ * @param callback The engine request callback.
+ * @param data The data passed to the callback.
+ */
+extern void rvpf_pipe_runEngineWorkers(
+    int workers,
+    RVPF_PIPE_EngineCallback callback,
+    void *data);
+
+/** Sets the engine result value as a double.
+ *
+ * <p>The value is formatted when the response is written; until then, the
+ * result 'value' field is NULL.</p>
+ *
+ * <p>Note: must not be called after 'clearEngineResults'.</p>
+ *
+ * @param request The engine request.
+ * @param value The value.
+ */
+extern void rvpf_pipe_setEngineResultDouble(
+    RVPF_PIPE_EngineRequest request,
+    double value);
+
+/** Sets the engine result value as a long integer.
+ *
+ * <p>The value is formatted when the response is written; until then, the
+ * result 'value' field is NULL.</p>
+ *
+ * <p>Note: must not be called after 'clearEngineResults'.</p>
+ *
+ * @param request The engine request.
+ * @param value The value.
+ */
+extern void rvpf_pipe_setEngineResultLong(
+    RVPF_PIPE_EngineRequest request,
+    long long value);
+
 /** Sets the engine result state.
  *
  * <p>Note: must not be called after 'clearEngineResults'.</p>
@@ -278,6 +507,8 @@ extern void rvpf_pipe_setEngineResultValue(
 extern void rvpf_pipe_setLogLevel(int level);
 
 /** Logs a message at the TRACE level.
+ *
+ * <p>The RVPF_PIPE_TRACE macro is preferable in loops.</p>
  *
  * @param format The message text format.
  */
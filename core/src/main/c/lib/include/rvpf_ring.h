@@ -0,0 +1,120 @@
+/** Related Values Processing Framework.
+ *
+ * Copyright (C) 2003-2019 Serge Brisson.
+ *
+ * This software is distributable under the LGPL license.
+ * See details at the bottom of this file.
+ *
+ * $Id$
+ */
+
+/** RVPF ring API.
+ *
+ * <p>A bounded queue of fixed size cells, filled without locking by multiple
+ * producers and emptied by a single consumer. A producer claims a cell, fills
+ * it, then publishes it; the consumer peeks at the oldest published cell, then
+ * releases it. A full ring refuses the claims.</p>
+ */
+
+#ifndef RVPF_RING_H_
+#define RVPF_RING_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Ring context.
+ */
+typedef struct rvpf_ring_context *RVPF_RING_Context;
+
+/** Claims a cell (producers).
+ *
+ * @param context The context.
+ * @param position Receives the position of the cell (for 'publish').
+ *
+ * @return The cell content (NULL when the ring is full).
+ */
+extern void *rvpf_ring_claim(RVPF_RING_Context context, size_t *position);
+
+/** Creates a context.
+ *
+ * @param capacity The minimum number of cells (rounded up to a power of 2).
+ * @param cellSize The size of the content of each cell.
+ *
+ * @return The context (NULL on failure).
+ */
+extern RVPF_RING_Context rvpf_ring_create(size_t capacity, size_t cellSize);
+
+/** Disposes of the context.
+ *
+ * @param context The context.
+ */
+extern void rvpf_ring_dispose(RVPF_RING_Context context);
+
+/** Gets the number of cells released since the creation.
+ *
+ * @param context The context.
+ *
+ * @return The number of cells released.
+ */
+extern size_t rvpf_ring_getDequeued(RVPF_RING_Context context);
+
+/** Gets the number of cells claimed since the creation.
+ *
+ * @param context The context.
+ *
+ * @return The number of cells claimed.
+ */
+extern size_t rvpf_ring_getEnqueued(RVPF_RING_Context context);
+
+/** Asks if all the claimed cells have been released.
+ *
+ * @param context The context.
+ *
+ * @return True if empty.
+ */
+extern bool rvpf_ring_isEmpty(RVPF_RING_Context context);
+
+/** Peeks at the oldest published cell (consumer).
+ *
+ * @param context The context.
+ *
+ * @return The cell content (NULL if none is published).
+ */
+extern void *rvpf_ring_peek(RVPF_RING_Context context);
+
+/** Publishes a claimed cell (producers).
+ *
+ * @param context The context.
+ * @param position The position of the cell (from 'claim').
+ */
+extern void rvpf_ring_publish(RVPF_RING_Context context, size_t position);
+
+/** Releases the cell returned by 'peek' (consumer).
+ *
+ * @param context The context.
+ */
+extern void rvpf_ring_release(RVPF_RING_Context context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RVPF_RING_H_ */
+
+/* This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
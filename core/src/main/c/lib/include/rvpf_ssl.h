@@ -46,6 +46,27 @@ enum {
  */
 typedef struct rvpf_ssl_context *RVPF_SSL_Context;
 
+/** Buffer for a gathering send.
+ */
+typedef struct rvpf_ssl_buffer
+{
+    char *buffer;
+    size_t size;
+} RVPF_SSL_Buffer;
+
+/** Awaits until the connection is ready for the operation which would
+ * have blocked.
+ *
+ * <p>Reading is awaited unless rvpf_ssl_wantsWrite. Data already
+ * decrypted (see rvpf_ssl_pending) is ready without polling.</p>
+ *
+ * @param context The context.
+ * @param timeout A timeout in milliseconds (negative for none).
+ *
+ * @return A true value if the connection is ready.
+ */
+extern bool rvpf_ssl_await(RVPF_SSL_Context context, int timeout);
+
 /** Clears an error.
  *
  * @param context The context.
@@ -102,7 +123,19 @@ extern bool rvpf_ssl_failed(RVPF_SSL_Context context);
  */
 extern bool rvpf_ssl_isOpen(RVPF_SSL_Context context);
 
+/** Asks if the last open has resumed a previous TLS session.
+ *
+ * @param context The context.
+ *
+ * @return A true value if the TLS session has been resumed.
+ */
+extern bool rvpf_ssl_isResumed(RVPF_SSL_Context context);
+
 /** Opens a connection to the XML Port.
+ *
+ * <p>A secure connection offers the last TLS session received from the
+ * same address by any context with the same trust and certificate
+ * configuration, or else the session saved in the session file.</p>
  *
  * @param context The context.
  * @param address The server address ([host]:port).
@@ -111,6 +144,17 @@ extern bool rvpf_ssl_isOpen(RVPF_SSL_Context context);
  */
 extern int rvpf_ssl_open(RVPF_SSL_Context context, char *address);
 
+/** Returns the number of received bytes already buffered.
+ *
+ * <p>These bytes may be received without waiting on the socket. Encrypted
+ * bytes read ahead count as 1.</p>
+ *
+ * @param context The context.
+ *
+ * @return The number of buffered bytes.
+ */
+extern int rvpf_ssl_pending(RVPF_SSL_Context context);
+
 /** Prints an error message.
  *
  * @param context The context.
@@ -121,6 +165,9 @@ extern int rvpf_ssl_open(RVPF_SSL_Context context, char *address);
 extern bool rvpf_ssl_printError(RVPF_SSL_Context context, char *prefix);
 
 /** Receives bytes.
+ *
+ * <p>When not blocking, returns 0 without failure if no bytes are
+ * available (see rvpf_ssl_wouldBlock).</p>
  *
  * @param context The context.
  * @param buffer A buffer.
@@ -134,6 +181,10 @@ extern int rvpf_ssl_receive(
         size_t size);
 
 /** Sends bytes.
+ *
+ * <p>When not blocking, returns 0 without failure if the bytes cannot be
+ * sent now (see rvpf_ssl_wouldBlock); the same bytes must then be sent
+ * again.</p>
  *
  * @param context The context.
  * @param buffer A buffer.
@@ -146,6 +197,35 @@ extern int rvpf_ssl_send(
         char *buffer,
         size_t size);
 
+/** Sends bytes gathered from buffers.
+ *
+ * <p>The buffers go out with one system call: a secure connection sends
+ * them in a common record, up to its maximum size. As with rvpf_ssl_send,
+ * less than the total size may be sent.</p>
+ *
+ * @param context The context.
+ * @param buffers The buffers.
+ * @param count The number of buffers.
+ *
+ * @return The number of bytes sent.
+ */
+extern int rvpf_ssl_sendBuffers(
+        RVPF_SSL_Context context,
+        RVPF_SSL_Buffer *buffers,
+        int count);
+
+/** Sets the blocking mode.
+ *
+ * <p>The connection and its TLS handshake always block; the mode applies
+ * to the sends and receives which follow.</p>
+ *
+ * @param context The context.
+ * @param blocking False for non-blocking sends and receives.
+ *
+ * @return A status code.
+ */
+extern int rvpf_ssl_setBlocking(RVPF_SSL_Context context, bool blocking);
+
 /** Sets the certificate.
  *
  * @param context The context.
@@ -153,6 +233,16 @@ extern int rvpf_ssl_send(
  */
 extern void rvpf_ssl_setCertificate(RVPF_SSL_Context context, char *filePath);
 
+/** Sets a file to keep the TLS session across processes.
+ *
+ * <p>The file is readable only by its owner, since it holds the
+ * session secrets.</p>
+ *
+ * @param context The context.
+ * @param filePath A file path (NULL to keep the session in memory only).
+ */
+extern void rvpf_ssl_setSessionFile(RVPF_SSL_Context context, char *filePath);
+
 /** Sets the trust configuration.
  *
  * @param context The context.
@@ -164,6 +254,16 @@ extern void rvpf_ssl_setTrust(
         char *filePath,
         char *directoryPath);
 
+/** Returns the socket of the connection.
+ *
+ * <p>Allows a thread to poll many connections.</p>
+ *
+ * @param context The context.
+ *
+ * @return The socket (-1 if not open).
+ */
+extern int rvpf_ssl_socket(RVPF_SSL_Context context);
+
 /** Returns the current status.
  *
  * @param context The context.
@@ -186,6 +286,24 @@ extern bool rvpf_ssl_succeeded(RVPF_SSL_Context context);
  */
 extern char *rvpf_ssl_version(void);
 
+/** Asks if the operation which would have blocked waits to write.
+ *
+ * <p>A secure connection may need to write to complete a receive.</p>
+ *
+ * @param context The context.
+ *
+ * @return A true value to poll for writing, false for reading.
+ */
+extern bool rvpf_ssl_wantsWrite(RVPF_SSL_Context context);
+
+/** Asks if the last send or receive would have blocked.
+ *
+ * @param context The context.
+ *
+ * @return A true value if it would have blocked.
+ */
+extern bool rvpf_ssl_wouldBlock(RVPF_SSL_Context context);
+
 #ifdef __vms
 #pragma names restore
 #endif
@@ -44,6 +44,31 @@ enum {
  */
 typedef struct rvpf_xpvpc_context *RVPF_XPVPC_Context;
 
+/** Opaque pool of connected contexts.
+ */
+typedef struct rvpf_xpvpc_pool *RVPF_XPVPC_Pool;
+
+/** Configures a new pool context before it is opened.
+ *
+ * <p>Allows the SSL configuration of the context (see rvpf_xpvpc_ssl).</p>
+ *
+ * @param context The context.
+ * @param data The data supplied to rvpf_xpvpc_createPool.
+ */
+typedef void (*RVPF_XPVPC_Configure)(RVPF_XPVPC_Context context, void *data);
+
+/** Acquires a connected context from a pool.
+ *
+ * <p>Returns an idle context if there is one, otherwise a new context,
+ * configured, opened and logged in. A new context may have failed: it
+ * holds the error and should be released.</p>
+ *
+ * @param pool The pool.
+ *
+ * @return The context.
+ */
+extern RVPF_XPVPC_Context rvpf_xpvpc_acquire(RVPF_XPVPC_Pool pool);
+
 /** Clears an error.
  *
  * @param context The context.
@@ -64,6 +89,28 @@ extern int rvpf_xpvpc_close(RVPF_XPVPC_Context context);
  */
 extern RVPF_XPVPC_Context rvpf_xpvpc_create(void);
 
+/** Creates a pool of connected contexts.
+ *
+ * <p>Since the contexts of a pool share their SSL configuration, each new
+ * connection may resume the TLS session of a previous one.</p>
+ *
+ * @param address The server address ([host]:port).
+ * @param user The user (NULL to skip the login).
+ * @param password The password.
+ * @param capacity The maximum number of idle contexts kept.
+ * @param configure A configuration callback (may be NULL).
+ * @param data Data for the configuration callback.
+ *
+ * @return The pool.
+ */
+extern RVPF_XPVPC_Pool rvpf_xpvpc_createPool(
+        char *address,
+        char *user,
+        char *password,
+        int capacity,
+        RVPF_XPVPC_Configure configure,
+        void *data);
+
 /** Returns a deleted value marker state.
  *
  * @return The deleted value marker state.
@@ -76,6 +123,14 @@ extern char *rvpf_xpvpc_deletedState(void);
  */
 extern void rvpf_xpvpc_dispose(RVPF_XPVPC_Context context);
 
+/** Disposes of a pool and of its idle contexts.
+ *
+ * <p>The acquired contexts must have been released.</p>
+ *
+ * @param pool The pool.
+ */
+extern void rvpf_xpvpc_disposePool(RVPF_XPVPC_Pool pool);
+
 /** Returns the error message.
  *
  * @param context The context.
@@ -93,6 +148,9 @@ extern char *rvpf_xpvpc_errorMessage(RVPF_XPVPC_Context context);
 extern bool rvpf_xpvpc_failed(RVPF_XPVPC_Context context);
 
 /** Flushes pending entries.
+ *
+ * <p>When a window is set, returns as soon as fewer messages than the window
+ * size remain unacknowledged.</p>
  *
  * @param context The context.
  *
@@ -136,6 +194,31 @@ extern int rvpf_xpvpc_open(RVPF_XPVPC_Context context, char *address);
  */
 extern bool rvpf_xpvpc_printError(RVPF_XPVPC_Context context, char *prefix);
 
+/** Releases a context to its pool.
+ *
+ * <p>Stops the sender and synchronizes the context; keeps it idle if it is
+ * still open without error and the pool has room, otherwise disposes of
+ * it.</p>
+ *
+ * @param pool The pool.
+ * @param context The context (may be NULL).
+ */
+extern void rvpf_xpvpc_release(
+    RVPF_XPVPC_Pool pool,
+    RVPF_XPVPC_Context context);
+
+/** Resumes what a polled context has left when its connection got ready.
+ *
+ * <p>Sends the queued bytes, receives the acknowledgements due, then sends
+ * the pending values which were waiting for room in the window. Whatever
+ * is still left is told by rvpf_xpvpc_wouldBlock.</p>
+ *
+ * @param context The context.
+ *
+ * @return A status code.
+ */
+extern int rvpf_xpvpc_resume(RVPF_XPVPC_Context context);
+
 /** Sends a point value.
  *
  * @param context The context.
@@ -156,10 +239,48 @@ extern int rvpf_xpvpc_sendValue(
 /** Sets the auto-flush trigger.
  *
  * @param context The context.
- * @param autoFlush The auto-flush trigger (inactive when less than 1).
+ * @param autoFlush The pending values count triggering an automatic flush
+ *                  (inactive when less than 1).
  */
 extern void rvpf_xpvpc_setAutoFlush(RVPF_XPVPC_Context context, int autoFlush);
 
+/** Sets the auto-flush size trigger.
+ *
+ * @param context The context.
+ * @param autoFlushBytes The pending text size triggering an automatic flush
+ *                       (inactive when 0).
+ */
+extern void rvpf_xpvpc_setAutoFlushBytes(
+    RVPF_XPVPC_Context context,
+    size_t autoFlushBytes);
+
+/** Sets the auto-flush latency trigger.
+ *
+ * @param context The context.
+ * @param autoFlushMillis The maximum age in milliseconds of the oldest
+ *                        pending value before an automatic flush
+ *                        (inactive when less than 1).
+ */
+extern void rvpf_xpvpc_setAutoFlushMillis(
+    RVPF_XPVPC_Context context,
+    int autoFlushMillis);
+
+/** Sets the binary framing mode.
+ *
+ * <p>The next login offers the binary framing to the server. If the server
+ * accepts it, the values then travel as length-prefixed frames where point
+ * names are interned to integer indexes after their first use and UTC
+ * stamps (ending with 'Z') travel as raw 64-bit ticks. A server without
+ * binary support ignores the offer and the connection stays on XML. The
+ * server responses are unchanged.</p>
+ *
+ * <p>When polled, values are refused until the login has completed.</p>
+ *
+ * @param context The context.
+ * @param binary True for the binary framing mode.
+ */
+extern void rvpf_xpvpc_setBinary(RVPF_XPVPC_Context context, bool binary);
+
 /** Sets the client.
  *
  * @param context The context.
@@ -167,7 +288,47 @@ extern void rvpf_xpvpc_setAutoFlush(RVPF_XPVPC_Context context, int autoFlush);
  */
 extern void rvpf_xpvpc_setClient(RVPF_XPVPC_Context context, char *client);
 
+/** Sets the polled mode.
+ *
+ * <p>A polled context never waits on its connection, allowing a thread to
+ * drive many connections from one poll or epoll loop. The operations
+ * return as soon as the connection would block, queuing what could not be
+ * sent; the values keep accumulating while the window is full. When
+ * rvpf_xpvpc_wouldBlock, the caller polls rvpf_xpvpc_socket for reading
+ * (rvpf_xpvpc_wantsRead) or writing (rvpf_xpvpc_wantsWrite), then calls
+ * rvpf_xpvpc_resume. A flush or sync is complete once nothing would
+ * block.</p>
+ *
+ * <p>Open still blocks; so do close and release, which complete what is
+ * left. Like a sync, a login is complete once nothing would block. Excludes
+ * the sender thread.</p>
+ *
+ * @param context The context.
+ * @param polled True for the polled mode.
+ */
+extern void rvpf_xpvpc_setPolled(RVPF_XPVPC_Context context, bool polled);
+
+/** Sets the window of unacknowledged messages.
+ *
+ * @param context The context.
+ * @param window The maximum number of messages sent without waiting for
+ *               their acknowledgement (inactive when less than 2).
+ */
+extern void rvpf_xpvpc_setWindow(RVPF_XPVPC_Context context, int window);
+
+/** Returns the socket of the connection.
+ *
+ * @param context The context.
+ *
+ * @return The socket (-1 if not open).
+ */
+extern int rvpf_xpvpc_socket(RVPF_XPVPC_Context context);
+
 /** Returns the RVPF_SSL_Context context.
+ *
+ * <p>The context may be set to not block (see rvpf_ssl_setBlocking): the
+ * sends and receives then await the readiness of the connection, unless
+ * the context is polled (see rvpf_xpvpc_setPolled).</p>
  *
  * @param context The context.
  *
@@ -175,6 +336,18 @@ extern void rvpf_xpvpc_setClient(RVPF_XPVPC_Context context, char *client);
  */
 extern RVPF_SSL_Context rvpf_xpvpc_ssl(RVPF_XPVPC_Context context);
 
+/** Starts a background sender thread.
+ *
+ * While the sender runs, sendValue only queues the value: the sender
+ * sends the pending values and verifies their acknowledgements when an
+ * auto-flush trigger fires or on flush, sync and close.
+ *
+ * @param context The context.
+ *
+ * @return The status code.
+ */
+extern int rvpf_xpvpc_startSender(RVPF_XPVPC_Context context);
+
 /** Returns the current status.
  *
  * @param context The context.
@@ -183,6 +356,14 @@ extern RVPF_SSL_Context rvpf_xpvpc_ssl(RVPF_XPVPC_Context context);
  */
 extern int rvpf_xpvpc_status(RVPF_XPVPC_Context context);
 
+/** Stops the background sender thread after it has drained the pending values.
+ *
+ * @param context The context.
+ *
+ * @return The status code.
+ */
+extern int rvpf_xpvpc_stopSender(RVPF_XPVPC_Context context);
+
 /** Asks if the last operation has succeeded.
  *
  * @param context The context.
@@ -191,12 +372,44 @@ extern int rvpf_xpvpc_status(RVPF_XPVPC_Context context);
  */
 extern bool rvpf_xpvpc_succeeded(RVPF_XPVPC_Context context);
 
+/** Flushes pending entries, then waits for all acknowledgements.
+ *
+ * @param context The context.
+ *
+ * @return A status code.
+ */
+extern int rvpf_xpvpc_sync(RVPF_XPVPC_Context context);
+
 /** Returns version informations.
  *
  * @return The version informations.
  */
 extern char *rvpf_xpvpc_version(void);
 
+/** Asks if a polled context waits for its connection to be readable.
+ *
+ * @param context The context.
+ *
+ * @return A true value to poll for reading.
+ */
+extern bool rvpf_xpvpc_wantsRead(RVPF_XPVPC_Context context);
+
+/** Asks if a polled context waits for its connection to be writable.
+ *
+ * @param context The context.
+ *
+ * @return A true value to poll for writing.
+ */
+extern bool rvpf_xpvpc_wantsWrite(RVPF_XPVPC_Context context);
+
+/** Asks if a polled context has something left for rvpf_xpvpc_resume.
+ *
+ * @param context The context.
+ *
+ * @return A true value if the context waits for its connection.
+ */
+extern bool rvpf_xpvpc_wouldBlock(RVPF_XPVPC_Context context);
+
 #ifdef __vms
 #pragma names restore
 #endif
@@ -8,14 +8,28 @@
  * $Id: CStore.c 3961 2019-05-06 20:14:59Z SFB $
  */
 #include "CStore.h"
+#include "Metrics.h"
 #include "ProxyStoreImpl.h"
 
+#include "rvpf_ring.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <time.h>
 
 // Private macro definitions.
 
 #define CONTEXT_FUNCTION_NAME "RVPF_CStore_context"
+#define LOG_ASYNC_ENV "RVPF_C_STORE_LOG_ASYNC"
+#define LOG_ASYNC_IDLE_NANOS 1000000
+#define LOG_ASYNC_MESSAGE_SIZE 512
+
+#define LOAD_ACQUIRE(location) __atomic_load_n((location), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(location, value) \
+    __atomic_store_n((location), (value), __ATOMIC_RELEASE)
 
 // Private structure definitions.
 
@@ -24,6 +38,23 @@ struct logger_context
     jobject cStoreInstance;
 };
 
+struct read_cursor
+{
+    void *cursor; // From the implementation; NULL when emulated by reads.
+    c_store_handle_t serverHandle;
+    c_store_stamp_t next;
+    c_store_stamp_t end;
+    bool reverse;
+    bool ended;
+};
+
+struct log_cell
+{
+    jobject cStoreInstance;
+    int level;
+    char text[LOG_ASYNC_MESSAGE_SIZE];
+};
+
 // Private variable definitions.
 
 static jclass _atomicLongClass = NULL;
@@ -38,6 +69,17 @@ static jmethodID _integerValueMethod = NULL;
 
 static JavaVM *_javaVM = NULL;
 
+static struct
+{
+    RVPF_RING_Context ring;
+    unsigned long dropped;
+    int users;
+    bool running;
+    bool stopping;
+    pthread_t writer;
+}
+_logAsync = {0};
+
 static jmethodID _logMethod = NULL;
 
 static jclass _valuesClass = NULL;
@@ -46,6 +88,8 @@ static struct
 {
     jmethodID constructor;
     jmethodID add;
+    jmethodID addAll;
+    jmethodID pack;
     jmethodID statusCode;
     jmethodID size;
     jmethodID next;
@@ -58,6 +102,12 @@ static struct
     jfieldID deleted;
     jfieldID quality;
     jfieldID value;
+    jfieldID handles;
+    jfieldID times;
+    jfieldID deletedFlags;
+    jfieldID qualities;
+    jfieldID offsets;
+    jfieldID bytes;
 }
 _valuesFields = {};
 
@@ -81,6 +131,8 @@ static void _logBack(
     const char *format,
     ...);
 
+static void _logDrain(void);
+
 static int _loggerLog(
     c_store_logger_t logger,
     size_t size,
@@ -96,6 +148,26 @@ static int _logJava(
     const char *format,
     va_list args);
 
+static void _logQueue(
+    jobject cStoreInstance,
+    int level,
+    const char *format,
+    va_list args);
+
+static bool _logStart(void);
+
+static void _logStop(void);
+
+static void *_logWriter(void *argument);
+
+static c_store_code_t _readCursor(
+    c_store_t store,
+    struct read_cursor *readCursor,
+    size_t limit,
+    c_store_byte_t *buffer,
+    size_t length,
+    size_t *count);
+
 static void _throwNew(const char *name, const char *msg);
 
 // JNI function definitions.
@@ -117,6 +189,11 @@ JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved)
         return JNI_ERR;
     }
 
+    if (!_logStart()) {
+        _throwNew("java/lang/RuntimeException", "Failed to start the logger");
+        return JNI_ERR;
+    }
+
     return JNI_VERSION_1_4;
 }
 
@@ -125,7 +202,9 @@ JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved)
 JNIEXPORT void JNICALL JNI_OnUnload(JavaVM *vm, void *reserved)
 {
     if (_javaVM) {
+        _logStop();
         CStore_unloadClasses(NULL);
+        Metrics_dispose();
         _javaVM = NULL;
     }
 }
@@ -165,6 +244,26 @@ JNIEXPORT jlong JNICALL Java_org_rvpf_store_server_c_CStore_contextHandle(
     return (jlong) (size_t) contextFunction(logger, NULL, 0, NULL, _javaVM);
 }
 
+/** Closes a read cursor.
+ *
+ * @param contextHandle The implementation context handle.
+ * @param cursorHandle The cursor handle.
+ */
+JNIEXPORT void JNICALL Java_org_rvpf_store_server_c_CStore_closeCursor(
+    JNIEnv *env, jobject obj, jlong contextHandle, jlong cursorHandle)
+{
+    c_store_t store = (c_store_t) (size_t) contextHandle;
+    struct read_cursor *readCursor =
+        (struct read_cursor *) (size_t) cursorHandle;
+
+    if (readCursor) {
+        if (readCursor->cursor) {
+            store->vector->closeCursor(store, readCursor->cursor);
+        }
+        CStore_free(readCursor);
+    }
+}
+
 /** Closes a library.
  *
  * @param libraryHandle The library handle.
@@ -217,6 +316,82 @@ JNIEXPORT jint JNICALL Java_org_rvpf_store_server_c_CStore_count(
     return status_code;
 }
 
+/** Counts values for multiple points.
+ *
+ * <p>Counts point by point when the implementation does not support
+ * multi-point requests.</p>
+ *
+ * @param contextHandle The implementation context handle.
+ * @param serverHandles The server handles for the points.
+ * @param startTimes The inclusive start times.
+ * @param endTimes The exclusive end times.
+ * @param limit A limit for the number of values per point.
+ * @param counts The individual counts.
+ * @param statusCodes The individual status codes.
+ *
+ * @return A status code.
+ */
+JNIEXPORT jint JNICALL Java_org_rvpf_store_server_c_CStore_countMany(
+    JNIEnv *env, jobject obj, jlong contextHandle, jintArray serverHandles,
+    jlongArray startTimes, jlongArray endTimes, jint limit,
+    jlongArray counts, jintArray statusCodes)
+{
+    c_store_t store = (c_store_t) (size_t) contextHandle;
+    size_t count = (*env)->GetArrayLength(env, serverHandles);
+    c_store_handle_t *server_handles = (*env)->GetIntArrayElements(
+                               env, serverHandles, NULL);
+    c_store_stamp_t *start_times = (*env)->GetLongArrayElements(
+                               env, startTimes, NULL);
+    c_store_stamp_t *end_times = (*env)->GetLongArrayElements(
+                               env, endTimes, NULL);
+    c_store_long_t *point_counts = (*env)->GetLongArrayElements(
+                               env, counts, NULL);
+    c_store_code_t *status_codes = (*env)->GetIntArrayElements(
+                               env, statusCodes, NULL);
+    c_store_code_t status_code = STATUS_CODE_FAILED;
+
+    if (server_handles && start_times && end_times
+            && point_counts && status_codes) {
+        if (store->vector->supportsMany
+                && store->vector->supportsMany(store)) {
+            status_code = store->vector->countMany(store, count,
+                server_handles, start_times, end_times, limit,
+                point_counts, status_codes);
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                point_counts[i] = -1;
+                status_codes[i] = store->vector->count(store,
+                    server_handles[i], start_times[i], end_times[i],
+                    limit, &point_counts[i]);
+            }
+            status_code = STATUS_CODE_SUCCESS;
+        }
+    }
+
+    if (server_handles) {
+        (*env)->ReleaseIntArrayElements(
+            env, serverHandles, server_handles, JNI_ABORT);
+    }
+    if (start_times) {
+        (*env)->ReleaseLongArrayElements(
+            env, startTimes, start_times, JNI_ABORT);
+    }
+    if (end_times) {
+        (*env)->ReleaseLongArrayElements(
+            env, endTimes, end_times, JNI_ABORT);
+    }
+    if (point_counts) {
+        (*env)->ReleaseLongArrayElements(
+            env, counts, point_counts, 0);
+    }
+    if (status_codes) {
+        (*env)->ReleaseIntArrayElements(
+            env, statusCodes, status_codes, 0);
+    }
+
+    return status_code;
+}
+
 /** Deletes points values.
  *
  * @param contextHandle The implementation context handle.
@@ -280,9 +455,11 @@ JNIEXPORT jint JNICALL Java_org_rvpf_store_server_c_CStore_deliver(
     size_t count = 0;
     c_store_value_t **values = NULL;
     c_store_code_t status_code;
+    int64_t start = Metrics_start();
 
     status_code = store->vector->deliver(store,
         limit, timeout, &count, &values);
+    Metrics_recordValues(METRICS_DELIVER, start, count, values);
 
     if (values) {
         CStore_returnValues(env, count, values, container);
@@ -349,9 +526,12 @@ JNIEXPORT jint JNICALL Java_org_rvpf_store_server_c_CStore_exchangeHandles(
     }
 
     if (!failed) {
+        int64_t start = Metrics_start();
+
         status_code = store->vector->exchangeHandles(
             store, count, tag_strings, client_handles, server_handles,
             status_codes);
+        Metrics_record(METRICS_EXCHANGE_HANDLES, start, count, 0);
     }
 
     if (server_handles) {
@@ -379,6 +559,48 @@ JNIEXPORT jint JNICALL Java_org_rvpf_store_server_c_CStore_exchangeHandles(
     return status_code;
 }
 
+/** Fetches values from a read cursor into a direct buffer.
+ *
+ * <p>The values are laid out back to back in the buffer, as described by
+ * the value layout. A count of 0 means that the cursor is exhausted, unless
+ * the status is BUFFER_TOO_SMALL: the next value does not fit.</p>
+ *
+ * @param contextHandle The implementation context handle.
+ * @param cursorHandle The cursor handle.
+ * @param limit A limit for the number of values (0 for no limit).
+ * @param buffer The direct buffer.
+ * @param countContainer A container for the count.
+ *
+ * @return A status code.
+ */
+JNIEXPORT jint JNICALL Java_org_rvpf_store_server_c_CStore_fetchCursor(
+    JNIEnv *env, jobject obj, jlong contextHandle, jlong cursorHandle,
+    jint limit, jobject buffer, jobject countContainer)
+{
+    c_store_t store = (c_store_t) (size_t) contextHandle;
+    struct read_cursor *readCursor =
+        (struct read_cursor *) (size_t) cursorHandle;
+    c_store_byte_t *address = (*env)->GetDirectBufferAddress(env, buffer);
+    jlong length = (*env)->GetDirectBufferCapacity(env, buffer);
+    size_t count = 0;
+    c_store_code_t status_code = STATUS_CODE_FAILED;
+
+    if (readCursor && address && length >= 0 && limit >= 0) {
+        if (readCursor->cursor) {
+            status_code = store->vector->fetchCursor(store,
+                readCursor->cursor, limit, address, length, &count);
+        } else {
+            status_code = _readCursor(store,
+                readCursor, limit, address, length, &count);
+        }
+    }
+
+    (*env)->CallVoidMethod(env, countContainer, _atomicLongSetMethod,
+        (jlong) count);
+
+    return status_code;
+}
+
 /** Frees the implementation context.
  *
  * @param contextHandle The implementation context handle.
@@ -393,6 +615,7 @@ JNIEXPORT void JNICALL Java_org_rvpf_store_server_c_CStore_freeContext(
 
     struct logger_context *loggerContext = logger->context;
 
+    _logDrain();
     (*env)->DeleteWeakGlobalRef(env, loggerContext->cStoreInstance);
     loggerContext->cStoreInstance = NULL;
     CStore_free(loggerContext);
@@ -501,6 +724,74 @@ JNIEXPORT jbyteArray JNICALL Java_org_rvpf_store_server_c_CStore_getStateName(
     return nameBytes;
 }
 
+/** Returns the metrics.
+ *
+ * <p>The metrics are aggregated from the counters of all the threads.</p>
+ *
+ * @return The functions and buckets counts, followed, for each function,
+ *         by the calls, values, bytes and nanoseconds counts, then by the
+ *         log2 nanoseconds latency buckets.
+ */
+JNIEXPORT jlongArray JNICALL Java_org_rvpf_store_server_c_CStore_metrics(
+    JNIEnv *env, jobject obj)
+{
+    int64_t metrics[METRICS_LENGTH];
+    jlongArray metricsArray = (*env)->NewLongArray(env, METRICS_LENGTH);
+
+    if (metricsArray) {
+        Metrics_snapshot(metrics);
+        (*env)->SetLongArrayRegion(env, metricsArray, 0, METRICS_LENGTH,
+            (jlong *) metrics);
+    }
+
+    return metricsArray;
+}
+
+/** Opens a read cursor.
+ *
+ * <p>When the implementation does not support cursors (no openCursor
+ * entry, or one answering unsupported), the cursor is emulated by
+ * successive reads.</p>
+ *
+ * @param contextHandle The implementation context handle.
+ * @param serverHandle The server handle for the point.
+ * @param startTime The inclusive start time.
+ * @param endTime The exclusive end time.
+ * @param cursorContainer A container for the cursor handle.
+ *
+ * @return A status code.
+ */
+JNIEXPORT jint JNICALL Java_org_rvpf_store_server_c_CStore_openCursor(
+    JNIEnv *env, jobject obj, jlong contextHandle, jint serverHandle,
+    jlong startTime, jlong endTime, jobject cursorContainer)
+{
+    c_store_t store = (c_store_t) (size_t) contextHandle;
+    struct read_cursor *readCursor = _allocate(sizeof(struct read_cursor));
+    c_store_code_t status_code;
+
+    if (!readCursor) return STATUS_CODE_FAILED;
+
+    status_code = store->vector->openCursor?
+        store->vector->openCursor(store, serverHandle,
+            startTime, endTime, &readCursor->cursor):
+        STATUS_CODE_UNSUPPORTED;
+    if (status_code == STATUS_CODE_UNSUPPORTED) {
+        readCursor->cursor = NULL;
+        readCursor->serverHandle = serverHandle;
+        readCursor->next = startTime;
+        readCursor->end = endTime;
+        readCursor->reverse = startTime > endTime;
+        status_code = STATUS_CODE_SUCCESS;
+    }
+
+    if (status_code == STATUS_CODE_SUCCESS) {
+        (*env)->CallVoidMethod(env, cursorContainer, _atomicLongSetMethod,
+            (jlong) (size_t) readCursor);
+    } else CStore_free(readCursor);
+
+    return status_code;
+}
+
 /** Opens a library.
  *
  * @param libraryFilePath The library file path.
@@ -584,9 +875,11 @@ JNIEXPORT jint JNICALL Java_org_rvpf_store_server_c_CStore_read(
     size_t count = 0;
     c_store_value_t **values = NULL;
     c_store_code_t status_code;
+    int64_t start = Metrics_start();
 
     status_code = store->vector->read(store, serverHandle,
         startTime, endTime, limit, &count, &values);
+    Metrics_recordValues(METRICS_READ, start, count, values);
 
     if (values) {
         CStore_returnValues(env, count, values, container);
@@ -596,6 +889,95 @@ JNIEXPORT jint JNICALL Java_org_rvpf_store_server_c_CStore_read(
     return status_code;
 }
 
+/** Reads values for multiple points.
+ *
+ * <p>The values for all the points are returned in a single container,
+ * grouped by point in the order of the server handles. Reads point by point
+ * when the implementation does not support multi-point requests.</p>
+ *
+ * @param contextHandle The implementation context handle.
+ * @param serverHandles The server handles for the points.
+ * @param startTimes The inclusive start times.
+ * @param endTimes The exclusive end times.
+ * @param limit A limit for the number of values per point.
+ * @param container A container for the values.
+ * @param statusCodes The individual status codes.
+ *
+ * @return A status code.
+ */
+JNIEXPORT jint JNICALL Java_org_rvpf_store_server_c_CStore_readMany(
+    JNIEnv *env, jobject obj, jlong contextHandle, jintArray serverHandles,
+    jlongArray startTimes, jlongArray endTimes, jint limit,
+    jobject container, jintArray statusCodes)
+{
+    c_store_t store = (c_store_t) (size_t) contextHandle;
+    size_t count = (*env)->GetArrayLength(env, serverHandles);
+    c_store_handle_t *server_handles = (*env)->GetIntArrayElements(
+                               env, serverHandles, NULL);
+    c_store_stamp_t *start_times = (*env)->GetLongArrayElements(
+                               env, startTimes, NULL);
+    c_store_stamp_t *end_times = (*env)->GetLongArrayElements(
+                               env, endTimes, NULL);
+    c_store_code_t *status_codes = (*env)->GetIntArrayElements(
+                               env, statusCodes, NULL);
+    c_store_code_t status_code = STATUS_CODE_FAILED;
+
+    if (server_handles && start_times && end_times && status_codes) {
+        if (store->vector->supportsMany
+                && store->vector->supportsMany(store)) {
+            size_t valueCount = 0;
+            c_store_value_t **values = NULL;
+            int64_t start = Metrics_start();
+
+            status_code = store->vector->readMany(store, count,
+                server_handles, start_times, end_times, limit,
+                &valueCount, &values, status_codes);
+            Metrics_recordValues(METRICS_READ_MANY, start, valueCount, values);
+
+            if (values) {
+                CStore_returnValues(env, valueCount, values, container);
+                store->vector->freeValues(store, valueCount, values);
+            }
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                size_t valueCount = 0;
+                c_store_value_t **values = NULL;
+                int64_t start = Metrics_start();
+
+                status_codes[i] = store->vector->read(store,
+                    server_handles[i], start_times[i], end_times[i],
+                    limit, &valueCount, &values);
+                Metrics_recordValues(METRICS_READ, start, valueCount, values);
+
+                if (values) {
+                    CStore_returnValues(env, valueCount, values, container);
+                    store->vector->freeValues(store, valueCount, values);
+                }
+            }
+            status_code = STATUS_CODE_SUCCESS;
+        }
+    }
+
+    if (server_handles) {
+        (*env)->ReleaseIntArrayElements(
+            env, serverHandles, server_handles, JNI_ABORT);
+    }
+    if (start_times) {
+        (*env)->ReleaseLongArrayElements(
+            env, startTimes, start_times, JNI_ABORT);
+    }
+    if (end_times) {
+        (*env)->ReleaseLongArrayElements(
+            env, endTimes, end_times, JNI_ABORT);
+    }
+    if (status_codes) {
+        (*env)->ReleaseIntArrayElements(
+            env, statusCodes, status_codes, 0);
+    }
+
+    return status_code;
+}
+
 /** Releases handles.
  *
  * @param contextHandle The implementation context handle.
@@ -852,6 +1234,35 @@ JNIEXPORT jint JNICALL Java_org_rvpf_store_server_c_CStore_useCharset(
     return status_code;
 }
 
+/** Returns the layout of a value in a values buffer.
+ *
+ * @return The offsets of the handle, stamp, deleted, quality, size and
+ *         value fields, followed by the size field length and the
+ *         alignment of each value.
+ */
+JNIEXPORT jintArray JNICALL Java_org_rvpf_store_server_c_CStore_valueLayout(
+    JNIEnv *env, jobject obj)
+{
+    jint layout[] = {
+        offsetof(c_store_value_t, handle),
+        offsetof(c_store_value_t, stamp),
+        offsetof(c_store_value_t, deleted),
+        offsetof(c_store_value_t, quality),
+        offsetof(c_store_value_t, size),
+        offsetof(c_store_value_t, value),
+        sizeof(size_t),
+        BUFFER_VALUE_ALIGNMENT,
+    };
+    jsize length = sizeof(layout) / sizeof(jint);
+    jintArray layoutArray = (*env)->NewIntArray(env, length);
+
+    if (layoutArray) {
+        (*env)->SetIntArrayRegion(env, layoutArray, 0, length, layout);
+    }
+
+    return layoutArray;
+}
+
 /** Writes points values.
  *
  * @param contextHandle The implementation context handle.
@@ -874,15 +1285,75 @@ JNIEXPORT jint JNICALL Java_org_rvpf_store_server_c_CStore_write(
 
     if (!status_codes) status_code = STATUS_CODE_FAILED;
     if (status_code == STATUS_CODE_SUCCESS) {
+        int64_t start = Metrics_start();
+
         status_code = store->vector->write(store,
             count, values, status_codes);
+        Metrics_recordValues(METRICS_WRITE, start, count, values);
+    }
+
+    if (status_codes) {
+        (*env)->ReleaseIntArrayElements(
+            env, statusCodes, status_codes, 0);
+    }
+    CStore_freeValueBatch(values);
+
+    return status_code;
+}
+
+/** Writes points values from a direct buffer.
+ *
+ * <p>The values are laid out back to back in the buffer, as described by
+ * the value layout. When the implementation does not support buffers (no
+ * writeBuffer entry, or one answering unsupported), the values are written
+ * in place by the write entry.</p>
+ *
+ * @param contextHandle The implementation context handle.
+ * @param buffer The direct buffer.
+ * @param count The number of values in the buffer.
+ * @param statusCodes The individual status codes.
+ *
+ * @return A status code.
+ */
+JNIEXPORT jint JNICALL Java_org_rvpf_store_server_c_CStore_writeBuffer(
+    JNIEnv *env, jobject obj, jlong contextHandle,
+    jobject buffer, jint count, jintArray statusCodes)
+{
+    c_store_t store = (c_store_t) (size_t) contextHandle;
+    c_store_byte_t *address = (*env)->GetDirectBufferAddress(env, buffer);
+    jlong length = (*env)->GetDirectBufferCapacity(env, buffer);
+    c_store_handle_t *status_codes = (*env)->GetIntArrayElements(
+                               env, statusCodes, NULL);
+    c_store_code_t status_code = STATUS_CODE_FAILED;
+
+    if (address && length >= 0 && status_codes) {
+        int64_t start = Metrics_start();
+
+        status_code = store->vector->writeBuffer?
+            store->vector->writeBuffer(store,
+                count, address, length, status_codes):
+            STATUS_CODE_UNSUPPORTED;
+        if (status_code == STATUS_CODE_UNSUPPORTED) {
+            c_store_value_t **values = NULL;
+
+            status_code =
+                CStore_bufferValues(address, length, count, &values);
+            if (status_code == STATUS_CODE_SUCCESS) {
+                start = Metrics_start();
+                status_code = store->vector->write(store,
+                    count, values, status_codes);
+                Metrics_recordValues(METRICS_WRITE, start, count, values);
+            }
+            CStore_free(values);
+        } else {
+            Metrics_record(METRICS_WRITE_BUFFER, start, count, length);
+        }
     }
 
     if (status_codes) {
         (*env)->ReleaseIntArrayElements(
             env, statusCodes, status_codes, 0);
     }
-    if (values) store->vector->freeValues(store, count, values);
 
     return status_code;
 }
@@ -898,72 +1369,115 @@ int CStore_acceptValues(
 {
     if (!container) return STATUS_CODE_FAILED;
 
+    int64_t start = Metrics_start();
     int status_code = (*env)->CallIntMethod(env, container,
         _valuesMethods.statusCode);
-    bool failed = false;
 
     if ((*env)->ExceptionCheck(env)) return STATUS_CODE_FAILED;
     *count = (*env)->CallIntMethod(env, container, _valuesMethods.size);
-    if (*count) {
-        *values = CStore_allocate(sizeof(c_store_value_t *) * *count);
-        ASSERT(*values);
-        for (int i = 0; i < *count; ++i) {
-            int client_handle =
-                (*env)->CallIntMethod(env, container, _valuesMethods.next);
+    if ((*env)->ExceptionCheck(env)) return STATUS_CODE_FAILED;
+    if (!*count) {
+        *values = NULL;
+        return status_code;
+    }
 
-            if ((*env)->ExceptionCheck(env)) return STATUS_CODE_FAILED;
+    (*env)->CallVoidMethod(env, container, _valuesMethods.pack);
+    if ((*env)->ExceptionCheck(env)) return STATUS_CODE_FAILED;
 
-            jbyteArray value =
-                (*env)->GetObjectField(env, container,
-                    _valuesFields.value);
-            size_t size;
+    jintArray handles =
+        (*env)->GetObjectField(env, container, _valuesFields.handles);
+    jlongArray times =
+        (*env)->GetObjectField(env, container, _valuesFields.times);
+    jbooleanArray deletedFlags =
+        (*env)->GetObjectField(env, container, _valuesFields.deletedFlags);
+    jintArray qualities =
+        (*env)->GetObjectField(env, container, _valuesFields.qualities);
+    jintArray offsets =
+        (*env)->GetObjectField(env, container, _valuesFields.offsets);
+    jbyteArray bytes =
+        (*env)->GetObjectField(env, container, _valuesFields.bytes);
+    jint *client_handles = NULL;
+    jlong *stamps = NULL;
+    jboolean *deleted = NULL;
+    jint *qualityCodes = NULL;
+    jint *valueOffsets = NULL;
+    jbyte *valueBytes = NULL;
+    bool failed = (*env)->ExceptionCheck(env)
+        || !handles || !times || !deletedFlags
+        || !qualities || !offsets || !bytes;
+
+    if (!failed) {
+        client_handles = (*env)->GetIntArrayElements(env, handles, NULL);
+        stamps = (*env)->GetLongArrayElements(env, times, NULL);
+        deleted = (*env)->GetBooleanArrayElements(env, deletedFlags, NULL);
+        qualityCodes = (*env)->GetIntArrayElements(env, qualities, NULL);
+        valueOffsets = (*env)->GetIntArrayElements(env, offsets, NULL);
+        valueBytes = (*env)->GetByteArrayElements(env, bytes, NULL);
+        failed = !client_handles || !stamps || !deleted
+            || !qualityCodes || !valueOffsets || !valueBytes;
+    }
 
-            if ((*env)->ExceptionCheck(env)) return STATUS_CODE_FAILED;
+    *values = NULL;
+    if (!failed) {
+        *values = CStore_newValueBatch(*count, valueOffsets[*count]);
+        failed = !*values;
+    }
+    if (!failed) {
+        for (int i = 0; i < *count; ++i) {
+            size_t size = deleted[i]? 0: valueOffsets[i + 1] - valueOffsets[i];
+            c_store_value_t *value = CStore_batchValue(*values, size);
 
-            if (value != NULL) {
-                size = (*env)->GetArrayLength(env, value);
-                if ((*env)->ExceptionCheck(env)) failed = true;
-            } else size = 0;
-            if (!failed) {
-                (*values)[i] = CStore_allocate(sizeof (c_store_value_t) + size);
-                if (!(*values)[i]) failed = true;
-            }
-            if (!failed) {
-                (*values)[i]->handle = client_handle;
-                (*values)[i]->stamp =
-                    (*env)->GetLongField(env,
-                        container, _valuesFields.time);
-                if ((*env)->ExceptionCheck(env)) failed = true;
+            if (!value) {
+                failed = true;
+                break;
             }
-
-            if (!failed) {
-                (*values)[i]->deleted =
-                    (*env)->GetBooleanField(env,
-                        container, _valuesFields.deleted);
-                if ((*env)->ExceptionCheck(env)) failed = true;
+            value->handle = client_handles[i];
+            value->stamp = stamps[i];
+            value->deleted = deleted[i];
+            if (!value->deleted) {
+                value->quality = qualityCodes[i];
+                memcpy(value->value, &valueBytes[valueOffsets[i]], size);
             }
-            if (!(*values)[i]->deleted) {
-                if (!failed) {
-                    (*values)[i]->quality =
-                        (*env)->GetIntField(env,
-                            container, _valuesFields.quality);
-                    if ((*env)->ExceptionCheck(env)) failed = true;
-                }
+            (*values)[i] = value;
+        }
+        if (failed) {
+            CStore_freeValueBatch(*values);
+            *values = NULL;
+        }
+    }
+    if (failed) *count = 0;
 
-                if (!failed && value != NULL) {
-                    (*env)->GetByteArrayRegion(env,
-                        value, 0, size, (*values)[i]->value);
-                    if ((*env)->ExceptionCheck(env)) failed = true;
-                    (*values)[i]->size = size;
-                }
-            }
+    if (valueBytes) {
+        (*env)->ReleaseByteArrayElements(env, bytes, valueBytes, JNI_ABORT);
+    }
+    if (valueOffsets) {
+        (*env)->ReleaseIntArrayElements(env, offsets, valueOffsets, JNI_ABORT);
+    }
+    if (qualityCodes) {
+        (*env)->ReleaseIntArrayElements(
+            env, qualities, qualityCodes, JNI_ABORT);
+    }
+    if (deleted) {
+        (*env)->ReleaseBooleanArrayElements(
+            env, deletedFlags, deleted, JNI_ABORT);
+    }
+    if (stamps) {
+        (*env)->ReleaseLongArrayElements(env, times, stamps, JNI_ABORT);
+    }
+    if (client_handles) {
+        (*env)->ReleaseIntArrayElements(
+            env, handles, client_handles, JNI_ABORT);
+    }
+    (*env)->DeleteLocalRef(env, bytes);
+    (*env)->DeleteLocalRef(env, offsets);
+    (*env)->DeleteLocalRef(env, qualities);
+    (*env)->DeleteLocalRef(env, deletedFlags);
+    (*env)->DeleteLocalRef(env, times);
+    (*env)->DeleteLocalRef(env, handles);
 
-            (*env)->DeleteLocalRef(env, value);
-            if (failed) return STATUS_CODE_FAILED;
-        }
-    } else *values = NULL;
+    Metrics_recordValues(METRICS_ACCEPT_VALUES, start, *count, *values);
 
-    return status_code;
+    return failed? STATUS_CODE_FAILED: status_code;
 }
 
 char *CStore_bytesToCString(JNIEnv *env, jbyteArray bytes)
@@ -1078,6 +1592,13 @@ bool CStore_loadClasses(JNIEnv *env, c_store_logger_t logger)
     _valuesMethods.add =
         CStore_getMethodID(env, _valuesClass, "add", "(IJZI[B)V", logger);
     failed |= _valuesMethods.add == NULL;
+    _valuesMethods.addAll =
+        CStore_getMethodID(env, _valuesClass, "addAll", "([I[J[Z[I[B[I)V",
+            logger);
+    failed |= _valuesMethods.addAll == NULL;
+    _valuesMethods.pack =
+        CStore_getMethodID(env, _valuesClass, "pack", "()V", logger);
+    failed |= _valuesMethods.pack == NULL;
     _valuesMethods.statusCode =
         CStore_getMethodID(env, _valuesClass, "statusCode", "()I", logger);
     failed |= _valuesMethods.statusCode == NULL;
@@ -1100,6 +1621,24 @@ bool CStore_loadClasses(JNIEnv *env, c_store_logger_t logger)
     _valuesFields.value =
         _getFieldID(env, _valuesClass, "_value", "[B", logger);
     failed |= _valuesFields.value == NULL;
+    _valuesFields.handles =
+        _getFieldID(env, _valuesClass, "_handles", "[I", logger);
+    failed |= _valuesFields.handles == NULL;
+    _valuesFields.times =
+        _getFieldID(env, _valuesClass, "_times", "[J", logger);
+    failed |= _valuesFields.times == NULL;
+    _valuesFields.deletedFlags =
+        _getFieldID(env, _valuesClass, "_deletedFlags", "[Z", logger);
+    failed |= _valuesFields.deletedFlags == NULL;
+    _valuesFields.qualities =
+        _getFieldID(env, _valuesClass, "_qualities", "[I", logger);
+    failed |= _valuesFields.qualities == NULL;
+    _valuesFields.offsets =
+        _getFieldID(env, _valuesClass, "_offsets", "[I", logger);
+    failed |= _valuesFields.offsets == NULL;
+    _valuesFields.bytes =
+        _getFieldID(env, _valuesClass, "_bytes", "[B", logger);
+    failed |= _valuesFields.bytes == NULL;
 
     _integerValueMethod =
         CStore_getStaticMethodID(env, _integerClass, "valueOf",
@@ -1127,23 +1666,67 @@ void CStore_returnValues(
     c_store_value_t **values,
     jobject container)
 {
-    for (int i = 0; i < count; ++i) {
-        c_store_value_t *value = values[i];
-        jbyteArray value_bytes = (*env)->NewByteArray(env, value->size);
+    if (count <= 0) return;
 
-        if (!value_bytes) return;
+    int64_t start = Metrics_start();
+    size_t bytesLength = 0;
 
-        (*env)->SetByteArrayRegion(env, value_bytes,
-            0, value->size, value->value);
-        ASSERT(!(*env)->ExceptionCheck(env));
+    for (int i = 0; i < count; ++i) bytesLength += values[i]->size;
 
-        (*env)->CallVoidMethod(env, container, _valuesMethods.add,
-            value->handle, value->stamp, value->deleted,
-            value->quality, value_bytes);
-        ASSERT(!(*env)->ExceptionCheck(env));
+    jintArray handles = (*env)->NewIntArray(env, count);
+    jlongArray times = (*env)->NewLongArray(env, count);
+    jbooleanArray deletedFlags = (*env)->NewBooleanArray(env, count);
+    jintArray qualities = (*env)->NewIntArray(env, count);
+    jintArray offsets = (*env)->NewIntArray(env, count + 1);
+    jbyteArray bytes = (*env)->NewByteArray(env, bytesLength);
+
+    if (handles && times && deletedFlags && qualities && offsets && bytes) {
+        jint *client_handles = (*env)->GetIntArrayElements(env, handles, NULL);
+        jlong *stamps = (*env)->GetLongArrayElements(env, times, NULL);
+        jboolean *deleted =
+            (*env)->GetBooleanArrayElements(env, deletedFlags, NULL);
+        jint *qualityCodes = (*env)->GetIntArrayElements(env, qualities, NULL);
+        jint *valueOffsets = (*env)->GetIntArrayElements(env, offsets, NULL);
+        jbyte *valueBytes = (*env)->GetByteArrayElements(env, bytes, NULL);
+
+        ASSERT(client_handles && stamps && deleted
+            && qualityCodes && valueOffsets && valueBytes);
+
+        size_t offset = 0;
+
+        for (int i = 0; i < count; ++i) {
+            c_store_value_t *value = values[i];
+
+            client_handles[i] = value->handle;
+            stamps[i] = value->stamp;
+            deleted[i] = value->deleted;
+            qualityCodes[i] = value->quality;
+            valueOffsets[i] = offset;
+            memcpy(&valueBytes[offset], value->value, value->size);
+            offset += value->size;
+        }
+        valueOffsets[count] = offset;
+
+        (*env)->ReleaseByteArrayElements(env, bytes, valueBytes, 0);
+        (*env)->ReleaseIntArrayElements(env, offsets, valueOffsets, 0);
+        (*env)->ReleaseIntArrayElements(env, qualities, qualityCodes, 0);
+        (*env)->ReleaseBooleanArrayElements(env, deletedFlags, deleted, 0);
+        (*env)->ReleaseLongArrayElements(env, times, stamps, 0);
+        (*env)->ReleaseIntArrayElements(env, handles, client_handles, 0);
 
-        (*env)->DeleteLocalRef(env, value_bytes);
+        (*env)->CallVoidMethod(env, container, _valuesMethods.addAll,
+            handles, times, deletedFlags, qualities, bytes, offsets);
+        ASSERT(!(*env)->ExceptionCheck(env));
     }
+
+    (*env)->DeleteLocalRef(env, bytes);
+    (*env)->DeleteLocalRef(env, offsets);
+    (*env)->DeleteLocalRef(env, qualities);
+    (*env)->DeleteLocalRef(env, deletedFlags);
+    (*env)->DeleteLocalRef(env, times);
+    (*env)->DeleteLocalRef(env, handles);
+
+    Metrics_record(METRICS_RETURN_VALUES, start, count, bytesLength);
 }
 
 void CStore_unloadClasses(JNIEnv *env)
@@ -1228,6 +1811,25 @@ static void _logBack(
     ASSERT(result == 0);
 }
 
+static void _logDrain(void)
+{
+    if (!LOAD_ACQUIRE(&_logAsync.running)) return;
+
+    struct timespec idle = {0, LOG_ASYNC_IDLE_NANOS};
+
+    // The users count keeps the ring alive while it is used.
+
+    __atomic_add_fetch(&_logAsync.users, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&_logAsync.running, __ATOMIC_SEQ_CST)) {
+        size_t enqueue = rvpf_ring_getEnqueued(_logAsync.ring);
+
+        while ((long) (rvpf_ring_getDequeued(_logAsync.ring) - enqueue) < 0) {
+            nanosleep(&idle, NULL);
+        }
+    }
+    __atomic_sub_fetch(&_logAsync.users, 1, __ATOMIC_SEQ_CST);
+}
+
 static int _loggerLog(
     c_store_logger_t logger,
     size_t size,
@@ -1238,6 +1840,20 @@ static int _loggerLog(
     ASSERT(_javaVM);
     ASSERT(logger->context);
 
+    struct logger_context *loggerContext = logger->context;
+
+    if (LOAD_ACQUIRE(&_logAsync.running)) {
+        bool queued = false;
+
+        __atomic_add_fetch(&_logAsync.users, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&_logAsync.running, __ATOMIC_SEQ_CST)) {
+            _logQueue(loggerContext->cStoreInstance, level, format, args);
+            queued = true;
+        }
+        __atomic_sub_fetch(&_logAsync.users, 1, __ATOMIC_SEQ_CST);
+        if (queued) return 0;
+    }
+
     JavaVMAttachArgs vmArgs;
     JNIEnv *env;
 
@@ -1248,8 +1864,6 @@ static int _loggerLog(
         return -1;
     }
 
-    struct logger_context *loggerContext = logger->context;
-
     return _logJava(env, loggerContext->cStoreInstance,
         size, level, format, args);
 }
@@ -1287,6 +1901,191 @@ static int _logJava(
     return result;
 }
 
+static void _logQueue(
+    jobject cStoreInstance,
+    int level,
+    const char *format,
+    va_list args)
+{
+    // A full ring drops the message.
+
+    size_t position;
+    struct log_cell *cell = rvpf_ring_claim(_logAsync.ring, &position);
+
+    if (!cell) {
+        __atomic_add_fetch(&_logAsync.dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    cell->cStoreInstance = cStoreInstance;
+    cell->level = level;
+    if (vsnprintf(cell->text, sizeof(cell->text), format, args) < 0) {
+        cell->text[0] = '\0';
+    }
+
+    rvpf_ring_publish(_logAsync.ring, position);
+}
+
+static bool _logStart(void)
+{
+    char *envString = getenv(LOG_ASYNC_ENV);
+    long capacity = envString? atol(envString): 0;
+    struct timespec idle = {0, LOG_ASYNC_IDLE_NANOS};
+
+    if (capacity <= 0) return true;
+
+    _logAsync.ring = rvpf_ring_create(capacity, sizeof(struct log_cell));
+    if (!_logAsync.ring) return false;
+
+    if (pthread_create(&_logAsync.writer, NULL, _logWriter, NULL)) {
+        rvpf_ring_dispose(_logAsync.ring);
+        _logAsync.ring = NULL;
+        return false;
+    }
+
+    // The writer publishes 'running' once attached to the VM; when it can't
+    // attach, the messages are logged synchronously.
+
+    while (!LOAD_ACQUIRE(&_logAsync.running)
+            && !LOAD_ACQUIRE(&_logAsync.stopping)) {
+        nanosleep(&idle, NULL);
+    }
+    if (!LOAD_ACQUIRE(&_logAsync.running)) {
+        pthread_join(_logAsync.writer, NULL);
+        rvpf_ring_dispose(_logAsync.ring);
+        _logAsync.ring = NULL;
+        _logAsync.stopping = false;
+    }
+
+    return true;
+}
+
+static void _logStop(void)
+{
+    if (!LOAD_ACQUIRE(&_logAsync.running)) return;
+
+    struct timespec idle = {0, LOG_ASYNC_IDLE_NANOS};
+
+    // Waits for the users of the ring before letting the writer empty it.
+
+    __atomic_store_n(&_logAsync.running, false, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&_logAsync.users, __ATOMIC_SEQ_CST)) {
+        nanosleep(&idle, NULL);
+    }
+    STORE_RELEASE(&_logAsync.stopping, true);
+    pthread_join(_logAsync.writer, NULL);
+    rvpf_ring_dispose(_logAsync.ring);
+    _logAsync.ring = NULL;
+    _logAsync.stopping = false;
+}
+
+static void *_logWriter(void *argument)
+{
+    struct timespec idle = {0, LOG_ASYNC_IDLE_NANOS};
+    JavaVMAttachArgs vmArgs;
+    JNIEnv *env;
+    unsigned long reported = 0;
+
+    vmArgs.version = JNI_VERSION_1_4;
+    vmArgs.name = "CStore logger";
+    vmArgs.group = NULL;
+    if ((*_javaVM)->AttachCurrentThreadAsDaemon(
+            _javaVM, (void **) &env, &vmArgs)) {
+        STORE_RELEASE(&_logAsync.stopping, true);
+        return NULL;
+    }
+    STORE_RELEASE(&_logAsync.running, true);
+
+    while (true) {
+        jobject cStoreInstance = NULL;
+        size_t written = 0;
+        struct log_cell *cell;
+
+        while ((cell = rvpf_ring_peek(_logAsync.ring))) {
+            cStoreInstance = cell->cStoreInstance;
+            _logBack(env, cStoreInstance, cell->level, "%s", cell->text);
+            rvpf_ring_release(_logAsync.ring);
+            ++written;
+        }
+
+        unsigned long dropped =
+            __atomic_load_n(&_logAsync.dropped, __ATOMIC_RELAXED);
+
+        if (dropped != reported && cStoreInstance) {
+            _logBack(env, cStoreInstance, LOG_LEVEL_WARN,
+                "Dropped %lu log messages", dropped - reported);
+            reported = dropped;
+        }
+
+        if (written) continue;
+
+        if (LOAD_ACQUIRE(&_logAsync.stopping)) {
+            // Waits for the messages claimed before the stop.
+
+            if (rvpf_ring_isEmpty(_logAsync.ring)) break;
+        } else nanosleep(&idle, NULL);
+    }
+
+    (*_javaVM)->DetachCurrentThread(_javaVM);
+
+    return NULL;
+}
+
+static c_store_code_t _readCursor(
+    c_store_t store,
+    struct read_cursor *readCursor,
+    size_t limit,
+    c_store_byte_t *buffer,
+    size_t length,
+    size_t *count)
+{
+    // Reads at most what could fit, then resumes after the last value kept.
+
+    size_t wanted = length / sizeof(c_store_value_t);
+    size_t found = 0;
+    size_t fetched = 0;
+    size_t offset = 0;
+    c_store_value_t **values = NULL;
+    c_store_code_t status_code;
+
+    *count = 0;
+    if (limit && limit < wanted) wanted = limit;
+    if (readCursor->ended) return STATUS_CODE_SUCCESS;
+    if (!wanted) return STATUS_CODE_BUFFER_TOO_SMALL;
+
+    status_code = store->vector->read(store, readCursor->serverHandle,
+        readCursor->next, readCursor->end, wanted, &found, &values);
+
+    if (status_code == STATUS_CODE_SUCCESS) {
+        for (; fetched < found; ++fetched) {
+            c_store_value_t *value = values[fetched];
+            c_store_value_t *bufferValue =
+                CStore_bufferValue(buffer, length, &offset, value->size);
+
+            if (!bufferValue) break;
+            bufferValue->handle = value->handle;
+            bufferValue->stamp = value->stamp;
+            bufferValue->deleted = value->deleted;
+            bufferValue->quality = value->quality;
+            memcpy(bufferValue->value, value->value, value->size);
+            readCursor->next = readCursor->reverse?
+                value->stamp - 1: value->stamp + 1;
+        }
+
+        if (fetched == found && found < wanted) readCursor->ended = true;
+        if (readCursor->reverse? readCursor->next <= readCursor->end:
+                readCursor->next >= readCursor->end) {
+            readCursor->ended = true;
+        }
+        if (!fetched && found) status_code = STATUS_CODE_BUFFER_TOO_SMALL;
+        *count = fetched;
+    }
+
+    if (values) store->vector->freeValues(store, found, values);
+
+    return status_code;
+}
+
 static void _throwNew(const char *name, const char *msg)
 {
     if (_javaVM) {
@@ -9,6 +9,7 @@
  */
 #include "CStoreImpl.h"
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
@@ -25,8 +26,33 @@
 
 #define MAX_BYTES_BLOCK 65534
 
+// The Externalizer encodes numbers as big-endian.
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) \
+        && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define FROM_BIG_32(x) __builtin_bswap32(x)
+#define FROM_BIG_64(x) __builtin_bswap64(x)
+#elif defined(__GNUC__) && defined(__BYTE_ORDER__) \
+        && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define FROM_BIG_32(x) (x)
+#define FROM_BIG_64(x) (x)
+#endif
+
+#define NUMBER_VALUE_SIZE 9
+
 // Private type definitions.
 
+struct value_slab {
+    struct value_slab *next;
+    size_t capacity;
+    size_t used;
+    c_store_long_t bytes[]; // Aligned for values.
+};
+
+struct value_batch {
+    struct value_slab *slab;
+    c_store_value_t *values[];
+};
+
 union number {
     c_store_double_t doubleValue;
     c_store_long_t longValue;
@@ -45,12 +71,49 @@ static char _assertOutput;
 
 // Private forward declarations.
 
+static struct value_batch *_batch(c_store_value_t **values);
+
+static size_t _blockLength(
+    c_store_value_t *storeValue,
+    const c_store_byte_t *valuePointer);
+
+static size_t _bufferValueLength(size_t size);
+
+static size_t _formatInt(c_store_long_t value, char *text);
+
+static uint32_t _getBig32(const c_store_byte_t *bytes);
+
+static uint64_t _getBig64(const c_store_byte_t *bytes);
+
 static char *_joinedStringValue(c_store_value_t *storeValue);
 
 static size_t _joinedValueLength(c_store_value_t *storeValue);
 
 static void _joinValue(c_store_value_t *storeValue, void *buffer);
 
+static bool _newNumberValues(
+    c_store_value_t **batch,
+    enum value_type valueType,
+    const void *numbers,
+    size_t count,
+    c_store_value_t **values);
+
+static struct value_slab *_newSlab(size_t capacity);
+
+static c_store_value_t *_newValue(
+    c_store_value_t **batch,
+    enum value_type valueType,
+    va_list args);
+
+static void _putBig32(c_store_byte_t *bytes, uint32_t number);
+
+static void _putBig64(c_store_byte_t *bytes, uint64_t number);
+
+static bool _singleBlock(
+    c_store_value_t *storeValue,
+    const c_store_byte_t **bytes,
+    size_t *length);
+
 static size_t _splitLength(size_t joinedLength);
 
 static void _splitValue(
@@ -78,6 +141,81 @@ void CStore_assert(const char *file, int line, const char *message)
     _assertOutput = *_assertInput; // Crash!
 }
 
+c_store_value_t *CStore_batchValue(c_store_value_t **batch, size_t size)
+{
+    struct value_batch *valueBatch = _batch(batch);
+    size_t length = _bufferValueLength(size);
+    struct value_slab *slab = valueBatch->slab;
+
+    if (!slab || slab->capacity - slab->used < length) {
+        size_t capacity = slab? slab->capacity * 2: length;
+
+        slab = _newSlab(capacity < length? length: capacity);
+        if (!slab) return NULL;
+        slab->next = valueBatch->slab;
+        valueBatch->slab = slab;
+    }
+
+    c_store_value_t *value =
+        (c_store_value_t *) ((c_store_byte_t *) slab->bytes + slab->used);
+
+    slab->used += length;
+    value->size = size;
+
+    return value;
+}
+
+c_store_value_t *CStore_bufferValue(
+    c_store_byte_t *buffer,
+    size_t length,
+    size_t *offset,
+    size_t size)
+{
+    // Lays out a value as expected by CStore_bufferValues.
+
+    size_t valueLength = _bufferValueLength(size);
+
+    if (length < *offset || length - *offset < valueLength) return NULL;
+
+    c_store_value_t *value = (c_store_value_t *) (buffer + *offset);
+
+    memset(value, 0, offsetof(c_store_value_t, value));
+    value->size = size;
+    *offset += valueLength;
+
+    return value;
+}
+
+c_store_code_t CStore_bufferValues(
+    c_store_byte_t *buffer,
+    size_t length,
+    size_t count,
+    c_store_value_t ***values)
+{
+    c_store_value_t **bufferValues =
+        CStore_allocate(sizeof(c_store_value_t *) * (count? count: 1));
+    size_t offset = 0;
+
+    if (!bufferValues) return STATUS_CODE_FAILED;
+
+    for (size_t i = 0; i < count; ++i) {
+        c_store_value_t *value = (c_store_value_t *) (buffer + offset);
+
+        if (length < offset + offsetof(c_store_value_t, value)
+                || length - offset - offsetof(c_store_value_t, value)
+                    < value->size) {
+            CStore_free(bufferValues);
+            return STATUS_CODE_FAILED;
+        }
+        bufferValues[i] = value;
+        offset += _bufferValueLength(value->size);
+    }
+
+    *values = bufferValues;
+
+    return STATUS_CODE_SUCCESS;
+}
+
 void CStore_closeLibrary(void *libraryHandle)
 {
 #ifdef _WIN32
@@ -92,6 +230,22 @@ void CStore_free(void *memory)
     free(memory);
 }
 
+void CStore_freeValueBatch(c_store_value_t **batch)
+{
+    if (!batch) return;
+
+    struct value_batch *valueBatch = _batch(batch);
+    struct value_slab *slab = valueBatch->slab;
+
+    while (slab) {
+        struct value_slab *next = slab->next;
+
+        CStore_free(slab);
+        slab = next;
+    }
+    CStore_free(valueBatch);
+}
+
 enum value_type CStore_getValueType(c_store_value_t *storeValue)
 {
     return storeValue->size? storeValue->value[0]: VALUE_TYPE_NULL;
@@ -116,143 +270,88 @@ void CStore_log(c_store_logger_t logger, int level, const char *format, ...)
     }
 }
 
+c_store_value_t *CStore_newBatchValue(
+    c_store_value_t **batch,
+    enum value_type valueType,
+    ...)
+{
+    va_list args;
+
+    va_start(args, valueType);
+
+    c_store_value_t *storeValue = _newValue(batch, valueType, args);
+
+    va_end(args);
+
+    return storeValue;
+}
+
+bool CStore_newBatchDoubleValues(
+    c_store_value_t **batch,
+    const c_store_double_t *doubleValues,
+    size_t count,
+    c_store_value_t **values)
+{
+    ASSERT(sizeof(c_store_double_t) == sizeof(c_store_long_t));
+
+    return _newNumberValues(
+        batch, VALUE_TYPE_DOUBLE, doubleValues, count, values);
+}
+
+bool CStore_newBatchLongValues(
+    c_store_value_t **batch,
+    const c_store_long_t *longValues,
+    size_t count,
+    c_store_value_t **values)
+{
+    return _newNumberValues(batch, VALUE_TYPE_LONG, longValues, count, values);
+}
+
 c_store_value_t *CStore_newValue(
     c_store_t cStore,
     enum value_type valueType,
     ...)
 {
     va_list args;
-    char textBuffer[12];
-    size_t textLength;
-    size_t bytesLength;
-    union number number;
-    void *bytes;
-    size_t valueLength;
-    c_store_quality_t *stateCode;
 
     va_start(args, valueType);
-    switch (valueType) {
-    case VALUE_TYPE_NULL:
-        valueLength = 0;
-        break;
-    case VALUE_TYPE_DOUBLE:
-        number.doubleValue = va_arg(args, c_store_double_t);
-        valueLength = 1 + sizeof(number.doubleValue);
-        break;
-    case VALUE_TYPE_LONG:
-        number.longValue = va_arg(args, c_store_long_t);
-        valueLength = 1 + sizeof(number.longValue);
-        break;
-    case VALUE_TYPE_BOOLEAN:
-        number.boolValue = va_arg(args, int);
-        valueLength = 1 + sizeof(number.boolValue);
-        break;
-    case VALUE_TYPE_SHORT:
-        number.shortValue = va_arg(args, int);
-        valueLength = 1 + sizeof(number.shortValue);
-        break;
-    case VALUE_TYPE_STATE:
-        stateCode = va_arg(args, c_store_quality_t *);
-        if (stateCode) {
-            sprintf(textBuffer, "%li", (long) *stateCode);
-            textLength = strlen(textBuffer);
-        } else textLength = 0;
-        valueLength = 1 + _splitLength(textLength);
-        bytes = va_arg(args, void *);
-        if (bytes) {
-            textBuffer[textLength++] = ':';
-            ++valueLength;
-            bytesLength = va_arg(args, size_t);
-            valueLength += _splitLength(bytesLength) - 2;
-        } else bytesLength = 0;
-        break;
-    case VALUE_TYPE_STRING:
-    case VALUE_TYPE_BYTE_ARRAY:
-        bytes = va_arg(args, void *);
-        bytesLength = va_arg(args, size_t);
-        valueLength = 1 + _splitLength(bytesLength);
-        break;
-    case VALUE_TYPE_INTEGER:
-        number.intValue = va_arg(args, c_store_int_t);
-        valueLength = 1 + sizeof(number.intValue);
-        break;
-    case VALUE_TYPE_FLOAT:
-        number.floatValue = va_arg(args, double);
-        valueLength = 1 + sizeof(number.floatValue);
-        break;
-    case VALUE_TYPE_CHARACTER:
-    case VALUE_TYPE_BYTE:
-        number.byteValue = va_arg(args, int);
-        valueLength = 1 + sizeof(number.byteValue);
-        break;
-    default:
-        ASSERT(false);
-        valueLength = 0;
-        break;
-    }
+
+    c_store_value_t *storeValue = _newValue(NULL, valueType, args);
 
     va_end(args);
 
-    c_store_value_t *storeValue =
-        CStore_allocate(sizeof(c_store_value_t) + valueLength);
+    return storeValue;
+}
 
-    ASSERT(storeValue);
-    if (valueLength) {
-        storeValue->size = valueLength;
-        storeValue->value[0] = valueType;
-    }
+c_store_value_t **CStore_newValueBatch(size_t count, size_t bytesLength)
+{
+    struct value_batch *valueBatch = CStore_allocate(
+        sizeof(struct value_batch) + sizeof(c_store_value_t *) * count);
 
-    switch (valueType) {
-    case VALUE_TYPE_DOUBLE:
-    case VALUE_TYPE_LONG:
-        ASSERT(valueLength == 9);
-        storeValue->value[1] = number.longValue >> 56;
-        storeValue->value[2] = number.longValue >> 48;
-        storeValue->value[3] = number.longValue >> 40;
-        storeValue->value[4] = number.longValue >> 32;
-        storeValue->value[5] = number.longValue >> 24;
-        storeValue->value[6] = number.longValue >> 16;
-        storeValue->value[7] = number.longValue >> 8;
-        storeValue->value[8] = number.longValue >> 0;
-        break;
-    case VALUE_TYPE_BOOLEAN:
-    case VALUE_TYPE_CHARACTER:
-    case VALUE_TYPE_BYTE:
-        ASSERT(valueLength == 2);
-        storeValue->value[1] = number.byteValue;
-        break;
-    case VALUE_TYPE_SHORT:
-        ASSERT(valueLength == 3);
-        storeValue->value[1] = number.shortValue >> 8;
-        storeValue->value[2] = number.shortValue >> 0;
-        break;
-    case VALUE_TYPE_STATE:
-        _splitValue(textBuffer, textLength, storeValue, 0);
-        if (bytes) {
-            _splitValue(bytes, bytesLength,
-                    storeValue, _splitLength(textLength) - 2);
+    if (!valueBatch) return NULL;
+
+    if (count) {
+        size_t capacity = count * _bufferValueLength(0)
+            + bytesLength + count * (BUFFER_VALUE_ALIGNMENT - 1);
+
+        valueBatch->slab = _newSlab(capacity);
+        if (!valueBatch->slab) {
+            CStore_free(valueBatch);
+            return NULL;
         }
-        ASSERT(textLength + bytesLength == _joinedValueLength(storeValue));
-        break;
-    case VALUE_TYPE_STRING:
-    case VALUE_TYPE_BYTE_ARRAY:
-        ASSERT(valueLength);
-        _splitValue(bytes, bytesLength, storeValue, 0);
-        break;
-    case VALUE_TYPE_INTEGER:
-    case VALUE_TYPE_FLOAT:
-        ASSERT(valueLength == 5);
-        storeValue->value[1] = number.intValue >> 24;
-        storeValue->value[2] = number.intValue >> 16;
-        storeValue->value[3] = number.intValue >> 8;
-        storeValue->value[4] = number.intValue >> 0;
-        break;
-    default:
-        ASSERT(!valueLength);
-        break;
     }
 
-    return storeValue;
+    return valueBatch->values;
+}
+
+c_store_value_t **CStore_newValueReferences(size_t count)
+{
+    // The values are owned elsewhere: freeing the batch leaves them alone.
+
+    struct value_batch *valueBatch = CStore_allocate(
+        sizeof(struct value_batch) + sizeof(c_store_value_t *) * count);
+
+    return valueBatch? valueBatch->values: NULL;
 }
 
 void *CStore_openLibrary(const char *libraryPath)
@@ -326,6 +425,39 @@ void *CStore_resolveSymbol(void *libraryHandle, const char *symbol)
     return address;
 }
 
+bool CStore_valueToBuffer(
+    c_store_value_t *storeValue,
+    void *buffer,
+    size_t capacity,
+    size_t *length)
+{
+    // Joins in a single pass; on overflow, only the length is completed.
+
+    enum value_type valueType = CStore_getValueType(storeValue);
+    c_store_byte_t *valuePointer = &storeValue->value[1];
+    c_store_byte_t *bufferPointer = buffer;
+    size_t valueLength = 0;
+
+    if (valueType != VALUE_TYPE_STRING
+            && valueType != VALUE_TYPE_BYTE_ARRAY) return false;
+
+    for (;;) {
+        size_t blockLength = _blockLength(storeValue, valuePointer);
+
+        if (blockLength == 0) break;
+        valuePointer += 2;
+        if (valueLength + blockLength <= capacity) {
+            memcpy(bufferPointer + valueLength, valuePointer, blockLength);
+        }
+        valueLength += blockLength;
+        valuePointer += blockLength;
+    }
+
+    *length = valueLength;
+
+    return valueLength <= capacity;
+}
+
 bool CStore_valueToByteArray(
     c_store_value_t *storeValue,
     c_store_byte_t **bytesValue,
@@ -342,6 +474,21 @@ bool CStore_valueToByteArray(
 
 }
 
+bool CStore_valueToBytesReference(
+    c_store_value_t *storeValue,
+    const c_store_byte_t **bytes,
+    size_t *length)
+{
+    // The bytes stay in the value and are not terminated.
+
+    enum value_type valueType = CStore_getValueType(storeValue);
+
+    if (valueType != VALUE_TYPE_STRING
+            && valueType != VALUE_TYPE_BYTE_ARRAY) return false;
+
+    return _singleBlock(storeValue, bytes, length);
+}
+
 bool CStore_valueToDouble(
     c_store_value_t *storeValue,
     c_store_double_t *doubleValue)
@@ -350,28 +497,11 @@ bool CStore_valueToDouble(
 
     switch (CStore_getValueType(storeValue)) {
     case VALUE_TYPE_DOUBLE:
-        number.longValue =
-            (c_store_long_t) (unsigned char) storeValue->value[1] << 56;
-        number.longValue |=
-            (c_store_long_t) (unsigned char) storeValue->value[2] << 48;
-        number.longValue |=
-            (c_store_long_t) (unsigned char) storeValue->value[3] << 40;
-        number.longValue |=
-            (c_store_long_t) (unsigned char) storeValue->value[4] << 32;
-        number.longValue |=
-            (c_store_long_t) (unsigned char) storeValue->value[5] << 24;
-        number.longValue |=
-            (c_store_long_t) (unsigned char) storeValue->value[6] << 16;
-        number.longValue |=
-            (c_store_long_t) (unsigned char) storeValue->value[7] << 8;
-        number.longValue |=
-            (c_store_long_t) (unsigned char) storeValue->value[8] << 0;
+        number.longValue = _getBig64(&storeValue->value[1]);
         break;
     case VALUE_TYPE_FLOAT:
-        number.longValue = (unsigned char) storeValue->value[1] << 24;
-        number.longValue |= (unsigned char) storeValue->value[2] << 16;
-        number.longValue |= (unsigned char) storeValue->value[3] << 8;
-        number.longValue |= (unsigned char) storeValue->value[4] << 0;
+        number.intValue = _getBig32(&storeValue->value[1]);
+        number.doubleValue = number.floatValue;
         break;
     case VALUE_TYPE_STRING:
         {
@@ -401,7 +531,7 @@ bool CStore_valueToDouble(
                 *doubleValue = 0;
                 return false;
             }
-            *doubleValue = longValue;
+            number.doubleValue = longValue;
             break;
         }
     default:
@@ -420,28 +550,10 @@ bool CStore_valueToLong(
 {
     switch (CStore_getValueType(storeValue)) {
     case VALUE_TYPE_LONG:
-        *longValue =
-            (c_store_long_t) (unsigned char) storeValue->value[1] << 56;
-        *longValue |=
-            (c_store_long_t) (unsigned char) storeValue->value[2] << 48;
-        *longValue |=
-            (c_store_long_t) (unsigned char) storeValue->value[3] << 40;
-        *longValue |=
-            (c_store_long_t) (unsigned char) storeValue->value[4] << 32;
-        *longValue |=
-            (c_store_long_t) (unsigned char) storeValue->value[5] << 24;
-        *longValue |=
-            (c_store_long_t) (unsigned char) storeValue->value[6] << 16;
-        *longValue |=
-            (c_store_long_t) (unsigned char) storeValue->value[7] << 8;
-        *longValue |=
-            (c_store_long_t) (unsigned char) storeValue->value[8] << 0;
+        *longValue = (c_store_long_t) _getBig64(&storeValue->value[1]);
         break;
     case VALUE_TYPE_INTEGER:
-        *longValue = (unsigned char) storeValue->value[1] << 24;
-        *longValue |= (unsigned char) storeValue->value[2] << 16;
-        *longValue |= (unsigned char) storeValue->value[3] << 8;
-        *longValue |= (unsigned char) storeValue->value[4] << 0;
+        *longValue = (c_store_int_t) _getBig32(&storeValue->value[1]);
         break;
     case VALUE_TYPE_SHORT:
         *longValue = (unsigned char) storeValue->value[1] << 8;
@@ -521,13 +633,13 @@ bool CStore_valueToStateName(
         char *colon = strchr(stateString, ':');
 
         if (colon) {
-            size_t length = &stateString[storeValue->size] - (colon + 1);
+            size_t length = strlen(colon + 1);
 
             *stateName = CStore_allocate(length + 1);
             ASSERT(*stateName);
             memcpy(*stateName, colon + 1, length);
-            CStore_free(stateString);
         } else *stateName = NULL;
+        CStore_free(stateString);
     } else {
         if (!CStore_valueToString(storeValue, stateName)) return false;
     }
@@ -547,15 +659,168 @@ bool CStore_valueToString(
 
 }
 
+size_t CStore_valuesToDoubles(
+    c_store_value_t **values,
+    size_t count,
+    c_store_double_t *doubleValues,
+    bool *converted)
+{
+    size_t done = 0;
+    size_t i;
+
+    // Fast path while the values are doubles: a load and a byte swap each.
+
+    for (i = 0; i < count; ++i) {
+        const c_store_value_t *storeValue = values[i];
+        union number number;
+
+        if (storeValue->size != NUMBER_VALUE_SIZE
+                || storeValue->value[0] != VALUE_TYPE_DOUBLE) break;
+        number.longValue = _getBig64(&storeValue->value[1]);
+        doubleValues[i] = number.doubleValue;
+        if (converted) converted[i] = true;
+    }
+    done = i;
+
+    for (; i < count; ++i) {
+        bool success = CStore_valueToDouble(values[i], &doubleValues[i]);
+
+        if (success) ++done;
+        if (converted) converted[i] = success;
+    }
+
+    return done;
+}
+
+size_t CStore_valuesToLongs(
+    c_store_value_t **values,
+    size_t count,
+    c_store_long_t *longValues,
+    bool *converted)
+{
+    size_t done = 0;
+    size_t i;
+
+    // Fast path while the values are longs: a load and a byte swap each.
+
+    for (i = 0; i < count; ++i) {
+        const c_store_value_t *storeValue = values[i];
+
+        if (storeValue->size != NUMBER_VALUE_SIZE
+                || storeValue->value[0] != VALUE_TYPE_LONG) break;
+        longValues[i] = (c_store_long_t) _getBig64(&storeValue->value[1]);
+        if (converted) converted[i] = true;
+    }
+    done = i;
+
+    for (; i < count; ++i) {
+        bool success = CStore_valueToLong(values[i], &longValues[i]);
+
+        if (success) ++done;
+        if (converted) converted[i] = success;
+    }
+
+    return done;
+}
+
 
 // Private function definitions.
 
-static char *_joinedStringValue(c_store_value_t *storeValue)
+static struct value_batch *_batch(c_store_value_t **values)
+{
+    return (struct value_batch *)
+        ((c_store_byte_t *) values - offsetof(struct value_batch, values));
+}
+
+static size_t _blockLength(
+    c_store_value_t *storeValue,
+    const c_store_byte_t *valuePointer)
+{
+    // Zero ends the walk, also for a block running past the value size.
+
+    size_t offset = (size_t) (valuePointer - storeValue->value);
+    size_t blockLength;
+
+    if (offset + 2 > storeValue->size) return 0;
+    blockLength = (valuePointer[0] & 0xFF) << 8 | (valuePointer[1] & 0xFF);
+    if (offset + 2 + blockLength > storeValue->size) return 0;
+
+    return blockLength;
+}
+
+static size_t _bufferValueLength(size_t size)
+{
+    size_t length = offsetof(c_store_value_t, value) + size;
+
+    return (length + BUFFER_VALUE_ALIGNMENT - 1)
+        / BUFFER_VALUE_ALIGNMENT * BUFFER_VALUE_ALIGNMENT;
+}
+
+static size_t _formatInt(c_store_long_t value, char *text)
+{
+    char digits[20];
+    size_t length = 0;
+    size_t count = 0;
+    uint64_t magnitude = value < 0?
+        -(uint64_t) value: (uint64_t) value;
+
+    do {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude);
+
+    if (value < 0) text[length++] = '-';
+    while (count) text[length++] = digits[--count];
+    text[length] = '\0';
+
+    return length;
+}
+
+static uint32_t _getBig32(const c_store_byte_t *bytes)
+{
+#ifdef FROM_BIG_32
+    uint32_t number;
+
+    memcpy(&number, bytes, sizeof(number));
+
+    return FROM_BIG_32(number);
+#else
+    const unsigned char *next = (const unsigned char *) bytes;
+
+    return (uint32_t) next[0] << 24 | (uint32_t) next[1] << 16
+        | (uint32_t) next[2] << 8 | (uint32_t) next[3];
+#endif
+}
+
+static uint64_t _getBig64(const c_store_byte_t *bytes)
 {
-    char *stringValue = CStore_allocate(_joinedValueLength(storeValue) + 1);
+#ifdef FROM_BIG_64
+    uint64_t number;
 
-    ASSERT(stringValue);
-    _joinValue(storeValue, stringValue);
+    memcpy(&number, bytes, sizeof(number));
+
+    return FROM_BIG_64(number);
+#else
+    return (uint64_t) _getBig32(bytes) << 32 | _getBig32(bytes + 4);
+#endif
+}
+
+static char *_joinedStringValue(c_store_value_t *storeValue)
+{
+    const c_store_byte_t *bytes;
+    size_t length;
+    char *stringValue;
+
+    if (_singleBlock(storeValue, &bytes, &length)) {
+        stringValue = malloc(length + 1);
+        ASSERT(stringValue);
+        memcpy(stringValue, bytes, length);
+        stringValue[length] = '\0';
+    } else {
+        stringValue = CStore_allocate(_joinedValueLength(storeValue) + 1);
+        ASSERT(stringValue);
+        _joinValue(storeValue, stringValue);
+    }
 
     return stringValue;
 }
@@ -566,10 +831,10 @@ static size_t _joinedValueLength(c_store_value_t *storeValue)
     size_t valueLength = 0;
 
     for (;;) {
-        size_t length = (*valuePointer++  & 0xFF) << 8;
+        size_t length = _blockLength(storeValue, valuePointer);
 
-        length += *valuePointer++ & 0xFF;
         if (length == 0) break;
+        valuePointer += 2;
         valueLength += length;
         valuePointer += length;
     }
@@ -583,16 +848,227 @@ static void _joinValue(c_store_value_t *storeValue, void *buffer)
     c_store_byte_t *bufferPointer = buffer;
 
     for (;;) {
-        size_t length = (*valuePointer++  & 0xFF) << 8;
+        size_t length = _blockLength(storeValue, valuePointer);
 
-        length += *valuePointer++ & 0xFF;
         if (length == 0) break;
+        valuePointer += 2;
         memcpy(bufferPointer, valuePointer, length);
         valuePointer += length;
         bufferPointer += length;
     }
 }
 
+static struct value_slab *_newSlab(size_t capacity)
+{
+    struct value_slab *slab = malloc(sizeof(struct value_slab) + capacity);
+
+    if (slab) {
+        memset(slab->bytes, 0, capacity);
+        slab->next = NULL;
+        slab->capacity = capacity;
+        slab->used = 0;
+    }
+
+    return slab;
+}
+
+static bool _newNumberValues(
+    c_store_value_t **batch,
+    enum value_type valueType,
+    const void *numbers,
+    size_t count,
+    c_store_value_t **values)
+{
+    // The numbers are copied out as raw 64 bits: the doubles are not read
+    // through a long pointer.
+
+    const c_store_byte_t *bytes = numbers;
+
+    for (size_t i = 0; i < count; ++i) {
+        c_store_value_t *storeValue =
+            CStore_batchValue(batch, NUMBER_VALUE_SIZE);
+        c_store_long_t number;
+
+        if (!storeValue) return false;
+        memcpy(&number, bytes + i * sizeof number, sizeof number);
+        storeValue->value[0] = valueType;
+        _putBig64(&storeValue->value[1], number);
+        values[i] = storeValue;
+    }
+
+    return true;
+}
+
+static c_store_value_t *_newValue(
+    c_store_value_t **batch,
+    enum value_type valueType,
+    va_list args)
+{
+    char textBuffer[12];
+    size_t textLength;
+    size_t bytesLength;
+    union number number;
+    void *bytes;
+    size_t valueLength;
+    c_store_quality_t *stateCode;
+
+    switch (valueType) {
+    case VALUE_TYPE_NULL:
+        valueLength = 0;
+        break;
+    case VALUE_TYPE_DOUBLE:
+        number.doubleValue = va_arg(args, c_store_double_t);
+        valueLength = 1 + sizeof(number.doubleValue);
+        break;
+    case VALUE_TYPE_LONG:
+        number.longValue = va_arg(args, c_store_long_t);
+        valueLength = 1 + sizeof(number.longValue);
+        break;
+    case VALUE_TYPE_BOOLEAN:
+        number.boolValue = va_arg(args, int);
+        valueLength = 1 + sizeof(number.boolValue);
+        break;
+    case VALUE_TYPE_SHORT:
+        number.shortValue = va_arg(args, int);
+        valueLength = 1 + sizeof(number.shortValue);
+        break;
+    case VALUE_TYPE_STATE:
+        stateCode = va_arg(args, c_store_quality_t *);
+        textLength = stateCode? _formatInt(*stateCode, textBuffer): 0;
+        valueLength = 1 + _splitLength(textLength);
+        bytes = va_arg(args, void *);
+        if (bytes) {
+            textBuffer[textLength++] = ':';
+            ++valueLength;
+            bytesLength = va_arg(args, size_t);
+            valueLength += _splitLength(bytesLength) - 2;
+        } else bytesLength = 0;
+        break;
+    case VALUE_TYPE_STRING:
+    case VALUE_TYPE_BYTE_ARRAY:
+        bytes = va_arg(args, void *);
+        bytesLength = va_arg(args, size_t);
+        valueLength = 1 + _splitLength(bytesLength);
+        break;
+    case VALUE_TYPE_INTEGER:
+        number.intValue = va_arg(args, c_store_int_t);
+        valueLength = 1 + sizeof(number.intValue);
+        break;
+    case VALUE_TYPE_FLOAT:
+        number.floatValue = va_arg(args, double);
+        valueLength = 1 + sizeof(number.floatValue);
+        break;
+    case VALUE_TYPE_CHARACTER:
+    case VALUE_TYPE_BYTE:
+        number.byteValue = va_arg(args, int);
+        valueLength = 1 + sizeof(number.byteValue);
+        break;
+    default:
+        ASSERT(false);
+        valueLength = 0;
+        break;
+    }
+
+    c_store_value_t *storeValue = batch?
+        CStore_batchValue(batch, valueLength):
+        CStore_allocate(sizeof(c_store_value_t) + valueLength);
+
+    ASSERT(storeValue);
+    if (valueLength) {
+        storeValue->size = valueLength;
+        storeValue->value[0] = valueType;
+    }
+
+    switch (valueType) {
+    case VALUE_TYPE_DOUBLE:
+    case VALUE_TYPE_LONG:
+        ASSERT(valueLength == NUMBER_VALUE_SIZE);
+        _putBig64(&storeValue->value[1], number.longValue);
+        break;
+    case VALUE_TYPE_BOOLEAN:
+    case VALUE_TYPE_CHARACTER:
+    case VALUE_TYPE_BYTE:
+        ASSERT(valueLength == 2);
+        storeValue->value[1] = number.byteValue;
+        break;
+    case VALUE_TYPE_SHORT:
+        ASSERT(valueLength == 3);
+        storeValue->value[1] = number.shortValue >> 8;
+        storeValue->value[2] = number.shortValue >> 0;
+        break;
+    case VALUE_TYPE_STATE:
+        _splitValue(textBuffer, textLength, storeValue, 0);
+        if (bytes) {
+            _splitValue(bytes, bytesLength,
+                    storeValue, _splitLength(textLength) - 2);
+        }
+        ASSERT(textLength + bytesLength == _joinedValueLength(storeValue));
+        break;
+    case VALUE_TYPE_STRING:
+    case VALUE_TYPE_BYTE_ARRAY:
+        ASSERT(valueLength);
+        _splitValue(bytes, bytesLength, storeValue, 0);
+        break;
+    case VALUE_TYPE_INTEGER:
+    case VALUE_TYPE_FLOAT:
+        ASSERT(valueLength == 5);
+        _putBig32(&storeValue->value[1], number.intValue);
+        break;
+    default:
+        ASSERT(!valueLength);
+        break;
+    }
+
+    return storeValue;
+}
+
+static void _putBig32(c_store_byte_t *bytes, uint32_t number)
+{
+#ifdef FROM_BIG_32
+    number = FROM_BIG_32(number);
+    memcpy(bytes, &number, sizeof(number));
+#else
+    unsigned char *next = (unsigned char *) bytes;
+
+    next[0] = number >> 24;
+    next[1] = number >> 16;
+    next[2] = number >> 8;
+    next[3] = number;
+#endif
+}
+
+static void _putBig64(c_store_byte_t *bytes, uint64_t number)
+{
+#ifdef FROM_BIG_64
+    number = FROM_BIG_64(number);
+    memcpy(bytes, &number, sizeof(number));
+#else
+    _putBig32(bytes, number >> 32);
+    _putBig32(bytes + 4, number);
+#endif
+}
+
+static bool _singleBlock(
+    c_store_value_t *storeValue,
+    const c_store_byte_t **bytes,
+    size_t *length)
+{
+    // An empty value may be only the type and the terminator.
+
+    const c_store_byte_t *valuePointer = &storeValue->value[1];
+    size_t blockLength = _blockLength(storeValue, valuePointer);
+
+    if (blockLength > 0
+            && (storeValue->size < 1 + 2 + blockLength + 2
+                || valuePointer[2 + blockLength]
+                || valuePointer[3 + blockLength])) return false;
+
+    *bytes = valuePointer + 2;
+    *length = blockLength;
+
+    return true;
+}
+
 static size_t _splitLength(size_t joinedLength)
 {
     size_t length = joinedLength + (joinedLength / MAX_BYTES_BLOCK + 1) * 2;
@@ -22,18 +22,43 @@
 
 #define ASSERT(e) ((e)? (void) 0: CStore_assert(__FILE__, __LINE__, #e))
 
-#define LOG_FATAL(logger, ...) CStore_log(logger, LOG_LEVEL_FATAL, __VA_ARGS__)
-#define LOG_ERROR(logger, ...) CStore_log(logger, LOG_LEVEL_ERROR, __VA_ARGS__)
-#define LOG_WARN(logger, ...) CStore_log(logger, LOG_LEVEL_WARN, __VA_ARGS__)
-#define LOG_INFO(logger, ...) CStore_log(logger, LOG_LEVEL_INFO, __VA_ARGS__)
-#define LOG_INFO_ENABLED(logger) (LOG_LEVEL_INFO <= logger->level)
-#define LOG_DEBUG(logger, ...) CStore_log(logger, LOG_LEVEL_DEBUG, __VA_ARGS__)
-#define LOG_DEBUG_ENABLED(logger) (LOG_LEVEL_DEBUG <= logger->level)
-#define LOG_TRACE(logger, ...) CStore_log(logger, LOG_LEVEL_TRACE, __VA_ARGS__)
-#define LOG_TRACE_ENABLED(logger) (LOG_LEVEL_TRACE <= logger->level)
+// Messages above this level are removed at compile time (see Makefile).
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_LEVEL_ALL
+#endif
+
+#ifdef __GNUC__
+#define LOG_UNLIKELY(e) __builtin_expect(!!(e), 0)
+#else
+#define LOG_UNLIKELY(e) (e)
+#endif
+
+#define LOG_ENABLED(logger, logLevel) \
+    ((logLevel) <= LOG_MIN_LEVEL \
+        && (logger) && (logLevel) <= (logger)->level) // Logger may be NULL.
+#define LOG_AT(logger, logLevel, ...) (LOG_ENABLED(logger, logLevel)? \
+    CStore_log(logger, logLevel, __VA_ARGS__): (void) 0)
+
+#define LOG_FATAL(logger, ...) LOG_AT(logger, LOG_LEVEL_FATAL, __VA_ARGS__)
+#define LOG_ERROR(logger, ...) LOG_AT(logger, LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_WARN(logger, ...) LOG_AT(logger, LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_INFO(logger, ...) LOG_AT(logger, LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_INFO_ENABLED(logger) LOG_ENABLED(logger, LOG_LEVEL_INFO)
+#define LOG_DEBUG(logger, ...) \
+    (LOG_DEBUG_ENABLED(logger)? \
+        CStore_log(logger, LOG_LEVEL_DEBUG, __VA_ARGS__): (void) 0)
+#define LOG_DEBUG_ENABLED(logger) \
+    LOG_UNLIKELY(LOG_ENABLED(logger, LOG_LEVEL_DEBUG))
+#define LOG_TRACE(logger, ...) \
+    (LOG_TRACE_ENABLED(logger)? \
+        CStore_log(logger, LOG_LEVEL_TRACE, __VA_ARGS__): (void) 0)
+#define LOG_TRACE_ENABLED(logger) \
+    LOG_UNLIKELY(LOG_ENABLED(logger, LOG_LEVEL_TRACE))
 
 #define TRACE(...) {fprintf(stderr, __VA_ARGS__); fflush(stderr);}
 
+#define BUFFER_VALUE_ALIGNMENT sizeof(c_store_stamp_t)
+
 enum status_code { // Must match status codes in Status.java.
     STATUS_CODE_SUCCESS = 0,
     STATUS_CODE_UNKNOWN = -1001,
@@ -45,6 +70,7 @@ enum status_code { // Must match status codes in Status.java.
     STATUS_CODE_DISCONNECTED = -1007,
     STATUS_CODE_UNSUPPORTED = -1008,
     STATUS_CODE_UNRECOVERABLE = -1009,
+    STATUS_CODE_BUFFER_TOO_SMALL = -1010,
 };
 
 enum log_level { // Must match Logger.LogLogger levels.
@@ -193,6 +219,46 @@ struct c_store_vector
         c_store_code_t *status_codes);
     c_store_code_t (*disconnect)(c_store_t cStore);
     void (*dispose)(c_store_t cStore);
+    c_store_code_t (*writeBuffer)( // Optional: NULL falls back to 'write'.
+        c_store_t cStore,
+        size_t count,
+        c_store_byte_t *buffer,
+        size_t length,
+        c_store_code_t *status_codes);
+    c_store_code_t (*openCursor)( // Optional: NULL emulates by reads.
+        c_store_t cStore,
+        c_store_handle_t server_handle,
+        c_store_stamp_t start_time,
+        c_store_stamp_t end_time,
+        void **cursor);
+    c_store_code_t (*fetchCursor)(
+        c_store_t cStore,
+        void *cursor,
+        size_t limit,
+        c_store_byte_t *buffer,
+        size_t length,
+        size_t *count);
+    void (*closeCursor)(c_store_t cStore, void *cursor);
+    bool (*supportsMany)(c_store_t cStore); // Optional: NULL for false.
+    c_store_code_t (*countMany)(
+        c_store_t cStore,
+        size_t count,
+        c_store_handle_t *server_handles,
+        c_store_stamp_t *start_times,
+        c_store_stamp_t *end_times,
+        size_t limit,
+        c_store_long_t *counts,
+        c_store_code_t *status_codes);
+    c_store_code_t (*readMany)(
+        c_store_t cStore,
+        size_t count,
+        c_store_handle_t *server_handles,
+        c_store_stamp_t *start_times,
+        c_store_stamp_t *end_times,
+        size_t limit,
+        size_t *value_count,
+        c_store_value_t ***values,
+        c_store_code_t *status_codes);
 };
 
 typedef c_store_t c_store_context_function_t( // Must match RVPF_CStore_context.
@@ -213,10 +279,28 @@ extern void *CStore_allocate(size_t size);
 
 extern void CStore_assert(const char *file, int line, const char *message);
 
+extern c_store_value_t *CStore_batchValue(
+    c_store_value_t **batch,
+    size_t size);
+
+extern c_store_value_t *CStore_bufferValue(
+    c_store_byte_t *buffer,
+    size_t length,
+    size_t *offset,
+    size_t size);
+
+extern c_store_code_t CStore_bufferValues(
+    c_store_byte_t *buffer,
+    size_t length,
+    size_t count,
+    c_store_value_t ***values);
+
 extern void CStore_closeLibrary(void *libraryHandle);
 
 extern void CStore_free(void *memory);
 
+extern void CStore_freeValueBatch(c_store_value_t **batch);
+
 extern enum value_type CStore_getValueType(c_store_value_t *storeValue);
 
 extern void CStore_log(
@@ -225,11 +309,34 @@ extern void CStore_log(
     const char *format,
     ...);
 
+extern c_store_value_t *CStore_newBatchValue(
+    c_store_value_t **batch,
+    enum value_type valueType,
+    ...);
+
+extern bool CStore_newBatchDoubleValues(
+    c_store_value_t **batch,
+    const c_store_double_t *doubleValues,
+    size_t count,
+    c_store_value_t **values);
+
+extern bool CStore_newBatchLongValues(
+    c_store_value_t **batch,
+    const c_store_long_t *longValues,
+    size_t count,
+    c_store_value_t **values);
+
 extern c_store_value_t *CStore_newValue(
     c_store_t cStore,
     enum value_type valueType,
     ...);
 
+extern c_store_value_t **CStore_newValueBatch(
+    size_t count,
+    size_t bytesLength);
+
+extern c_store_value_t **CStore_newValueReferences(size_t count);
+
 extern void *CStore_openLibrary(const char *libraryPath);
 
 extern bool CStore_parseBoolEnvValue(
@@ -243,11 +350,22 @@ extern void *CStore_resolveSymbol(
     void *libraryHandle,
     const char *symbol);
 
+extern bool CStore_valueToBuffer(
+    c_store_value_t *storeValue,
+    void *buffer,
+    size_t capacity,
+    size_t *length);
+
 extern bool CStore_valueToByteArray(
     c_store_value_t *storeValue,
     c_store_byte_t **bytesValue,
     size_t *bytesLength);
 
+extern bool CStore_valueToBytesReference(
+    c_store_value_t *storeValue,
+    const c_store_byte_t **bytes,
+    size_t *length);
+
 extern bool CStore_valueToDouble(
     c_store_value_t *storeValue,
     c_store_double_t *doubleValue);
@@ -268,6 +386,18 @@ extern bool CStore_valueToString(
     c_store_value_t *storeValue,
     char **stringValue);
 
+extern size_t CStore_valuesToDoubles(
+    c_store_value_t **values,
+    size_t count,
+    c_store_double_t *doubleValues,
+    bool *converted);
+
+extern size_t CStore_valuesToLongs(
+    c_store_value_t **values,
+    size_t count,
+    c_store_long_t *longValues,
+    bool *converted);
+
 #endif /* RVPF_C_STORE_IMPL_H */
 
 /* This is free software; you can redistribute it and/or modify
@@ -82,6 +82,16 @@ static c_store_code_t CStore_count(
     size_t limit,
     c_store_long_t *count);
 
+static c_store_code_t CStore_countMany(
+    c_store_t cStore,
+    size_t count,
+    c_store_handle_t *server_handles,
+    c_store_stamp_t *start_times,
+    c_store_stamp_t *end_times,
+    size_t limit,
+    c_store_long_t *counts,
+    c_store_code_t *status_codes);
+
 static c_store_code_t CStore_read(
     c_store_t cStore,
     c_store_handle_t server_handle,
@@ -91,6 +101,34 @@ static c_store_code_t CStore_read(
     size_t *count,
     c_store_value_t ***values);
 
+static c_store_code_t CStore_readMany(
+    c_store_t cStore,
+    size_t count,
+    c_store_handle_t *server_handles,
+    c_store_stamp_t *start_times,
+    c_store_stamp_t *end_times,
+    size_t limit,
+    size_t *value_count,
+    c_store_value_t ***values,
+    c_store_code_t *status_codes);
+
+static c_store_code_t CStore_openCursor(
+    c_store_t cStore,
+    c_store_handle_t server_handle,
+    c_store_stamp_t start_time,
+    c_store_stamp_t end_time,
+    void **cursor);
+
+static c_store_code_t CStore_fetchCursor(
+    c_store_t cStore,
+    void *cursor,
+    size_t limit,
+    c_store_byte_t *buffer,
+    size_t length,
+    size_t *count);
+
+static void CStore_closeCursor(c_store_t cStore, void *cursor);
+
 static c_store_code_t CStore_releaseHandles(
     c_store_t cStore,
     size_t count,
@@ -113,6 +151,8 @@ static bool CStore_supportsCount(c_store_t cStore);
 
 static bool CStore_supportsDelete(c_store_t cStore);
 
+static bool CStore_supportsMany(c_store_t cStore);
+
 static bool CStore_supportsPull(c_store_t cStore);
 
 static bool CStore_supportsSubscribe(c_store_t cStore);
@@ -133,6 +173,13 @@ static c_store_code_t CStore_write(
     c_store_value_t **values,
     c_store_code_t *status_codes);
 
+static c_store_code_t CStore_writeBuffer(
+    c_store_t cStore,
+    size_t count,
+    c_store_byte_t *buffer,
+    size_t length,
+    c_store_code_t *status_codes);
+
 // Private forward declarations.
 
 static c_store_t CStore_createContext(
@@ -173,6 +220,13 @@ static struct c_store_vector cStoreVector =
         CStore_releaseHandles,
         CStore_disconnect,
         CStore_dispose,
+        CStore_writeBuffer,
+        CStore_openCursor,
+        CStore_fetchCursor,
+        CStore_closeCursor,
+        CStore_supportsMany,
+        CStore_countMany,
+        CStore_readMany,
     };
 
 // Private function definitions.
@@ -10,9 +10,16 @@
 
 /* Notes.
  *
- * This implementation tries to reproduce some of the
- * behavior of the Java HashMap class for a handle to
- * handle Map.
+ * This implementation keeps the interface of a Java HashMap
+ * for a handle to handle Map, but stores its entries inline
+ * in a single table using linear probing. Removals shift the
+ * following entries back, so that no tombstone is needed.
+ *
+ * A null (0) key marks an empty slot; the entry for a null
+ * key, if any, is kept apart. At least one slot is always
+ * left empty, since that is what ends the probes: at the
+ * maximum capacity, a put which would fill the last one
+ * fails its assertion, like an allocation failure would.
  */
 #include "HandlesMap.h"
 #include "CStoreImpl.h"
@@ -44,20 +51,23 @@ typedef unsigned int hash_t;
 // Private structure definitions.
 
 struct c_store_handles_map {
-    entry_t *table;
+    entry_t table;
     size_t capacity;
     size_t size;
     size_t threshold;
+    bool hasNullKey;
+    c_store_handle_t nullKeyValue;
 };
 
 struct entry {
     c_store_handle_t key;
     c_store_handle_t value;
-    entry_t next;
 };
 
 // Private forward declarations.
 
+static size_t _find(c_store_handles_map_t map, c_store_handle_t key);
+
 static size_t _indexFor(c_store_handles_map_t map, c_store_handle_t key);
 
 static void _rehash(c_store_handles_map_t map);
@@ -68,20 +78,9 @@ void HandlesMap_clear(c_store_handles_map_t map)
 {
     ASSERT(map);
 
-    for (int i = 0; i < map->capacity; ++i) {
-        entry_t entry = map->table[i];
-
-        map->table[i] = NULL;
-        while (entry) {
-            entry_t next = entry->next;
-
-            entry->next = NULL;
-            entry->key = 0;
-            entry->value = 0;
-            CStore_free(entry);
-            entry = next;
-        }
-    }
+    memset(map->table, 0, map->capacity * sizeof(struct entry));
+    map->hasNullKey = false;
+    map->nullKeyValue = 0;
     map->size = 0;
 }
 
@@ -96,13 +95,13 @@ c_store_handles_map_t HandlesMap_create(size_t initialLoadSize)
     ASSERT(map);
     ASSERT(initialCapacity <= MAXIMUM_CAPACITY);
     for (
-        map->capacity = 1;
+        map->capacity = 2;
         map->capacity < initialCapacity;
         map->capacity <<= 1);
 
     map->size = 0;
     map->threshold = map->capacity * LOAD_FACTOR;
-    map->table = CStore_allocate(map->capacity * sizeof(entry_t));
+    map->table = CStore_allocate(map->capacity * sizeof(struct entry));
     ASSERT(map->table);
 
     return map;
@@ -122,17 +121,43 @@ c_store_handle_t HandlesMap_get(c_store_handles_map_t map, c_store_handle_t key)
 {
     ASSERT(map);
 
-    entry_t entry = map->table[_indexFor(map, key)];
+    if (!key) return map->hasNullKey? map->nullKeyValue: 0;
 
-    while (entry) {
-        if (entry->key == key) {
-            return entry->value;
-        }
+    return map->table[_find(map, key)].value;
+}
 
-        entry = entry->next;
-    };
+size_t HandlesMap_getBatch(
+    c_store_handles_map_t map,
+    size_t count,
+    const c_store_handle_t *keys,
+    c_store_handle_t *values)
+{
+    ASSERT(map);
+
+    entry_t table = map->table;
+    size_t mask = map->capacity - 1;
+    size_t found = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        c_store_handle_t key = keys[i];
+        c_store_handle_t value = 0;
+
+        if (key) {
+            for (size_t index = _indexFor(map, key);
+                    table[index].key;
+                    index = (index + 1) & mask) {
+                if (table[index].key == key) {
+                    value = table[index].value;
+                    break;
+                }
+            }
+        } else if (map->hasNullKey) value = map->nullKeyValue;
+
+        values[i] = value;
+        if (value) ++found;
+    }
 
-    return 0;
+    return found;
 }
 
 c_store_handle_t *HandlesMap_keys(c_store_handles_map_t map)
@@ -145,13 +170,11 @@ c_store_handle_t *HandlesMap_keys(c_store_handles_map_t map)
     size_t index = 0;
 
     ASSERT(keys);
+    if (map->hasNullKey) keys[index++] = 0;
     for (int i = 0; i < map->capacity; ++i) {
-        entry_t entry = map->table[i];
-
-        while (entry) {
+        if (map->table[i].key) {
             ASSERT(index < mapSize);
-            keys[index++] = entry->key;
-            entry = entry->next;
+            keys[index++] = map->table[i].key;
         }
     }
     ASSERT(index == mapSize);
@@ -166,31 +189,32 @@ c_store_handle_t HandlesMap_put(
 {
     ASSERT(map);
 
-    size_t index = _indexFor(map, key);
-    entry_t entry = map->table[index];
+    c_store_handle_t previousValue = 0;
 
-    while (entry) {
-        if (entry->key == key) {
-            c_store_handle_t previousValue = entry->value;
+    if (key) {
+        entry_t entry = &map->table[_find(map, key)];
 
+        if (entry->key) {
+            previousValue = entry->value;
             entry->value = value;
 
             return previousValue;
         }
 
-        entry = entry->next;
-    };
+        ASSERT(map->size - map->hasNullKey < map->capacity - 1);
 
-    entry = CStore_allocate(sizeof(struct entry));
-    ASSERT(entry);
-    entry->key = key;
-    entry->value = value;
-    entry->next = map->table[index];
-    map->table[index] = entry;
+        entry->key = key;
+        entry->value = value;
+    } else {
+        previousValue = map->nullKeyValue;
+        map->nullKeyValue = value;
+        if (map->hasNullKey) return previousValue;
+        map->hasNullKey = true;
+    }
 
     if (++map->size > map->threshold) _rehash(map);
 
-    return 0;
+    return previousValue;
 }
 
 c_store_handle_t HandlesMap_remove(
@@ -199,31 +223,41 @@ c_store_handle_t HandlesMap_remove(
 {
     ASSERT(map);
 
-    size_t index = _indexFor(map, key);
-    entry_t entry = map->table[index];
-    entry_t previousEntry = NULL;
+    c_store_handle_t value;
 
-    while (entry) {
-        if (entry->key == key) {
-            c_store_handle_t value = entry->value;
+    if (!key) {
+        if (!map->hasNullKey) return 0;
+        value = map->nullKeyValue;
+        map->hasNullKey = false;
+        map->nullKeyValue = 0;
+        --map->size;
 
-            if (previousEntry) previousEntry->next = entry->next;
-            else map->table[index] = NULL;
-            --map->size;
+        return value;
+    }
 
-            entry->next = NULL;
-            entry->key = 0;
-            entry->value = 0;
-            CStore_free(entry);
+    entry_t table = map->table;
+    size_t mask = map->capacity - 1;
+    size_t hole = _find(map, key);
 
-            return value;
-        }
+    if (!table[hole].key) return 0;
+    value = table[hole].value;
 
-        previousEntry = entry;
-        entry = entry->next;
-    };
+    for (size_t index = (hole + 1) & mask;
+            table[index].key;
+            index = (index + 1) & mask) {
+        size_t home = _indexFor(map, table[index].key);
 
-    return 0;
+        // Moves back the entry unless its home lies in (hole, index].
+        if (((index - home) & mask) >= ((index - hole) & mask)) {
+            table[hole] = table[index];
+            hole = index;
+        }
+    }
+    table[hole].key = 0;
+    table[hole].value = 0;
+    --map->size;
+
+    return value;
 }
 
 size_t HandlesMap_size(c_store_handles_map_t map)
@@ -243,13 +277,11 @@ c_store_handle_t *HandlesMap_values(c_store_handles_map_t map)
     size_t index = 0;
 
     ASSERT(values);
+    if (map->hasNullKey) values[index++] = map->nullKeyValue;
     for (int i = 0; i < map->capacity; ++i) {
-        entry_t entry = map->table[i];
-
-        while (entry) {
+        if (map->table[i].key) {
             ASSERT(index < mapSize);
-            values[index++] = entry->value;
-            entry = entry->next;
+            values[index++] = map->table[i].value;
         }
     }
     ASSERT(index == mapSize);
@@ -259,6 +291,19 @@ c_store_handle_t *HandlesMap_values(c_store_handles_map_t map)
 
 // Private function definitions.
 
+static size_t _find(c_store_handles_map_t map, c_store_handle_t key)
+{
+    entry_t table = map->table;
+    size_t mask = map->capacity - 1;
+    size_t index = _indexFor(map, key);
+
+    while (table[index].key && table[index].key != key) {
+        index = (index + 1) & mask;
+    }
+
+    return index;
+}
+
 static size_t _indexFor(c_store_handles_map_t map, c_store_handle_t key)
 {
     hash_t hash = key;
@@ -278,27 +323,21 @@ static void _rehash(c_store_handles_map_t map)
         return;
     }
 
-    entry_t *oldTable = map->table;
+    entry_t oldTable = map->table;
     size_t oldCapacity = map->capacity;
 
     map->capacity <<= 1;
     map->threshold = map->capacity * LOAD_FACTOR;
-    map->table = CStore_allocate(map->capacity * sizeof(entry_t));
+    map->table = CStore_allocate(map->capacity * sizeof(struct entry));
     ASSERT(map->table);
 
     for (int i = 0; i < oldCapacity; ++i) {
-        entry_t entry = oldTable[i];
-
-        while (entry) {
-            entry_t next = entry->next;
-            size_t index = _indexFor(map, entry->key);
-
-            entry->next = map->table[index];
-            map->table[index] = entry;
-
-            entry = next;
+        if (oldTable[i].key) {
+            map->table[_find(map, oldTable[i].key)] = oldTable[i];
         }
     }
+
+    CStore_free(oldTable);
 }
 
 /* This is free software; you can redistribute it and/or modify
@@ -24,9 +24,15 @@ extern c_store_handle_t HandlesMap_get(
     c_store_handles_map_t map,
     c_store_handle_t key);
 
+extern size_t HandlesMap_getBatch(
+    c_store_handles_map_t map,
+    size_t count,
+    const c_store_handle_t *keys,
+    c_store_handle_t *values);
+
 extern c_store_handle_t *HandlesMap_keys(c_store_handles_map_t map);
 
-extern c_store_handle_t HandlesMap_put(
+extern c_store_handle_t HandlesMap_put( // Asserts on a full table.
     c_store_handles_map_t map,
     c_store_handle_t key,
     c_store_handle_t value);
@@ -0,0 +1,1981 @@
+/** Related Values Processing Framework.
+ *
+ * Copyright (C) 2003-2019 Serge Brisson.
+ *
+ * This software is distributable under the LGPL license.
+ * See details at the bottom of this file.
+ *
+ * $Id$
+ */
+
+/* Notes.
+ *
+ * This implementation keeps the point values in memory. The values
+ * of each point are held in stamp-sorted chunks, with the stamps, the
+ * qualities and the values in separate arrays: the time ranges are found
+ * by binary searches, first on the chunks, then within a chunk. Appends
+ * fill the last chunk; an insert into a full chunk splits it in two.
+ *
+ * The points are identified by their tag: their values survive the
+ * release of their handle. The server handle of a point is its index
+ * (plus one) in the points table.
+ *
+ * The points table is protected by a read / write lock held for each
+ * operation; each point has its own read / write lock.
+ *
+ * When a directory is supplied (MEMORY_STORE_DIRECTORY), the store
+ * persists in memory-mapped, append-only segment files: each write or
+ * delete appends a record holding a c_store_value_t and the index then
+ * refers to the values inside the mapping. Read results point straight
+ * into the mapping when their handle is current; the segments stay
+ * mapped until the store is disposed of and their space is not reclaimed.
+ *
+ * On connect, the segments are mapped again and their record headers
+ * scanned: this restores the points (from their tag records) and notes,
+ * for each point, the segments holding its values. The index of a point
+ * is rebuilt from those segments only on its first use.
+ *
+ * The values written or deleted for subscribed points are copied to a
+ * notifier, from which deliver takes them.
+ */
+#include "CStoreVector.h"
+#include "Notifier.h"
+#include "SharedHandlesMap.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#define SEGMENTS_SUPPORTED
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Private macro definitions.
+
+#define CHUNK_CAPACITY 128
+#define DEFAULT_SEGMENT_SIZE (64 * 1024 * 1024)
+#define DIRECTORY_ENV "MEMORY_STORE_DIRECTORY"
+#define INITIAL_POINTS_CAPACITY 64
+#define MINIMUM_SEGMENT_SIZE 4096
+#define NOTIFIER_CAPACITY (64 * 1024)
+#define RECORD_ALIGNMENT 8
+#define SEGMENT_HEADER_SIZE 16
+#define SEGMENT_MAGIC "RVPFSEG1"
+#define SEGMENT_SIZE_ENV "MEMORY_STORE_SEGMENT_SIZE"
+
+#define VALUE_OF(bytes) \
+    ((c_store_value_t *) ((bytes) - offsetof(c_store_value_t, value)))
+
+// Private type definitions.
+
+struct chunk
+{
+    size_t length;
+    c_store_stamp_t stamps[CHUNK_CAPACITY];
+    c_store_quality_t qualities[CHUNK_CAPACITY];
+    size_t sizes[CHUNK_CAPACITY];
+    c_store_byte_t *values[CHUNK_CAPACITY];
+};
+
+struct point
+{
+    pthread_rwlock_t lock;
+    char *tag;
+    size_t hash;
+    size_t index;
+    struct chunk **chunks;
+    size_t chunkCount;
+    size_t chunkCapacity;
+    bool loaded;
+    size_t *segments; // Segments to load.
+    size_t segmentCount;
+    size_t segmentCapacity;
+    size_t changes; // Inserts and removes (invalidate cursor positions).
+    bool subscribed;
+};
+
+enum record_type
+{
+    RECORD_END = 0,
+    RECORD_TAG = 1,
+    RECORD_VALUE = 2,
+    RECORD_DELETE = 3,
+};
+
+struct record
+{
+    uint32_t type; // Stored last.
+    uint32_t point;
+    uint64_t length;
+    c_store_value_t value; // The tag string for a tag record.
+};
+
+struct segment
+{
+    int fd;
+    c_store_byte_t *base;
+    size_t size;
+    size_t used;
+};
+
+struct position
+{
+    size_t chunk;
+    size_t index;
+};
+
+struct cursor
+{
+    c_store_handle_t serverHandle;
+    c_store_stamp_t next; // Next stamp (inclusive).
+    c_store_stamp_t end; // Exclusive.
+    bool reverse;
+    bool ended;
+    bool positioned;
+    struct position position; // Of the next stamp.
+    size_t changes; // Of the point, when the position was kept.
+};
+
+struct context
+{
+    pthread_rwlock_t lock;
+    struct point **points;
+    size_t pointCount;
+    size_t pointCapacity;
+    size_t *slots; // Point index plus one; 0 when empty.
+    size_t slotCount;
+    pthread_mutex_t appendMutex;
+    char *directory;
+    size_t segmentSize;
+    struct segment **segments;
+    size_t segmentCount;
+    size_t segmentCapacity;
+    bool persistent;
+    c_store_notifier_t notifier;
+    c_store_shared_handles_map_t clientHandles; // By server handle.
+};
+
+// Private forward declarations.
+
+static c_store_handle_t _addPoint(
+    struct context *context,
+    const char *tag,
+    size_t hash);
+
+static bool _addSegment(struct context *context, struct segment *segment);
+
+static void _advance(struct point *point, struct position *position);
+
+static struct record *_append(
+    struct context *context,
+    enum record_type type,
+    struct point *point,
+    c_store_value_t *storeValue);
+
+static c_store_handle_t _clientHandle(
+    struct context *context,
+    struct point *point);
+
+static void _closeSegments(struct context *context);
+
+static c_store_code_t _delete(
+    struct context *context,
+    struct point *point,
+    c_store_stamp_t stamp);
+
+static size_t _distance(
+    struct point *point,
+    struct position from,
+    struct position to);
+
+static void _freePoint(struct context *context, struct point *point);
+
+static size_t _hash(const char *tag);
+
+static c_store_code_t _insert(
+    struct context *context,
+    struct point *point,
+    c_store_value_t *storeValue,
+    c_store_byte_t *value);
+
+static bool _insertChunk(struct point *point, size_t at, struct chunk *chunk);
+
+static void _load(struct context *context, struct point *point);
+
+static void _lock(struct context *context, struct point *point, bool write);
+
+static struct segment *_newSegment(struct context *context, size_t minimum);
+
+static bool _noteSegment(struct point *point, size_t segmentIndex);
+
+static void _notify(
+    struct context *context,
+    struct point *point,
+    c_store_value_t *storeValue);
+
+static bool _openSegment(
+    struct context *context,
+    size_t segmentIndex,
+    struct segment **segment);
+
+static struct point *_point(
+    struct context *context,
+    c_store_handle_t serverHandle);
+
+static c_store_code_t _put(
+    struct context *context,
+    struct point *point,
+    c_store_value_t *storeValue);
+
+static bool _range(
+    struct point *point,
+    c_store_stamp_t start_time,
+    c_store_stamp_t end_time,
+    struct position *from,
+    struct position *to);
+
+static c_store_code_t _remove(
+    struct context *context,
+    struct point *point,
+    c_store_stamp_t stamp);
+
+static bool _resizeSlots(struct context *context, size_t slotCount);
+
+static bool _restore(struct context *context);
+
+static void _retreat(struct point *point, struct position *position);
+
+static bool _scanSegment(struct context *context, size_t segmentIndex);
+
+static struct position _search(
+    struct point *point,
+    c_store_stamp_t stamp,
+    bool after);
+
+static char *_segmentPath(struct context *context, size_t segmentIndex);
+
+static void _syncSegments(struct context *context);
+
+static c_store_handle_t _tagHandle(struct context *context, const char *tag);
+
+// Public shareable object function definitions.
+
+RVPF_EXPORT c_store_t RVPF_CStore_context(
+    const c_store_logger_t logger,
+    const char *vmPath,
+    int argc,
+    char *argv[],
+    void *vm)
+{
+    struct context *context = CStore_allocate(sizeof(struct context));
+
+    if (context && pthread_rwlock_init(&context->lock, NULL)) {
+        CStore_free(context);
+        context = NULL;
+    }
+    if (context && pthread_mutex_init(&context->appendMutex, NULL)) {
+        pthread_rwlock_destroy(&context->lock);
+        CStore_free(context);
+        context = NULL;
+    }
+    if (context) {
+        context->segmentSize = DEFAULT_SEGMENT_SIZE;
+        context->notifier = Notifier_create(NOTIFIER_CAPACITY);
+        context->clientHandles =
+            SharedHandlesMap_create(INITIAL_POINTS_CAPACITY);
+    }
+
+    c_store_t store = CStore_createContext(logger, context);
+
+    if (!store) {
+        if (context) {
+            Notifier_dispose(context->notifier);
+            SharedHandlesMap_dispose(context->clientHandles);
+            pthread_mutex_destroy(&context->appendMutex);
+            pthread_rwlock_destroy(&context->lock);
+            CStore_free(context);
+        }
+        CStore_dispose(NULL);
+    }
+
+    return store;
+}
+
+// Private CStore implementation definitions.
+
+static c_store_code_t CStore_connect(c_store_t cStore)
+{
+    struct context *context = (struct context *) cStore->context;
+    c_store_code_t status_code = STATUS_CODE_SUCCESS;
+
+    if (!context->directory) return status_code;
+
+#ifndef SEGMENTS_SUPPORTED
+    LOG_ERROR(cStore->logger, "The memory store segments are not supported");
+    return STATUS_CODE_UNSUPPORTED;
+#endif
+
+    pthread_rwlock_wrlock(&context->lock);
+
+    if (context->persistent) {
+        // Already restored.
+    } else if (context->pointCount) {
+        LOG_ERROR(cStore->logger,
+            "The memory store must be connected before exchanging handles");
+        status_code = STATUS_CODE_ILLEGAL_STATE;
+    } else if (_restore(context)) {
+        LOG_INFO(cStore->logger, "Restored %zu points from %zu segments in %s",
+            context->pointCount, context->segmentCount, context->directory);
+        context->persistent = true;
+    } else {
+        LOG_ERROR(cStore->logger,
+            "Failed to restore the segments in %s", context->directory);
+        status_code = STATUS_CODE_FAILED;
+    }
+
+    pthread_rwlock_unlock(&context->lock);
+
+    return status_code;
+}
+
+static c_store_code_t CStore_delete(
+    c_store_t cStore,
+    size_t count,
+    c_store_handle_t *server_handles,
+    c_store_stamp_t *time_stamps,
+    c_store_code_t *status_codes)
+{
+    struct context *context = (struct context *) cStore->context;
+    struct point *locked = NULL;
+
+    pthread_rwlock_rdlock(&context->lock);
+
+    for (size_t i = 0; i < count; ++i) {
+        struct point *point = _point(context, server_handles[i]);
+
+        if (point != locked) {
+            if (locked) pthread_rwlock_unlock(&locked->lock);
+            if (point) _lock(context, point, true);
+            locked = point;
+        }
+
+        status_codes[i] = point?
+            _delete(context, point, time_stamps[i]): STATUS_CODE_BAD_HANDLE;
+    }
+
+    if (locked) pthread_rwlock_unlock(&locked->lock);
+    pthread_rwlock_unlock(&context->lock);
+
+    return STATUS_CODE_SUCCESS;
+}
+
+static c_store_code_t CStore_deliver(
+    c_store_t cStore,
+    size_t limit,
+    c_store_millis_t timeout,
+    size_t *count,
+    c_store_value_t ***values)
+{
+    struct context *context = (struct context *) cStore->context;
+
+    if (!context->notifier) return STATUS_CODE_UNSUPPORTED;
+
+    size_t dropped = Notifier_dropped(context->notifier);
+
+    if (dropped) {
+        LOG_WARN(cStore->logger,
+            "Dropped %zu notices: the notifier was full", dropped);
+    }
+
+    return Notifier_deliver(context->notifier, limit, timeout, count, values);
+}
+
+static c_store_code_t CStore_disconnect(c_store_t cStore)
+{
+    struct context *context = (struct context *) cStore->context;
+
+    if (context->persistent) _syncSegments(context);
+
+    return STATUS_CODE_SUCCESS;
+}
+
+static void CStore_dispose(c_store_t cStore)
+{
+    if (cStore) {
+        struct context *context = (struct context *) cStore->context;
+
+        CStore_disposeContext(cStore);
+
+        for (size_t i = 0; i < context->pointCount; ++i) {
+            _freePoint(context, context->points[i]);
+        }
+        CStore_free(context->points);
+        CStore_free(context->slots);
+        _closeSegments(context);
+        Notifier_dispose(context->notifier);
+        SharedHandlesMap_dispose(context->clientHandles);
+        CStore_free(context->directory);
+        pthread_mutex_destroy(&context->appendMutex);
+        pthread_rwlock_destroy(&context->lock);
+        memset(context, 0, sizeof(struct context));
+        CStore_free(context);
+    }
+}
+
+static c_store_code_t CStore_exchangeHandles(
+    c_store_t cStore,
+    size_t count,
+    char **tag_strings,
+    c_store_handle_t *client_handles,
+    c_store_handle_t *server_handles,
+    c_store_code_t *status_codes)
+{
+    struct context *context = (struct context *) cStore->context;
+    c_store_code_t status_code = STATUS_CODE_SUCCESS;
+
+    pthread_rwlock_wrlock(&context->lock);
+
+    for (size_t i = 0; i < count; ++i) {
+        c_store_handle_t server_handle =
+            tag_strings[i]? _tagHandle(context, tag_strings[i]): 0;
+
+        server_handles[i] = server_handle;
+        if (server_handle) {
+            SharedHandlesMap_put(
+                context->clientHandles, server_handle, client_handles[i]);
+            status_codes[i] = STATUS_CODE_SUCCESS;
+        } else if (tag_strings[i]) {
+            status_codes[i] = STATUS_CODE_FAILED;
+            status_code = STATUS_CODE_FAILED;
+        } else status_codes[i] = STATUS_CODE_POINT_UNKNOWN;
+    }
+
+    pthread_rwlock_unlock(&context->lock);
+
+    return status_code;
+}
+
+static void CStore_freeValues(
+    c_store_t cStore,
+    size_t count,
+    c_store_value_t **values)
+{
+    CStore_freeValueBatch(values);
+}
+
+static c_store_code_t CStore_getQualityCode(
+    c_store_t cStore,
+    char *qualityName,
+    c_store_quality_t *qualityCode)
+{
+    return STATUS_CODE_UNSUPPORTED;
+}
+
+static char *CStore_getQualityName(
+    c_store_t cStore,
+    c_store_quality_t qualityCode)
+{
+    return NULL;
+}
+
+static c_store_code_t CStore_getStateCode(
+    c_store_t cStore,
+    c_store_handle_t server_handle,
+    char *stateName,
+    c_store_quality_t *stateCode)
+{
+    return STATUS_CODE_UNSUPPORTED;
+}
+
+static char *CStore_getStateName(
+    c_store_t cStore,
+    c_store_handle_t server_handle,
+    c_store_quality_t stateCode)
+{
+    return NULL;
+}
+
+static c_store_code_t CStore_interrupt(c_store_t cStore)
+{
+    struct context *context = (struct context *) cStore->context;
+
+    if (context->notifier) Notifier_interrupt(context->notifier);
+
+    return STATUS_CODE_SUCCESS;
+}
+
+static c_store_code_t CStore_putEnv(c_store_t cStore, char *entryString)
+{
+    struct context *context = (struct context *) cStore->context;
+    char *value = CStore_parseEnvEntry(cStore, entryString);
+
+    if (!strcmp(entryString, DIRECTORY_ENV)) {
+        CStore_free(context->directory);
+        context->directory = *value? value: NULL;
+        if (context->directory) return STATUS_CODE_SUCCESS;
+    } else if (!strcmp(entryString, SEGMENT_SIZE_ENV)) {
+        long long segmentSize = atoll(value);
+
+        if (segmentSize >= MINIMUM_SEGMENT_SIZE) {
+            context->segmentSize = (size_t) segmentSize;
+        } else {
+            LOG_WARN(cStore->logger, "Ignored %s value '%s'",
+                SEGMENT_SIZE_ENV, value);
+        }
+    }
+
+    CStore_free(value);
+
+    return STATUS_CODE_SUCCESS;
+}
+
+static c_store_code_t CStore_count(
+    c_store_t cStore,
+    c_store_handle_t server_handle,
+    c_store_stamp_t start_time,
+    c_store_stamp_t end_time,
+    size_t limit,
+    c_store_long_t *count)
+{
+    struct context *context = (struct context *) cStore->context;
+    c_store_code_t status_code = STATUS_CODE_SUCCESS;
+
+    pthread_rwlock_rdlock(&context->lock);
+
+    struct point *point = _point(context, server_handle);
+
+    if (point) {
+        struct position from;
+        struct position to;
+
+        _lock(context, point, false);
+        _range(point, start_time, end_time, &from, &to);
+
+        size_t found = _distance(point, from, to);
+
+        pthread_rwlock_unlock(&point->lock);
+
+        *count = (limit && found > limit)? limit: found;
+    } else status_code = STATUS_CODE_BAD_HANDLE;
+
+    pthread_rwlock_unlock(&context->lock);
+
+    return status_code;
+}
+
+static c_store_code_t CStore_countMany(
+    c_store_t cStore,
+    size_t count,
+    c_store_handle_t *server_handles,
+    c_store_stamp_t *start_times,
+    c_store_stamp_t *end_times,
+    size_t limit,
+    c_store_long_t *counts,
+    c_store_code_t *status_codes)
+{
+    struct context *context = (struct context *) cStore->context;
+
+    pthread_rwlock_rdlock(&context->lock);
+
+    for (size_t i = 0; i < count; ++i) {
+        struct point *point = _point(context, server_handles[i]);
+
+        if (point) {
+            struct position from;
+            struct position to;
+
+            _lock(context, point, false);
+            _range(point, start_times[i], end_times[i], &from, &to);
+
+            size_t found = _distance(point, from, to);
+
+            pthread_rwlock_unlock(&point->lock);
+
+            counts[i] = (limit && found > limit)? limit: found;
+            status_codes[i] = STATUS_CODE_SUCCESS;
+        } else {
+            counts[i] = -1;
+            status_codes[i] = STATUS_CODE_BAD_HANDLE;
+        }
+    }
+
+    pthread_rwlock_unlock(&context->lock);
+
+    return STATUS_CODE_SUCCESS;
+}
+
+static c_store_code_t CStore_read(
+    c_store_t cStore,
+    c_store_handle_t server_handle,
+    c_store_stamp_t start_time,
+    c_store_stamp_t end_time,
+    size_t limit,
+    size_t *count,
+    c_store_value_t ***values)
+{
+    struct context *context = (struct context *) cStore->context;
+    c_store_code_t status_code = STATUS_CODE_SUCCESS;
+
+    pthread_rwlock_rdlock(&context->lock);
+
+    struct point *point = _point(context, server_handle);
+    c_store_handle_t clientHandle = _clientHandle(context, point);
+
+    if (clientHandle) {
+        struct position from;
+        struct position to;
+
+        _lock(context, point, false);
+
+        bool reverse = _range(point, start_time, end_time, &from, &to);
+        size_t found = _distance(point, from, to);
+
+        if (limit && found > limit) found = limit;
+
+        if (found) {
+            struct position position = reverse? to: from;
+            struct position scan = position;
+            bool mapped = context->persistent;
+            size_t bytesLength = 0;
+
+            for (size_t i = 0; i < found; ++i) {
+                if (reverse) _retreat(point, &scan);
+
+                struct chunk *chunk = point->chunks[scan.chunk];
+
+                bytesLength += chunk->sizes[scan.index];
+                if (mapped && VALUE_OF(chunk->values[scan.index])->handle
+                        != clientHandle) {
+                    mapped = false;
+                }
+                if (!reverse) _advance(point, &scan);
+            }
+
+            c_store_value_t **batch = mapped?
+                CStore_newValueReferences(found):
+                CStore_newValueBatch(found, bytesLength);
+
+            for (size_t i = 0; batch && i < found; ++i) {
+                if (reverse) _retreat(point, &position);
+
+                struct chunk *chunk = point->chunks[position.chunk];
+                c_store_byte_t *value = chunk->values[position.index];
+
+                if (mapped) batch[i] = VALUE_OF(value);
+                else {
+                    size_t size = chunk->sizes[position.index];
+                    c_store_value_t *storeValue =
+                        CStore_batchValue(batch, size);
+
+                    if (!storeValue) {
+                        CStore_freeValueBatch(batch);
+                        batch = NULL;
+                        break;
+                    }
+                    storeValue->handle = clientHandle;
+                    storeValue->stamp = chunk->stamps[position.index];
+                    storeValue->deleted = false;
+                    storeValue->quality = chunk->qualities[position.index];
+                    if (size) memcpy(storeValue->value, value, size);
+                    batch[i] = storeValue;
+                }
+
+                if (!reverse) _advance(point, &position);
+            }
+
+            if (batch) {
+                *count = found;
+                *values = batch;
+            } else status_code = STATUS_CODE_FAILED;
+        } else *count = 0;
+
+        pthread_rwlock_unlock(&point->lock);
+    } else status_code = STATUS_CODE_BAD_HANDLE;
+
+    pthread_rwlock_unlock(&context->lock);
+
+    return status_code;
+}
+
+static c_store_code_t CStore_readMany(
+    c_store_t cStore,
+    size_t count,
+    c_store_handle_t *server_handles,
+    c_store_stamp_t *start_times,
+    c_store_stamp_t *end_times,
+    size_t limit,
+    size_t *value_count,
+    c_store_value_t ***values,
+    c_store_code_t *status_codes)
+{
+    // Sizes the batch from the range distances, then fills it point by
+    // point; a point gaining values between the two passes keeps its first
+    // count.
+
+    struct context *context = (struct context *) cStore->context;
+    size_t *founds = CStore_allocate(sizeof(size_t) * (count? count: 1));
+    c_store_handle_t *clientHandles =
+        CStore_allocate(sizeof(c_store_handle_t) * (count? count: 1));
+    size_t total = 0;
+    size_t filled = 0;
+
+    *value_count = 0;
+    if (!founds || !clientHandles) {
+        CStore_free(founds);
+        CStore_free(clientHandles);
+        return STATUS_CODE_FAILED;
+    }
+
+    pthread_rwlock_rdlock(&context->lock);
+
+    SharedHandlesMap_getBatch(
+        context->clientHandles, count, server_handles, clientHandles);
+
+    for (size_t i = 0; i < count; ++i) {
+        struct point *point = _point(context, server_handles[i]);
+
+        founds[i] = 0;
+        if (point && clientHandles[i]) {
+            struct position from;
+            struct position to;
+
+            _lock(context, point, false);
+            _range(point, start_times[i], end_times[i], &from, &to);
+            founds[i] = _distance(point, from, to);
+            pthread_rwlock_unlock(&point->lock);
+
+            if (limit && founds[i] > limit) founds[i] = limit;
+            total += founds[i];
+            status_codes[i] = STATUS_CODE_SUCCESS;
+        } else status_codes[i] = STATUS_CODE_BAD_HANDLE;
+    }
+
+    c_store_value_t **batch = CStore_newValueBatch(total, 0);
+
+    for (size_t i = 0; batch && i < count; ++i) {
+        struct point *point = _point(context, server_handles[i]);
+
+        if (!founds[i] || !point || !clientHandles[i]) continue;
+
+        struct position from;
+        struct position to;
+
+        _lock(context, point, false);
+
+        bool reverse = _range(
+            point, start_times[i], end_times[i], &from, &to);
+        size_t found = _distance(point, from, to);
+        struct position position = reverse? to: from;
+
+        if (found > founds[i]) found = founds[i];
+
+        for (size_t j = 0; j < found; ++j) {
+            if (reverse) _retreat(point, &position);
+
+            struct chunk *chunk = point->chunks[position.chunk];
+            size_t size = chunk->sizes[position.index];
+            c_store_value_t *storeValue = CStore_batchValue(batch, size);
+
+            if (!storeValue) {
+                CStore_freeValueBatch(batch);
+                batch = NULL;
+                break;
+            }
+            storeValue->handle = clientHandles[i];
+            storeValue->stamp = chunk->stamps[position.index];
+            storeValue->deleted = false;
+            storeValue->quality = chunk->qualities[position.index];
+            if (size) memcpy(storeValue->value,
+                chunk->values[position.index], size);
+            batch[filled++] = storeValue;
+
+            if (!reverse) _advance(point, &position);
+        }
+
+        pthread_rwlock_unlock(&point->lock);
+    }
+
+    pthread_rwlock_unlock(&context->lock);
+
+    CStore_free(clientHandles);
+    CStore_free(founds);
+
+    if (!batch) return STATUS_CODE_FAILED;
+
+    *value_count = filled;
+    *values = batch;
+
+    return STATUS_CODE_SUCCESS;
+}
+
+static c_store_code_t CStore_openCursor(
+    c_store_t cStore,
+    c_store_handle_t server_handle,
+    c_store_stamp_t start_time,
+    c_store_stamp_t end_time,
+    void **cursor)
+{
+    struct context *context = (struct context *) cStore->context;
+    c_store_code_t status_code = STATUS_CODE_SUCCESS;
+
+    pthread_rwlock_rdlock(&context->lock);
+
+    struct point *point = _point(context, server_handle);
+
+    if (_clientHandle(context, point)) {
+        struct cursor *readCursor = CStore_allocate(sizeof(struct cursor));
+
+        if (readCursor) {
+            readCursor->serverHandle = server_handle;
+            readCursor->next = start_time;
+            readCursor->end = end_time;
+            readCursor->reverse = start_time > end_time;
+            *cursor = readCursor;
+        } else status_code = STATUS_CODE_FAILED;
+    } else status_code = STATUS_CODE_BAD_HANDLE;
+
+    pthread_rwlock_unlock(&context->lock);
+
+    return status_code;
+}
+
+static c_store_code_t CStore_fetchCursor(
+    c_store_t cStore,
+    void *cursor,
+    size_t limit,
+    c_store_byte_t *buffer,
+    size_t length,
+    size_t *count)
+{
+    // Resumes from the kept position unless the point has changed since.
+
+    struct context *context = (struct context *) cStore->context;
+    struct cursor *readCursor = cursor;
+    c_store_code_t status_code = STATUS_CODE_SUCCESS;
+    size_t fetched = 0;
+
+    *count = 0;
+    if (readCursor->ended) return STATUS_CODE_SUCCESS;
+
+    pthread_rwlock_rdlock(&context->lock);
+
+    struct point *point = _point(context, readCursor->serverHandle);
+    c_store_handle_t clientHandle = _clientHandle(context, point);
+
+    if (clientHandle) {
+        bool reverse = readCursor->reverse;
+        size_t offset = 0;
+
+        _lock(context, point, false);
+
+        struct position position =
+            readCursor->positioned && readCursor->changes == point->changes?
+                readCursor->position:
+                _search(point, readCursor->next, reverse);
+
+        while (!limit || fetched < limit) {
+            struct position at = position;
+
+            if (reverse) {
+                if (!at.chunk && !at.index) {
+                    readCursor->ended = true;
+                    break;
+                }
+                _retreat(point, &at);
+            } else if (at.chunk == point->chunkCount) {
+                readCursor->ended = true;
+                break;
+            }
+
+            struct chunk *chunk = point->chunks[at.chunk];
+            c_store_stamp_t stamp = chunk->stamps[at.index];
+
+            if (reverse? stamp <= readCursor->end: stamp >= readCursor->end) {
+                readCursor->ended = true;
+                break;
+            }
+
+            size_t size = chunk->sizes[at.index];
+            c_store_value_t *storeValue =
+                CStore_bufferValue(buffer, length, &offset, size);
+
+            if (!storeValue) break; // The buffer is full.
+            storeValue->handle = clientHandle;
+            storeValue->stamp = stamp;
+            storeValue->quality = chunk->qualities[at.index];
+            if (size) memcpy(storeValue->value, chunk->values[at.index], size);
+            ++fetched;
+
+            if (!reverse) _advance(point, &at);
+            position = at;
+            readCursor->next = reverse? stamp - 1: stamp + 1;
+        }
+
+        readCursor->position = position;
+        readCursor->changes = point->changes;
+        readCursor->positioned = true;
+
+        pthread_rwlock_unlock(&point->lock);
+
+        if (!fetched && !readCursor->ended) {
+            status_code = STATUS_CODE_BUFFER_TOO_SMALL;
+        }
+        *count = fetched;
+    } else status_code = STATUS_CODE_BAD_HANDLE;
+
+    pthread_rwlock_unlock(&context->lock);
+
+    return status_code;
+}
+
+static void CStore_closeCursor(c_store_t cStore, void *cursor)
+{
+    CStore_free(cursor);
+}
+
+static c_store_code_t CStore_releaseHandles(
+    c_store_t cStore,
+    size_t count,
+    c_store_handle_t *server_handles,
+    c_store_code_t *status_codes)
+{
+    struct context *context = (struct context *) cStore->context;
+    c_store_handle_t *clientHandles =
+        CStore_allocate(sizeof(c_store_handle_t) * (count? count: 1));
+
+    if (!clientHandles) return STATUS_CODE_FAILED;
+
+    pthread_rwlock_wrlock(&context->lock);
+
+    SharedHandlesMap_getBatch(
+        context->clientHandles, count, server_handles, clientHandles);
+
+    for (size_t i = 0; i < count; ++i) {
+        struct point *point = _point(context, server_handles[i]);
+
+        if (point) {
+            // The values are kept.
+            if (clientHandles[i]) {
+                SharedHandlesMap_remove(
+                    context->clientHandles, server_handles[i]);
+            }
+            point->subscribed = false;
+            status_codes[i] = STATUS_CODE_SUCCESS;
+        } else status_codes[i] = STATUS_CODE_BAD_HANDLE;
+    }
+
+    pthread_rwlock_unlock(&context->lock);
+
+    CStore_free(clientHandles);
+
+    return STATUS_CODE_SUCCESS;
+}
+
+static c_store_code_t CStore_subscribe(
+    c_store_t cStore,
+    size_t count,
+    c_store_handle_t *server_handles,
+    c_store_code_t *status_codes)
+{
+    struct context *context = (struct context *) cStore->context;
+
+    if (!context->notifier) return STATUS_CODE_UNSUPPORTED;
+
+    c_store_handle_t *clientHandles =
+        CStore_allocate(sizeof(c_store_handle_t) * (count? count: 1));
+
+    if (!clientHandles) return STATUS_CODE_FAILED;
+
+    pthread_rwlock_rdlock(&context->lock);
+
+    SharedHandlesMap_getBatch(
+        context->clientHandles, count, server_handles, clientHandles);
+
+    for (size_t i = 0; i < count; ++i) {
+        struct point *point = _point(context, server_handles[i]);
+
+        if (point && clientHandles[i]) {
+            _lock(context, point, true);
+            point->subscribed = true;
+            pthread_rwlock_unlock(&point->lock);
+            status_codes[i] = STATUS_CODE_SUCCESS;
+        } else status_codes[i] = STATUS_CODE_BAD_HANDLE;
+    }
+
+    pthread_rwlock_unlock(&context->lock);
+
+    CStore_free(clientHandles);
+
+    return STATUS_CODE_SUCCESS;
+}
+
+static char *CStore_supportedValueTypeCodes(c_store_t cStore)
+{
+    return "DIRzbacnxdfijm0orsqt";
+}
+
+static bool CStore_supportsConnections(c_store_t cStore)
+{
+    return true;
+}
+
+static bool CStore_supportsCount(c_store_t cStore)
+{
+    return true;
+}
+
+static bool CStore_supportsDelete(c_store_t cStore)
+{
+    return true;
+}
+
+static bool CStore_supportsDeliver(c_store_t cStore)
+{
+    struct context *context = (struct context *) cStore->context;
+
+    return context->notifier != NULL;
+}
+
+static bool CStore_supportsMany(c_store_t cStore)
+{
+    return true;
+}
+
+static bool CStore_supportsPull(c_store_t cStore)
+{
+    return false;
+}
+
+static bool CStore_supportsSubscribe(c_store_t cStore)
+{
+    struct context *context = (struct context *) cStore->context;
+
+    return context->notifier != NULL;
+}
+
+static bool CStore_supportsThreads(c_store_t cStore)
+{
+    return true;
+}
+
+static c_store_code_t CStore_unsubscribe(
+    c_store_t cStore,
+    size_t count,
+    c_store_handle_t *server_handles,
+    c_store_code_t *status_codes)
+{
+    struct context *context = (struct context *) cStore->context;
+
+    if (!context->notifier) return STATUS_CODE_UNSUPPORTED;
+
+    c_store_handle_t *clientHandles =
+        CStore_allocate(sizeof(c_store_handle_t) * (count? count: 1));
+
+    if (!clientHandles) return STATUS_CODE_FAILED;
+
+    pthread_rwlock_rdlock(&context->lock);
+
+    SharedHandlesMap_getBatch(
+        context->clientHandles, count, server_handles, clientHandles);
+
+    for (size_t i = 0; i < count; ++i) {
+        struct point *point = _point(context, server_handles[i]);
+
+        if (point && clientHandles[i]) {
+            _lock(context, point, true);
+            point->subscribed = false;
+            pthread_rwlock_unlock(&point->lock);
+            status_codes[i] = STATUS_CODE_SUCCESS;
+        } else status_codes[i] = STATUS_CODE_BAD_HANDLE;
+    }
+
+    pthread_rwlock_unlock(&context->lock);
+
+    CStore_free(clientHandles);
+
+    return STATUS_CODE_SUCCESS;
+}
+
+static c_store_code_t CStore_useCharset(c_store_t cStore, char *useCharset)
+{
+    return STATUS_CODE_SUCCESS;
+}
+
+static c_store_code_t CStore_write(
+    c_store_t cStore,
+    size_t count,
+    c_store_value_t **values,
+    c_store_code_t *status_codes)
+{
+    struct context *context = (struct context *) cStore->context;
+    struct point *locked = NULL;
+
+    pthread_rwlock_rdlock(&context->lock);
+
+    for (size_t i = 0; i < count; ++i) {
+        c_store_value_t *storeValue = values[i];
+        struct point *point = _point(context, storeValue->handle);
+
+        if (point != locked) {
+            if (locked) pthread_rwlock_unlock(&locked->lock);
+            if (point) _lock(context, point, true);
+            locked = point;
+        }
+
+        if (!point) status_codes[i] = STATUS_CODE_BAD_HANDLE;
+        else if (storeValue->deleted) {
+            status_codes[i] = _delete(context, point, storeValue->stamp);
+        } else status_codes[i] = _put(context, point, storeValue);
+    }
+
+    if (locked) pthread_rwlock_unlock(&locked->lock);
+    pthread_rwlock_unlock(&context->lock);
+
+    return STATUS_CODE_SUCCESS;
+}
+
+static c_store_code_t CStore_writeBuffer(
+    c_store_t cStore,
+    size_t count,
+    c_store_byte_t *buffer,
+    size_t length,
+    c_store_code_t *status_codes)
+{
+    return STATUS_CODE_UNSUPPORTED; // Falls back on write.
+}
+
+// Private function definitions.
+
+static c_store_handle_t _addPoint(
+    struct context *context,
+    const char *tag,
+    size_t hash)
+{
+    if (context->pointCount == context->pointCapacity) {
+        size_t capacity = context->pointCapacity?
+            context->pointCapacity * 2: INITIAL_POINTS_CAPACITY;
+        struct point **points =
+            realloc(context->points, capacity * sizeof(struct point *));
+
+        if (!points) return 0;
+        context->points = points;
+        context->pointCapacity = capacity;
+    }
+
+    if (context->slotCount < 2 * (context->pointCount + 1)) {
+        if (!_resizeSlots(context, 2 * context->pointCapacity)) return 0;
+    }
+
+    struct point *point = CStore_allocate(sizeof(struct point));
+
+    if (!point) return 0;
+    point->tag = strdup(tag);
+    if (!point->tag || pthread_rwlock_init(&point->lock, NULL)) {
+        CStore_free(point->tag);
+        CStore_free(point);
+        return 0;
+    }
+    point->hash = hash;
+    point->index = context->pointCount;
+    point->loaded = !context->persistent; // Loaded when first used.
+
+    size_t slot = hash & (context->slotCount - 1);
+
+    while (context->slots[slot]) slot = (slot + 1) & (context->slotCount - 1);
+    context->points[context->pointCount++] = point;
+    context->slots[slot] = context->pointCount;
+
+    return context->pointCount;
+}
+
+static bool _addSegment(struct context *context, struct segment *segment)
+{
+    if (context->segmentCount == context->segmentCapacity) {
+        size_t capacity =
+            context->segmentCapacity? context->segmentCapacity * 2: 16;
+        struct segment **segments = realloc(
+            context->segments, capacity * sizeof(struct segment *));
+
+        if (!segments) return false;
+        context->segments = segments;
+        context->segmentCapacity = capacity;
+    }
+
+    context->segments[context->segmentCount++] = segment;
+
+    return true;
+}
+
+static void _advance(struct point *point, struct position *position)
+{
+    if (++position->index == point->chunks[position->chunk]->length) {
+        ++position->chunk;
+        position->index = 0;
+    }
+}
+
+static struct record *_append(
+    struct context *context,
+    enum record_type type,
+    struct point *point,
+    c_store_value_t *storeValue)
+{
+    // Records the client handle of the point (for reads that don't copy).
+
+    size_t length = offsetof(struct record, value)
+        + offsetof(c_store_value_t, value) + storeValue->size;
+
+    length = (length + RECORD_ALIGNMENT - 1) & ~(size_t) (RECORD_ALIGNMENT - 1);
+
+    pthread_mutex_lock(&context->appendMutex);
+
+    struct segment *segment = context->segmentCount?
+        context->segments[context->segmentCount - 1]: NULL;
+
+    if (!segment || segment->size - segment->used < length) {
+        segment = _newSegment(context, length);
+    }
+
+    struct record *record = NULL;
+
+    if (segment) {
+        record = (struct record *) (segment->base + segment->used);
+        record->point = point? point->index: context->pointCount;
+        record->length = length;
+        memcpy(&record->value, storeValue,
+            offsetof(c_store_value_t, value) + storeValue->size);
+        record->value.handle = _clientHandle(context, point);
+        record->value.deleted = false;
+        __atomic_store_n(&record->type, type, __ATOMIC_RELEASE);
+        segment->used += length;
+    }
+
+    pthread_mutex_unlock(&context->appendMutex);
+
+    return record;
+}
+
+static c_store_handle_t _clientHandle(
+    struct context *context,
+    struct point *point)
+{
+    // Lock free: the handles are exchanged and released with the context
+    // locked for writing.
+
+    return point? SharedHandlesMap_get(
+        context->clientHandles, (c_store_handle_t) point->index + 1): 0;
+}
+
+static void _closeSegments(struct context *context)
+{
+#ifdef SEGMENTS_SUPPORTED
+    for (size_t i = 0; i < context->segmentCount; ++i) {
+        struct segment *segment = context->segments[i];
+
+        munmap(segment->base, segment->size);
+        close(segment->fd);
+        CStore_free(segment);
+    }
+#endif
+    CStore_free(context->segments);
+    context->segments = NULL;
+    context->segmentCount = 0;
+    context->segmentCapacity = 0;
+}
+
+static c_store_code_t _delete(
+    struct context *context,
+    struct point *point,
+    c_store_stamp_t stamp)
+{
+    c_store_code_t status_code = _remove(context, point, stamp);
+
+    if (status_code == STATUS_CODE_SUCCESS && context->persistent) {
+        c_store_value_t storeValue = {.stamp = stamp};
+
+        if (!_append(context, RECORD_DELETE, point, &storeValue)) {
+            status_code = STATUS_CODE_FAILED;
+        }
+    }
+
+    if (status_code == STATUS_CODE_SUCCESS && point->subscribed) {
+        c_store_value_t storeValue = {.stamp = stamp, .deleted = true};
+
+        _notify(context, point, &storeValue);
+    }
+
+    return status_code;
+}
+
+static size_t _distance(
+    struct point *point,
+    struct position from,
+    struct position to)
+{
+    if (from.chunk == to.chunk) return to.index - from.index;
+
+    size_t distance = point->chunks[from.chunk]->length - from.index;
+
+    for (size_t i = from.chunk + 1; i < to.chunk; ++i) {
+        distance += point->chunks[i]->length;
+    }
+
+    return distance + to.index;
+}
+
+static void _freePoint(struct context *context, struct point *point)
+{
+    for (size_t i = 0; i < point->chunkCount; ++i) {
+        struct chunk *chunk = point->chunks[i];
+
+        if (!context->persistent) {
+            for (size_t j = 0; j < chunk->length; ++j) {
+                CStore_free(chunk->values[j]);
+            }
+        }
+        CStore_free(chunk);
+    }
+    CStore_free(point->chunks);
+    CStore_free(point->segments);
+    CStore_free(point->tag);
+    pthread_rwlock_destroy(&point->lock);
+    CStore_free(point);
+}
+
+static size_t _hash(const char *tag)
+{
+    uint32_t hash = 2166136261U; // FNV-1a.
+
+    while (*tag) {
+        hash ^= (unsigned char) *tag++;
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+static c_store_code_t _insert(
+    struct context *context,
+    struct point *point,
+    c_store_value_t *storeValue,
+    c_store_byte_t *value)
+{
+    struct position position = _search(point, storeValue->stamp, false);
+    struct chunk *chunk;
+
+    if (position.chunk == point->chunkCount) { // Appends.
+        chunk = point->chunkCount? point->chunks[position.chunk - 1]: NULL;
+        if (chunk && chunk->length < CHUNK_CAPACITY) {
+            --position.chunk;
+            position.index = chunk->length;
+        } else {
+            chunk = CStore_allocate(sizeof(struct chunk));
+            if (!chunk || !_insertChunk(point, position.chunk, chunk)) {
+                CStore_free(chunk);
+                return STATUS_CODE_FAILED;
+            }
+        }
+    } else {
+        chunk = point->chunks[position.chunk];
+
+        if (chunk->stamps[position.index] == storeValue->stamp) {
+            if (!context->persistent) {
+                CStore_free(chunk->values[position.index]);
+            }
+            chunk->qualities[position.index] = storeValue->quality;
+            chunk->sizes[position.index] = storeValue->size;
+            chunk->values[position.index] = value;
+            return STATUS_CODE_SUCCESS;
+        }
+
+        if (chunk->length == CHUNK_CAPACITY) { // Splits.
+            struct chunk *upper = CStore_allocate(sizeof(struct chunk));
+            size_t half = CHUNK_CAPACITY / 2;
+
+            if (!upper || !_insertChunk(point, position.chunk + 1, upper)) {
+                CStore_free(upper);
+                return STATUS_CODE_FAILED;
+            }
+            memcpy(upper->stamps, chunk->stamps + half,
+                half * sizeof(c_store_stamp_t));
+            memcpy(upper->qualities, chunk->qualities + half,
+                half * sizeof(c_store_quality_t));
+            memcpy(upper->sizes, chunk->sizes + half, half * sizeof(size_t));
+            memcpy(upper->values, chunk->values + half,
+                half * sizeof(c_store_byte_t *));
+            upper->length = half;
+            chunk->length = half;
+
+            if (position.index > half) {
+                chunk = upper;
+                ++position.chunk;
+                position.index -= half;
+            }
+        }
+
+        size_t moved = chunk->length - position.index;
+        size_t at = position.index;
+
+        memmove(chunk->stamps + at + 1, chunk->stamps + at,
+            moved * sizeof(c_store_stamp_t));
+        memmove(chunk->qualities + at + 1, chunk->qualities + at,
+            moved * sizeof(c_store_quality_t));
+        memmove(chunk->sizes + at + 1, chunk->sizes + at,
+            moved * sizeof(size_t));
+        memmove(chunk->values + at + 1, chunk->values + at,
+            moved * sizeof(c_store_byte_t *));
+    }
+
+    chunk->stamps[position.index] = storeValue->stamp;
+    chunk->qualities[position.index] = storeValue->quality;
+    chunk->sizes[position.index] = storeValue->size;
+    chunk->values[position.index] = value;
+    ++chunk->length;
+    ++point->changes;
+
+    return STATUS_CODE_SUCCESS;
+}
+
+static bool _insertChunk(struct point *point, size_t at, struct chunk *chunk)
+{
+    if (point->chunkCount == point->chunkCapacity) {
+        size_t capacity = point->chunkCapacity? point->chunkCapacity * 2: 4;
+        struct chunk **chunks =
+            realloc(point->chunks, capacity * sizeof(struct chunk *));
+
+        if (!chunks) return false;
+        point->chunks = chunks;
+        point->chunkCapacity = capacity;
+    }
+
+    memmove(point->chunks + at + 1, point->chunks + at,
+        (point->chunkCount - at) * sizeof(struct chunk *));
+    point->chunks[at] = chunk;
+    ++point->chunkCount;
+
+    return true;
+}
+
+static void _load(struct context *context, struct point *point)
+{
+    // Replays the records of the point in the segments noted for it.
+
+    c_store_handle_t clientHandle = _clientHandle(context, point);
+
+    for (size_t i = 0; i < point->segmentCount; ++i) {
+        pthread_mutex_lock(&context->appendMutex);
+
+        struct segment *segment = context->segments[point->segments[i]];
+        size_t used = segment->used;
+
+        pthread_mutex_unlock(&context->appendMutex);
+
+        for (size_t offset = SEGMENT_HEADER_SIZE; offset < used; ) {
+            struct record *record =
+                (struct record *) (segment->base + offset);
+
+            offset += record->length;
+            if (record->point != point->index) continue;
+
+            if (record->type == RECORD_VALUE) {
+                record->value.handle = clientHandle;
+                _insert(context, point, &record->value, record->value.value);
+            } else if (record->type == RECORD_DELETE) {
+                _remove(context, point, record->value.stamp);
+            }
+        }
+    }
+
+    CStore_free(point->segments);
+    point->segments = NULL;
+    point->segmentCount = 0;
+    point->segmentCapacity = 0;
+    __atomic_store_n(&point->loaded, true, __ATOMIC_RELEASE);
+}
+
+static void _lock(struct context *context, struct point *point, bool write)
+{
+    if (write) {
+        pthread_rwlock_wrlock(&point->lock);
+        if (!point->loaded) _load(context, point);
+    } else {
+        if (!__atomic_load_n(&point->loaded, __ATOMIC_ACQUIRE)) {
+            pthread_rwlock_wrlock(&point->lock);
+            if (!point->loaded) _load(context, point);
+            pthread_rwlock_unlock(&point->lock);
+        }
+        pthread_rwlock_rdlock(&point->lock);
+    }
+}
+
+static struct segment *_newSegment(struct context *context, size_t minimum)
+{
+    // Called with the append mutex held.
+
+#ifdef SEGMENTS_SUPPORTED
+    size_t size = context->segmentSize;
+
+    if (size < SEGMENT_HEADER_SIZE + minimum) {
+        size = SEGMENT_HEADER_SIZE + minimum;
+    }
+
+    char *path = _segmentPath(context, context->segmentCount);
+    struct segment *segment = CStore_allocate(sizeof(struct segment));
+
+    if (!path || !segment) {
+        CStore_free(path);
+        CStore_free(segment);
+        return NULL;
+    }
+
+    segment->fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (segment->fd < 0 || ftruncate(segment->fd, size) < 0) {
+        if (segment->fd >= 0) {
+            close(segment->fd);
+            unlink(path);
+        }
+        CStore_free(path);
+        CStore_free(segment);
+        return NULL;
+    }
+    CStore_free(path);
+
+    segment->base =
+        mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, segment->fd, 0);
+    if (segment->base == MAP_FAILED) {
+        close(segment->fd);
+        CStore_free(segment);
+        return NULL;
+    }
+    segment->size = size;
+    segment->used = SEGMENT_HEADER_SIZE;
+    memcpy(segment->base, SEGMENT_MAGIC, strlen(SEGMENT_MAGIC));
+
+    if (!_addSegment(context, segment)) {
+        munmap(segment->base, segment->size);
+        close(segment->fd);
+        CStore_free(segment);
+        return NULL;
+    }
+
+    return segment;
+#else
+    return NULL;
+#endif
+}
+
+static bool _noteSegment(struct point *point, size_t segmentIndex)
+{
+    if (point->segmentCount
+            && point->segments[point->segmentCount - 1] == segmentIndex) {
+        return true;
+    }
+
+    if (point->segmentCount == point->segmentCapacity) {
+        size_t capacity =
+            point->segmentCapacity? point->segmentCapacity * 2: 4;
+        size_t *segments =
+            realloc(point->segments, capacity * sizeof(size_t));
+
+        if (!segments) return false;
+        point->segments = segments;
+        point->segmentCapacity = capacity;
+    }
+
+    point->segments[point->segmentCount++] = segmentIndex;
+
+    return true;
+}
+
+static void _notify(
+    struct context *context,
+    struct point *point,
+    c_store_value_t *storeValue)
+{
+    // Called with the point locked for writing.
+
+    size_t size = storeValue->deleted? 0: storeValue->size;
+    c_store_value_t *notice =
+        CStore_allocate(offsetof(c_store_value_t, value) + size);
+
+    if (!notice) return;
+
+    notice->handle = _clientHandle(context, point);
+    notice->stamp = storeValue->stamp;
+    notice->deleted = storeValue->deleted;
+    notice->quality = storeValue->quality;
+    notice->size = size;
+    if (size) memcpy(notice->value, storeValue->value, size);
+
+    if (!Notifier_push(context->notifier, notice)) CStore_free(notice);
+}
+
+static bool _openSegment(
+    struct context *context,
+    size_t segmentIndex,
+    struct segment **segment)
+{
+    // Succeeds with a NULL segment when the file does not exist.
+
+    *segment = NULL;
+
+#ifdef SEGMENTS_SUPPORTED
+    char *path = _segmentPath(context, segmentIndex);
+
+    if (!path) return false;
+
+    int fd = open(path, O_RDWR);
+    bool missing = fd < 0 && errno == ENOENT;
+    struct stat status;
+
+    CStore_free(path);
+    if (fd < 0) return missing;
+
+    if (fstat(fd, &status) < 0 || status.st_size < SEGMENT_HEADER_SIZE) {
+        close(fd);
+        return false;
+    }
+
+    c_store_byte_t *base = mmap(NULL, status.st_size,
+        PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (base == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    if (memcmp(base, SEGMENT_MAGIC, strlen(SEGMENT_MAGIC))
+            || !(*segment = CStore_allocate(sizeof(struct segment)))) {
+        munmap(base, status.st_size);
+        close(fd);
+        return false;
+    }
+    (*segment)->fd = fd;
+    (*segment)->base = base;
+    (*segment)->size = status.st_size;
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+static struct point *_point(
+    struct context *context,
+    c_store_handle_t serverHandle)
+{
+    if (serverHandle <= 0 || (size_t) serverHandle > context->pointCount) {
+        return NULL;
+    }
+
+    return context->points[serverHandle - 1];
+}
+
+static c_store_code_t _put(
+    struct context *context,
+    struct point *point,
+    c_store_value_t *storeValue)
+{
+    c_store_byte_t *value = NULL;
+
+    if (context->persistent) {
+        struct record *record =
+            _append(context, RECORD_VALUE, point, storeValue);
+
+        if (!record) return STATUS_CODE_FAILED;
+        value = record->value.value;
+    } else if (storeValue->size) {
+        value = malloc(storeValue->size);
+        if (!value) return STATUS_CODE_FAILED;
+        memcpy(value, storeValue->value, storeValue->size);
+    }
+
+    c_store_code_t status_code = _insert(context, point, storeValue, value);
+
+    if (status_code != STATUS_CODE_SUCCESS && !context->persistent) {
+        CStore_free(value);
+    }
+
+    if (status_code == STATUS_CODE_SUCCESS && point->subscribed) {
+        _notify(context, point, storeValue);
+    }
+
+    return status_code;
+}
+
+static bool _range(
+    struct point *point,
+    c_store_stamp_t start_time,
+    c_store_stamp_t end_time,
+    struct position *from,
+    struct position *to)
+{
+    if (start_time > end_time) { // Reverse: end time < stamp <= start time.
+        *from = _search(point, end_time, true);
+        *to = _search(point, start_time, true);
+        return true;
+    }
+
+    *from = _search(point, start_time, false);
+    *to = _search(point, end_time, false);
+
+    return false;
+}
+
+static c_store_code_t _remove(
+    struct context *context,
+    struct point *point,
+    c_store_stamp_t stamp)
+{
+    struct position position = _search(point, stamp, false);
+
+    if (position.chunk == point->chunkCount) return STATUS_CODE_IGNORED;
+
+    struct chunk *chunk = point->chunks[position.chunk];
+    size_t at = position.index;
+
+    if (chunk->stamps[at] != stamp) return STATUS_CODE_IGNORED;
+
+    if (!context->persistent) CStore_free(chunk->values[at]);
+
+    if (--chunk->length) {
+        size_t moved = chunk->length - at;
+
+        memmove(chunk->stamps + at, chunk->stamps + at + 1,
+            moved * sizeof(c_store_stamp_t));
+        memmove(chunk->qualities + at, chunk->qualities + at + 1,
+            moved * sizeof(c_store_quality_t));
+        memmove(chunk->sizes + at, chunk->sizes + at + 1,
+            moved * sizeof(size_t));
+        memmove(chunk->values + at, chunk->values + at + 1,
+            moved * sizeof(c_store_byte_t *));
+    } else {
+        CStore_free(chunk);
+        --point->chunkCount;
+        memmove(point->chunks + position.chunk,
+            point->chunks + position.chunk + 1,
+            (point->chunkCount - position.chunk) * sizeof(struct chunk *));
+    }
+    ++point->changes;
+
+    return STATUS_CODE_SUCCESS;
+}
+
+static bool _resizeSlots(struct context *context, size_t slotCount)
+{
+    size_t *slots = CStore_allocate(slotCount * sizeof(size_t));
+
+    if (!slots) return false;
+
+    for (size_t i = 0; i < context->pointCount; ++i) {
+        size_t slot = context->points[i]->hash & (slotCount - 1);
+
+        while (slots[slot]) slot = (slot + 1) & (slotCount - 1);
+        slots[slot] = i + 1;
+    }
+
+    CStore_free(context->slots);
+    context->slots = slots;
+    context->slotCount = slotCount;
+
+    return true;
+}
+
+static bool _restore(struct context *context)
+{
+    // Maps the existing segments (numbered from 0) and scans them.
+
+#ifdef SEGMENTS_SUPPORTED
+    context->persistent = true; // Restored points load lazily.
+
+    while (true) {
+        struct segment *segment;
+
+        if (!_openSegment(context, context->segmentCount, &segment)) break;
+        if (!segment) return true;
+
+        if (!_addSegment(context, segment)) {
+            munmap(segment->base, segment->size);
+            close(segment->fd);
+            CStore_free(segment);
+            break;
+        }
+        if (!_scanSegment(context, context->segmentCount - 1)) break;
+    }
+
+    context->persistent = false;
+#endif
+
+    return false;
+}
+
+static void _retreat(struct point *point, struct position *position)
+{
+    if (!position->index--) {
+        position->index = point->chunks[--position->chunk]->length - 1;
+    }
+}
+
+static bool _scanSegment(struct context *context, size_t segmentIndex)
+{
+    // Stops at the first incomplete or corrupt record, where appends resume.
+
+    struct segment *segment = context->segments[segmentIndex];
+    size_t offset = SEGMENT_HEADER_SIZE;
+
+    while (segment->size - offset >= sizeof(struct record)) {
+        struct record *record = (struct record *) (segment->base + offset);
+
+        if (record->type == RECORD_END
+                || record->length < sizeof(struct record)
+                || record->length > segment->size - offset
+                || record->length - offsetof(struct record, value.value)
+                    < record->value.size) {
+            break;
+        }
+
+        if (record->type == RECORD_TAG) {
+            if (record->value.size == 0) break; // No room for the NUL.
+            if (record->point == context->pointCount) {
+                char *tag = (char *) record->value.value;
+
+                tag[record->value.size - 1] = '\0';
+                if (!_addPoint(context, tag, _hash(tag))) return false;
+            }
+        } else if (record->point < context->pointCount) {
+            if (!_noteSegment(context->points[record->point], segmentIndex)) {
+                return false;
+            }
+        }
+
+        offset += record->length;
+    }
+
+    segment->used = offset;
+
+    return true;
+}
+
+static struct position _search(
+    struct point *point,
+    c_store_stamp_t stamp,
+    bool after)
+{
+    // Finds the first value with a stamp not before (or after) the stamp.
+
+    size_t low = 0;
+    size_t high = point->chunkCount;
+
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        struct chunk *chunk = point->chunks[middle];
+        c_store_stamp_t last = chunk->stamps[chunk->length - 1];
+
+        if (after? last > stamp: last >= stamp) high = middle;
+        else low = middle + 1;
+    }
+
+    struct position position = {low, 0};
+
+    if (low < point->chunkCount) {
+        struct chunk *chunk = point->chunks[low];
+
+        high = chunk->length - 1;
+        while (position.index < high) {
+            size_t middle = position.index + (high - position.index) / 2;
+            c_store_stamp_t found = chunk->stamps[middle];
+
+            if (after? found > stamp: found >= stamp) high = middle;
+            else position.index = middle + 1;
+        }
+    }
+
+    return position;
+}
+
+static char *_segmentPath(struct context *context, size_t segmentIndex)
+{
+    size_t size = strlen(context->directory) + 32;
+    char *path = CStore_allocate(size);
+
+    if (path) {
+        snprintf(path, size, "%s/%08zu.seg", context->directory, segmentIndex);
+    }
+
+    return path;
+}
+
+static void _syncSegments(struct context *context)
+{
+#ifdef SEGMENTS_SUPPORTED
+    pthread_mutex_lock(&context->appendMutex);
+
+    for (size_t i = 0; i < context->segmentCount; ++i) {
+        struct segment *segment = context->segments[i];
+
+        msync(segment->base, segment->used, MS_SYNC);
+    }
+
+    pthread_mutex_unlock(&context->appendMutex);
+#endif
+}
+
+static c_store_handle_t _tagHandle(struct context *context, const char *tag)
+{
+    size_t hash = _hash(tag);
+
+    if (context->slotCount) {
+        size_t slot = hash & (context->slotCount - 1);
+
+        while (context->slots[slot]) {
+            struct point *point = context->points[context->slots[slot] - 1];
+
+            if (point->hash == hash && !strcmp(point->tag, tag)) {
+                return context->slots[slot];
+            }
+            slot = (slot + 1) & (context->slotCount - 1);
+        }
+    }
+
+    if (context->persistent) {
+        size_t size = strlen(tag) + 1;
+        c_store_value_t *tagValue =
+            CStore_allocate(offsetof(c_store_value_t, value) + size);
+
+        if (!tagValue) return 0;
+        tagValue->size = size;
+        memcpy(tagValue->value, tag, size);
+
+        struct record *record = _append(context, RECORD_TAG, NULL, tagValue);
+
+        CStore_free(tagValue);
+        if (!record) return 0;
+    }
+
+    c_store_handle_t handle = _addPoint(context, tag, hash);
+
+    if (handle) {
+        context->points[handle - 1]->loaded = true; // A new point.
+    }
+
+    return handle;
+}
+
+/* This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
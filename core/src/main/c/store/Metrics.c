@@ -0,0 +1,259 @@
+/** Related Values Processing Framework.
+ *
+ * Copyright (C) 2003-2019 Serge Brisson.
+ *
+ * This software is distributable under the LGPL license.
+ * See details at the bottom of this file.
+ *
+ * $Id$
+ */
+
+/* Notes.
+ *
+ * The metrics are kept per thread, in counters padded to a cache line, so
+ * that recording them costs a clock read and a few plain stores. Each
+ * thread registers its counters on its first record; they are folded into
+ * the retired totals when it ends.
+ *
+ * A snapshot sums the retired totals and the counters of the live threads
+ * while holding the registry mutex. Since each counter has a single writer,
+ * relaxed atomic loads and stores are enough to keep it consistent.
+ */
+#include "Metrics.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+// Private macro definitions.
+
+#define CACHE_LINE_SIZE 64
+
+#define LOAD(location) __atomic_load_n((location), __ATOMIC_RELAXED)
+#define STORE(location, value) \
+    __atomic_store_n((location), (value), __ATOMIC_RELAXED)
+
+// Private structure definitions.
+
+struct metrics_counter
+{
+    int64_t fields[METRICS_FIELDS];
+}
+__attribute__((aligned(CACHE_LINE_SIZE)));
+
+struct metrics_thread
+{
+    struct metrics_counter counters[METRICS_FUNCTIONS];
+    struct metrics_thread *next;
+    struct metrics_thread *previous;
+    void *memory; // As allocated.
+};
+
+// Private variable definitions.
+
+static bool _threadKeyCreated = false;
+
+static pthread_key_t _threadKey;
+
+static struct metrics_thread *_threads = NULL;
+
+static pthread_mutex_t _threadsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_once_t _threadsOnce = PTHREAD_ONCE_INIT;
+
+static struct metrics_counter _retired[METRICS_FUNCTIONS];
+
+static __thread struct metrics_thread *_thread = NULL;
+
+// Private forward declarations.
+
+static int _bucket(int64_t nanos);
+
+static void _createKey(void);
+
+static void _increment(int64_t *field, int64_t increment);
+
+static void _record(
+    enum metrics_function function,
+    int64_t nanos,
+    size_t values,
+    size_t bytes);
+
+static struct metrics_thread *_register(void);
+
+static void _retire(void *argument);
+
+// Public function definitions.
+
+void Metrics_dispose(void)
+{
+    // Called when the library is unloaded: the threads must not call back.
+
+    if (_threadKeyCreated) {
+        pthread_key_delete(_threadKey);
+        _threadKeyCreated = false;
+    }
+}
+
+void Metrics_record(
+    enum metrics_function function,
+    int64_t start,
+    size_t values,
+    size_t bytes)
+{
+    _record(function, Metrics_start() - start, values, bytes);
+}
+
+void Metrics_recordValues(
+    enum metrics_function function,
+    int64_t start,
+    size_t count,
+    c_store_value_t **values)
+{
+    // The values are measured after the time is taken.
+
+    int64_t nanos = Metrics_start() - start;
+    size_t bytes = 0;
+
+    for (size_t i = 0; i < count; ++i) bytes += values[i]->size;
+
+    _record(function, nanos, count, bytes);
+}
+
+void Metrics_snapshot(int64_t *metrics)
+{
+    // Fills METRICS_LENGTH entries.
+
+    metrics[0] = METRICS_FUNCTIONS;
+    metrics[1] = METRICS_BUCKETS;
+
+    pthread_mutex_lock(&_threadsMutex);
+
+    for (int i = 0; i < METRICS_FUNCTIONS; ++i) {
+        int64_t *fields = metrics + METRICS_HEADER + i * METRICS_FIELDS;
+
+        memcpy(fields, _retired[i].fields, sizeof _retired[i].fields);
+
+        for (struct metrics_thread *thread = _threads;
+                thread; thread = thread->next) {
+            for (int j = 0; j < METRICS_FIELDS; ++j) {
+                fields[j] += LOAD(&thread->counters[i].fields[j]);
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&_threadsMutex);
+}
+
+int64_t Metrics_start(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// Private function definitions.
+
+static int _bucket(int64_t nanos)
+{
+    int bucket = nanos > 0? 63 - __builtin_clzll((uint64_t) nanos): 0;
+
+    return bucket < METRICS_BUCKETS? bucket: METRICS_BUCKETS - 1;
+}
+
+static void _createKey(void)
+{
+    _threadKeyCreated = !pthread_key_create(&_threadKey, _retire);
+}
+
+static void _increment(int64_t *field, int64_t increment)
+{
+    // Only the owner thread writes the field.
+
+    STORE(field, LOAD(field) + increment);
+}
+
+static void _record(
+    enum metrics_function function,
+    int64_t nanos,
+    size_t values,
+    size_t bytes)
+{
+    struct metrics_thread *thread = _thread? _thread: _register();
+
+    if (!thread) return;
+
+    int64_t *fields = thread->counters[function].fields;
+
+    _increment(&fields[METRICS_CALLS], 1);
+    _increment(&fields[METRICS_VALUES], (int64_t) values);
+    _increment(&fields[METRICS_BYTES], (int64_t) bytes);
+    _increment(&fields[METRICS_NANOS], nanos);
+    _increment(&fields[METRICS_BUCKET + _bucket(nanos)], 1);
+}
+
+static struct metrics_thread *_register(void)
+{
+    pthread_once(&_threadsOnce, _createKey);
+    if (!_threadKeyCreated) return NULL;
+
+    void *memory =
+        CStore_allocate(sizeof(struct metrics_thread) + CACHE_LINE_SIZE - 1);
+
+    if (!memory) return NULL;
+
+    struct metrics_thread *thread = (struct metrics_thread *)
+        (((uintptr_t) memory + CACHE_LINE_SIZE - 1)
+            & ~(uintptr_t) (CACHE_LINE_SIZE - 1));
+
+    thread->memory = memory;
+
+    pthread_mutex_lock(&_threadsMutex);
+    thread->next = _threads;
+    if (_threads) _threads->previous = thread;
+    _threads = thread;
+    pthread_mutex_unlock(&_threadsMutex);
+
+    pthread_setspecific(_threadKey, thread);
+    _thread = thread;
+
+    return thread;
+}
+
+static void _retire(void *argument)
+{
+    struct metrics_thread *thread = argument;
+
+    pthread_mutex_lock(&_threadsMutex);
+
+    for (int i = 0; i < METRICS_FUNCTIONS; ++i) {
+        for (int j = 0; j < METRICS_FIELDS; ++j) {
+            _retired[i].fields[j] += thread->counters[i].fields[j];
+        }
+    }
+
+    if (thread->previous) thread->previous->next = thread->next;
+    else _threads = thread->next;
+    if (thread->next) thread->next->previous = thread->previous;
+
+    pthread_mutex_unlock(&_threadsMutex);
+
+    _thread = NULL;
+    CStore_free(thread->memory);
+}
+
+/* This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
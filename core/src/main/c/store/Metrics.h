@@ -0,0 +1,77 @@
+/** Related Values Processing Framework.
+ *
+ * Copyright (C) 2003-2019 Serge Brisson.
+ *
+ * This software is distributable under the LGPL license.
+ * See details at the bottom of this file.
+ *
+ * $Id$
+ */
+#ifndef RVPF_METRICS_H
+#define RVPF_METRICS_H
+
+#include "CStoreImpl.h"
+
+#include <stdint.h>
+
+// A snapshot holds the functions and buckets counts, then the fields of
+// each function: calls, values, bytes, nanoseconds and the buckets, where
+// bucket i counts the calls which took from 2^i to 2^(i+1) nanoseconds.
+
+#define METRICS_BUCKETS 32 // The last bucket is open.
+#define METRICS_CALLS 0
+#define METRICS_VALUES 1
+#define METRICS_BYTES 2
+#define METRICS_NANOS 3
+#define METRICS_BUCKET 4 // First bucket.
+#define METRICS_FIELDS (METRICS_BUCKET + METRICS_BUCKETS)
+#define METRICS_HEADER 2
+
+enum metrics_function // Must match the functions in Metrics.java.
+{
+    METRICS_WRITE,
+    METRICS_WRITE_BUFFER,
+    METRICS_READ,
+    METRICS_READ_MANY,
+    METRICS_DELIVER,
+    METRICS_EXCHANGE_HANDLES,
+    METRICS_ACCEPT_VALUES,
+    METRICS_RETURN_VALUES,
+    METRICS_FUNCTIONS
+};
+
+#define METRICS_LENGTH (METRICS_HEADER + METRICS_FUNCTIONS * METRICS_FIELDS)
+
+extern void Metrics_dispose(void);
+
+extern void Metrics_record(
+    enum metrics_function function,
+    int64_t start,
+    size_t values,
+    size_t bytes);
+
+extern void Metrics_recordValues(
+    enum metrics_function function,
+    int64_t start,
+    size_t count,
+    c_store_value_t **values);
+
+extern void Metrics_snapshot(int64_t *metrics);
+
+extern int64_t Metrics_start(void);
+
+#endif /* RVPF_METRICS_H */
+
+/* This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
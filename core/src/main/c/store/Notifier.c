@@ -0,0 +1,357 @@
+/** Related Values Processing Framework.
+ *
+ * Copyright (C) 2003-2019 Serge Brisson.
+ *
+ * This software is distributable under the LGPL license.
+ * See details at the bottom of this file.
+ *
+ * $Id$
+ */
+
+/* Notes.
+ *
+ * A notifier carries the values of subscribed points from the threads
+ * writing them to the thread calling deliver. The values are queued in a
+ * ring of pointers: the producers are serialized by a mutex, but the
+ * consumer never takes it, so that it only synchronizes with them through
+ * the head and tail indexes.
+ *
+ * A consumer about to block raises a waiting flag, then checks the ring
+ * once more before waiting on an eventfd (a pipe where eventfd is not
+ * available). A producer signals that descriptor only when it sees the
+ * flag, so that a busy flow of values costs no system call. Values pushed
+ * while the ring is full are dropped and counted.
+ *
+ * There must be at most one consumer at a time.
+ */
+#include "Notifier.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef _WIN32
+#define NOTIFIER_SUPPORTED
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#define EVENTFD_SUPPORTED
+#include <sys/eventfd.h>
+#endif
+#endif
+
+// Private macro definitions.
+
+#define MINIMUM_CAPACITY 16
+
+// Private structure definitions.
+
+struct c_store_notifier
+{
+    c_store_value_t **ring;
+    size_t mask;
+    size_t head; // Next value to deliver (written by the consumer).
+    size_t tail; // Next slot to fill (written by the producers).
+    pthread_mutex_t pushMutex;
+    int readFD;
+    int writeFD; // Same as readFD for an eventfd.
+    int waiting;
+    int interrupted;
+    size_t dropped;
+};
+
+// Private forward declarations.
+
+#ifdef NOTIFIER_SUPPORTED
+
+static void _drain(c_store_notifier_t notifier);
+
+static size_t _pending(c_store_notifier_t notifier);
+
+static void _signal(c_store_notifier_t notifier);
+
+static bool _wait(c_store_notifier_t notifier, c_store_millis_t timeout);
+
+#endif
+
+// Public function definitions.
+
+c_store_notifier_t Notifier_create(size_t capacity)
+{
+#ifdef NOTIFIER_SUPPORTED
+    c_store_notifier_t notifier =
+        CStore_allocate(sizeof(struct c_store_notifier));
+    size_t ringCapacity = MINIMUM_CAPACITY;
+
+    if (!notifier) return NULL;
+
+    while (ringCapacity < capacity) ringCapacity <<= 1;
+    notifier->ring =
+        CStore_allocate(sizeof(c_store_value_t *) * ringCapacity);
+    notifier->mask = ringCapacity - 1;
+    notifier->readFD = notifier->writeFD = -1;
+
+#ifdef EVENTFD_SUPPORTED
+    notifier->readFD = notifier->writeFD =
+        eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#else
+    int fds[2];
+
+    if (!pipe(fds)) {
+        notifier->readFD = fds[0];
+        notifier->writeFD = fds[1];
+        fcntl(fds[0], F_SETFL, O_NONBLOCK);
+        fcntl(fds[1], F_SETFL, O_NONBLOCK);
+        fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+        fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    }
+#endif
+
+    if (!notifier->ring || notifier->readFD < 0
+            || pthread_mutex_init(&notifier->pushMutex, NULL)) {
+        if (notifier->readFD >= 0) close(notifier->readFD);
+        if (notifier->writeFD != notifier->readFD) close(notifier->writeFD);
+        CStore_free(notifier->ring);
+        CStore_free(notifier);
+        notifier = NULL;
+    }
+
+    return notifier;
+#else
+    return NULL;
+#endif
+}
+
+c_store_code_t Notifier_deliver(
+    c_store_notifier_t notifier,
+    size_t limit,
+    c_store_millis_t timeout,
+    size_t *count,
+    c_store_value_t ***values)
+{
+    // The values are copied into a batch freed by CStore_freeValueBatch.
+
+    *count = 0;
+
+#ifdef NOTIFIER_SUPPORTED
+    ASSERT(notifier);
+
+    if (!_wait(notifier, timeout)) return STATUS_CODE_SUCCESS;
+
+    size_t head = notifier->head;
+    size_t found = _pending(notifier);
+    size_t bytesLength = 0;
+
+    if (limit && found > limit) found = limit;
+
+    for (size_t i = 0; i < found; ++i) {
+        bytesLength += notifier->ring[(head + i) & notifier->mask]->size;
+    }
+
+    c_store_value_t **batch = CStore_newValueBatch(found, bytesLength);
+
+    if (!batch) return STATUS_CODE_FAILED;
+
+    for (size_t i = 0; i < found; ++i) {
+        c_store_value_t *value = notifier->ring[(head + i) & notifier->mask];
+        c_store_value_t *batchValue = CStore_batchValue(batch, value->size);
+
+        ASSERT(batchValue); // The batch was sized for the values.
+        memcpy(batchValue, value,
+            offsetof(c_store_value_t, value) + value->size);
+        batch[i] = batchValue;
+        CStore_free(value);
+    }
+
+    __atomic_store_n(&notifier->head, head + found, __ATOMIC_RELEASE);
+
+    *count = found;
+    *values = batch;
+
+    return STATUS_CODE_SUCCESS;
+#else
+    return STATUS_CODE_UNSUPPORTED;
+#endif
+}
+
+void Notifier_dispose(c_store_notifier_t notifier)
+{
+#ifdef NOTIFIER_SUPPORTED
+    if (notifier) {
+        for (size_t i = notifier->head; i != notifier->tail; ++i) {
+            CStore_free(notifier->ring[i & notifier->mask]);
+        }
+        if (notifier->writeFD != notifier->readFD) close(notifier->writeFD);
+        close(notifier->readFD);
+        pthread_mutex_destroy(&notifier->pushMutex);
+        CStore_free(notifier->ring);
+        CStore_free(notifier);
+    }
+#endif
+}
+
+size_t Notifier_dropped(c_store_notifier_t notifier)
+{
+    // Returns the count dropped since the previous call.
+
+#ifdef NOTIFIER_SUPPORTED
+    return __atomic_exchange_n(&notifier->dropped, 0, __ATOMIC_RELAXED);
+#else
+    return 0;
+#endif
+}
+
+void Notifier_interrupt(c_store_notifier_t notifier)
+{
+    // Interrupts the current (or next) wait of the consumer.
+
+#ifdef NOTIFIER_SUPPORTED
+    __atomic_store_n(&notifier->interrupted, 1, __ATOMIC_SEQ_CST);
+    _signal(notifier);
+#endif
+}
+
+bool Notifier_push(c_store_notifier_t notifier, c_store_value_t *value)
+{
+    // Takes ownership of the value (from CStore_allocate) when it returns
+    // true.
+
+#ifdef NOTIFIER_SUPPORTED
+    bool pushed;
+
+    pthread_mutex_lock(&notifier->pushMutex);
+
+    size_t tail = notifier->tail;
+
+    pushed = tail - __atomic_load_n(&notifier->head, __ATOMIC_ACQUIRE)
+        <= notifier->mask;
+    if (pushed) {
+        notifier->ring[tail & notifier->mask] = value;
+        __atomic_store_n(&notifier->tail, tail + 1, __ATOMIC_RELEASE);
+    } else __atomic_add_fetch(&notifier->dropped, 1, __ATOMIC_RELAXED);
+
+    pthread_mutex_unlock(&notifier->pushMutex);
+
+    if (pushed) {
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&notifier->waiting, __ATOMIC_RELAXED)) {
+            _signal(notifier);
+        }
+    }
+
+    return pushed;
+#else
+    return false;
+#endif
+}
+
+// Private function definitions.
+
+#ifdef NOTIFIER_SUPPORTED
+
+static void _drain(c_store_notifier_t notifier)
+{
+#ifdef EVENTFD_SUPPORTED
+    uint64_t events;
+
+    while (read(notifier->readFD, &events, sizeof events) > 0);
+#else
+    char bytes[64];
+
+    while (read(notifier->readFD, bytes, sizeof bytes) > 0);
+#endif
+}
+
+static size_t _pending(c_store_notifier_t notifier)
+{
+    return __atomic_load_n(&notifier->tail, __ATOMIC_SEQ_CST)
+        - notifier->head;
+}
+
+static void _signal(c_store_notifier_t notifier)
+{
+    // A full descriptor is already signaled.
+
+#ifdef EVENTFD_SUPPORTED
+    uint64_t event = 1;
+
+    if (write(notifier->writeFD, &event, sizeof event) < 0) return;
+#else
+    char byte = 0;
+
+    if (write(notifier->writeFD, &byte, 1) < 0) return;
+#endif
+}
+
+static bool _wait(c_store_notifier_t notifier, c_store_millis_t timeout)
+{
+    // Returns true when values are pending.
+
+    struct timespec deadline;
+
+    if (timeout > 0) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout / 1000;
+        deadline.tv_nsec += (timeout % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            ++deadline.tv_sec;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+
+    for (;;) {
+        if (_pending(notifier)) return true;
+        if (__atomic_exchange_n(&notifier->interrupted, 0, __ATOMIC_SEQ_CST)) {
+            return false;
+        }
+
+        int millis = -1;
+
+        if (timeout > 0) {
+            struct timespec now;
+
+            clock_gettime(CLOCK_MONOTONIC, &now);
+
+            c_store_millis_t remaining =
+                (deadline.tv_sec - now.tv_sec) * 1000
+                + (deadline.tv_nsec - now.tv_nsec) / 1000000;
+
+            if (remaining <= 0) return false;
+            millis = remaining > INT32_MAX? INT32_MAX: (int) remaining;
+        } else if (!timeout) return false;
+
+        __atomic_store_n(&notifier->waiting, 1, __ATOMIC_SEQ_CST);
+
+        if (!_pending(notifier)
+                && !__atomic_load_n(&notifier->interrupted, __ATOMIC_SEQ_CST)) {
+            struct pollfd pollFD = {notifier->readFD, POLLIN, 0};
+
+            if (poll(&pollFD, 1, millis) < 0 && errno != EINTR) {
+                __atomic_store_n(&notifier->waiting, 0, __ATOMIC_RELAXED);
+                return false;
+            }
+        }
+
+        __atomic_store_n(&notifier->waiting, 0, __ATOMIC_RELAXED);
+        _drain(notifier);
+    }
+}
+
+#endif
+
+/* This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
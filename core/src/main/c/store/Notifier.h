@@ -0,0 +1,48 @@
+/** Related Values Processing Framework.
+ *
+ * Copyright (C) 2003-2019 Serge Brisson.
+ *
+ * This software is distributable under the LGPL license.
+ * See details at the bottom of this file.
+ *
+ * $Id$
+ */
+#ifndef RVPF_NOTIFIER_H
+#define RVPF_NOTIFIER_H
+
+#include "CStoreImpl.h"
+
+typedef struct c_store_notifier *c_store_notifier_t;
+
+extern c_store_notifier_t Notifier_create(size_t capacity);
+
+extern c_store_code_t Notifier_deliver(
+    c_store_notifier_t notifier,
+    size_t limit,
+    c_store_millis_t timeout,
+    size_t *count,
+    c_store_value_t ***values);
+
+extern void Notifier_dispose(c_store_notifier_t notifier);
+
+extern size_t Notifier_dropped(c_store_notifier_t notifier);
+
+extern void Notifier_interrupt(c_store_notifier_t notifier);
+
+extern bool Notifier_push(c_store_notifier_t notifier, c_store_value_t *value);
+
+#endif /* RVPF_NOTIFIER_H */
+
+/* This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
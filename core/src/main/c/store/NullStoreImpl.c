@@ -101,11 +101,7 @@ static void CStore_freeValues(
     size_t count,
     c_store_value_t **values)
 {
-    for (int i = 0; i < count; ++i) {
-        CStore_free(values[i]);
-        values[i] = NULL;
-    }
-    CStore_free(values);
+    CStore_freeValueBatch(values);
 }
 
 static c_store_code_t CStore_getQualityCode(
@@ -163,6 +159,19 @@ static c_store_code_t CStore_count(
     return STATUS_CODE_SUCCESS;
 }
 
+static c_store_code_t CStore_countMany(
+    c_store_t cStore,
+    size_t count,
+    c_store_handle_t *server_handles,
+    c_store_stamp_t *start_times,
+    c_store_stamp_t *end_times,
+    size_t limit,
+    c_store_long_t *counts,
+    c_store_code_t *status_codes)
+{
+    return STATUS_CODE_UNSUPPORTED;
+}
+
 static c_store_code_t CStore_read(
     c_store_t cStore,
     c_store_handle_t server_handle,
@@ -175,6 +184,45 @@ static c_store_code_t CStore_read(
     return STATUS_CODE_SUCCESS;
 }
 
+static c_store_code_t CStore_readMany(
+    c_store_t cStore,
+    size_t count,
+    c_store_handle_t *server_handles,
+    c_store_stamp_t *start_times,
+    c_store_stamp_t *end_times,
+    size_t limit,
+    size_t *value_count,
+    c_store_value_t ***values,
+    c_store_code_t *status_codes)
+{
+    return STATUS_CODE_UNSUPPORTED;
+}
+
+static c_store_code_t CStore_openCursor(
+    c_store_t cStore,
+    c_store_handle_t server_handle,
+    c_store_stamp_t start_time,
+    c_store_stamp_t end_time,
+    void **cursor)
+{
+    return STATUS_CODE_UNSUPPORTED;
+}
+
+static c_store_code_t CStore_fetchCursor(
+    c_store_t cStore,
+    void *cursor,
+    size_t limit,
+    c_store_byte_t *buffer,
+    size_t length,
+    size_t *count)
+{
+    return STATUS_CODE_UNSUPPORTED;
+}
+
+static void CStore_closeCursor(c_store_t cStore, void *cursor)
+{
+}
+
 static c_store_code_t CStore_releaseHandles(
     c_store_t cStore,
     size_t count,
@@ -218,6 +266,11 @@ static bool CStore_supportsDeliver(c_store_t cStore)
     return false;
 }
 
+static bool CStore_supportsMany(c_store_t cStore)
+{
+    return false;
+}
+
 static bool CStore_supportsPull(c_store_t cStore)
 {
     return false;
@@ -256,6 +309,16 @@ static c_store_code_t CStore_write(
     return STATUS_CODE_SUCCESS;
 }
 
+static c_store_code_t CStore_writeBuffer(
+    c_store_t cStore,
+    size_t count,
+    c_store_byte_t *buffer,
+    size_t length,
+    c_store_code_t *status_codes)
+{
+    return STATUS_CODE_SUCCESS;
+}
+
 /* This is free software; you can redistribute it and/or modify
  * it under the terms of the GNU Lesser General Public License
  * version 2.1 as published by the Free Software Foundation.
@@ -12,6 +12,14 @@
 
 #include <string.h>
 
+// Private macro definitions.
+
+#ifdef _WIN32
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
 // Private type definitions.
 
 struct context
@@ -29,6 +37,8 @@ static void *_jvmHandle = 0;
 
 static jclass _storeProxyClass = NULL;
 
+static THREAD_LOCAL JNIEnv *_threadEnv = NULL;
+
 static struct
 {
     jmethodID describeException;
@@ -215,6 +225,21 @@ static c_store_code_t CStore_count(
     return status_code;
 }
 
+static c_store_code_t CStore_countMany(
+    c_store_t cStore,
+    size_t count,
+    c_store_handle_t *server_handles,
+    c_store_stamp_t *start_times,
+    c_store_stamp_t *end_times,
+    size_t limit,
+    c_store_long_t *counts,
+    c_store_code_t *status_codes)
+{
+    // The proxy reads one point at a time.
+
+    return STATUS_CODE_UNSUPPORTED;
+}
+
 static c_store_code_t CStore_delete(
     c_store_t cStore,
     size_t count,
@@ -416,13 +441,7 @@ static void CStore_freeValues(
     size_t count,
     c_store_value_t **values)
 {
-    if (values) {
-        for (int i = 0; i < count; ++i) {
-            CStore_free(values[i]);
-            values[i] = NULL;
-        }
-        CStore_free(values);
-    }
+    CStore_freeValueBatch(values); // Values come from CStore_acceptValues.
 }
 
 static c_store_code_t CStore_getQualityCode(
@@ -554,6 +573,47 @@ static c_store_code_t CStore_read(
     return status_code;
 }
 
+static c_store_code_t CStore_readMany(
+    c_store_t cStore,
+    size_t count,
+    c_store_handle_t *server_handles,
+    c_store_stamp_t *start_times,
+    c_store_stamp_t *end_times,
+    size_t limit,
+    size_t *value_count,
+    c_store_value_t ***values,
+    c_store_code_t *status_codes)
+{
+    // The proxy reads one point at a time.
+
+    return STATUS_CODE_UNSUPPORTED;
+}
+
+static c_store_code_t CStore_openCursor(
+    c_store_t cStore,
+    c_store_handle_t server_handle,
+    c_store_stamp_t start_time,
+    c_store_stamp_t end_time,
+    void **cursor)
+{
+    return STATUS_CODE_UNSUPPORTED; // The proxy reads values containers.
+}
+
+static c_store_code_t CStore_fetchCursor(
+    c_store_t cStore,
+    void *cursor,
+    size_t limit,
+    c_store_byte_t *buffer,
+    size_t length,
+    size_t *count)
+{
+    return STATUS_CODE_UNSUPPORTED;
+}
+
+static void CStore_closeCursor(c_store_t cStore, void *cursor)
+{
+}
+
 static c_store_code_t CStore_releaseHandles(
     c_store_t cStore,
     size_t count,
@@ -696,6 +756,11 @@ static bool CStore_supportsDeliver(c_store_t cStore)
     return answer;
 }
 
+static bool CStore_supportsMany(c_store_t cStore)
+{
+    return false;
+}
+
 static bool CStore_supportsPull(c_store_t cStore)
 {
     struct context *context = (struct context *) cStore->context;
@@ -828,6 +893,16 @@ static c_store_code_t CStore_write(
     return status_code;
 }
 
+static c_store_code_t CStore_writeBuffer(
+    c_store_t cStore,
+    size_t count,
+    c_store_byte_t *buffer,
+    size_t length,
+    c_store_code_t *status_codes)
+{
+    return STATUS_CODE_UNSUPPORTED; // The proxy receives a values container.
+}
+
 
 // Private function definitions.
 
@@ -857,16 +932,24 @@ static bool _exceptionDescribed(JNIEnv *env, c_store_logger_t logger)
 
 static JNIEnv *_getJNIEnv(void)
 {
-    JavaVMAttachArgs args;
-    JNIEnv *env;
+    JNIEnv *env = _threadEnv;
+
+    if (env) return env;
+
+    if ((*_javaVM)->GetEnv(_javaVM, (void **) &env, JNI_VERSION_1_4)) {
+        JavaVMAttachArgs args;
 
-    args.version = JNI_VERSION_1_4;
-    args.name = NULL;
-    args.group = NULL;
-    if ((*_javaVM)->AttachCurrentThread(_javaVM, (void **) &env, &args)) {
-        env = NULL;
+        args.version = JNI_VERSION_1_4;
+        args.name = NULL;
+        args.group = NULL;
+        if ((*_javaVM)->AttachCurrentThreadAsDaemon(
+                _javaVM, (void **) &env, &args)) {
+            return NULL;
+        }
     }
 
+    _threadEnv = env; // Threads stay attached once attached.
+
     return env;
 }
 
@@ -0,0 +1,498 @@
+/** Related Values Processing Framework.
+ *
+ * Copyright (C) 2003-2019 Serge Brisson.
+ *
+ * This software is distributable under the LGPL license.
+ * See details at the bottom of this file.
+ *
+ * $Id$
+ */
+
+/* Notes.
+ *
+ * This implementation offers the HandlesMap interface to
+ * stores that support threads. Lookups never lock: they
+ * probe the current table after an acquire load of its
+ * reference. Modifications are serialized by a mutex.
+ *
+ * Entries are never moved within a table: a removed entry
+ * keeps its key with a null (0) value, and is reused if the
+ * key comes back. When the table gets too full, a new table
+ * holding only the live entries is built, then published; the
+ * previous table is retired, since lookups may still be using
+ * it. Retired tables are freed by SharedHandlesMap_reclaim,
+ * called after each resize or clear, or on dispose.
+ *
+ * Each lookup is counted as a reader of the current epoch
+ * (even or odd). SharedHandlesMap_reclaim advances the epoch,
+ * then waits for the readers of the previous one, twice: a
+ * lookup that has read the epoch just before it changed is
+ * then also waited for. Since the retired tables were already
+ * replaced, the lookups started after cannot reach them.
+ *
+ * As a consequence, putting a null (0) value is equivalent
+ * to a remove.
+ */
+#include "SharedHandlesMap.h"
+#include "CStoreImpl.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Private macro defintions.
+
+#define LOAD_FACTOR 0.5
+#define MAXIMUM_CAPACITY (1 << 30)
+
+#ifdef _WIN32
+#define LOAD_ACQUIRE(location) (*(volatile LONG *) (location))
+#define STORE_RELEASE(location, value) \
+    InterlockedExchange((volatile LONG *) (location), (value))
+#define LOAD_TABLE(location) (*(table_t volatile *) (location))
+#define STORE_TABLE(location, table) \
+    InterlockedExchangePointer((PVOID volatile *) (location), (table))
+#define ENTER(counter) InterlockedIncrement((volatile LONG *) (counter))
+#define LEAVE(counter) InterlockedDecrement((volatile LONG *) (counter))
+#define FENCE() MemoryBarrier()
+#define YIELD() SwitchToThread()
+#define LOCK(map) EnterCriticalSection(&(map)->mutex)
+#define UNLOCK(map) LeaveCriticalSection(&(map)->mutex)
+#else
+#define LOAD_ACQUIRE(location) __atomic_load_n((location), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(location, value) \
+    __atomic_store_n((location), (value), __ATOMIC_RELEASE)
+#define LOAD_TABLE(location) __atomic_load_n((location), __ATOMIC_SEQ_CST)
+#define STORE_TABLE(location, table) \
+    __atomic_store_n((location), (table), __ATOMIC_RELEASE)
+#define ENTER(counter) __atomic_add_fetch((counter), 1, __ATOMIC_SEQ_CST)
+#define LEAVE(counter) __atomic_sub_fetch((counter), 1, __ATOMIC_RELEASE)
+#define FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define YIELD() sched_yield()
+#define LOCK(map) pthread_mutex_lock(&(map)->mutex)
+#define UNLOCK(map) pthread_mutex_unlock(&(map)->mutex)
+#endif
+
+// Private type definitions.
+
+typedef struct table *table_t;
+
+#ifdef _WIN32
+typedef unsigned long hash_t;
+#else
+typedef unsigned int hash_t;
+#endif
+
+// Private structure definitions.
+
+struct c_store_shared_handles_map {
+    table_t table;
+    table_t retired;
+    long epoch;
+    long readers[2]; // By epoch parity.
+    size_t size;
+    c_store_handle_t nullKeyValue;
+#ifdef _WIN32
+    CRITICAL_SECTION mutex;
+#else
+    pthread_mutex_t mutex;
+#endif
+};
+
+struct entry {
+    c_store_handle_t key;
+    c_store_handle_t value;
+};
+
+struct table {
+    table_t retired;
+    size_t capacity;
+    size_t used;
+    size_t threshold;
+    struct entry entries[];
+};
+
+// Private forward declarations.
+
+static void _awaitReaders(c_store_shared_handles_map_t map);
+
+static long *_enter(c_store_shared_handles_map_t map);
+
+static size_t _indexFor(table_t table, c_store_handle_t key);
+
+static c_store_handle_t _lookup(table_t table, c_store_handle_t key);
+
+static table_t _newTable(size_t loadSize);
+
+static void _resize(c_store_shared_handles_map_t map);
+
+// Public function definitions.
+
+void SharedHandlesMap_clear(c_store_shared_handles_map_t map)
+{
+    ASSERT(map);
+
+    LOCK(map);
+
+    table_t table = _newTable(0);
+
+    table->retired = map->retired;
+    map->retired = map->table;
+    STORE_TABLE(&map->table, table);
+    STORE_RELEASE(&map->nullKeyValue, 0);
+    map->size = 0;
+
+    UNLOCK(map);
+
+    SharedHandlesMap_reclaim(map);
+}
+
+c_store_shared_handles_map_t SharedHandlesMap_create(size_t initialLoadSize)
+{
+    c_store_shared_handles_map_t map =
+        CStore_allocate(sizeof(struct c_store_shared_handles_map));
+
+    ASSERT(map);
+    map->table = _newTable(initialLoadSize);
+#ifdef _WIN32
+    InitializeCriticalSection(&map->mutex);
+#else
+    pthread_mutex_init(&map->mutex, NULL);
+#endif
+
+    return map;
+}
+
+void SharedHandlesMap_dispose(c_store_shared_handles_map_t map)
+{
+    if (map) {
+        SharedHandlesMap_reclaim(map);
+        CStore_free(map->table);
+        map->table = NULL;
+#ifdef _WIN32
+        DeleteCriticalSection(&map->mutex);
+#else
+        pthread_mutex_destroy(&map->mutex);
+#endif
+        CStore_free(map);
+    }
+}
+
+c_store_handle_t SharedHandlesMap_get(
+    c_store_shared_handles_map_t map,
+    c_store_handle_t key)
+{
+    ASSERT(map);
+
+    if (!key) return LOAD_ACQUIRE(&map->nullKeyValue);
+
+    long *readers = _enter(map);
+    c_store_handle_t value = _lookup(LOAD_TABLE(&map->table), key);
+
+    LEAVE(readers);
+
+    return value;
+}
+
+size_t SharedHandlesMap_getBatch(
+    c_store_shared_handles_map_t map,
+    size_t count,
+    const c_store_handle_t *keys,
+    c_store_handle_t *values)
+{
+    ASSERT(map);
+
+    long *readers = _enter(map);
+    table_t table = LOAD_TABLE(&map->table);
+    size_t found = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        c_store_handle_t key = keys[i];
+        c_store_handle_t value = key?
+            _lookup(table, key): LOAD_ACQUIRE(&map->nullKeyValue);
+
+        values[i] = value;
+        if (value) ++found;
+    }
+
+    LEAVE(readers);
+
+    return found;
+}
+
+c_store_handle_t *SharedHandlesMap_keys(c_store_shared_handles_map_t map)
+{
+    ASSERT(map);
+
+    LOCK(map);
+
+    table_t table = map->table;
+    size_t mapSize = map->size;
+    c_store_handle_t *keys =
+        CStore_allocate((mapSize? mapSize: 1) * sizeof(c_store_handle_t));
+    size_t index = 0;
+
+    ASSERT(keys);
+    if (map->nullKeyValue) keys[index++] = 0;
+    for (size_t i = 0; i < table->capacity; ++i) {
+        if (table->entries[i].value) {
+            ASSERT(index < mapSize);
+            keys[index++] = table->entries[i].key;
+        }
+    }
+    ASSERT(index == mapSize);
+
+    UNLOCK(map);
+
+    return keys;
+}
+
+c_store_handle_t SharedHandlesMap_put(
+    c_store_shared_handles_map_t map,
+    c_store_handle_t key,
+    c_store_handle_t value)
+{
+    ASSERT(map);
+
+    if (!value) return SharedHandlesMap_remove(map, key);
+
+    LOCK(map);
+
+    c_store_handle_t previousValue;
+    bool resized = false;
+
+    if (key) {
+        table_t table = map->table;
+        size_t mask = table->capacity - 1;
+        size_t index = _indexFor(table, key);
+
+        while (table->entries[index].key
+                && table->entries[index].key != key) {
+            index = (index + 1) & mask;
+        }
+
+        struct entry *entry = &table->entries[index];
+
+        previousValue = entry->value;
+        STORE_RELEASE(&entry->value, value);
+        if (!entry->key) {
+            STORE_RELEASE(&entry->key, key);
+            ++table->used;
+        }
+        if (!previousValue) ++map->size;
+        if (table->used > table->threshold) {
+            _resize(map);
+            resized = true;
+        }
+    } else {
+        previousValue = map->nullKeyValue;
+        STORE_RELEASE(&map->nullKeyValue, value);
+        if (!previousValue) ++map->size;
+    }
+
+    UNLOCK(map);
+
+    if (resized) SharedHandlesMap_reclaim(map);
+
+    return previousValue;
+}
+
+void SharedHandlesMap_reclaim(c_store_shared_handles_map_t map)
+{
+    ASSERT(map);
+
+    LOCK(map);
+
+    table_t retired = map->retired;
+
+    map->retired = NULL;
+    if (retired) _awaitReaders(map);
+    while (retired) {
+        table_t next = retired->retired;
+
+        CStore_free(retired);
+        retired = next;
+    }
+
+    UNLOCK(map);
+}
+
+c_store_handle_t SharedHandlesMap_remove(
+    c_store_shared_handles_map_t map,
+    c_store_handle_t key)
+{
+    ASSERT(map);
+
+    LOCK(map);
+
+    c_store_handle_t previousValue;
+
+    if (key) {
+        table_t table = map->table;
+        size_t mask = table->capacity - 1;
+        size_t index = _indexFor(table, key);
+
+        while (table->entries[index].key
+                && table->entries[index].key != key) {
+            index = (index + 1) & mask;
+        }
+
+        previousValue = table->entries[index].value;
+        if (previousValue) STORE_RELEASE(&table->entries[index].value, 0);
+    } else {
+        previousValue = map->nullKeyValue;
+        STORE_RELEASE(&map->nullKeyValue, 0);
+    }
+    if (previousValue) --map->size;
+
+    UNLOCK(map);
+
+    return previousValue;
+}
+
+size_t SharedHandlesMap_size(c_store_shared_handles_map_t map)
+{
+    ASSERT(map);
+
+    LOCK(map);
+
+    size_t size = map->size;
+
+    UNLOCK(map);
+
+    return size;
+}
+
+c_store_handle_t *SharedHandlesMap_values(c_store_shared_handles_map_t map)
+{
+    ASSERT(map);
+
+    LOCK(map);
+
+    table_t table = map->table;
+    size_t mapSize = map->size;
+    c_store_handle_t *values =
+        CStore_allocate((mapSize? mapSize: 1) * sizeof(c_store_handle_t));
+    size_t index = 0;
+
+    ASSERT(values);
+    if (map->nullKeyValue) values[index++] = map->nullKeyValue;
+    for (size_t i = 0; i < table->capacity; ++i) {
+        if (table->entries[i].value) {
+            ASSERT(index < mapSize);
+            values[index++] = table->entries[i].value;
+        }
+    }
+    ASSERT(index == mapSize);
+
+    UNLOCK(map);
+
+    return values;
+}
+
+// Private function definitions.
+
+static void _awaitReaders(c_store_shared_handles_map_t map)
+{
+    for (int pass = 0; pass < 2; ++pass) {
+        long epoch = map->epoch;
+
+        STORE_RELEASE(&map->epoch, epoch + 1);
+        FENCE();
+        while (LOAD_ACQUIRE(&map->readers[epoch & 1])) YIELD();
+    }
+}
+
+static long *_enter(c_store_shared_handles_map_t map)
+{
+    long *readers = &map->readers[LOAD_ACQUIRE(&map->epoch) & 1];
+
+    ENTER(readers);
+
+    return readers;
+}
+
+static size_t _indexFor(table_t table, c_store_handle_t key)
+{
+    hash_t hash = key;
+
+    hash += ~(hash << 9);
+    hash ^=  (hash >> 14);
+    hash +=  (hash << 4);
+    hash ^=  (hash >> 10);
+
+    return hash & (table->capacity - 1);
+}
+
+static c_store_handle_t _lookup(table_t table, c_store_handle_t key)
+{
+    size_t mask = table->capacity - 1;
+
+    for (size_t index = _indexFor(table, key);; index = (index + 1) & mask) {
+        c_store_handle_t entryKey = LOAD_ACQUIRE(&table->entries[index].key);
+
+        if (entryKey == key) return LOAD_ACQUIRE(&table->entries[index].value);
+        if (!entryKey) return 0;
+    }
+}
+
+static table_t _newTable(size_t loadSize)
+{
+    size_t initialCapacity = 1 + (size_t) (loadSize / LOAD_FACTOR);
+    size_t capacity;
+
+    ASSERT(initialCapacity <= MAXIMUM_CAPACITY);
+    for (capacity = 2; capacity < initialCapacity; capacity <<= 1);
+
+    table_t table = CStore_allocate(
+        sizeof(struct table) + capacity * sizeof(struct entry));
+
+    ASSERT(table);
+    table->capacity = capacity;
+    table->threshold = capacity * LOAD_FACTOR;
+
+    return table;
+}
+
+static void _resize(c_store_shared_handles_map_t map)
+{
+    table_t oldTable = map->table;
+    table_t table = _newTable(2 * map->size);
+    size_t mask = table->capacity - 1;
+
+    for (size_t i = 0; i < oldTable->capacity; ++i) {
+        struct entry *entry = &oldTable->entries[i];
+
+        if (entry->value) {
+            size_t index = _indexFor(table, entry->key);
+
+            while (table->entries[index].key) index = (index + 1) & mask;
+            table->entries[index] = *entry;
+            ++table->used;
+        }
+    }
+
+    oldTable->retired = map->retired;
+    map->retired = oldTable;
+    STORE_TABLE(&map->table, table);
+}
+
+/* This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
@@ -24,12 +24,15 @@ public enum ForwarderMessages
     AUTHENTICATION_FAILED,
     AUTHORIZED,
     AUTHORIZED_ROLE,
+    BAD_BINARY_FRAME,
+    BAD_BINARY_POINT,
     BAD_CONNECTION,
     BAD_FILTER_UUID,
     BAD_MODULE_UUID,
     BATCH_SIZE_LIMIT,
     BATCH_TIMEOUT,
     BATCH_WAIT,
+    BINARY_FRAMING,
     CLIENT,
     COMPRESSED_SUFFIX,
     CONFIRM,
@@ -10,11 +10,14 @@
 
 package org.rvpf.forwarder.input;
 
+import java.io.BufferedInputStream;
+import java.io.DataInputStream;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
 import java.io.Reader;
 import java.io.Serializable;
+import java.io.StreamCorruptedException;
 
 import java.net.InetSocketAddress;
 import java.net.ServerSocket;
@@ -22,6 +25,9 @@ import java.net.Socket;
 import java.net.SocketAddress;
 import java.net.SocketException;
 
+import java.nio.BufferUnderflowException;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 import java.nio.charset.StandardCharsets;
 
 import java.rmi.AccessException;
@@ -46,6 +52,7 @@ import javax.net.ssl.SSLServerSocket;
 import javax.net.ssl.SSLSocket;
 
 import org.rvpf.base.BaseMessages;
+import org.rvpf.base.DateTime;
 import org.rvpf.base.ElapsedTime;
 import org.rvpf.base.logger.Logger;
 import org.rvpf.base.logger.Message;
@@ -58,6 +65,8 @@ import org.rvpf.base.tool.Inet;
 import org.rvpf.base.tool.Require;
 import org.rvpf.base.tool.ValueConverter;
 import org.rvpf.base.util.container.KeyedGroups;
+import org.rvpf.base.value.PointValue;
+import org.rvpf.base.value.VersionedValue;
 import org.rvpf.base.xml.XMLDocument;
 import org.rvpf.base.xml.XMLElement;
 import org.rvpf.base.xml.streamer.Streamer;
@@ -302,6 +311,9 @@ public final class MessagesPortServerModule
     /** Flush element name. */
     public static final String FLUSH_ELEMENT = "flush";
 
+    /** Framing attribute. */
+    public static final String FRAMING_ATTRIBUTE = "framing";
+
     /** ID attribute. */
     public static final String ID_ATTRIBUTE = "id";
 
@@ -320,6 +332,15 @@ public final class MessagesPortServerModule
     /** User attribute. */
     public static final String USER_ATTRIBUTE = "user";
 
+    private static final int _BINARY_DELETED_FLAG = 0x01;
+    private static final int _BINARY_FLUSH_FLAG = 0x01;
+    private static final String _BINARY_FRAMING = "binary";
+    private static final int _BINARY_MESSAGES_FRAME = 'M';
+    private static final int _BINARY_NEW_POINT_FLAG = 0x02;
+    private static final int _BINARY_RAW_STAMP_FLAG = 0x04;
+    private static final int _BINARY_STATE_FLAG = 0x08;
+    private static final int _BINARY_VALUE_FLAG = 0x10;
+
     private final BlockingQueue<List<Serializable>> _queue =
         new SynchronousQueue<>();
     private final Realm _realm = new Realm();
@@ -646,6 +667,15 @@ public final class MessagesPortServerModule
 
                         break;
                     }
+
+                    if (_binary) {
+                        // The client waits for the login response before
+                        // sending its first frame.
+
+                        new _BinaryDecoder(_input).run();
+
+                        break;
+                    }
                 }
 
                 _close();
@@ -744,6 +774,16 @@ public final class MessagesPortServerModule
          * parsing.</p>
          */
         void _done()
+        {
+            _done(false);
+        }
+
+        /**
+         * Responds with 'done'.
+         *
+         * @param binary True to accept the binary framing.
+         */
+        void _done(final boolean binary)
         {
             final StringBuilder stringBuilder = new StringBuilder();
 
@@ -756,6 +796,12 @@ public final class MessagesPortServerModule
                 _reference = null;
             }
 
+            if (binary) {
+                stringBuilder.append(" " + FRAMING_ATTRIBUTE + "='");
+                stringBuilder.append(_BINARY_FRAMING);
+                stringBuilder.append("'");
+            }
+
             stringBuilder.append("/>\n");
 
             _respond(stringBuilder);
@@ -903,7 +949,7 @@ public final class MessagesPortServerModule
                 _socket = socket;
 
                 try {
-                    _input = socket.getInputStream();
+                    _input = new BufferedInputStream(socket.getInputStream());
                     _output = socket.getOutputStream();
 
                     final XMLDocument.ElementReader reader =
@@ -993,6 +1039,16 @@ public final class MessagesPortServerModule
             _time = time;
         }
 
+        /**
+         * Sets the binary indicator.
+         *
+         * @param binary The binary indicator.
+         */
+        void _setBinary(final boolean binary)
+        {
+            _binary = binary;
+        }
+
         @CheckReturnValue
         private boolean _respond(@Nonnull final StringBuilder response)
         {
@@ -1015,6 +1071,7 @@ public final class MessagesPortServerModule
         }
 
         private boolean _authorized;
+        private volatile boolean _binary;
         private final Optional<ElapsedTime> _batchWait;
         private Optional<String> _client;
         private final XMLDocument _document = new XMLDocument();
@@ -1031,6 +1088,194 @@ public final class MessagesPortServerModule
         private volatile Socket _socket;
         private volatile long _time;
 
+        /**
+         * Binary decoder.
+         *
+         * <p>Each frame holds a type byte, a little-endian 32 bits payload
+         * length and the payload. Unsigned integers are sent 7 bits at a
+         * time, low order first; strings are sent as their UTF-8 length
+         * followed by their UTF-8 bytes. Point names are interned on first
+         * use and are then referenced by their index.</p>
+         *
+         * <p>Takes over the input once the login has accepted the binary
+         * framing.</p>
+         */
+        private final class _BinaryDecoder
+        {
+            /**
+             * Constructs an instance.
+             *
+             * @param input The input stream.
+             */
+            _BinaryDecoder(@Nonnull final InputStream input)
+            {
+                _input = new DataInputStream(input);
+            }
+
+            /**
+             * Runs until the end of the input.
+             *
+             * @throws IOException On I/O exception.
+             * @throws XMLDocument.ParseException When not authorized.
+             */
+            void run()
+                throws IOException, XMLDocument.ParseException
+            {
+                for (;;) {
+                    final int type = _input.read();
+
+                    if (type < 0) {
+                        break;
+                    }
+
+                    if (Character.isWhitespace(type)) {
+                        continue;    // Left after the XML login.
+                    }
+
+                    final int length = Integer.reverseBytes(_input.readInt());
+
+                    if (length < 0) {
+                        throw new StreamCorruptedException(
+                            Message.format(
+                                ForwarderMessages.BAD_BINARY_FRAME,
+                                Integer.valueOf(type)));
+                    }
+
+                    final byte[] payload = new byte[length];
+
+                    _input.readFully(payload);
+                    _payload = ByteBuffer
+                        .wrap(payload)
+                        .order(ByteOrder.LITTLE_ENDIAN);
+
+                    try {
+                        if (type != _BINARY_MESSAGES_FRAME) {
+                            throw new StreamCorruptedException(
+                                Message.format(
+                                    ForwarderMessages.BAD_BINARY_FRAME,
+                                    Integer.valueOf(type)));
+                        }
+
+                        _messages();
+                    } catch (final BufferUnderflowException exception) {
+                        throw new StreamCorruptedException(
+                            Message.format(
+                                ForwarderMessages.BAD_BINARY_FRAME,
+                                Integer.valueOf(type)));
+                    }
+                }
+            }
+
+            private void _messages()
+                throws StreamCorruptedException, XMLDocument.ParseException
+            {
+                _checkAuthorized();
+                _reference = String.valueOf(_readUnsigned());
+
+                final boolean flush = (_payload.get() & _BINARY_FLUSH_FLAG)
+                    != 0;
+
+                while (_payload.hasRemaining()) {
+                    _addMessage(_readValue());
+                }
+
+                if (flush) {
+                    _flush(ForwarderMessages.FLUSH_REQUEST, true);
+                }
+
+                _done();
+            }
+
+            private String _readString()
+            {
+                final int length = (int) _readUnsigned();
+
+                if ((length < 0) || (length > _payload.remaining())) {
+                    throw new BufferUnderflowException();
+                }
+
+                final String string = new String(
+                    _payload.array(),
+                    _payload.arrayOffset() + _payload.position(),
+                    length,
+                    StandardCharsets.UTF_8);
+
+                _payload.position(_payload.position() + length);
+
+                return string;
+            }
+
+            private long _readUnsigned()
+            {
+                long unsigned = 0;
+
+                for (int shift = 0; shift < Long.SIZE; shift += 7) {
+                    final byte next = _payload.get();
+
+                    unsigned |= (long) (next & 0x7F) << shift;
+
+                    if (next >= 0) {
+                        break;
+                    }
+                }
+
+                return unsigned;
+            }
+
+            private PointValue _readValue()
+                throws StreamCorruptedException
+            {
+                final int flags = _payload.get();
+                final long index = _readUnsigned();
+                final String point;
+
+                if ((flags & _BINARY_NEW_POINT_FLAG) != 0) {
+                    if (index != _points.size()) {
+                        throw new StreamCorruptedException(
+                            Message.format(
+                                ForwarderMessages.BAD_BINARY_POINT,
+                                Long.valueOf(index)));
+                    }
+
+                    point = _readString();
+                    _points.add(point);
+                } else {
+                    if ((index < 0) || (index >= _points.size())) {
+                        throw new StreamCorruptedException(
+                            Message.format(
+                                ForwarderMessages.BAD_BINARY_POINT,
+                                Long.valueOf(index)));
+                    }
+
+                    point = _points.get((int) index);
+                }
+
+                final Optional<DateTime> stamp = ((flags
+                        & _BINARY_RAW_STAMP_FLAG) != 0)? Optional
+                            .of(
+                                DateTime.fromRaw(
+                                    _payload.getLong())): DateTime
+                                            .fromString(
+                                                    Optional.of(_readString()));
+
+                if ((flags & _BINARY_DELETED_FLAG) != 0) {
+                    return new VersionedValue.Deleted(point, stamp);
+                }
+
+                final String state = ((flags & _BINARY_STATE_FLAG) != 0)
+                    ? _readString(): null;
+                final String value = ((flags & _BINARY_VALUE_FLAG) != 0)
+                    ? _readString(): null;
+
+                return new PointValue(point, stamp, state, value);
+            }
+
+            private final DataInputStream _input;
+            private ByteBuffer _payload;
+            private final List<String> _points = new ArrayList<>();
+        }
+
+
         /**
          * Flush handler.
          */
@@ -1150,7 +1395,17 @@ public final class MessagesPortServerModule
                     throw new XMLDocument.ParseException(exception);
                 }
 
-                _done();
+                final boolean binary = element
+                    .getAttributeValue(FRAMING_ATTRIBUTE, Optional.empty())
+                    .filter(_BINARY_FRAMING::equals)
+                    .isPresent();
+
+                if (binary) {
+                    _getLogger().debug(ForwarderMessages.BINARY_FRAMING);
+                }
+
+                _done(binary);
+                _setBinary(binary);
 
                 return element;
             }
@@ -122,6 +122,9 @@ import org.rvpf.service.ServiceMessages;
  *   <li>A null state or value is indicated by a missing field.</li>
  *   <li>The request ID is used for synchronization verification and must be
  *     returned verbatim.</li>
+ *   <li>The program may read the requests already available before
+ *     responding to them as a batch; the responses must keep the
+ *     order of the requests.</li>
  *   <li>Leading spaces are stripped from the lines received from the process;
  *     resulting empty lines are ignored.</li>
  *   <li>The state is encoded by replacing ']' by '[]' and '[' by ']['.</li>
@@ -84,6 +84,9 @@ public enum StoreMessages
     LOG_LEVEL_UNKNOWN,
     LOST_UPDATE_QUEUE,
     MARKED_VALUE,
+    NATIVE_CALLS,
+    NATIVE_CONVERSION_TIME,
+    NATIVE_STORE_TIME,
     NO_CODE_FOR_QUALITY,
     NO_NAME_FOR_QUALITY,
     NO_POINT_FOR_POLATE,
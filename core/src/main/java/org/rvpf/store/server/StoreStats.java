@@ -253,6 +253,18 @@ public final class StoreStats
                 String.valueOf(getArchived()));
         }
 
+        if (getNativeCalls() > 0) {
+            addLine(
+                StoreMessages.NATIVE_CALLS,
+                String.valueOf(getNativeCalls()));
+            addLine(
+                StoreMessages.NATIVE_STORE_TIME,
+                nanosToString(getNativeStoreTime()));
+            addLine(
+                StoreMessages.NATIVE_CONVERSION_TIME,
+                nanosToString(getNativeConversionTime()));
+        }
+
         super.buildText();
     }
 
@@ -265,6 +277,10 @@ public final class StoreStats
 
         clone._archived = new AtomicLong(getArchived());
         clone._deleted = new AtomicLong(getDeleted());
+        clone._nativeCalls = new AtomicLong(getNativeCalls());
+        clone._nativeConversionTime = new AtomicLong(
+            getNativeConversionTime());
+        clone._nativeStoreTime = new AtomicLong(getNativeStoreTime());
         clone._noticesBatched = new AtomicLong(getNoticesBatched());
         clone._noticesBatches = new AtomicInteger(getNoticesBatches());
         clone._noticesSent = new AtomicLong(getNoticesSent());
@@ -310,6 +326,39 @@ public final class StoreStats
         return _deleted.get();
     }
 
+    /**
+     * Gets the number of native store calls.
+     *
+     * @return The number of native store calls.
+     */
+    @CheckReturnValue
+    public long getNativeCalls()
+    {
+        return _nativeCalls.get();
+    }
+
+    /**
+     * Gets the native conversion time.
+     *
+     * @return The native conversion time.
+     */
+    @CheckReturnValue
+    public long getNativeConversionTime()
+    {
+        return _nativeConversionTime.get();
+    }
+
+    /**
+     * Gets the native store time.
+     *
+     * @return The native store time.
+     */
+    @CheckReturnValue
+    public long getNativeStoreTime()
+    {
+        return _nativeStoreTime.get();
+    }
+
     /**
      * Gets the number of notices batched.
      *
@@ -545,6 +594,26 @@ public final class StoreStats
         _sessionsOpened.incrementAndGet();
     }
 
+    /**
+     * Sets the native stats.
+     *
+     * <p>The native values are totals kept since the native library was
+     * loaded; the intermediate stats get their differences.</p>
+     *
+     * @param calls The number of calls to the native store.
+     * @param storeTime The native store time in nanoseconds.
+     * @param conversionTime The native conversion time in nanoseconds.
+     */
+    public void setNative(
+            final long calls,
+            final long storeTime,
+            final long conversionTime)
+    {
+        _nativeCalls.set(calls);
+        _nativeStoreTime.set(storeTime);
+        _nativeConversionTime.set(conversionTime);
+    }
+
     /** {@inheritDoc}
      */
     @Override
@@ -553,6 +622,9 @@ public final class StoreStats
         final StoreStats stats = (StoreStats) snapshot;
 
         _deleted.addAndGet(-stats.getDeleted());
+        _nativeCalls.addAndGet(-stats.getNativeCalls());
+        _nativeConversionTime.addAndGet(-stats.getNativeConversionTime());
+        _nativeStoreTime.addAndGet(-stats.getNativeStoreTime());
         _noticesBatches.addAndGet(-stats.getNoticesBatches());
         _noticesBatched.addAndGet(-stats.getNoticesBatched());
         _noticesSent.addAndGet(-stats.getNoticesSent());
@@ -580,6 +652,9 @@ public final class StoreStats
 
     private AtomicLong _archived = new AtomicLong();
     private AtomicLong _deleted = new AtomicLong();
+    private AtomicLong _nativeCalls = new AtomicLong();
+    private AtomicLong _nativeConversionTime = new AtomicLong();
+    private AtomicLong _nativeStoreTime = new AtomicLong();
     private AtomicLong _noticesBatched = new AtomicLong();
     private AtomicInteger _noticesBatches = new AtomicInteger();
     private AtomicLong _noticesSent = new AtomicLong();
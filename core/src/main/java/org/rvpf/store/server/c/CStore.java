@@ -13,6 +13,8 @@ package org.rvpf.store.server.c;
 import java.io.File;
 import java.io.Serializable;
 
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 import java.nio.charset.Charset;
 import java.nio.charset.StandardCharsets;
 
@@ -229,21 +231,22 @@ final class CStore
     }
 
     /**
-     * Counts values for a point.
+     * Counts values for multiple points in a single call.
      *
-     * @param uuid The UUID for the point.
+     * @param uuids The UUIDs for the points.
      * @param startTime The inclusive start time.
      * @param endTime The exclusive end time.
-     * @param limit A limit for the number of values.
+     * @param limit A limit for the number of values per point.
      *
-     * @return A container for the values.
+     * @return The counts, in the order of the UUIDs.
      *
-     * @throws Status.FailedException When the count operation fails.
+     * @throws Status.FailedException When the count operation fails for any
+     *         of the points.
      */
     @Nonnull
     @CheckReturnValue
-    Long count(
-            @Nonnull final UUID uuid,
+    long[] count(
+            @Nonnull final List<UUID> uuids,
             @Nonnull final DateTime startTime,
             @Nonnull final DateTime endTime,
             final int limit)
@@ -251,21 +254,34 @@ final class CStore
     {
         _protectSingleThread();
 
-        final int serverHandle = getServerHandle(uuid);
-        final AtomicLong count = new AtomicLong(-1);
-        final int statusCode = count(
+        final int[] serverHandles = new int[uuids.size()];
+        final long[] startTimes = new long[serverHandles.length];
+        final long[] endTimes = new long[serverHandles.length];
+        final long[] counts = new long[serverHandles.length];
+        final int[] statusCodes = new int[serverHandles.length];
+
+        for (int i = 0; i < serverHandles.length; ++i) {
+            serverHandles[i] = getServerHandle(uuids.get(i));
+            startTimes[i] = startTime.toRaw();
+            endTimes[i] = endTime.toRaw();
+        }
+
+        final int statusCode = countMany(
             _contextHandle,
-            serverHandle,
-            startTime.toRaw(),
-            endTime.toRaw(),
+            serverHandles,
+            startTimes,
+            endTimes,
             limit,
-            count);
+            counts,
+            statusCodes);
 
         if (statusCode != Status.SUCCESS_CODE) {
             throw new Status.FailedException(statusCode);
         }
 
-        return Long.valueOf(count.get());
+        _checkStatusCodes(statusCodes);
+
+        return counts;
     }
 
     /**
@@ -554,6 +570,23 @@ final class CStore
         return _envProperties;
     }
 
+    /**
+     * Gets the metrics.
+     *
+     * <p>The metrics are kept by the native library for all its
+     * instances.</p>
+     *
+     * @return The metrics.
+     */
+    @Nonnull
+    @CheckReturnValue
+    Metrics getMetrics()
+    {
+        final long[] metrics = metrics();
+
+        return new Metrics((metrics != null)? metrics: new long[0]);
+    }
+
     /**
      * Gets a code for a quality name.
      *
@@ -791,40 +824,79 @@ final class CStore
     }
 
     /**
-     * Reads values for a point.
+     * Reads values for multiple points in a single call.
      *
-     * @param uuid The UUID for the point.
+     * <p>The values are grouped by point, in the order of the UUIDs. Without
+     * a limit, or above the cursor threshold, each point is read through a
+     * cursor.</p>
+     *
+     * @param uuids The UUIDs for the points.
      * @param startTime The inclusive start time.
      * @param endTime The exclusive end time.
-     * @param limit A limit for the number of values.
+     * @param limit A limit for the number of values per point.
      *
      * @return A container for the values.
      *
-     * @throws Status.FailedException When the read operation fails.
+     * @throws Status.FailedException When the read operation fails for any
+     *         of the points.
      */
+    @Nonnull
+    @CheckReturnValue
     Values read(
-            final UUID uuid,
-            final DateTime startTime,
-            final DateTime endTime,
+            @Nonnull final List<UUID> uuids,
+            @Nonnull final DateTime startTime,
+            @Nonnull final DateTime endTime,
             final int limit)
         throws Status.FailedException
     {
         _protectSingleThread();
 
-        final int serverHandle = getServerHandle(uuid);
+        if ((limit <= 0) || (limit > _CURSOR_READ_THRESHOLD)) {
+            final Values values = new Values();
+
+            for (final UUID uuid: uuids) {
+                final int statusCode = _readCursor(
+                    getServerHandle(uuid),
+                    startTime.toRaw(),
+                    endTime.toRaw(),
+                    limit,
+                    values);
+
+                if (statusCode != Status.SUCCESS_CODE) {
+                    throw new Status.FailedException(statusCode);
+                }
+            }
+
+            return values;
+        }
+
+        final int[] serverHandles = new int[uuids.size()];
+        final long[] startTimes = new long[serverHandles.length];
+        final long[] endTimes = new long[serverHandles.length];
+        final int[] statusCodes = new int[serverHandles.length];
         final Values values = new Values();
-        final int statusCode = read(
+
+        for (int i = 0; i < serverHandles.length; ++i) {
+            serverHandles[i] = getServerHandle(uuids.get(i));
+            startTimes[i] = startTime.toRaw();
+            endTimes[i] = endTime.toRaw();
+        }
+
+        final int statusCode = readMany(
             _contextHandle,
-            serverHandle,
-            startTime.toRaw(),
-            endTime.toRaw(),
+            serverHandles,
+            startTimes,
+            endTimes,
             limit,
-            values);
+            values,
+            statusCodes);
 
         if (statusCode != Status.SUCCESS_CODE) {
             throw new Status.FailedException(statusCode);
         }
 
+        _checkStatusCodes(statusCodes);
+
         return values;
     }
 
@@ -1308,7 +1380,21 @@ final class CStore
             values.add(handle, time, deleted, quality, valueBytes);
         }
 
-        final int statusCode = write(_contextHandle, values, statusCodes);
+        final int statusCode;
+
+        if (values.bytesLength() >= _BUFFER_WRITE_THRESHOLD) {
+            final ByteBuffer buffer = values
+                .toBuffer(_getValueLayout(), _writeBuffer.getAndSet(null));
+
+            statusCode = writeBuffer(
+                _contextHandle,
+                buffer,
+                values.size(),
+                statusCodes);
+            _writeBuffer.set(buffer);
+        } else {
+            statusCode = write(_contextHandle, values, statusCodes);
+        }
 
         if (statusCode != Status.SUCCESS_CODE) {
             throw new Status.FailedException(statusCode);
@@ -1322,6 +1408,29 @@ final class CStore
         return left == right;
     }
 
+    private static void _checkStatusCodes(
+            final int[] statusCodes)
+        throws Status.FailedException
+    {
+        for (final int statusCode: statusCodes) {
+            if (statusCode != Status.SUCCESS_CODE) {
+                throw new Status.FailedException(statusCode);
+            }
+        }
+    }
+
+    private int[] _getValueLayout()
+    {
+        int[] valueLayout = _valueLayout;
+
+        if (valueLayout == null) {
+            valueLayout = valueLayout();
+            _valueLayout = valueLayout;
+        }
+
+        return valueLayout;
+    }
+
     private boolean _preempt(final CStoreServiceAppImpl storeAppImpl)
     {
         if (storeAppImpl != _storeAppImpl) {
@@ -1344,6 +1453,77 @@ final class CStore
         }
     }
 
+    private int _readCursor(
+            final int serverHandle,
+            final long startTime,
+            final long endTime,
+            final int limit,
+            final Values values)
+    {
+        final AtomicLong cursorHandle = new AtomicLong();
+        int statusCode = openCursor(
+            _contextHandle,
+            serverHandle,
+            startTime,
+            endTime,
+            cursorHandle);
+
+        if (statusCode != Status.SUCCESS_CODE) {
+            return statusCode;
+        }
+
+        final int[] valueLayout = _getValueLayout();
+        final AtomicLong count = new AtomicLong();
+        ByteBuffer buffer = _readBuffer.getAndSet(null);
+
+        try {
+            for (;;) {
+                if (buffer == null) {
+                    buffer = ByteBuffer.allocateDirect(_CURSOR_BUFFER_CAPACITY);
+                    buffer.order(ByteOrder.nativeOrder());
+                }
+
+                final int remaining = (limit > 0)? limit - values.size(): 0;
+
+                statusCode = fetchCursor(
+                    _contextHandle,
+                    cursorHandle.get(),
+                    remaining,
+                    buffer,
+                    count);
+
+                if ((statusCode == Status.BUFFER_TOO_SMALL_CODE)
+                        && (buffer.capacity() < _CURSOR_BUFFER_LIMIT)) {
+                    // The next value may not fit: retries with a larger buffer.
+                    buffer = ByteBuffer.allocateDirect(2 * buffer.capacity());
+                    buffer.order(ByteOrder.nativeOrder());
+
+                    continue;
+                }
+
+                if ((statusCode != Status.SUCCESS_CODE)
+                        || (count.get() == 0)) {
+                    break;
+                }
+
+                values.addBuffer(valueLayout, buffer, (int) count.get());
+
+                if ((limit > 0) && (values.size() >= limit)) {
+                    break;
+                }
+            }
+        } finally {
+            closeCursor(_contextHandle, cursorHandle.get());
+
+            if ((buffer != null)
+                    && (buffer.capacity() == _CURSOR_BUFFER_CAPACITY)) {
+                _readBuffer.set(buffer);
+            }
+        }
+
+        return statusCode;
+    }
+
     private int[] _serverHandles(final Collection<Point> points)
     {
         final int count = points.size();
@@ -1493,6 +1673,16 @@ final class CStore
      */
     private native void closeLibrary(final long libraryHandle);
 
+    /**
+     * Closes a read cursor.
+     *
+     * @param contextHandle The implementation context handle.
+     * @param cursorHandle The cursor handle.
+     */
+    private native void closeCursor(
+            final long contextHandle,
+            final long cursorHandle);
+
     /**
      * Connects.
      *
@@ -1534,6 +1724,28 @@ final class CStore
             final int limit,
             final AtomicLong count);
 
+    /**
+     * Counts values for multiple points.
+     *
+     * @param contextHandle The implementation context handle.
+     * @param serverHandles The server handles for the points.
+     * @param startTimes The inclusive start times.
+     * @param endTimes The exclusive end times.
+     * @param limit A limit for the number of values per point.
+     * @param counts The individual counts.
+     * @param statusCodes The individual status codes.
+     *
+     * @return A status code.
+     */
+    private native int countMany(
+            final long contextHandle,
+            final int[] serverHandles,
+            final long[] startTimes,
+            final long[] endTimes,
+            final int limit,
+            final long[] counts,
+            final int[] statusCodes);
+
     /**
      * Deletes points values.
      *
@@ -1594,6 +1806,28 @@ final class CStore
             final int[] serverHandles,
             final int[] statusCodes);
 
+    /**
+     * Fetches values from a read cursor.
+     *
+     * <p>The values are laid out in the buffer as for a write; a count of 0
+     * means that the cursor is exhausted, unless the status code is
+     * {@link Status#BUFFER_TOO_SMALL_CODE}.</p>
+     *
+     * @param contextHandle The implementation context handle.
+     * @param cursorHandle The cursor handle.
+     * @param limit A limit for the number of values (0 for none).
+     * @param buffer The direct buffer receiving the values.
+     * @param count A container for the number of values fetched.
+     *
+     * @return A status code.
+     */
+    private native int fetchCursor(
+            final long contextHandle,
+            final long cursorHandle,
+            final int limit,
+            final ByteBuffer buffer,
+            final AtomicLong count);
+
     /**
      * Frees the implementation context.
      *
@@ -1662,6 +1896,33 @@ final class CStore
      */
     private native int interrupt(final long contextHandle);
 
+    /**
+     * Returns the metrics.
+     *
+     * @return The metrics (see Metrics.h).
+     */
+    private native long[] metrics();
+
+    /**
+     * Opens a read cursor.
+     *
+     * <p>The cursor covers the same values as a read without limit.</p>
+     *
+     * @param contextHandle The implementation context handle.
+     * @param serverHandle The server handle for the point.
+     * @param startTime The inclusive start time.
+     * @param endTime The exclusive end time.
+     * @param cursorHandle A container for the cursor handle.
+     *
+     * @return A status code.
+     */
+    private native int openCursor(
+            final long contextHandle,
+            final int serverHandle,
+            final long startTime,
+            final long endTime,
+            final AtomicLong cursorHandle);
+
     /**
      * Opens a library.
      *
@@ -1701,6 +1962,28 @@ final class CStore
             final int limit,
             final Values container);
 
+    /**
+     * Reads values for multiple points.
+     *
+     * @param contextHandle The implementation context handle.
+     * @param serverHandles The server handles for the points.
+     * @param startTimes The inclusive start times.
+     * @param endTimes The exclusive end times.
+     * @param limit A limit for the number of values per point.
+     * @param container A container for the values.
+     * @param statusCodes The individual status codes.
+     *
+     * @return A status code.
+     */
+    private native int readMany(
+            final long contextHandle,
+            final int[] serverHandles,
+            final long[] startTimes,
+            final long[] endTimes,
+            final int limit,
+            final Values container,
+            final int[] statusCodes);
+
     /**
      * Releases handles.
      *
@@ -1829,6 +2112,15 @@ final class CStore
             final long contextHandle,
             final byte[] charsetName);
 
+    /**
+     * Returns the layout of a value in a values buffer.
+     *
+     * @return The offsets of the handle, stamp, deleted, quality, size and
+     *         value fields, followed by the size field length and the
+     *         alignment of each value.
+     */
+    private native int[] valueLayout();
+
     /**
      * Writes points values.
      *
@@ -1843,11 +2135,31 @@ final class CStore
             final Values values,
             final int[] statusCodes);
 
+    /**
+     * Writes points values from a direct buffer.
+     *
+     * @param contextHandle The implementation context handle.
+     * @param buffer The direct buffer holding the values.
+     * @param count The number of values in the buffer.
+     * @param statusCodes The individual status codes.
+     *
+     * @return A status code.
+     */
+    private native int writeBuffer(
+            final long contextHandle,
+            final ByteBuffer buffer,
+            final int count,
+            final int[] statusCodes);
+
     /** Native library for this class. */
     public static final String LIBRARY = "rvpf-c-store";
 
     /**  */
 
+    private static final int _BUFFER_WRITE_THRESHOLD = 64 * 1024;
+    private static final int _CURSOR_BUFFER_CAPACITY = 64 * 1024;
+    private static final int _CURSOR_BUFFER_LIMIT = 16 * 1024 * 1024;
+    private static final int _CURSOR_READ_THRESHOLD = 1000;
     private static final boolean _IMPLEMENTED;
     private static final Logger _LOGGER = Logger.getInstance(CStore.class);
     private static final Integer _NO_CODE = Integer.valueOf(0);
@@ -1883,6 +2195,8 @@ final class CStore
     private final Map<String, Integer> _qualityCodes = new HashMap<>();
     private final Map<Integer, String> _qualityNames = new HashMap<>();
     private final SynchronousQueue<Runnable> _queue = new SynchronousQueue<>();
+    private final AtomicReference<ByteBuffer> _readBuffer =
+        new AtomicReference<>();
     private final Map<UUID, Integer> _serverHandles = new HashMap<>();
     private boolean _started;
     private volatile CStoreServiceAppImpl _storeAppImpl;
@@ -1895,6 +2209,9 @@ final class CStore
     private Boolean _supportsThreads;
     private final AtomicReference<ServiceThread> _thread =
         new AtomicReference<>();
+    private volatile int[] _valueLayout;
+    private final AtomicReference<ByteBuffer> _writeBuffer =
+        new AtomicReference<>();
 
     /**
      * Task.
@@ -272,6 +272,8 @@ public class CStoreServiceAppImpl
      */
     void onServerStop()
     {
+        updateStats();    // Keeps the final metrics.
+
         if (_notifierThread != null) {
             _notifierThread.stop();
             _notifierThread = null;
@@ -285,6 +287,34 @@ public class CStoreServiceAppImpl
         _resolve();
     }
 
+    /**
+     * Updates the stats with the metrics of the native store bridge.
+     */
+    void updateStats()
+    {
+        final CStoreServer server = _server;
+
+        if (server == null) {
+            return;
+        }
+
+        final Metrics metrics = server.getCStore().getMetrics();
+        long calls = 0;
+        long storeTime = 0;
+        long conversionTime = 0;
+
+        for (final Metrics.Function function: Metrics.Function.values()) {
+            if (function.isConversion()) {
+                conversionTime += metrics.getNanos(function);
+            } else {
+                calls += metrics.getCalls(function);
+                storeTime += metrics.getNanos(function);
+            }
+        }
+
+        getStoreStats().setNative(calls, storeTime, conversionTime);
+    }
+
     /**
      * Wakes up the notifier.
      */
@@ -39,8 +39,28 @@ public final class CStoreServiceImpl
     @Override
     protected MetadataServiceApp newMetadataServiceApp()
     {
-        return new CStoreServiceAppImpl();
+        final CStoreServiceAppImpl cStoreAppImpl = new CStoreServiceAppImpl();
+
+        _cStoreAppImpl = cStoreAppImpl;
+
+        return cStoreAppImpl;
     }
+
+    /** {@inheritDoc}
+     */
+    @Override
+    protected void updateStats()
+    {
+        final CStoreServiceAppImpl cStoreAppImpl = _cStoreAppImpl;
+
+        if (cStoreAppImpl != null) {
+            cStoreAppImpl.updateStats();
+        }
+
+        super.updateStats();
+    }
+
+    private volatile CStoreServiceAppImpl _cStoreAppImpl;
 }
 
 /* This is free software; you can redistribute it and/or modify
@@ -0,0 +1,216 @@
+/** Related Values Processing Framework.
+ *
+ * Copyright (c) 2003-2019 Serge Brisson.
+ *
+ * This software is distributable under the LGPL license.
+ * See details at the bottom of this file.
+ *
+ * $Id$
+ */
+
+package org.rvpf.store.server.c;
+
+import java.util.Arrays;
+
+import javax.annotation.CheckReturnValue;
+import javax.annotation.Nonnull;
+
+/**
+ * Metrics.
+ *
+ * <p>A snapshot of the metrics kept by the native store bridge. The times
+ * of the implementation functions exclude the JNI conversions, which are
+ * measured by the accept and return values functions.</p>
+ */
+public final class Metrics
+{
+    /**
+     * Constructs an instance.
+     *
+     * @param metrics The metrics from native code.
+     */
+    Metrics(@Nonnull final long[] metrics)
+    {
+        _metrics = metrics;
+    }
+
+    /**
+     * Gets the latency buckets for a function.
+     *
+     * <p>The bucket at index <code>i</code> counts the calls which took
+     * from 2^i to 2^(i+1) nanoseconds; the last bucket is open.</p>
+     *
+     * @param function The function.
+     *
+     * @return The latency buckets.
+     */
+    @Nonnull
+    @CheckReturnValue
+    public long[] getBuckets(@Nonnull final Function function)
+    {
+        final int offset = _offset(function);
+
+        if (offset < 0) {
+            return new long[0];
+        }
+
+        return Arrays
+            .copyOfRange(
+                _metrics,
+                offset + _BUCKET_INDEX,
+                offset + _BUCKET_INDEX + _bucketsCount());
+    }
+
+    /**
+     * Gets the bytes transferred by a function.
+     *
+     * @param function The function.
+     *
+     * @return The bytes transferred.
+     */
+    @CheckReturnValue
+    public long getBytes(@Nonnull final Function function)
+    {
+        return _get(function, _BYTES_INDEX);
+    }
+
+    /**
+     * Gets the calls count for a function.
+     *
+     * @param function The function.
+     *
+     * @return The calls count.
+     */
+    @CheckReturnValue
+    public long getCalls(@Nonnull final Function function)
+    {
+        return _get(function, _CALLS_INDEX);
+    }
+
+    /**
+     * Gets the total time spent in a function.
+     *
+     * @param function The function.
+     *
+     * @return The total time in nanoseconds.
+     */
+    @CheckReturnValue
+    public long getNanos(@Nonnull final Function function)
+    {
+        return _get(function, _NANOS_INDEX);
+    }
+
+    /**
+     * Gets the values count for a function.
+     *
+     * @param function The function.
+     *
+     * @return The values count.
+     */
+    @CheckReturnValue
+    public long getValues(@Nonnull final Function function)
+    {
+        return _get(function, _VALUES_INDEX);
+    }
+
+    /** {@inheritDoc}
+     */
+    @Override
+    public String toString()
+    {
+        final StringBuilder builder = new StringBuilder();
+
+        for (final Function function: Function.values()) {
+            if (getCalls(function) > 0) {
+                if (builder.length() > 0) {
+                    builder.append(", ");
+                }
+                builder.append(function.name());
+                builder.append('(');
+                builder.append(getCalls(function));
+                builder.append(' ');
+                builder.append(getValues(function));
+                builder.append(' ');
+                builder.append(getBytes(function));
+                builder.append(' ');
+                builder.append(getNanos(function));
+                builder.append(')');
+            }
+        }
+
+        return builder.toString();
+    }
+
+    private int _bucketsCount()
+    {
+        return (int) _metrics[1];
+    }
+
+    private long _get(final Function function, final int index)
+    {
+        final int offset = _offset(function);
+
+        return (offset < 0)? 0: _metrics[offset + index];
+    }
+
+    private int _offset(final Function function)
+    {
+        if ((_metrics.length < _HEADER_LENGTH)
+                || (function.ordinal() >= _metrics[0])) {
+            return -1;
+        }
+
+        return _HEADER_LENGTH
+               + (function.ordinal() * (_BUCKET_INDEX + _bucketsCount()));
+    }
+
+    private static final int _BUCKET_INDEX = 4;
+    private static final int _BYTES_INDEX = 2;
+    private static final int _CALLS_INDEX = 0;
+    private static final int _HEADER_LENGTH = 2;
+    private static final int _NANOS_INDEX = 3;
+    private static final int _VALUES_INDEX = 1;
+
+    private final long[] _metrics;
+
+    /**
+     * Function.
+     */
+    public enum Function    // Must match metrics_function in Metrics.h.
+    {
+        WRITE,
+        WRITE_BUFFER,
+        READ,
+        READ_MANY,
+        DELIVER,
+        EXCHANGE_HANDLES,
+        ACCEPT_VALUES,
+        RETURN_VALUES;
+
+        /**
+         * Asks if this is a JNI conversion function.
+         *
+         * @return True if this is a JNI conversion function.
+         */
+        @CheckReturnValue
+        public boolean isConversion()
+        {
+            return (this == ACCEPT_VALUES) || (this == RETURN_VALUES);
+        }
+    }
+}
+
+/* This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA
+ */
@@ -11,7 +11,9 @@
 package org.rvpf.store.server.c;
 
 import java.util.Collection;
+import java.util.Collections;
 import java.util.Iterator;
+import java.util.List;
 import java.util.Optional;
 import java.util.concurrent.Callable;
 import java.util.concurrent.ExecutionException;
@@ -135,18 +137,23 @@ final class Responder
         throws ExecutionException, InterruptedException
     {
         final CStore cStore = _cStore;
+        final List<UUID> pointUUIDs = Collections.singletonList(pointUUID);
         final CStore.Task<Long> task = new CStore.Task<Long>(
             new Callable<Long>()
             {
                 @Override
                 public Long call()
                 {
+                    final long[] counts;
+
                     try {
-                        return cStore
-                            .count(pointUUID, startTime, endTime, limit);
+                        counts = cStore
+                            .count(pointUUIDs, startTime, endTime, limit);
                     } catch (final Status.FailedException exception) {
                         throw new RuntimeException(exception);
                     }
+
+                    return Long.valueOf(counts[0]);
                 }
             });
 
@@ -162,6 +169,7 @@ final class Responder
         throws ExecutionException, InterruptedException
     {
         final CStore cStore = _cStore;
+        final List<UUID> pointUUIDs = Collections.singletonList(pointUUID);
         final CStore.Task<Collection<PointValue>> task =
             new CStore.Task<Collection<PointValue>>(
                 new Callable<Collection<PointValue>>()
@@ -173,7 +181,7 @@ final class Responder
 
                         try {
                             values = cStore
-                                .read(pointUUID, startTime, endTime, limit);
+                                .read(pointUUIDs, startTime, endTime, limit);
                         } catch (final Status.FailedException exception) {
                             throw new RuntimeException(exception);
                         }
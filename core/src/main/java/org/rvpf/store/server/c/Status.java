@@ -30,7 +30,8 @@ public enum Status    // Must match status codes in CStoreImpl.h.
     ILLEGAL_STATE(-1006),
     DISCONNECTED(-1007),
     UNSUPPORTED(-1008),
-    UNRECOVERABLE(-1009),;
+    UNRECOVERABLE(-1009),
+    BUFFER_TOO_SMALL(-1010),;
 
     Status(final int code)
     {
@@ -89,6 +90,9 @@ public enum Status    // Must match status codes in CStoreImpl.h.
     /** Bad handle code. */
     public static final int BAD_HANDLE_CODE = BAD_HANDLE.code();
 
+    /** Buffer too small code. */
+    public static final int BUFFER_TOO_SMALL_CODE = BUFFER_TOO_SMALL.code();
+
     /** Disconnected code. */
     public static final int DISCONNECTED_CODE = DISCONNECTED.code();
 
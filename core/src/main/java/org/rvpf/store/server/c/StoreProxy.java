@@ -16,9 +16,10 @@ import java.io.StringWriter;
 
 import java.nio.charset.Charset;
 
-import java.util.HashMap;
 import java.util.Map;
 import java.util.Optional;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.atomic.AtomicInteger;
 
 import org.rvpf.base.DateTime;
 import org.rvpf.base.UUID;
@@ -85,42 +86,33 @@ public final class StoreProxy
 
         _keyedGroups.freeze();
 
-        final RegistryEntry registryEntry = RegistryEntry
-            .newBuilder()
-            .setBinding(_keyedGroups.getString(BINDING_PROPERTY))
-            .setName(_keyedGroups.getString(NAME_PROPERTY))
-            .setDefaultName(Store.DEFAULT_STORE_NAME)
-            .setDefaultRegistryAddress(ServiceRegistry.getRegistryAddress())
-            .setDefaultRegistryPort(ServiceRegistry.getRegistryPort())
-            .build();
-
-        _storeSessionProxy = (StoreSessionProxy) StoreSessionProxy
-            .newBuilder()
-            .setRegistryEntry(registryEntry)
-            .setConfigProperties(_keyedGroups)
-            .setSecurityProperties(
-                _keyedGroups.getGroup(SecurityContext.SECURITY_PROPERTIES))
-            .setLoginUser(_keyedGroups.getString(USER_PROPERTY))
-            .setLoginPassword(_keyedGroups.getPassword(PASSWORD_PROPERTY))
-            .setClientName(
-                _keyedGroups
-                    .getString(SESSION_PROPERTY, Optional.of(_DEFAULT_SESSION))
-                    .get())
-            .setClientLogger(_LOGGER)
-            .build();
+        _storeSessionProxy = _newSessionProxy();
 
         if (_storeSessionProxy == null) {
             return Status.FAILED_CODE;
         }
 
-        try {
-            _storeSessionProxy.connect();
-        } catch (final SessionConnectFailedException exception) {
-            _LOGGER.error(StoreMessages.CONNECT_FAILED, exception.getMessage());
+        final StoreSessionProxy[] querySessionProxies =
+            new StoreSessionProxy[_keyedGroups
+                .getInt(QUERY_SESSIONS_PROPERTY, 0)];
 
-            return Status.FAILED_CODE;
+        for (int i = 0; i < querySessionProxies.length; ++i) {
+            querySessionProxies[i] = _newSessionProxy();
+
+            if (querySessionProxies[i] == null) {
+                for (int j = 0; j < i; ++j) {
+                    querySessionProxies[j].tearDown();
+                }
+
+                _storeSessionProxy.tearDown();
+                _storeSessionProxy = null;
+
+                return Status.FAILED_CODE;
+            }
         }
 
+        _querySessionProxies = querySessionProxies;
+
         return Status.SUCCESS_CODE;
     }
 
@@ -163,8 +155,9 @@ public final class StoreProxy
                 queryBuilder.setAll(true);
                 queryBuilder.setCount(true);
 
-                final Optional<StoreValues> storeResponse = _storeSessionProxy
-                    .select(queryBuilder.build());
+                final Optional<StoreValues> storeResponse =
+                    _querySessionProxy()
+                        .select(queryBuilder.build());
 
                 count = (storeResponse.isPresent()
                          && storeResponse.get().isSuccess())? storeResponse
@@ -285,6 +278,12 @@ public final class StoreProxy
      */
     synchronized int disconnect()
     {
+        for (final StoreSessionProxy querySessionProxy: _querySessionProxies) {
+            querySessionProxy.tearDown();
+        }
+
+        _querySessionProxies = _NO_SESSION_PROXIES;
+
         if (_storeSessionProxy != null) {
             _storeSessionProxy.tearDown();
             _storeSessionProxy = null;
@@ -524,7 +523,7 @@ public final class StoreProxy
 
                 try {
                     for (final PointValue pointValue:
-                            _storeSessionProxy
+                            _querySessionProxy()
                                 .iterate(
                                         storeQueryBuilder.build(),
                                                 Optional.empty())) {
@@ -880,6 +879,63 @@ public final class StoreProxy
         values.add(clientHandle, time, deleted, quality, value);
     }
 
+    private StoreSessionProxy _newSessionProxy()
+    {
+        final RegistryEntry registryEntry = RegistryEntry
+            .newBuilder()
+            .setBinding(_keyedGroups.getString(BINDING_PROPERTY))
+            .setName(_keyedGroups.getString(NAME_PROPERTY))
+            .setDefaultName(Store.DEFAULT_STORE_NAME)
+            .setDefaultRegistryAddress(ServiceRegistry.getRegistryAddress())
+            .setDefaultRegistryPort(ServiceRegistry.getRegistryPort())
+            .build();
+        final StoreSessionProxy storeSessionProxy =
+            (StoreSessionProxy) StoreSessionProxy
+                .newBuilder()
+                .setRegistryEntry(registryEntry)
+                .setConfigProperties(_keyedGroups)
+                .setSecurityProperties(
+                    _keyedGroups.getGroup(SecurityContext.SECURITY_PROPERTIES))
+                .setLoginUser(_keyedGroups.getString(USER_PROPERTY))
+                .setLoginPassword(_keyedGroups.getPassword(PASSWORD_PROPERTY))
+                .setClientName(
+                    _keyedGroups
+                        .getString(
+                            SESSION_PROPERTY,
+                            Optional.of(_DEFAULT_SESSION))
+                        .get())
+                .setClientLogger(_LOGGER)
+                .build();
+
+        if (storeSessionProxy == null) {
+            return null;
+        }
+
+        try {
+            storeSessionProxy.connect();
+        } catch (final SessionConnectFailedException exception) {
+            _LOGGER.error(StoreMessages.CONNECT_FAILED, exception.getMessage());
+
+            return null;
+        }
+
+        return storeSessionProxy;
+    }
+
+    private StoreSessionProxy _querySessionProxy()
+    {
+        final StoreSessionProxy[] querySessionProxies = _querySessionProxies;
+
+        if (querySessionProxies.length == 0) {
+            return _storeSessionProxy;
+        }
+
+        return querySessionProxies[Math
+            .floorMod(
+                _nextQuerySession.getAndIncrement(),
+                querySessionProxies.length)];
+    }
+
     /** Binding property. */
     public static final String BINDING_PROPERTY = "binding";
 
@@ -889,6 +945,12 @@ public final class StoreProxy
     /** Password property. */
     public static final String PASSWORD_PROPERTY = "password";
 
+    /**
+     * Query sessions property: the number of additional store sessions
+     * shared by concurrent reads and counts.
+     */
+    public static final String QUERY_SESSIONS_PROPERTY = "query.sessions";
+
     /** Session name property. */
     public static final String SESSION_PROPERTY = "session";
 
@@ -896,13 +958,19 @@ public final class StoreProxy
     public static final String USER_PROPERTY = "user";
     private static final String _DEFAULT_SESSION = "c-store";
     private static final Logger _LOGGER = Logger.getInstance(StoreProxy.class);
+    private static final StoreSessionProxy[] _NO_SESSION_PROXIES =
+        new StoreSessionProxy[0];
 
-    private final Map<UUID, Integer> _clientHandles = new HashMap<>();
+    private final Map<UUID, Integer> _clientHandles =
+        new ConcurrentHashMap<>();
     private volatile Coder _coder;
     private final KeyedGroups _keyedGroups = new KeyedGroups();
     private int _lastHandle;
-    private final Map<UUID, Integer> _serverHandles = new HashMap<>();
-    private final Map<Integer, UUID> _serverPoints = new HashMap<>();
+    private final AtomicInteger _nextQuerySession = new AtomicInteger();
+    private volatile StoreSessionProxy[] _querySessionProxies =
+        _NO_SESSION_PROXIES;
+    private final Map<UUID, Integer> _serverHandles = new ConcurrentHashMap<>();
+    private final Map<Integer, UUID> _serverPoints = new ConcurrentHashMap<>();
     private volatile StoreSessionProxy _storeSessionProxy;
 }
 
@@ -9,6 +9,10 @@
  */
 package org.rvpf.store.server.c;
 
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+import java.util.Arrays;
 import java.util.Iterator;
 import java.util.LinkedList;
 import java.util.List;
@@ -41,12 +45,102 @@ final class Values
                 valueBytes));
     }
 
+    /** Adds values from packed arrays.
+     *
+     * <p>Called from native code: the value bytes for the value at index
+     * <code>i</code> are found in <code>valuesBytes</code> from
+     * <code>offsets[i]</code> (inclusive) to <code>offsets[i + 1]</code>
+     * (exclusive).</p>
+     *
+     * @param handles The handles for the points.
+     * @param valuesTimes The time stamps for the values.
+     * @param valuesDeleted True for the deleted values.
+     * @param valuesQualities The qualities of the values.
+     * @param valuesBytes The packed values.
+     * @param offsets The offsets of the values in the packed values.
+     */
+    void addAll(
+            final int[] handles,
+            final long[] valuesTimes,
+            final boolean[] valuesDeleted,
+            final int[] valuesQualities,
+            final byte[] valuesBytes,
+            final int[] offsets)
+    {
+        for (int i = 0; i < handles.length; ++i) {
+            add(
+                handles[i],
+                valuesTimes[i],
+                valuesDeleted[i],
+                valuesQualities[i],
+                Arrays.copyOfRange(valuesBytes, offsets[i], offsets[i + 1]));
+        }
+    }
+
+    /** Adds values laid out back to back in a direct buffer.
+     *
+     * <p>This is the inverse of {@link #toBuffer}.</p>
+     *
+     * @param layout The value layout.
+     * @param buffer The buffer.
+     * @param count The number of values in the buffer.
+     */
+    void addBuffer(final int[] layout, final ByteBuffer buffer, final int count)
+    {
+        final int alignment = layout[_ALIGNMENT_INDEX];
+        int offset = 0;
+
+        for (int i = 0; i < count; ++i) {
+            final int size = (layout[_SIZE_LENGTH_INDEX] == Long.BYTES)
+                ? (int) buffer.getLong(offset + layout[_SIZE_INDEX])
+                : buffer.getInt(offset + layout[_SIZE_INDEX]);
+            final byte[] valueBytes = new byte[size];
+
+            if (size > 0) {
+                final ByteBuffer valueBuffer = buffer.duplicate();
+
+                valueBuffer.position(offset + layout[_VALUE_INDEX]);
+                valueBuffer.get(valueBytes);
+            }
+            add(
+                buffer.getInt(offset + layout[_HANDLE_INDEX]),
+                buffer.getLong(offset + layout[_STAMP_INDEX]),
+                buffer.get(offset + layout[_DELETED_INDEX]) != 0,
+                buffer.getInt(offset + layout[_QUALITY_INDEX]),
+                valueBytes);
+            offset += _bufferValueLength(
+                layout[_VALUE_INDEX],
+                valueBytes,
+                alignment);
+        }
+    }
+
+    /** Returns the total length of the value bytes.
+     *
+     * @return The total length.
+     */
+    int bytesLength()
+    {
+        int bytesLength = 0;
+
+        for (final Value value: _values) {
+            final byte[] valueBytes = value.getValue();
+
+            if (valueBytes != null) {
+                bytesLength += valueBytes.length;
+            }
+        }
+
+        return bytesLength;
+    }
+
     /** Clears the values.
      */
     void clear()
     {
         _iterator = null;
         _values.clear();
+        _unpack();
     }
 
     /** Gets the quality.
@@ -118,6 +212,118 @@ final class Values
         return next.getHandle();
     }
 
+    /** Packs the values into arrays.
+     *
+     * <p>Called from native code to fetch all the values with a fixed
+     * number of calls. A null value is packed as an empty value.</p>
+     */
+    void pack()
+    {
+        final int size = _values.size();
+        int bytesLength = 0;
+
+        _handles = new int[size];
+        _times = new long[size];
+        _deletedFlags = new boolean[size];
+        _qualities = new int[size];
+        _offsets = new int[size + 1];
+
+        int index = 0;
+
+        for (final Value value: _values) {
+            final byte[] valueBytes = value.getValue();
+
+            _handles[index] = value.getHandle();
+            _times[index] = value.getTime();
+            _deletedFlags[index] = value.isDeleted();
+            _qualities[index] = value.getQuality();
+            _offsets[index] = bytesLength;
+            if (valueBytes != null) {
+                bytesLength += valueBytes.length;
+            }
+            ++index;
+        }
+        _offsets[size] = bytesLength;
+
+        _bytes = new byte[bytesLength];
+        index = 0;
+
+        for (final Value value: _values) {
+            final byte[] valueBytes = value.getValue();
+
+            if (valueBytes != null) {
+                System
+                    .arraycopy(
+                        valueBytes,
+                        0,
+                        _bytes,
+                        _offsets[index],
+                        valueBytes.length);
+            }
+            ++index;
+        }
+    }
+
+    /** Lays out the values back to back in a direct buffer.
+     *
+     * <p>Each value is written as its native representation, described by
+     * the layout supplied by the native library.</p>
+     *
+     * @param layout The value layout.
+     * @param buffer A previous buffer (may be null).
+     *
+     * @return The buffer (may be the previous buffer).
+     */
+    ByteBuffer toBuffer(final int[] layout, ByteBuffer buffer)
+    {
+        final int alignment = layout[_ALIGNMENT_INDEX];
+        int capacity = 0;
+
+        for (final Value value: _values) {
+            capacity += _bufferValueLength(
+                layout[_VALUE_INDEX],
+                value.isDeleted()? null: value.getValue(),
+                alignment);
+        }
+
+        if ((buffer == null) || (buffer.capacity() < capacity)) {
+            buffer = ByteBuffer.allocateDirect(capacity);
+            buffer.order(ByteOrder.nativeOrder());
+        }
+
+        int offset = 0;
+
+        for (final Value value: _values) {
+            final byte[] valueBytes = value.isDeleted()? null: value.getValue();
+            final int size = (valueBytes != null)? valueBytes.length: 0;
+
+            buffer.putInt(offset + layout[_HANDLE_INDEX], value.getHandle());
+            buffer.putLong(offset + layout[_STAMP_INDEX], value.getTime());
+            buffer
+                .put(
+                    offset + layout[_DELETED_INDEX],
+                    (byte) (value.isDeleted()? 1: 0));
+            buffer.putInt(offset + layout[_QUALITY_INDEX], value.getQuality());
+            if (layout[_SIZE_LENGTH_INDEX] == Long.BYTES) {
+                buffer.putLong(offset + layout[_SIZE_INDEX], size);
+            } else {
+                buffer.putInt(offset + layout[_SIZE_INDEX], size);
+            }
+            if (size > 0) {
+                final ByteBuffer valueBuffer = buffer.duplicate();
+
+                valueBuffer.position(offset + layout[_VALUE_INDEX]);
+                valueBuffer.put(valueBytes);
+            }
+            offset += _bufferValueLength(
+                layout[_VALUE_INDEX],
+                valueBytes,
+                alignment);
+        }
+
+        return buffer;
+    }
+
     /** Sets the status.
      *
      * @param status The new status.
@@ -145,12 +351,47 @@ final class Values
         return _status.code();
     }
 
-    private boolean _deleted;
+    private static int _bufferValueLength(
+            final int valueOffset,
+            final byte[] valueBytes,
+            final int alignment)
+    {
+        final int length = valueOffset
+            + ((valueBytes != null)? valueBytes.length: 0);
+
+        return (length + alignment - 1) / alignment * alignment;
+    }
+
+    private void _unpack()
+    {
+        _handles = null;
+        _times = null;
+        _deletedFlags = null;
+        _qualities = null;
+        _offsets = null;
+        _bytes = null;
+    }
 
+    private static final int _ALIGNMENT_INDEX = 7;
+    private static final int _DELETED_INDEX = 2;
+    private static final int _HANDLE_INDEX = 0;
+    private static final int _QUALITY_INDEX = 3;
+    private static final int _SIZE_INDEX = 4;
+    private static final int _SIZE_LENGTH_INDEX = 6;
+    private static final int _STAMP_INDEX = 1;
+    private static final int _VALUE_INDEX = 5;
+
+    private byte[] _bytes;
+    private boolean _deleted;
+    private boolean[] _deletedFlags;
+    private int[] _handles;
     private Iterator<Value> _iterator;
+    private int[] _offsets;
+    private int[] _qualities;
     private int _quality;
     private Status _status = Status.SUCCESS;
     private long _time;
+    private long[] _times;
     private byte[] _value;
     private final List<Value> _values = new LinkedList<>();
 
@@ -15,10 +15,10 @@ import java.io.File;
 import java.nio.charset.Charset;
 import java.nio.charset.StandardCharsets;
 
+import java.util.Arrays;
 import java.util.Optional;
 
 import org.rvpf.base.ElapsedTime;
-import org.rvpf.base.Point;
 import org.rvpf.base.pipe.PipeRequest;
 import org.rvpf.base.pipe.PipeSinkRequest;
 import org.rvpf.base.util.SnoozeAlarm;
@@ -92,6 +92,10 @@ import org.rvpf.store.server.StoreMessages;
  *   <li>A null state or value is indicated by a missing field.</li>
  *   <li>The request ID is used for synchronization verification and must be
  *     returned verbatim.</li>
+ *   <li>Up to 64 requests may be sent before their responses are read: the
+ *     program may read the requests already available before responding to
+ *     them as a batch; the responses must keep the order of the
+ *     requests.</li>
  *   <li>Leading spaces are stripped from the lines received from the process;
  *     resulting empty lines are ignored.</li>
  *   <li>The state is encoded by replacing ']' by '[]' and '[' by ']['.</li>
@@ -101,6 +105,34 @@ import org.rvpf.store.server.StoreMessages;
 public final class PipeSink
     extends SinkModule.Abstract
 {
+    /** {@inheritDoc}
+     */
+    @Override
+    public boolean[] apply(final VersionedValue[] versionedValues)
+    {
+        final String[] requestTypes = new String[versionedValues.length];
+        final PointValue[] pointValues = new PointValue[versionedValues.length];
+
+        for (int i = 0; i < versionedValues.length; ++i) {
+            if (versionedValues[i].isDeleted()) {
+                requestTypes[i] = PipeSinkRequest.DELETE_REQUEST_TYPE;
+                pointValues[i] = _deletedPointValue(versionedValues[i]);
+            } else {
+                requestTypes[i] = PipeSinkRequest.UPDATE_REQUEST_TYPE;
+                pointValues[i] = versionedValues[i];
+            }
+        }
+
+        final int[] summaries = _processRequests(requestTypes, pointValues);
+        final boolean[] notices = new boolean[summaries.length];
+
+        for (int i = 0; i < summaries.length; ++i) {
+            notices[i] = summaries[i] > 0;
+        }
+
+        return notices;
+    }
+
     /** {@inheritDoc}
      */
     @Override
@@ -118,15 +150,9 @@ public final class PipeSink
     @Override
     public boolean delete(final VersionedValue versionedValue)
     {
-        final Point point = versionedValue.getPoint().get();
-
-        return _processRequest(
-            PipeSinkRequest.DELETE_REQUEST_TYPE,
-            new PointValue(
-                point,
-                Optional.of(versionedValue.getStamp()),
-                null,
-                null)) > 0;
+        return _processRequests(
+            new String[] {PipeSinkRequest.DELETE_REQUEST_TYPE, },
+            new PointValue[] {_deletedPointValue(versionedValue), })[0] > 0;
     }
 
     /** {@inheritDoc}
@@ -238,79 +264,123 @@ public final class PipeSink
     @Override
     public boolean update(final VersionedValue versionedValue)
     {
-        return _processRequest(
-            PipeSinkRequest.UPDATE_REQUEST_TYPE,
-            versionedValue) > 0;
+        return _processRequests(
+            new String[] {PipeSinkRequest.UPDATE_REQUEST_TYPE, },
+            new PointValue[] {versionedValue, })[0] > 0;
     }
 
-    private int _processRequest(
-            final String requestType,
-            final PointValue pointValue)
+    private static PointValue _deletedPointValue(
+            final VersionedValue versionedValue)
     {
-        int summary = 0;
+        return new PointValue(
+            versionedValue.getPoint().get(),
+            Optional.of(versionedValue.getStamp()),
+            null,
+            null);
+    }
 
-        if (_processMonitor.activateProcess()) {
-            try {
-                final long requestID = ProcessMonitor.newRequestID();
-                final String line;
-                String[] fields;
-
-                {
-                    final StringBuilder stringBuilder = new StringBuilder();
-
-                    stringBuilder.append(requestID);
-                    stringBuilder.append(' ');
-                    stringBuilder
-                        .append(PipeSinkRequest.REQUEST_FORMAT_VERSION);
-                    stringBuilder.append(' ');
-                    stringBuilder.append(requestType);
-
-                    if (!_processMonitor.writeLine(stringBuilder.toString())) {
-                        return -1;
-                    }
-                }
+    private int[] _processRequests(
+            final String[] requestTypes,
+            final PointValue[] pointValues)
+    {
+        final int[] summaries = new int[pointValues.length];
 
-                if (!_processMonitor
-                    .writeLine(PipeRequest.pointValueToString(pointValue))) {
-                    return -1;
-                }
+        if (pointValues.length == 0) {
+            return summaries;
+        }
+
+        if (!_processMonitor.activateProcess()) {
+            abort();
+
+            return summaries;
+        }
+
+        try {
+            final long[] requestIDs = new long[Math
+                .min(pointValues.length, _PIPELINE_LIMIT)];
 
-                line = _processMonitor.readLine();
+            for (int first = 0; first < pointValues.length;
+                    first += _PIPELINE_LIMIT) {
+                final int count = Math
+                    .min(pointValues.length - first, _PIPELINE_LIMIT);
 
-                if (line == null) {
-                    return -1;
+                // Sends the requests before reading their responses, so that
+                // the process may answer them as a batch.
+
+                for (int i = 0; i < count; ++i) {
+                    requestIDs[i] = ProcessMonitor.newRequestID();
+
+                    if (!_writeRequest(
+                            requestIDs[i],
+                            requestTypes[first + i],
+                            pointValues[first + i])) {
+                        Arrays.fill(summaries, first, summaries.length, -1);
+
+                        return summaries;
+                    }
                 }
 
-                fields = PipeSinkRequest.SPACE_PATTERN.split(line);
-
-                if (fields.length == 2) {
-                    try {
-                        if (Long.parseLong(fields[0]) == requestID) {
-                            summary = Integer.parseInt(fields[1]);
-                        } else {
-                            fields = null;
-                        }
-                    } catch (final NumberFormatException exception) {
-                        fields = null;
+                for (int i = 0; i < count; ++i) {
+                    final Optional<Integer> summary = _readResponse(
+                        requestIDs[i]);
+
+                    if (!summary.isPresent()) {
+                        Arrays.fill(summaries, first + i, summaries.length, -1);
+
+                        return summaries;
                     }
-                } else {
-                    fields = null;
+
+                    summaries[first + i] = summary.get().intValue();
                 }
+            }
+        } finally {
+            _processMonitor.freeProcess();
+        }
+
+        return summaries;
+    }
+
+    private Optional<Integer> _readResponse(final long requestID)
+    {
+        final String line = _processMonitor.readLine();
 
-                if (fields == null) {
-                    getThisLogger()
-                        .warn(ServiceMessages.BAD_RESPONSE_SUMMARY, line);
+        if (line == null) {
+            return Optional.empty();
+        }
+
+        final String[] fields = PipeSinkRequest.SPACE_PATTERN.split(line);
 
-                    return -1;
+        if (fields.length == 2) {
+            try {
+                if (Long.parseLong(fields[0]) == requestID) {
+                    return Optional.of(Integer.valueOf(fields[1]));
                 }
-            } finally {
-                _processMonitor.freeProcess();
+            } catch (final NumberFormatException exception) {
+                // Reported below.
             }
-        } else {
-            abort();
         }
 
-        return summary;
+        getThisLogger().warn(ServiceMessages.BAD_RESPONSE_SUMMARY, line);
+
+        return Optional.empty();
+    }
+
+    private boolean _writeRequest(
+            final long requestID,
+            final String requestType,
+            final PointValue pointValue)
+    {
+        final StringBuilder stringBuilder = new StringBuilder();
+
+        stringBuilder.append(requestID);
+        stringBuilder.append(' ');
+        stringBuilder.append(PipeSinkRequest.REQUEST_FORMAT_VERSION);
+        stringBuilder.append(' ');
+        stringBuilder.append(requestType);
+
+        return _processMonitor.writeLine(stringBuilder.toString())
+               && _processMonitor.writeLine(
+                   PipeRequest.pointValueToString(pointValue));
     }
 
     /** An argument for the process. */
@@ -353,6 +423,7 @@ public final class PipeSink
     /** Sets an environment variable. */
     public static final String SET_PROPERTY = "set";
     private static final String _DEFAULT_NAME = "PipeSink";
+    private static final int _PIPELINE_LIMIT = 64;
 
     private ProcessMonitor _processMonitor;
 }
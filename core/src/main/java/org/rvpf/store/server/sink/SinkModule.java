@@ -25,6 +25,19 @@ import org.rvpf.store.server.StoreMessages;
  */
 public interface SinkModule
 {
+    /**
+     * Applies a batch of values.
+     *
+     * <p>The deleted values are deleted, the others are updated, in order.</p>
+     *
+     * @param versionedValues The point values.
+     *
+     * @return True for each value when notification may proceed.
+     */
+    @Nonnull
+    @CheckReturnValue
+    boolean[] apply(@Nonnull VersionedValue[] versionedValues);
+
     /**
      * Closes this sink.
      */
@@ -80,6 +93,26 @@ public interface SinkModule
     abstract class Abstract
         implements SinkModule
     {
+        /** {@inheritDoc}
+         */
+        @Override
+        public boolean[] apply(final VersionedValue[] versionedValues)
+        {
+            final boolean[] notices = new boolean[versionedValues.length];
+
+            for (int i = 0; i < versionedValues.length; ++i) {
+                final VersionedValue versionedValue = versionedValues[i];
+
+                if (versionedValue.isDeleted()) {
+                    notices[i] = delete(versionedValue);
+                } else {
+                    notices[i] = update(versionedValue);
+                }
+            }
+
+            return notices;
+        }
+
         /** {@inheritDoc}
          */
         @Override
@@ -10,7 +10,9 @@
 
 package org.rvpf.store.server.sink;
 
+import java.util.ArrayList;
 import java.util.EnumSet;
+import java.util.List;
 import java.util.Optional;
 
 import org.rvpf.base.BaseMessages;
@@ -101,6 +103,9 @@ final class SinkServer
             long updated = 0;
             long deleted = 0;
 
+            final List<VersionedValue> versionedValues = new ArrayList<>(
+                updates.length);
+
             for (int i = 0; i < updates.length; i++) {
                 if (exceptions[i] != null) {
                     ++ignored;
@@ -110,8 +115,6 @@ final class SinkServer
 
                 final VersionedValue versionedValue = versionedValue(
                     updates[i]);
-                final boolean notify;
-                final Messages.Entry actionMessage;
 
                 exceptions[i] = checkUpdate(versionedValue, identity)
                     .orElse(null);
@@ -122,13 +125,25 @@ final class SinkServer
                     continue;
                 }
 
+                versionedValues.add(versionedValue);
+            }
+
+            // The accepted values are handed to the sink as a batch.
+
+            final boolean[] notices = _sink
+                .apply(
+                    versionedValues
+                        .toArray(new VersionedValue[versionedValues.size()]));
+
+            for (int i = 0; i < notices.length; ++i) {
+                final VersionedValue versionedValue = versionedValues.get(i);
+                final Messages.Entry actionMessage;
+
                 if (versionedValue.isDeleted()) {
-                    notify = _sink.delete(versionedValue);
                     ++deleted;
                     getDeletedTraces().add(versionedValue);
                     actionMessage = StoreMessages.UPDATER_DELETED;
                 } else {
-                    notify = _sink.update(versionedValue);
                     ++updated;
                     getUpdatedTraces().add(versionedValue);
                     actionMessage = StoreMessages.UPDATER_UPDATED;
@@ -138,7 +153,7 @@ final class SinkServer
 
                 getReplicator().replicate(versionedValue);
 
-                if (notify) {
+                if (notices[i]) {
                     addNotice(versionedValue);
                 }
             }
@@ -0,0 +1,275 @@
+/** Related Values Processing Framework.
+ *
+ * $Id$
+ */
+
+/* Notes.
+ *
+ * Times the hot paths of the C store support library: the handles map and
+ * the store values conversions (including the split and join of string and
+ * byte array values across blocks).
+ *
+ * Each result is written on stdout as a tab separated line:
+ * benchmark, size, operations, nanoseconds per operation.
+ */
+#include "CStoreImpl.h"
+#include "HandlesMap.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Private macro definitions.
+
+#define HEADER "# benchmark\tsize\toperations\tns_per_op"
+#define MAP_GROW_LOAD_SIZE 16
+#define TEXT_BYTES_PER_SIZE (16 * 1024 * 1024)
+#define TEXT_MIN_OPERATIONS 64
+#define VALUE_OPERATIONS 1000000
+
+// Private forward declarations.
+
+static void _benchHandlesMap(size_t size);
+
+static void _benchNumbers(void);
+
+static void _benchText(enum value_type valueType, const char *name, size_t size);
+
+static long long _nanos(void);
+
+static void _report(
+    const char *benchmark,
+    size_t size,
+    size_t operations,
+    long long nanos);
+
+// Private static variables.
+
+static const size_t _mapSizes[] = {10000, 100000, 1000000};
+
+static volatile c_store_long_t _sink;
+
+static const size_t _textSizes[] = {16, 1024, 65534, 1024 * 1024};
+
+// Main.
+
+extern int main(int argc, char **argv)
+{
+    puts(HEADER);
+
+    for (size_t i = 0; i < sizeof(_mapSizes) / sizeof(*_mapSizes); ++i) {
+        _benchHandlesMap(_mapSizes[i]);
+    }
+
+    _benchNumbers();
+
+    for (size_t i = 0; i < sizeof(_textSizes) / sizeof(*_textSizes); ++i) {
+        _benchText(VALUE_TYPE_STRING, "value_string", _textSizes[i]);
+        _benchText(VALUE_TYPE_BYTE_ARRAY, "value_byte_array", _textSizes[i]);
+    }
+
+    return 0;
+}
+
+// Private function definitions.
+
+static void _benchHandlesMap(size_t size)
+{
+    c_store_handles_map_t map = HandlesMap_create(MAP_GROW_LOAD_SIZE);
+    c_store_handle_t *keys = malloc(sizeof(c_store_handle_t) * size);
+    c_store_handle_t *values = malloc(sizeof(c_store_handle_t) * size);
+    long long start;
+
+    if (!map || !keys || !values) {
+        fprintf(stderr, "Allocation failed for %zu handles\n", size);
+        exit(1);
+    }
+
+    for (size_t i = 0; i < size; ++i) keys[i] = (c_store_handle_t) i + 1;
+
+    start = _nanos();
+    for (size_t i = 0; i < size; ++i) HandlesMap_put(map, keys[i], keys[i]);
+    _report("handles_map_put_rehash", size, size, _nanos() - start);
+
+    start = _nanos();
+    for (size_t i = 0; i < size; ++i) _sink += HandlesMap_get(map, keys[i]);
+    _report("handles_map_get", size, size, _nanos() - start);
+
+    start = _nanos();
+    for (size_t i = 0; i < size; ++i) {
+        _sink += HandlesMap_get(map, keys[i] + (c_store_handle_t) size);
+    }
+    _report("handles_map_get_miss", size, size, _nanos() - start);
+
+    start = _nanos();
+    _sink += HandlesMap_getBatch(map, size, keys, values);
+    _report("handles_map_get_batch", size, size, _nanos() - start);
+
+    start = _nanos();
+    for (size_t i = 0; i < size; ++i) _sink += HandlesMap_remove(map, keys[i]);
+    _report("handles_map_remove", size, size, _nanos() - start);
+
+    HandlesMap_dispose(map);
+    map = HandlesMap_create(size);
+
+    start = _nanos();
+    for (size_t i = 0; i < size; ++i) HandlesMap_put(map, keys[i], keys[i]);
+    _report("handles_map_put_presized", size, size, _nanos() - start);
+
+    HandlesMap_dispose(map);
+    free(values);
+    free(keys);
+}
+
+static void _benchNumbers(void)
+{
+    c_store_value_t *storeValue;
+    c_store_double_t doubleValue;
+    c_store_long_t longValue;
+    long long start;
+
+    start = _nanos();
+    for (size_t i = 0; i < VALUE_OPERATIONS; ++i) {
+        storeValue = CStore_newValue(
+            NULL, VALUE_TYPE_DOUBLE, (c_store_double_t) i);
+        CStore_valueToDouble(storeValue, &doubleValue);
+        _sink += (c_store_long_t) doubleValue;
+        CStore_free(storeValue);
+    }
+    _report("value_double", 1, VALUE_OPERATIONS, _nanos() - start);
+
+    start = _nanos();
+    for (size_t i = 0; i < VALUE_OPERATIONS; ++i) {
+        storeValue = CStore_newValue(
+            NULL, VALUE_TYPE_FLOAT, (double) i);
+        CStore_valueToDouble(storeValue, &doubleValue);
+        _sink += (c_store_long_t) doubleValue;
+        CStore_free(storeValue);
+    }
+    _report("value_float", 1, VALUE_OPERATIONS, _nanos() - start);
+
+    start = _nanos();
+    for (size_t i = 0; i < VALUE_OPERATIONS; ++i) {
+        storeValue = CStore_newValue(
+            NULL, VALUE_TYPE_LONG, (c_store_long_t) i);
+        CStore_valueToLong(storeValue, &longValue);
+        _sink += longValue;
+        CStore_free(storeValue);
+    }
+    _report("value_long", 1, VALUE_OPERATIONS, _nanos() - start);
+
+    start = _nanos();
+    for (size_t i = 0; i < VALUE_OPERATIONS; ++i) {
+        storeValue = CStore_newValue(
+            NULL, VALUE_TYPE_INTEGER, (c_store_int_t) i);
+        CStore_valueToLong(storeValue, &longValue);
+        _sink += longValue;
+        CStore_free(storeValue);
+    }
+    _report("value_integer", 1, VALUE_OPERATIONS, _nanos() - start);
+
+    start = _nanos();
+    for (size_t i = 0; i < VALUE_OPERATIONS; ++i) {
+        storeValue = CStore_newValue(NULL, VALUE_TYPE_SHORT, (int) (i & 0x7FFF));
+        CStore_valueToLong(storeValue, &longValue);
+        _sink += longValue;
+        CStore_free(storeValue);
+    }
+    _report("value_short", 1, VALUE_OPERATIONS, _nanos() - start);
+
+    start = _nanos();
+    for (size_t i = 0; i < VALUE_OPERATIONS; ++i) {
+        storeValue = CStore_newValue(NULL, VALUE_TYPE_BYTE, (int) (i & 0x7F));
+        CStore_valueToLong(storeValue, &longValue);
+        _sink += longValue;
+        CStore_free(storeValue);
+    }
+    _report("value_byte", 1, VALUE_OPERATIONS, _nanos() - start);
+
+    start = _nanos();
+    for (size_t i = 0; i < VALUE_OPERATIONS; ++i) {
+        storeValue = CStore_newValue(NULL, VALUE_TYPE_BOOLEAN, (int) (i & 1));
+        CStore_valueToLong(storeValue, &longValue);
+        _sink += longValue;
+        CStore_free(storeValue);
+    }
+    _report("value_boolean", 1, VALUE_OPERATIONS, _nanos() - start);
+
+    start = _nanos();
+    for (size_t i = 0; i < VALUE_OPERATIONS; ++i) {
+        c_store_quality_t stateCode = (c_store_quality_t) i;
+        c_store_int_t code;
+        char *stateName;
+
+        storeValue = CStore_newValue(
+            NULL, VALUE_TYPE_STATE, &stateCode, "STATE", (size_t) 5);
+        CStore_valueToStateCode(storeValue, &code);
+        CStore_valueToStateName(storeValue, &stateName);
+        _sink += code + (c_store_long_t) strlen(stateName);
+        CStore_free(stateName);
+        CStore_free(storeValue);
+    }
+    _report("value_state", 1, VALUE_OPERATIONS, _nanos() - start);
+}
+
+static void _benchText(enum value_type valueType, const char *name, size_t size)
+{
+    size_t operations = TEXT_BYTES_PER_SIZE / size;
+    char *text = malloc(size);
+    long long start;
+
+    if (!text) {
+        fprintf(stderr, "Allocation failed for %zu bytes\n", size);
+        exit(1);
+    }
+    if (operations < TEXT_MIN_OPERATIONS) operations = TEXT_MIN_OPERATIONS;
+    for (size_t i = 0; i < size; ++i) text[i] = 'A' + i % 26;
+
+    start = _nanos();
+    for (size_t i = 0; i < operations; ++i) {
+        c_store_value_t *storeValue =
+            CStore_newValue(NULL, valueType, text, size);
+
+        if (valueType == VALUE_TYPE_STRING) {
+            char *stringValue;
+
+            CStore_valueToString(storeValue, &stringValue);
+            _sink += stringValue[size - 1];
+            CStore_free(stringValue);
+        } else {
+            c_store_byte_t *bytesValue;
+            size_t bytesLength;
+
+            CStore_valueToByteArray(storeValue, &bytesValue, &bytesLength);
+            _sink += bytesValue[bytesLength - 1];
+            CStore_free(bytesValue);
+        }
+        CStore_free(storeValue);
+    }
+    _report(name, size, operations, _nanos() - start);
+
+    free(text);
+}
+
+static long long _nanos(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static void _report(
+    const char *benchmark,
+    size_t size,
+    size_t operations,
+    long long nanos)
+{
+    printf("%s\t%zu\t%zu\t%.1f\n",
+        benchmark, size, operations, (double) nanos / operations);
+    fflush(stdout);
+}
+
+// End.
@@ -0,0 +1,304 @@
+/** Related Values Processing Framework.
+ *
+ * $Id$
+ */
+
+/* Notes.
+ *
+ * Times the hot paths of the RVPF C library: the parsing of engine
+ * requests by rvpf_pipe from a canned input stream, and the building of
+ * XPVPC messages sent to a loopback sink which acknowledges them.
+ *
+ * The pipe benchmarks run in a child process, since rvpf_pipe owns the
+ * standard input and output, and leaves by a longjmp at end of input.
+ *
+ * Each result is written on stdout as a tab separated line:
+ * benchmark, size, operations, nanoseconds per operation.
+ */
+#include "rvpf_pipe.h"
+#include "rvpf_xpvpc.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// Private macro definitions.
+
+#define HEADER "# benchmark\tsize\toperations\tns_per_op"
+#define PIPE_BATCH_LIMIT 16
+#define PIPE_INPUTS 4
+#define PIPE_REQUESTS 100000
+#define SINK_BUFFER_SIZE 4096
+#define XPVPC_BATCH_VALUES 100000
+#define XPVPC_FLUSHED_VALUES 10000
+#define XPVPC_POINT "BENCH1"
+#define XPVPC_STAMP "2019-01-01 00:00"
+#define XPVPC_VALUE "12.3456"
+#define XPVPC_WINDOW 16
+
+// Private forward declarations.
+
+static void _benchPipe(const char *benchmark, size_t batchLimit);
+
+static void _benchXPVPC(void);
+
+static long long _nanos(void);
+
+static void _pipeTransform(size_t batchLimit);
+
+static void _report(
+    const char *benchmark,
+    size_t size,
+    size_t operations,
+    long long nanos);
+
+static void *_sink(void *argument);
+
+static void _xpvpcSend(
+    RVPF_XPVPC_Context context,
+    const char *benchmark,
+    size_t size,
+    size_t values);
+
+// Main.
+
+extern int main(int argc, char **argv)
+{
+    puts(HEADER);
+    fflush(stdout);
+
+    _benchPipe("pipe_engine_request", 1);
+    _benchPipe("pipe_engine_requests", PIPE_BATCH_LIMIT);
+
+    _benchXPVPC();
+
+    return 0;
+}
+
+// Private function definitions.
+
+static void _benchPipe(const char *benchmark, size_t batchLimit)
+{
+    FILE *input = tmpfile();
+    int results[2];
+
+    if (!input || pipe(results)) {
+        perror(benchmark);
+        exit(1);
+    }
+
+    for (size_t i = 1; i <= PIPE_REQUESTS; ++i) {
+        fprintf(input, "%zu 1 1 1 %i\n", i, PIPE_INPUTS);
+        fputs("RES 2019-01-01T00:00\n10\n2\n", input);
+        for (int j = 1; j <= PIPE_INPUTS; ++j) {
+            fprintf(input, "IN%i 2019-01-01T00:00 [1] \"%i.5\"\n", j, j);
+        }
+    }
+    fflush(input);
+    rewind(input);
+
+    pid_t child = fork();
+
+    if (child < 0) {
+        perror(benchmark);
+        exit(1);
+    }
+
+    if (!child) {
+        long long start = _nanos();
+        long long nanos;
+
+        close(results[0]);
+        dup2(fileno(input), 0);
+        if (!freopen("/dev/null", "w", stdout)) _exit(1);
+
+        if (!setjmp(rvpf_pipe_jmp_buf)) {
+            rvpf_pipe_setLogLevel(RVPF_LOG_LEVEL_WARN);
+            _pipeTransform(batchLimit);
+        }
+
+        nanos = rvpf_pipe_status? -1: _nanos() - start;
+        if (write(results[1], &nanos, sizeof nanos) < 0) _exit(1);
+        _exit(0);
+    }
+
+    long long nanos = -1;
+
+    close(results[1]);
+    if (read(results[0], &nanos, sizeof nanos) != sizeof nanos) nanos = -1;
+    close(results[0]);
+    waitpid(child, NULL, 0);
+    fclose(input);
+
+    if (nanos < 0) {
+        fprintf(stderr, "%s: the pipe child failed\n", benchmark);
+        exit(1);
+    }
+
+    _report(benchmark, batchLimit, PIPE_REQUESTS, nanos);
+}
+
+static void _benchXPVPC(void)
+{
+    struct sockaddr_in address;
+    socklen_t addressLength = sizeof address;
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    pthread_t sink;
+    char xpvpcAddress[32];
+
+    memset(&address, 0, sizeof address);
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (listener < 0
+            || bind(listener, (struct sockaddr *) &address, sizeof address)
+            || listen(listener, 1)
+            || getsockname(
+                listener, (struct sockaddr *) &address, &addressLength)
+            || pthread_create(&sink, NULL, _sink, &listener)) {
+        perror("xpvpc");
+        exit(1);
+    }
+
+    snprintf(xpvpcAddress, sizeof xpvpcAddress,
+        "127.0.0.1:%u", ntohs(address.sin_port));
+
+    RVPF_XPVPC_Context context = rvpf_xpvpc_create();
+
+    rvpf_xpvpc_open(context, xpvpcAddress);
+    rvpf_xpvpc_setClient(context, "BENCH");
+    rvpf_xpvpc_login(context, "user", "password");
+
+    _xpvpcSend(context, "xpvpc_send_flush", 1, XPVPC_FLUSHED_VALUES);
+    rvpf_xpvpc_setWindow(context, XPVPC_WINDOW);
+    _xpvpcSend(context, "xpvpc_send_window", 1, XPVPC_FLUSHED_VALUES);
+    rvpf_xpvpc_setWindow(context, 0);
+    _xpvpcSend(context, "xpvpc_send_batch", 100, XPVPC_BATCH_VALUES);
+    _xpvpcSend(context, "xpvpc_send_batch", 10000, XPVPC_BATCH_VALUES);
+
+    if (rvpf_xpvpc_printError(context, "xpvpc")) exit(1);
+
+    rvpf_xpvpc_close(context);
+    rvpf_xpvpc_dispose(context);
+
+    pthread_join(sink, NULL);
+    close(listener);
+}
+
+static long long _nanos(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static void _pipeTransform(size_t batchLimit)
+{
+    RVPF_PIPE_EngineRequest requests[PIPE_BATCH_LIMIT];
+
+    while (true) {
+        int count = batchLimit > 1
+            ? rvpf_pipe_nextEngineRequests(requests, batchLimit)
+            : (requests[0] = rvpf_pipe_nextEngineRequest(), 1);
+
+        for (int i = 0; i < count; ++i) {
+            int inputsCount = rvpf_pipe_getEngineInputsCount(requests[i]);
+            double total = 0.0;
+
+            for (int j = 1; j <= inputsCount; ++j) {
+                double value;
+
+                if (rvpf_pipe_getDoubleValue(
+                        rvpf_pipe_getEngineInput(requests[i], j), &value)) {
+                    total += value;
+                }
+            }
+
+            rvpf_pipe_setEngineResultDouble(requests[i], total);
+        }
+
+        if (batchLimit > 1) rvpf_pipe_endEngineRequests(requests, count);
+        else rvpf_pipe_endEngineRequest(requests[0]);
+    }
+}
+
+static void _report(
+    const char *benchmark,
+    size_t size,
+    size_t operations,
+    long long nanos)
+{
+    printf("%s\t%zu\t%zu\t%.1f\n",
+        benchmark, size, operations, (double) nanos / operations);
+    fflush(stdout);
+}
+
+static void *_sink(void *argument)
+{
+    // Acknowledges each login and messages element by its id attribute.
+
+    static const char idStart[] = " id='";
+    int connection = accept(*(int *) argument, NULL, NULL);
+    char buffer[SINK_BUFFER_SIZE];
+    size_t matched = 0;
+    long long id = 0;
+    ssize_t count;
+
+    if (connection < 0) return NULL;
+
+    while ((count = read(connection, buffer, sizeof buffer)) > 0) {
+        for (ssize_t i = 0; i < count; ++i) {
+            char next = buffer[i];
+
+            if (matched < sizeof idStart - 1) {
+                if (next == idStart[matched]) ++matched;
+                else matched = next == idStart[0];
+            } else if (next >= '0' && next <= '9') {
+                id = id * 10 + next - '0';
+            } else {
+                char response[64];
+                int length = snprintf(response, sizeof response,
+                    "<done ref='%lld'/>\n", id);
+
+                if (write(connection, response, length) != length) {
+                    close(connection);
+                    return NULL;
+                }
+                matched = 0;
+                id = 0;
+            }
+        }
+    }
+
+    close(connection);
+
+    return NULL;
+}
+
+static void _xpvpcSend(
+    RVPF_XPVPC_Context context,
+    const char *benchmark,
+    size_t size,
+    size_t values)
+{
+    long long start = _nanos();
+
+    for (size_t i = 1; i <= values; ++i) {
+        rvpf_xpvpc_sendValue(context, XPVPC_POINT, XPVPC_STAMP, NULL, XPVPC_VALUE);
+        if (!(i % size)) rvpf_xpvpc_flush(context);
+    }
+    rvpf_xpvpc_sync(context);
+
+    _report(benchmark, size, values, _nanos() - start);
+}
+
+// End.
@@ -0,0 +1,159 @@
+/** Related Values Processing Framework.
+ *
+ * $Id$
+ */
+
+/* Notes.
+ *
+ * Checks the shared handles map while lookups race with the modifications:
+ * reader threads get keys, one by one and in batches, while the main thread
+ * grows the map through its resizes, removes entries and clears it. A lookup
+ * must always find either nothing or the value put for its key; a table freed
+ * too early would show up here (or under a memory checker). Exits with the
+ * count of failures.
+ */
+#include "CStoreImpl.h"
+#include "SharedHandlesMap.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+
+// Private macro definitions.
+
+#define BATCH_SIZE 16
+#define GROW_LOAD_SIZE 4
+#define KEY_COUNT 20000
+#define READER_COUNT 2
+#define ROUND_COUNT 8
+#define YIELD_PERIOD 256
+
+#define CHECK(condition) _check((condition), #condition, __LINE__)
+#define VALUE_FOR(key) ((key) * 7 + 1)
+
+// Private variable definitions.
+
+static int _failures;
+
+static bool _stopping;
+
+// Private forward declarations.
+
+static void _check(bool condition, const char *text, int line);
+
+static void *_read(void *map);
+
+static void _testRaces(void);
+
+static void _testSingleThread(void);
+
+// Main.
+
+extern int main(int argc, char **argv)
+{
+    _testSingleThread();
+    _testRaces();
+
+    if (_failures) {
+        fprintf(stderr, "%i failure(s)\n", _failures);
+    }
+
+    return _failures;
+}
+
+// Private function definitions.
+
+static void _check(bool condition, const char *text, int line)
+{
+    if (!condition) {
+        fprintf(stderr, "Line %i: failed '%s'\n", line, text);
+        __atomic_add_fetch(&_failures, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static void *_read(void *map)
+{
+    c_store_handle_t keys[BATCH_SIZE];
+    c_store_handle_t values[BATCH_SIZE];
+    unsigned seed = (unsigned) (size_t) &keys;
+
+    while (!__atomic_load_n(&_stopping, __ATOMIC_ACQUIRE)) {
+        for (size_t i = 0; i < BATCH_SIZE; ++i) {
+            seed = seed * 1103515245 + 12345;
+            keys[i] = 1 + (c_store_handle_t) ((seed >> 8) % KEY_COUNT);
+        }
+
+        c_store_handle_t value = SharedHandlesMap_get(map, keys[0]);
+
+        CHECK(!value || value == VALUE_FOR(keys[0]));
+
+        size_t found = SharedHandlesMap_getBatch(
+            map, BATCH_SIZE, keys, values);
+
+        CHECK(found <= BATCH_SIZE);
+        for (size_t i = 0; i < BATCH_SIZE; ++i) {
+            CHECK(!values[i] || values[i] == VALUE_FOR(keys[i]));
+        }
+
+        sched_yield();
+    }
+
+    return NULL;
+}
+
+static void _testRaces(void)
+{
+    c_store_shared_handles_map_t map = SharedHandlesMap_create(GROW_LOAD_SIZE);
+    pthread_t readers[READER_COUNT];
+
+    for (size_t i = 0; i < READER_COUNT; ++i) {
+        CHECK(!pthread_create(&readers[i], NULL, _read, map));
+    }
+
+    for (int round = 0; round < ROUND_COUNT; ++round) {
+        for (c_store_handle_t key = 1; key <= KEY_COUNT; ++key) {
+            SharedHandlesMap_put(map, key, VALUE_FOR(key));
+            if (!(key % YIELD_PERIOD)) sched_yield(); // Lets the readers in.
+        }
+        CHECK(SharedHandlesMap_size(map) == KEY_COUNT);
+
+        for (c_store_handle_t key = 1; key <= KEY_COUNT; key += 2) {
+            CHECK(SharedHandlesMap_remove(map, key) == VALUE_FOR(key));
+        }
+        CHECK(SharedHandlesMap_size(map) == KEY_COUNT / 2);
+
+        SharedHandlesMap_clear(map);
+        CHECK(SharedHandlesMap_size(map) == 0);
+    }
+
+    __atomic_store_n(&_stopping, true, __ATOMIC_RELEASE);
+    for (size_t i = 0; i < READER_COUNT; ++i) {
+        pthread_join(readers[i], NULL);
+    }
+
+    SharedHandlesMap_dispose(map);
+}
+
+static void _testSingleThread(void)
+{
+    c_store_shared_handles_map_t map = SharedHandlesMap_create(GROW_LOAD_SIZE);
+    c_store_handle_t keys[] = {1, 2, 3, 0};
+    c_store_handle_t values[4];
+
+    CHECK(SharedHandlesMap_put(map, 1, 11) == 0);
+    CHECK(SharedHandlesMap_put(map, 2, 22) == 0);
+    CHECK(SharedHandlesMap_put(map, 1, 12) == 11);
+    CHECK(SharedHandlesMap_get(map, 1) == 12);
+    CHECK(SharedHandlesMap_get(map, 3) == 0);
+    CHECK(SharedHandlesMap_getBatch(map, 4, keys, values) == 2);
+    CHECK(values[0] == 12 && values[1] == 22 && !values[2] && !values[3]);
+    CHECK(SharedHandlesMap_put(map, 2, 0) == 22);
+    CHECK(SharedHandlesMap_get(map, 2) == 0);
+    CHECK(SharedHandlesMap_size(map) == 1);
+    CHECK(SharedHandlesMap_remove(map, 1) == 12);
+    CHECK(SharedHandlesMap_size(map) == 0);
+
+    SharedHandlesMap_dispose(map);
+}
+
+// End.
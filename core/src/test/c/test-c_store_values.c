@@ -0,0 +1,197 @@
+/* This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+/** Related Values Processing Framework.
+ *
+ * $Id$
+ */
+
+/* Notes.
+ *
+ * Checks the access to the bytes of string and byte array values laid out
+ * as Java sends them: 65534 bytes blocks, each preceded by its big-endian
+ * length and followed by a zero length. Each value is allocated at its exact
+ * size, so that a read past its end shows up under a memory checker. Exits
+ * with the count of failures.
+ */
+#include "CStoreImpl.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Private macro definitions.
+
+#define MAX_BLOCK_LENGTH 65534
+#define TWO_BLOCKS_LENGTH (MAX_BLOCK_LENGTH + 10)
+
+#define CHECK(condition) _check((condition), #condition, __LINE__)
+
+// Private variable definitions.
+
+static int _failures;
+
+// Private forward declarations.
+
+static void _check(bool condition, const char *text, int line);
+
+static c_store_value_t *_newValue(
+    enum value_type valueType,
+    const c_store_byte_t *bytes,
+    size_t length);
+
+static void _testByteArray(size_t length, bool single);
+
+static void _testEmpty(void);
+
+static void _testTruncated(void);
+
+// Main.
+
+extern int main(int argc, char **argv)
+{
+    _testEmpty();
+    _testByteArray(1, true);
+    _testByteArray(MAX_BLOCK_LENGTH, true);
+    _testByteArray(TWO_BLOCKS_LENGTH, false);
+    _testTruncated();
+
+    if (_failures) {
+        fprintf(stderr, "%i failure(s)\n", _failures);
+    }
+
+    return _failures;
+}
+
+// Private function definitions.
+
+static void _check(bool condition, const char *text, int line)
+{
+    if (!condition) {
+        fprintf(stderr, "Line %i: failed '%s'\n", line, text);
+        ++_failures;
+    }
+}
+
+static c_store_value_t *_newValue(
+    enum value_type valueType,
+    const c_store_byte_t *bytes,
+    size_t length)
+{
+    size_t size = 1 + length + (length / MAX_BLOCK_LENGTH + 1) * 2;
+
+    if (length % MAX_BLOCK_LENGTH) size += 2;
+
+    c_store_value_t *storeValue = calloc(
+        1, offsetof(c_store_value_t, value) + size);
+    c_store_byte_t *valuePointer = storeValue->value;
+
+    storeValue->size = size;
+    *valuePointer++ = valueType;
+    for (;;) {
+        size_t blockLength = length < MAX_BLOCK_LENGTH?
+            length: MAX_BLOCK_LENGTH;
+
+        *valuePointer++ = blockLength >> 8;
+        *valuePointer++ = blockLength & 0xFF;
+        if (blockLength == 0) break;
+        memcpy(valuePointer, bytes, blockLength);
+        valuePointer += blockLength;
+        bytes += blockLength;
+        length -= blockLength;
+    }
+    CHECK(valuePointer == storeValue->value + size);
+
+    return storeValue;
+}
+
+static void _testByteArray(size_t length, bool single)
+{
+    c_store_byte_t *bytes = malloc(length);
+    c_store_byte_t *buffer = malloc(length);
+    const c_store_byte_t *reference;
+    c_store_byte_t *joined;
+    size_t joinedLength;
+
+    for (size_t i = 0; i < length; ++i) bytes[i] = (c_store_byte_t) (i * 7);
+
+    c_store_value_t *storeValue = _newValue(
+        VALUE_TYPE_BYTE_ARRAY, bytes, length);
+
+    CHECK(CStore_valueToBytesReference(
+        storeValue, &reference, &joinedLength) == single);
+    if (single) {
+        CHECK(joinedLength == length);
+        CHECK(!memcmp(reference, bytes, length));
+    }
+
+    CHECK(!CStore_valueToBuffer(storeValue, buffer, length - 1, &joinedLength));
+    CHECK(joinedLength == length);
+    CHECK(CStore_valueToBuffer(storeValue, buffer, length, &joinedLength));
+    CHECK(joinedLength == length);
+    CHECK(!memcmp(buffer, bytes, length));
+
+    CHECK(CStore_valueToByteArray(storeValue, &joined, &joinedLength));
+    CHECK(joinedLength == length);
+    CHECK(!memcmp(joined, bytes, length));
+
+    CStore_free(joined);
+    free(storeValue);
+    free(buffer);
+    free(bytes);
+}
+
+static void _testEmpty(void)
+{
+    // Java sends an empty value as its type followed by the zero length.
+
+    c_store_value_t *storeValue = _newValue(VALUE_TYPE_STRING, NULL, 0);
+    const c_store_byte_t *reference;
+    char buffer[1];
+    char *string;
+    size_t length = 1;
+
+    CHECK(storeValue->size == 3);
+    CHECK(CStore_valueToBytesReference(storeValue, &reference, &length));
+    CHECK(length == 0);
+    length = 1;
+    CHECK(CStore_valueToBuffer(storeValue, buffer, 0, &length));
+    CHECK(length == 0);
+    CHECK(CStore_valueToString(storeValue, &string));
+    CHECK(!strcmp(string, ""));
+
+    free(string);
+    free(storeValue);
+}
+
+static void _testTruncated(void)
+{
+    // The value ends inside its block: nothing is read past its size.
+
+    c_store_byte_t bytes[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    c_store_value_t *storeValue = _newValue(
+        VALUE_TYPE_BYTE_ARRAY, bytes, sizeof bytes);
+    const c_store_byte_t *reference;
+    c_store_byte_t buffer[sizeof bytes];
+    size_t length;
+
+    storeValue->size -= 4;
+    CHECK(CStore_valueToBytesReference(storeValue, &reference, &length));
+    CHECK(length == 0);
+    CHECK(CStore_valueToBuffer(storeValue, buffer, sizeof buffer, &length));
+    CHECK(length == 0);
+
+    free(storeValue);
+}
+
+// End.
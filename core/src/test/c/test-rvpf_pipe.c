@@ -13,16 +13,33 @@
 
 // Private macro definitions.
 
+#define BATCH_LIMIT 16
+#define BATCH_MODE "BATCH"
+#define POOL_MODE "POOL"
+#define POOL_WORKERS 4
 #define PROGRAM_NAME "test-rvpf_pipe"
+#define SINK_BATCH_MODE "SINK_BATCH"
 #define SINK_MODE "SINK"
 #define TRANSFORM_MODE "TRANSFORM"
 
 // Private forward declarations.
 
+static void _doBatch(void);
+
+static void _doPool(void);
+
 static void _doSink(void);
 
+static void _doSinkBatch(void);
+
+static void _sink(RVPF_PIPE_SinkRequest request);
+
 static void _doTransform(void);
 
+static void _poolTransform(RVPF_PIPE_EngineRequest request, void *data);
+
+static void _transform(RVPF_PIPE_EngineRequest request);
+
 // Main.
 
 extern int main(int argc, char **argv)
@@ -47,95 +64,162 @@ extern int main(int argc, char **argv)
         if (!strcmp(mode, TRANSFORM_MODE)) {
             rvpf_pipe_debug("Started %s in %s mode", PROGRAM_NAME, mode);
             _doTransform();
+        } else if (!strcmp(mode, BATCH_MODE)) {
+            rvpf_pipe_debug("Started %s in %s mode", PROGRAM_NAME, mode);
+            _doBatch();
+        } else if (!strcmp(mode, POOL_MODE)) {
+            rvpf_pipe_debug("Started %s in %s mode", PROGRAM_NAME, mode);
+            _doPool();
         } else if (!strcmp(mode, SINK_MODE)) {
             rvpf_pipe_debug("Started %s in %s mode", PROGRAM_NAME, mode);
             _doSink();
+        } else if (!strcmp(mode, SINK_BATCH_MODE)) {
+            rvpf_pipe_debug("Started %s in %s mode", PROGRAM_NAME, mode);
+            _doSinkBatch();
         }
     }
 
-    rvpf_pipe_error("Usage: %s TRANSFORM|SINK", PROGRAM_NAME);
+    rvpf_pipe_error("Usage: %s TRANSFORM|BATCH|POOL|SINK|SINK_BATCH", PROGRAM_NAME);
 }
 
 // Private function definitions.
 
+static void _doBatch(void)
+{
+    RVPF_PIPE_EngineRequest requests[BATCH_LIMIT];
+
+    while (true) {
+        int count = rvpf_pipe_nextEngineRequests(requests, BATCH_LIMIT);
+
+        rvpf_pipe_debug("Got a batch of %i request(s)", count);
+
+        for (int i = 0; i < count; ++i) {
+            _transform(requests[i]);
+        }
+
+        rvpf_pipe_endEngineRequests(requests, count);
+    }
+}
+
+static void _doPool(void)
+{
+    rvpf_pipe_runEngineWorkers(POOL_WORKERS, _poolTransform, NULL);
+}
+
 static void _doSink(void)
 {
     while (true) {
         RVPF_PIPE_SinkRequest request = rvpf_pipe_nextSinkRequest();
-        RVPF_PIPE_PointValue pointValue = rvpf_pipe_getSinkPointValue(request);
-
-        rvpf_pipe_debug(
-            "Got request %s (%s) for point '%s'",
-            rvpf_pipe_getSinkRequestID(request),
-            rvpf_pipe_sink_request_types[rvpf_pipe_getSinkRequestType(request)],
-            pointValue->pointName);
 
-        if (pointValue->state) rvpf_pipe_debug("State: {%s}", pointValue->state);
-        if (pointValue->value) rvpf_pipe_debug("Value: {%s}", pointValue->value);
+        _sink(request);
 
         rvpf_pipe_endSinkRequest(request, 1);
     }
 }
 
+static void _doSinkBatch(void)
+{
+    RVPF_PIPE_SinkRequest requests[BATCH_LIMIT];
+    int summaries[BATCH_LIMIT];
+
+    while (true) {
+        int count = rvpf_pipe_nextSinkRequests(requests, BATCH_LIMIT, true);
+
+        rvpf_pipe_debug("Got a batch of %i sink request(s)", count);
+
+        for (int i = 0; i < count; ++i) {
+            _sink(requests[i]);
+            summaries[i] = 1;
+        }
+
+        rvpf_pipe_endSinkRequests(requests, summaries, count);
+    }
+}
+
 static void _doTransform(void)
 {
     while (true) {
         RVPF_PIPE_EngineRequest request = rvpf_pipe_nextEngineRequest();
 
-        rvpf_pipe_debug(
-            "Got request %s (Transform) for point '%s'",
-            rvpf_pipe_getEngineRequestID(request),
-            rvpf_pipe_getEngineResult(request)->pointName);
+        _transform(request);
 
-        if (rvpf_pipe_getEngineTransformParamsCount(request) != 1) {
-            rvpf_pipe_error("The transform should have 1 parameter");
-        }
-        if (rvpf_pipe_getEnginePointParamsCount(request) != 1) {
-            rvpf_pipe_error("The point should have 1 parameter");
-        }
-        if (rvpf_pipe_getEngineInputsCount(request) < 1) {
-            rvpf_pipe_error("The point should have at least 1 input");
-        }
+        rvpf_pipe_endEngineRequest(request);
+    }
+}
 
-        double modulo =
-            strtod(rvpf_pipe_getEngineTransformParam(request, 1), NULL);
-        double factor =
-            strtod(rvpf_pipe_getEnginePointParam(request, 1), NULL);
-
-        if (modulo > 0) {
-            int inputsCount = rvpf_pipe_getEngineInputsCount(request);
-            double total = 0.0;
-            bool containsNulls = false;
-
-            for (int i = 1; i <= inputsCount; ++i) {
-                char *value = rvpf_pipe_getEngineInput(request, i)->value;
-
-                if (value) {
-                    total += strtod(value, NULL);
-                } else {
-                    containsNulls = true;
-                    break;
-                }
-            }
+static void _poolTransform(RVPF_PIPE_EngineRequest request, void *data)
+{
+    _transform(request);
+}
+
+static void _sink(RVPF_PIPE_SinkRequest request)
+{
+    RVPF_PIPE_PointValue pointValue = rvpf_pipe_getSinkPointValue(request);
+
+    rvpf_pipe_debug(
+        "Got request %s (%s) for point '%s'",
+        rvpf_pipe_getSinkRequestID(request),
+        rvpf_pipe_sink_request_types[rvpf_pipe_getSinkRequestType(request)],
+        pointValue->pointName);
 
-            if (containsNulls) {
-                rvpf_pipe_setEngineResultValue(request, NULL);
+    if (pointValue->state) rvpf_pipe_debug("State: {%s}", pointValue->state);
+    if (pointValue->value) rvpf_pipe_debug("Value: {%s}", pointValue->value);
+}
+
+static void _transform(RVPF_PIPE_EngineRequest request)
+{
+    rvpf_pipe_debug(
+        "Got request %s (Transform) for point '%s'",
+        rvpf_pipe_getEngineRequestID(request),
+        rvpf_pipe_getEngineResult(request)->pointName);
+
+    if (rvpf_pipe_getEngineTransformParamsCount(request) != 1) {
+        rvpf_pipe_error("The transform should have 1 parameter");
+    }
+    if (rvpf_pipe_getEnginePointParamsCount(request) != 1) {
+        rvpf_pipe_error("The point should have 1 parameter");
+    }
+    if (rvpf_pipe_getEngineInputsCount(request) < 1) {
+        rvpf_pipe_error("The point should have at least 1 input");
+    }
+
+    double modulo =
+        strtod(rvpf_pipe_getEngineTransformParam(request, 1), NULL);
+    double factor =
+        strtod(rvpf_pipe_getEnginePointParam(request, 1), NULL);
+
+    if (modulo > 0) {
+        int inputsCount = rvpf_pipe_getEngineInputsCount(request);
+        double total = 0.0;
+        bool containsNulls = false;
+
+        for (int i = 1; i <= inputsCount; ++i) {
+            double value;
+
+            if (rvpf_pipe_getDoubleValue(
+                    rvpf_pipe_getEngineInput(request, i), &value)) {
+                total += value;
             } else {
-                char buffer[80];
-
-                snprintf(
-                    buffer,
-                    sizeof(buffer), "%.1f",
-                    fmod(total * factor, modulo));
-                rvpf_pipe_setEngineResultValue(request, buffer);
-                rvpf_pipe_setEngineResultState(request,
-                    rvpf_pipe_getEngineInput(request, 1)->state);
+                containsNulls = true;
+                break;
             }
-        } else {
-            rvpf_pipe_clearEngineResults(request);
         }
 
-        rvpf_pipe_endEngineRequest(request);
+        if (containsNulls) {
+            rvpf_pipe_setEngineResultValue(request, NULL);
+        } else {
+            char buffer[80];
+
+            snprintf(
+                buffer,
+                sizeof(buffer), "%.1f",
+                fmod(total * factor, modulo));
+            rvpf_pipe_setEngineResultValue(request, buffer);
+            rvpf_pipe_setEngineResultState(request,
+                rvpf_pipe_getEngineInput(request, 1)->state);
+        }
+    } else {
+        rvpf_pipe_clearEngineResults(request);
     }
 }
 
@@ -0,0 +1,170 @@
+/** Related Values Processing Framework.
+ *
+ * $Id$
+ */
+
+/* Notes.
+ *
+ * Checks the text conversions of rvpf_pipe: these are private, so the
+ * implementation is included here. Exits with the count of failures.
+ */
+#include "../../main/c/lib/impl/rvpf_pipe.c"
+
+// Private macro definitions.
+
+#define CHECK(condition) _check((condition), #condition, __LINE__)
+
+// Private variable definitions.
+
+static int _failures;
+
+// Private forward declarations.
+
+static void _check(bool condition, const char *text, int line);
+
+static void _checkDouble(const char *text);
+
+static void _checkDoubleText(double value, const char *expected);
+
+static void _checkStamp(const char *stamp, const char *expected);
+
+static void _testDoubles(void);
+
+static void _testStamps(void);
+
+// Main.
+
+extern int main(int argc, char **argv)
+{
+    _testDoubles();
+    _testStamps();
+
+    if (_failures) {
+        fprintf(stderr, "%i failure(s)\n", _failures);
+    }
+
+    return _failures;
+}
+
+// Private function definitions.
+
+static void _check(bool condition, const char *text, int line)
+{
+    if (!condition) {
+        fprintf(stderr, "Line %i: failed '%s'\n", line, text);
+        ++_failures;
+    }
+}
+
+static void _checkDouble(const char *text)
+{
+    // The fast path must agree with strtod.
+
+    double value;
+    bool parsed = _parseDouble(text, &value);
+
+    CHECK(parsed);
+    if (parsed && value != strtod(text, NULL)) {
+        fprintf(stderr, "'%s': got %.17g\n", text, value);
+        ++_failures;
+    }
+}
+
+static void _checkDoubleText(double value, const char *expected)
+{
+    struct rvpf_pipe_buffer buffer = {NULL};
+
+    _expandBuffer(&buffer, 1);
+    _doubleToBuffer(value, &buffer);
+    if (strcmp(buffer.at, expected)) {
+        fprintf(stderr, "%.17g: got '%s', expected '%s'\n",
+            value, buffer.at, expected);
+        ++_failures;
+    }
+    free(buffer.at);
+}
+
+static void _checkStamp(const char *stamp, const char *expected)
+{
+    struct rvpf_pipe_buffer buffer = {NULL};
+    long long ticks;
+
+    CHECK(_parseStamp(stamp, &ticks));
+    _expandBuffer(&buffer, 1);
+    _ticksToBuffer(ticks, &buffer);
+    if (strcmp(buffer.at, expected)) {
+        fprintf(stderr, "'%s': got '%s', expected '%s'\n",
+            stamp, buffer.at, expected);
+        ++_failures;
+    }
+    free(buffer.at);
+}
+
+static void _testDoubles(void)
+{
+    double value;
+
+    _checkDouble("0");
+    _checkDouble("1.5");
+    _checkDouble("-0.25");
+    _checkDouble("+12.3456");
+    _checkDouble("0000000000000000000000001");
+    _checkDouble("0.0000000000000000000001");
+    _checkDouble("0.0000000000000000000000000000000000000001");
+    _checkDouble("0.12345678901234567890123456789");
+    _checkDouble("123456789012345678901234567890");
+    _checkDouble("9007199254740993");
+    _checkDouble("1e10");
+    _checkDouble("-1.5E-3");
+    _checkDouble("1e-320");
+    _checkDouble(" 2.5 ");
+
+    CHECK(_parseDouble("nan", &value) && isnan(value));
+    CHECK(_parseDouble("NaN", &value) && isnan(value));
+    CHECK(_parseDouble("inf", &value) && isinf(value) && value > 0);
+    CHECK(_parseDouble("Infinity", &value) && isinf(value) && value > 0);
+    CHECK(_parseDouble("-Infinity", &value) && isinf(value) && value < 0);
+    CHECK(!_parseDouble("", &value));
+    CHECK(!_parseDouble("-", &value));
+    CHECK(!_parseDouble(".", &value));
+    CHECK(!_parseDouble("1.5x", &value));
+    CHECK(!_parseDouble("1.2.3", &value));
+
+    _checkDoubleText(0.0, "0.0");
+    _checkDoubleText(1.0, "1.0");
+    _checkDoubleText(-2.5, "-2.5");
+    _checkDoubleText(0.1, "0.1");
+    _checkDoubleText(1e300, "1e+300");
+    _checkDoubleText(0.1 + 0.2, "0.30000000000000004");
+    _checkDoubleText(NAN, "NaN");
+    _checkDoubleText(INFINITY, "Infinity");
+    _checkDoubleText(-INFINITY, "-Infinity");
+}
+
+static void _testStamps(void)
+{
+    long long ticks;
+
+    CHECK(_parseStamp("1970-01-01T00:00Z", &ticks) && ticks == UNIX_EPOCH_RAW);
+    CHECK(_parseStamp("1969-12-31 19:00:00-05:00", &ticks)
+        && ticks == UNIX_EPOCH_RAW);
+
+    _checkStamp("1970-01-01T00:00:00Z", "1970-01-01T00:00:00.0000000Z");
+    _checkStamp("2019-01-01T04:00:00.0000000-05:00",
+        "2019-01-01T09:00:00.0000000Z");
+    _checkStamp("2000-02-29T12:34:56.5+01:30", "2000-02-29T11:04:56.5000000Z");
+    _checkStamp("2019-06-30T23:59:59.123456789123Z",
+        "2019-06-30T23:59:59.1234567Z");
+    _checkStamp("1969-12-31T23:59:59.9999999Z", "1969-12-31T23:59:59.9999999Z");
+    _checkStamp("1600-03-01T00:00:00Z", "1600-03-01T00:00:00.0000000Z");
+    _checkStamp("2100-12-31T23:00:00+0100", "2100-12-31T22:00:00.0000000Z");
+
+    CHECK(!_parseStamp("2019-01-01T00:00", &ticks));
+    CHECK(!_parseStamp("2019-13-01T00:00Z", &ticks));
+    CHECK(!_parseStamp("2019-01-01T24:00Z", &ticks));
+    CHECK(!_parseStamp("2019-01-01T00:00:6Z", &ticks));
+    CHECK(!_parseStamp("2019-01-01T00:00Zx", &ticks));
+    CHECK(!_parseStamp("2019-01-01T00:00+5", &ticks));
+}
+
+// End.
@@ -70,12 +70,33 @@ extern int main(int argc, char **argv)
 
     if (rvpf_xpvpc_succeeded(context)) {
         SLEEP(2);
+        rvpf_xpvpc_setWindow(context, 4);
+        rvpf_xpvpc_printError(context, TEST);
         rvpf_xpvpc_sendValue(context, POINT, "2006-01-01 02:00", RVPF_XPVPC_DELETED_STATE, NULL);
         rvpf_xpvpc_printError(context, TEST);
         rvpf_xpvpc_sendValue(context, POINT, "2006-01-01 05:00", NULL, "20.1234");
         rvpf_xpvpc_printError(context, TEST);
         rvpf_xpvpc_sendValue(context, POINT, "2006-01-01 06:00", NULL, "25.6789");
         rvpf_xpvpc_printError(context, TEST);
+        rvpf_xpvpc_flush(context);
+        rvpf_xpvpc_printError(context, TEST);
+        rvpf_xpvpc_sync(context);
+        rvpf_xpvpc_printError(context, TEST);
+    }
+
+    if (rvpf_xpvpc_succeeded(context)) {
+        SLEEP(2);
+        rvpf_xpvpc_setAutoFlushMillis(context, 100);
+        rvpf_xpvpc_printError(context, TEST);
+        rvpf_xpvpc_startSender(context);
+        rvpf_xpvpc_printError(context, TEST);
+        rvpf_xpvpc_sendValue(context, POINT, "2006-01-01 07:00", NULL, "30.1234");
+        rvpf_xpvpc_printError(context, TEST);
+        rvpf_xpvpc_sendValue(context, POINT, "2006-01-01 08:00", NULL, "35.6789");
+        rvpf_xpvpc_printError(context, TEST);
+        SLEEP(1);
+        rvpf_xpvpc_stopSender(context);
+        rvpf_xpvpc_printError(context, TEST);
     }
 
     rvpf_xpvpc_close(context);
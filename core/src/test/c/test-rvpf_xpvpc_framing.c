@@ -0,0 +1,249 @@
+/** Related Values Processing Framework.
+ *
+ * $Id$
+ */
+
+/* Notes.
+ *
+ * Checks the negotiation of the binary framing against a local fake server,
+ * with and without binary support: the client offers the binary framing on
+ * login and must only use it once the server has accepted it, staying on XML
+ * otherwise. Exits with the count of failures.
+ */
+#include "rvpf_xpvpc.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Private macro definitions.
+
+#define BUFFER_SIZE 65536
+#define POINT "Test1"
+#define STAMP "2019-01-01T00:00:00Z"
+#define VALUE_COUNT 3
+
+#define CHECK(condition) _check((condition), #condition, __LINE__)
+
+// Private structure definitions.
+
+struct _server
+{
+    int listener;
+    bool binarySupported;
+    bool binaryOffered;
+    int binaryFrames;
+    int xmlBatches;
+    char buffer[BUFFER_SIZE + 1];
+    size_t limit;
+};
+
+// Private variable definitions.
+
+static int _failures;
+
+// Private forward declarations.
+
+static void _check(bool condition, const char *text, int line);
+
+static void _respond(int connection, long long id, bool binary);
+
+static void *_serve(void *server);
+
+static size_t _serveBinary(struct _server *server, int connection);
+
+static size_t _serveXML(struct _server *server, int connection);
+
+static void _test(bool binarySupported);
+
+// Main.
+
+extern int main(int argc, char **argv)
+{
+    _test(false);
+    _test(true);
+
+    if (_failures) {
+        fprintf(stderr, "%i failure(s)\n", _failures);
+    }
+
+    return _failures;
+}
+
+// Private function definitions.
+
+static void _check(bool condition, const char *text, int line)
+{
+    if (!condition) {
+        fprintf(stderr, "Line %i: failed '%s'\n", line, text);
+        ++_failures;
+    }
+}
+
+static void _respond(int connection, long long id, bool binary)
+{
+    char response[64];
+    int length = snprintf(
+        response, sizeof response, "<done ref='%lld'%s/>\n",
+        id, binary? " framing='binary'": "");
+
+    CHECK(send(connection, response, (size_t) length, 0) == length);
+}
+
+static void *_serve(void *data)
+{
+    struct _server *server = data;
+    int connection = accept(server->listener, NULL, NULL);
+    bool framed = false;
+
+    CHECK(connection >= 0);
+
+    while (connection >= 0) {
+        ssize_t received = recv(
+            connection,
+            server->buffer + server->limit,
+            BUFFER_SIZE - server->limit,
+            0);
+
+        if (received <= 0) {
+            break;
+        }
+        server->limit += (size_t) received;
+
+        for (;;) {
+            size_t used;
+
+            if (framed) {
+                used = _serveBinary(server, connection);
+            } else if (!strncmp(server->buffer, "<login ", 7)) {
+                char *end = memchr(server->buffer, '\n', server->limit);
+
+                if (!end) {
+                    break;
+                }
+                *end = '\0';
+                server->binaryOffered = strstr(
+                    server->buffer, " framing='binary'") != NULL;
+                framed = server->binaryOffered && server->binarySupported;
+                _respond(
+                    connection,
+                    strtoll(strstr(server->buffer, "id='") + 4, NULL, 10),
+                    framed);
+                used = (size_t) (end + 1 - server->buffer);
+            } else {
+                used = _serveXML(server, connection);
+            }
+            if (!used) {
+                break;
+            }
+            server->limit -= used;
+            memmove(server->buffer, server->buffer + used, server->limit);
+        }
+    }
+
+    close(connection);
+
+    return NULL;
+}
+
+static size_t _serveBinary(struct _server *server, int connection)
+{
+    // A frame is a type, a little-endian 32 bits length and the payload,
+    // which starts with the id.
+
+    unsigned char *bytes = (unsigned char *) server->buffer;
+    size_t length;
+    long long id = 0;
+
+    if (server->limit < 5) {
+        return 0;
+    }
+    length = bytes[1] | bytes[2] << 8 | bytes[3] << 16
+        | (size_t) bytes[4] << 24;
+    if (server->limit < 5 + length) {
+        return 0;
+    }
+
+    CHECK(bytes[0] == 'M');
+    for (size_t i = 0; i < length; ++i) {
+        id |= (long long) (bytes[5 + i] & 0x7F) << (7 * i);
+        if (!(bytes[5 + i] & 0x80)) break;
+    }
+    _respond(connection, id, false);
+    ++server->binaryFrames;
+
+    return 5 + length;
+}
+
+static size_t _serveXML(struct _server *server, int connection)
+{
+    static const char end[] = "</messages>\n";
+    char *found;
+
+    server->buffer[server->limit] = '\0';
+    found = strstr(server->buffer, end);
+    if (!found) {
+        return 0;
+    }
+
+    CHECK(!strncmp(server->buffer, "<messages id='", 14));
+    _respond(connection, strtoll(server->buffer + 14, NULL, 10), false);
+    ++server->xmlBatches;
+
+    return (size_t) (found + sizeof end - 1 - server->buffer);
+}
+
+static void _test(bool binarySupported)
+{
+    struct _server *server = calloc(1, sizeof *server);
+    struct sockaddr_in address = {0};
+    socklen_t addressLength = sizeof address;
+    char text[32];
+    pthread_t thread;
+
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    server->listener = socket(AF_INET, SOCK_STREAM, 0);
+    server->binarySupported = binarySupported;
+    CHECK(!bind(server->listener, (struct sockaddr *) &address, sizeof address));
+    CHECK(!listen(server->listener, 1));
+    CHECK(!getsockname(
+        server->listener, (struct sockaddr *) &address, &addressLength));
+    CHECK(!pthread_create(&thread, NULL, _serve, server));
+
+    RVPF_XPVPC_Context context = rvpf_xpvpc_create();
+
+    snprintf(text, sizeof text, "127.0.0.1:%i", ntohs(address.sin_port));
+    rvpf_xpvpc_setBinary(context, true);
+    CHECK(rvpf_xpvpc_open(context, text) == RVPF_XPVPC_OK);
+    CHECK(rvpf_xpvpc_login(context, "user", "password") == RVPF_XPVPC_OK);
+    for (int i = 0; i < VALUE_COUNT; ++i) {
+        snprintf(text, sizeof text, "%i", i);
+        CHECK(rvpf_xpvpc_sendValue(context, POINT, STAMP, NULL, text)
+            == RVPF_XPVPC_OK);
+        CHECK(rvpf_xpvpc_flush(context) == RVPF_XPVPC_OK);
+    }
+    CHECK(rvpf_xpvpc_sync(context) == RVPF_XPVPC_OK);
+    rvpf_xpvpc_printError(context, binarySupported? "binary": "XML");
+    rvpf_xpvpc_close(context);
+    rvpf_xpvpc_dispose(context);
+
+    pthread_join(thread, NULL);
+    close(server->listener);
+
+    CHECK(server->binaryOffered);
+    if (binarySupported) {
+        CHECK(server->binaryFrames == VALUE_COUNT && !server->xmlBatches);
+    } else {
+        CHECK(server->xmlBatches == VALUE_COUNT && !server->binaryFrames);
+    }
+
+    free(server);
+}
+
+// End.
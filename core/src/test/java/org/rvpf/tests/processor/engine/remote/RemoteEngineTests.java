@@ -79,10 +79,40 @@ public final class RemoteEngineTests
     @Test
     public void test()
         throws Exception
+    {
+        _test(_PIPE_ENGINE_NAME);
+    }
+
+    /**
+     * Tests the batch mode of the pipe program.
+     *
+     * @throws Exception On failure.
+     */
+    @Test
+    public void testBatch()
+        throws Exception
+    {
+        _test(_PIPE_BATCH_ENGINE_NAME);
+    }
+
+    /**
+     * Tests the pool mode of the pipe program.
+     *
+     * @throws Exception On failure.
+     */
+    @Test
+    public void testPool()
+        throws Exception
+    {
+        _test(_PIPE_POOL_ENGINE_NAME);
+    }
+
+    private void _test(final String engineName)
+        throws Exception
     {
         final RemoteEngineProxy sessionProxy = _engine.getSessionProxy();
         final EngineEntity engineEntity = getMetadata()
-            .getEngineEntity(Optional.of(_PIPE_ENGINE_NAME))
+            .getEngineEntity(Optional.of(engineName))
             .get();
         final Params engineParams = engineEntity.getParams().copy();
 
@@ -139,7 +169,9 @@ public final class RemoteEngineTests
 
     private static final String _NUMERIC_POINT_1_NAME = "TESTS.NUMERIC.01";
     private static final String _NUMERIC_POINT_2_NAME = "TESTS.NUMERIC.02";
+    private static final String _PIPE_BATCH_ENGINE_NAME = "PipeBatchExample";
     private static final String _PIPE_ENGINE_NAME = "PipeExample";
+    private static final String _PIPE_POOL_ENGINE_NAME = "PipePoolExample";
     private static final String _PIPE_TRANSFORM_NAME = "PipeExample";
 
     private RemoteExecutorEngine _engine;
@@ -62,6 +62,69 @@ public final class SinkServiceTests
         stopService(sinkService);
     }
 
+    /**
+     * Pipe batch test.
+     *
+     * <p>Sends the updates in a single batch, repeating a point value to
+     * allow its coalescing by the pipe program.</p>
+     *
+     * @throws Exception On failure.
+     */
+    @Test(dependsOnMethods = "nullTest")
+    public void pipeBatchTest()
+        throws Exception
+    {
+        setProperty(_TESTS_SERVICE_PROPERTY, "PipeBatch");
+
+        final ServiceActivator sinkService = startService(
+            SinkServiceActivator.class,
+            Optional.empty());
+        final Metadata metadata = getMetadata(sinkService);
+        final Store store = getStore(
+            metadata
+                .getStringValue(StoreServiceAppImpl.STORE_NAME_PROPERTY)
+                .get(),
+            metadata)
+            .get();
+        final MessagingSupport.Receiver noticeReceiver;
+
+        Require.notNull(store);
+        noticeReceiver = getMessaging()
+            .createClientReceiver(
+                metadata.getPropertiesGroup(NOTIFIER_QUEUE_PROPERTIES));
+        noticeReceiver.purge();
+
+        final Point point1 = metadata.getPointByName(_SINK_POINT_1_NAME).get();
+        final Point point2 = metadata.getPointByName(_SINK_POINT_2_NAME).get();
+        final DateTime stamp = DateTime.now();
+        final PointValue[] pointValues = new PointValue[] {
+            new PointValue(point1, Optional.of(stamp), null, Long.valueOf(1)),
+            new PointValue(point2, Optional.of(stamp), null, "Value"),
+            new PointValue(point1, Optional.of(stamp), null, Long.valueOf(2)),
+        };
+
+        for (final PointValue pointValue: pointValues) {
+            store.addUpdate(pointValue);
+        }
+
+        Require.success(store.sendUpdates());
+
+        // Each value is notified, even when superseded in the batch.
+
+        for (final PointValue sentValue: pointValues) {
+            final PointValue pointValue = (PointValue) noticeReceiver
+                .receive(getTimeout());
+
+            Require.equal(pointValue.getPointUUID(), sentValue.getPointUUID());
+            Require.equal(pointValue.getValue(), sentValue.getValue());
+        }
+
+        noticeReceiver.close();
+        store.close();
+
+        stopService(sinkService);
+    }
+
     /**
      * Pipe test.
      *
@@ -41,18 +41,25 @@ public final class PipeProgramExample
     {
         final String mode = (args.length == 1)? args[0]: null;
 
-        if (TRANSFORM_MODE.equalsIgnoreCase(mode)) {
+        // The batch and pool modes of the C test program answer as the
+        // transform or sink mode: the requests are still answered in order.
+
+        if (TRANSFORM_MODE.equalsIgnoreCase(mode)
+                || BATCH_MODE.equalsIgnoreCase(mode)
+                || POOL_MODE.equalsIgnoreCase(mode)) {
             PipeRequest
-                .debug("Started " + PROGRAM_NAME + " in " + TRANSFORM_MODE
-                       + " mode");
+                .debug("Started " + PROGRAM_NAME + " in " + mode + " mode");
             _transform();
-        } else if (SINK_MODE.equalsIgnoreCase(mode)) {
+        } else if (SINK_MODE.equalsIgnoreCase(mode)
+                   || SINK_BATCH_MODE.equalsIgnoreCase(mode)) {
             PipeRequest
-                .debug("Started " + PROGRAM_NAME + " in " + SINK_MODE
-                       + " mode");
+                .debug("Started " + PROGRAM_NAME + " in " + mode + " mode");
             _sink();
         } else {
-            throw PipeRequest.error("Usage: PipeProgramExample TRANSFORM|SINK");
+            throw PipeRequest
+                .error(
+                    "Usage: " + PROGRAM_NAME
+                    + " TRANSFORM|BATCH|POOL|SINK|SINK_BATCH");
         }
 
         PipeRequest.debug("Stopped " + PROGRAM_NAME);
@@ -143,7 +150,10 @@ public final class PipeProgramExample
         }
     }
 
+    public static final String BATCH_MODE = "BATCH";
+    public static final String POOL_MODE = "POOL";
     public static final String PROGRAM_NAME = "PipeProgramExample";
+    public static final String SINK_BATCH_MODE = "SINK_BATCH";
     public static final String SINK_MODE = "SINK";
     public static final String TRANSFORM_MODE = "TRANSFORM";
 }